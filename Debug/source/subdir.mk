@@ -4,36 +4,97 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../source/Bench.c \
+../source/CAN_BusLoad.c \
 ../source/CANopen_HAL.c \
+../source/CANopen_Node.c \
+../source/CANopen_PDO.c \
+../source/CyclicTask.c \
+../source/EcatBench.c \
+../source/EnetBench.c \
+../source/EoeBench.c \
+../source/FoeUpdate.c \
+../source/GatewayBench.c \
 ../source/INIT_HAL.c \
+../source/Joystick.c \
+../source/MemBench.c \
+../source/Profiler.c \
+../source/Shell.c \
+../source/Trace.c \
 ../source/UART_HAL.c \
 ../source/Utilities.c \
+../source/ecat_cycle.c \
+../source/ecat_eoe.c \
+../source/ecat_foe.c \
+../source/ecat_gateway.c \
+../source/ecat_mbx.c \
 ../source/enet_raw.c \
 ../source/main.c \
 ../source/rtos.c \
 ../source/semihost_hardfault.c 
 
 C_DEPS += \
+./source/Bench.d \
+./source/CAN_BusLoad.d \
 ./source/CANopen_HAL.d \
+./source/CANopen_Node.d \
+./source/CANopen_PDO.d \
+./source/CyclicTask.d \
+./source/EcatBench.d \
+./source/EnetBench.d \
+./source/EoeBench.d \
+./source/FoeUpdate.d \
+./source/GatewayBench.d \
 ./source/INIT_HAL.d \
+./source/Joystick.d \
+./source/MemBench.d \
+./source/Profiler.d \
+./source/Shell.d \
+./source/Trace.d \
 ./source/UART_HAL.d \
 ./source/Utilities.d \
+./source/ecat_cycle.d \
+./source/ecat_eoe.d \
+./source/ecat_foe.d \
+./source/ecat_gateway.d \
+./source/ecat_mbx.d \
 ./source/enet_raw.d \
 ./source/main.d \
 ./source/rtos.d \
 ./source/semihost_hardfault.d 
 
 OBJS += \
+./source/Bench.o \
+./source/CAN_BusLoad.o \
 ./source/CANopen_HAL.o \
+./source/CANopen_Node.o \
+./source/CANopen_PDO.o \
+./source/CyclicTask.o \
+./source/EcatBench.o \
+./source/EnetBench.o \
+./source/EoeBench.o \
+./source/FoeUpdate.o \
+./source/GatewayBench.o \
 ./source/INIT_HAL.o \
+./source/Joystick.o \
+./source/MemBench.o \
+./source/Profiler.o \
+./source/Shell.o \
+./source/Trace.o \
 ./source/UART_HAL.o \
 ./source/Utilities.o \
+./source/ecat_cycle.o \
+./source/ecat_eoe.o \
+./source/ecat_foe.o \
+./source/ecat_gateway.o \
+./source/ecat_mbx.o \
 ./source/enet_raw.o \
 ./source/main.o \
 ./source/rtos.o \
 ./source/semihost_hardfault.o 
 
 
+
 # Each subdirectory must supply rules for building sources it contributes
 source/%.o: ../source/%.c source/subdir.mk
 	@echo 'Building file: $<'
@@ -46,7 +107,7 @@ source/%.o: ../source/%.c source/subdir.mk
 clean: clean-source
 
 clean-source:
-	-$(RM) ./source/CANopen_HAL.d ./source/CANopen_HAL.o ./source/INIT_HAL.d ./source/INIT_HAL.o ./source/UART_HAL.d ./source/UART_HAL.o ./source/Utilities.d ./source/Utilities.o ./source/enet_raw.d ./source/enet_raw.o ./source/main.d ./source/main.o ./source/rtos.d ./source/rtos.o ./source/semihost_hardfault.d ./source/semihost_hardfault.o
+	-$(RM) ./source/Bench.d ./source/Bench.o ./source/CAN_BusLoad.d ./source/CAN_BusLoad.o ./source/CANopen_HAL.d ./source/CANopen_HAL.o ./source/CANopen_Node.d ./source/CANopen_Node.o ./source/CANopen_PDO.d ./source/CANopen_PDO.o ./source/CyclicTask.d ./source/CyclicTask.o ./source/EcatBench.d ./source/EcatBench.o ./source/EnetBench.d ./source/EnetBench.o ./source/EoeBench.d ./source/EoeBench.o ./source/FoeUpdate.d ./source/FoeUpdate.o ./source/GatewayBench.d ./source/GatewayBench.o ./source/INIT_HAL.d ./source/INIT_HAL.o ./source/Joystick.d ./source/Joystick.o ./source/MemBench.d ./source/MemBench.o ./source/Profiler.d ./source/Profiler.o ./source/Shell.d ./source/Shell.o ./source/Trace.d ./source/Trace.o ./source/UART_HAL.d ./source/UART_HAL.o ./source/Utilities.d ./source/Utilities.o ./source/ecat_cycle.d ./source/ecat_cycle.o ./source/ecat_eoe.d ./source/ecat_eoe.o ./source/ecat_foe.d ./source/ecat_foe.o ./source/ecat_gateway.d ./source/ecat_gateway.o ./source/ecat_mbx.d ./source/ecat_mbx.o ./source/enet_raw.d ./source/enet_raw.o ./source/main.d ./source/main.o ./source/rtos.d ./source/rtos.o ./source/semihost_hardfault.d ./source/semihost_hardfault.o
 
 .PHONY: clean-source
 
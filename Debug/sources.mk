@@ -16,7 +16,6 @@ OBJS :=
 SUBDIRS := \
 FreeRTOS/freertos_kernel \
 FreeRTOS/freertos_kernel/portable/GCC/ARM_CM4F \
-FreeRTOS/freertos_kernel/portable/MemMang \
 board \
 component/lists \
 component/serial_manager \
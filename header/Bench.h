@@ -0,0 +1,15 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include "enet_raw.h"
+
+// Helpers shared by the shell benchmarks and tools driving the Ethernet
+// interface themselves (enetbench, ecatbench, eoebench, gwbench, foe): a release
+// timed on the DWT cycle counter (cycles.h) and emptying the RX ring around a
+// run. The caller has suspended the task otherwise receiving on the interface.
+
+void Bench_WaitUntil(uint32_t release);
+void Bench_Drain(enet_raw_handle_t *handle);
+
+#endif /* BENCH_H */
@@ -0,0 +1,55 @@
+#ifndef CAN_BUSLOAD_H
+#define CAN_BUSLOAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Table sizes
+#define BUSLOAD_MAX_COB_IDS     (16U)
+#define BUSLOAD_HASH_SIZE       (32U)   // Power of two, at least twice BUSLOAD_MAX_COB_IDS
+#define BUSLOAD_JITTER_BUCKETS  (16U)   // Bucket k counts jitter in [2^(k-1), 2^k) us, bucket 0 is < 1 us
+
+// Statistics window
+#define BUSLOAD_WINDOW_NS       (1000000000ULL)
+
+// Per COB-ID statistics
+typedef struct {
+    uint16_t cob_id;
+    uint32_t frames;                // Since BusLoad_Init
+    uint32_t fps;                   // Frames in the last complete window
+    uint64_t last_rx_ns;            // 1588 time of the last frame
+    uint32_t last_interval_us;
+    uint32_t min_interval_us;
+    uint32_t max_interval_us;
+    uint32_t jitter_hist[BUSLOAD_JITTER_BUCKETS];   // |interval - previous interval|
+    uint32_t window_frames;         // Internal, frames in the current window
+} busload_cob_stats_t;
+
+// Bus-wide statistics
+typedef struct {
+    uint32_t bit_rate;
+    uint32_t frames;                // Since BusLoad_Init
+    uint32_t unknown_cob_ids;       // Frames dropped because the table was full
+    uint32_t load_permille;         // Bus utilisation over the last complete window
+    uint32_t peak_load_permille;
+    uint32_t max_queue_delay_us;    // Worst reception-to-processing delay
+    uint64_t window_start_ns;
+    uint32_t window_bits;           // Internal, bits on the bus in the current window
+} busload_stats_t;
+
+// Setup
+void BusLoad_Init(uint32_t bitRate);
+
+// Recording, called by the CAN task for every frame taken from the RX queue
+void BusLoad_Record(uint16_t cobId, uint8_t dlc, uint64_t rxTimeNs, uint64_t nowNs);
+void BusLoad_Update(uint64_t nowNs);
+
+// Results
+bool BusLoad_GetCobStats(uint16_t cobId, busload_cob_stats_t *stats);
+void BusLoad_GetStats(busload_stats_t *stats);
+uint32_t BusLoad_FrameBits(uint8_t dlc);
+
+// Debugging functions
+void BusLoad_Show(void);
+
+#endif /* CAN_BUSLOAD_H */
@@ -6,38 +6,52 @@
 #include "fsl_flexcan.h"
 #include "fsl_common.h"
 #include "fsl_clock.h"
+#include "FreeRTOS.h"
+#include "task.h"
 
 //CANopen Address IDs
 #define MOVES_ID    0x28A
 #define BUTTONS_ID  0x18A
 #define LED_ID      0x30A
 
-//TX and RX mailbox definitions for MOVES
-#define TX_MOVES_MAILBOX    (1UL)
+// Legacy RX FIFO occupies MB0-MB5, its 8-entry ID filter table MB6-MB7
+#define CAN_RX_FIFO_FILTER_NUM  (8U)
+#define CAN_FIRST_TX_MAILBOX    (8UL)
+
+// TX engine: every mailbox above the FIFO is in the pool (CAN0_config.maxMbNum = 16)
+#define CAN_TX_MAILBOX_END  (16UL)
+#define CAN_TX_QUEUE_SIZE   (16U)   // Power of two
+
+//Message IDs
 #define TX_MOVES_MSG_ID     (1UL)
-#define RX_MOVES_MAILBOX    (0UL)
 #define RX_MOVES_MSG_ID     (MOVES_ID)
-
-//TX and RX mailbox definitions for BUTTONS
-#define TX_BUTTONS_MAILBOX  (2UL)
 #define TX_BUTTONS_MSG_ID   (2UL)
-#define RX_BUTTONS_MAILBOX  (3UL)
 #define RX_BUTTONS_MSG_ID   (BUTTONS_ID)
-
-//TX and RX mailbox definitions for LED
-#define TX_LED_MAILBOX      (4UL)
 #define TX_LED_MSG_ID       (4UL)
-#define RX_LED_MAILBOX      (5UL)
 #define RX_LED_MSG_ID       (LED_ID)
 
+// RX queue between the FlexCAN ISR and the CAN task (power of two)
+#define CAN_RX_QUEUE_SIZE   (16U)
+
+// CAN ISR must stay below configMAX_SYSCALL_INTERRUPT_PRIORITY to notify tasks
+#define CAN_IRQ_PRIORITY    (6U)
+
+// Gateway layout of the EtherCAT output image and signal indexes for age tracking
+#define GW_IMAGE_AXE_X_BIT      (0U)
+#define GW_IMAGE_AXE_Y_BIT      (16U)
+#define GW_IMAGE_BUTTONS_BIT    (32U)
+#define GW_SIGNAL_AXE_X         (0U)
+#define GW_SIGNAL_AXE_Y         (1U)
+#define GW_SIGNAL_BUTTONS       (2U)
+
 // FlexCAN instance to use (adjust based on your hardware)
 #define FLEXCAN_INSTANCE    CAN0
 #define CAN0_PERIPHERAL     CAN0
 
 // Data structures for CAN messages
 typedef struct {
-    float Axe_X;
-    float Axe_Y;
+    uint16_t Axe_X;     // Hundredths of percent, 5000 = centre
+    uint16_t Axe_Y;
 } Moves;
 
 typedef struct {
@@ -60,19 +74,31 @@ extern Moves moves;
 extern Led led;
 extern Buttons buttons;
 
+// Prepared TX frame: everything but the data words
+typedef struct {
+    flexcan_frame_t frame;
+} can_tx_template_t;
+
 // Data transmission
-void SendCANData(uint32_t mailbox, uint32_t messageId, uint8_t * data, uint32_t len);
+void CAN_HAL_TxPrepare(can_tx_template_t *tpl, uint16_t cobId, uint8_t length);
+status_t CAN_HAL_TxSend(const can_tx_template_t *tpl, const uint8_t *data);
+status_t CAN_HAL_TxSendWords(const can_tx_template_t *tpl, uint32_t word0, uint32_t word1);
+void CAN_HAL_GetTxStats(uint32_t *sent, uint32_t *queued, uint32_t *dropped);
+void SendCANData(uint32_t messageId, uint8_t * data, uint32_t len);
 
-// Data reception
-status_t FLEXCAN_Receive_Moves(void);
-status_t FLEXCAN_Receive_Buttons(void);
-status_t FLEXCAN_Receive_Led(void);
+// Data reception (interrupt driven through the RX FIFO)
+status_t CAN_HAL_RxInit(TaskHandle_t notifyTask);
+uint32_t CAN_HAL_ProcessRx(void);
+uint32_t CAN_HAL_GetRxOverflows(void);
+uint64_t CAN_HAL_GetRxTime(uint16_t cobId);
 
 // Getter functions
-float get_Axe_X(void);
-float get_Axe_Y(void);
+uint16_t get_Axe_X(void);
+uint16_t get_Axe_Y(void);
 bool get_speed(void);
 bool get_enable(void);
+bool get_E_Stop(void);
+bool get_Horn(void);
 
 // Debugging functions
 void Show_movesRecvBuffer(void);
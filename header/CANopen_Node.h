@@ -0,0 +1,54 @@
+#ifndef CANOPEN_NODE_H
+#define CANOPEN_NODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fsl_common.h"
+
+// CANopen node of the master on the joystick bus
+#ifndef CANOPEN_NODE_ENABLE
+#define CANOPEN_NODE_ENABLE         1
+#endif
+
+#define CANOPEN_NODE_ID             (0x01U)
+#define CANOPEN_HEARTBEAT_MS        (1000U)     // Default of object 0x1017
+
+// Predefined connection set
+#define CANOPEN_COB_NMT             (0x000U)
+#define CANOPEN_COB_SDO_TX          (0x580U)    // Server -> client
+#define CANOPEN_COB_SDO_RX          (0x600U)    // Client -> server
+#define CANOPEN_COB_HEARTBEAT       (0x700U)
+
+// NMT states, as sent in the heartbeat
+typedef enum {
+    NMT_STATE_INITIALISING = 0x00,
+    NMT_STATE_STOPPED = 0x04,
+    NMT_STATE_OPERATIONAL = 0x05,
+    NMT_STATE_PRE_OPERATIONAL = 0x7F
+} nmt_state_t;
+
+// Object dictionary attributes
+#define OD_ATTR_READ                (0x01U)
+#define OD_ATTR_WRITE               (0x02U)
+#define OD_ATTR_RW                  (OD_ATTR_READ | OD_ATTR_WRITE)
+
+// Object dictionary entry. Entries are sorted by (index, subindex) for binary search
+typedef struct {
+    uint16_t index;
+    uint8_t subindex;
+    uint8_t attr;
+    uint8_t size;           // 1..4 bytes, SDO transfers are expedited only
+    void *data;
+} od_entry_t;
+
+// Setup, called from CAN_HAL_RxInit once the RPDO table exists and once TX is ready
+status_t CANopen_NodeInit(void);
+void CANopen_NodeStart(void);
+
+// State
+nmt_state_t CANopen_GetNmtState(void);
+
+// Object dictionary access
+const od_entry_t *CANopen_OdFind(uint16_t index, uint8_t subindex);
+
+#endif /* CANOPEN_NODE_H */
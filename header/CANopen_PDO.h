@@ -0,0 +1,65 @@
+#ifndef CANOPEN_PDO_H
+#define CANOPEN_PDO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fsl_flexcan.h"
+
+// Table sizes
+#define PDO_MAX_MAPPINGS    (16U)
+#define PDO_HASH_SIZE       (32U)   // Power of two, at least twice PDO_MAX_MAPPINGS
+
+// Destination type of a mapped object
+typedef enum {
+    PDO_TYPE_BOOL = 0,      // bool, any bit length (non-zero = true)
+    PDO_TYPE_U8,
+    PDO_TYPE_U16,
+    PDO_TYPE_S16,           // Sign extended from bit_length
+    PDO_TYPE_U32,
+    PDO_TYPE_S32,           // Sign extended from bit_length
+    PDO_TYPE_FLOAT          // Unsigned raw value multiplied by scale
+} pdo_type_t;
+
+// Return Status Codes
+typedef enum {
+    PDO_SUCCESS = 0,
+    PDO_ERROR_INVALID_PARAM = -1,
+    PDO_ERROR_TABLE_FULL = -2,
+    PDO_ERROR_DUPLICATE = -3,
+    PDO_ERROR_UNKNOWN_COB_ID = -4
+} pdo_status_t;
+
+// One mapped object inside a PDO. Bit offsets follow CANopen: bit 0 is the LSB of data byte 0
+typedef struct {
+    uint8_t bit_offset;
+    uint8_t bit_length;     // 1..32
+    pdo_type_t type;
+    void *data;             // Destination for an RPDO, source for a TPDO
+    float scale;            // PDO_TYPE_FLOAT only
+} pdo_map_entry_t;
+
+typedef struct pdo_mapping pdo_mapping_t;
+
+// Called after every mapped object of an RPDO has been written
+typedef void (*pdo_callback_t)(const pdo_mapping_t *pdo);
+
+// PDO mapping: a COB-ID and the list of objects it carries
+struct pdo_mapping {
+    uint16_t cob_id;
+    uint8_t entry_count;
+    const pdo_map_entry_t *entries;
+    flexcan_frame_t *last_frame;    // Optional copy of the last raw frame (debugging)
+    pdo_callback_t callback;        // Optional
+};
+
+// RPDO table
+pdo_status_t PDO_Init(const pdo_mapping_t *rpdos, uint32_t count);
+pdo_status_t PDO_Register(const pdo_mapping_t *rpdo);
+uint32_t PDO_GetCount(void);
+uint16_t PDO_GetCobId(uint32_t index);
+
+// Decoding / encoding
+pdo_status_t PDO_Dispatch(const flexcan_frame_t *frame);
+pdo_status_t PDO_Encode(const pdo_mapping_t *tpdo, flexcan_frame_t *frame);
+
+#endif /* CANOPEN_PDO_H */
@@ -0,0 +1,68 @@
+#ifndef CYCLIC_TASK_H
+#define CYCLIC_TASK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fsl_common.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Periodic tasks released on absolute tick times (xTaskDelayUntil), so the
+// period does not drift with the execution time. Every cycle is timed with the
+// DWT cycle counter against its ideal release time:
+//   jitter    = start of the step - ideal release
+//   execution = end of the step - start of the step
+//   response  = end of the step - ideal release, compared with the deadline
+// Periods are whole ticks (configTICK_RATE_HZ = 1000, so 1 ms resolution).
+
+// Registry
+#define CYCLIC_MAX_TASKS        (8U)
+#define CYCLIC_HIST_BUCKETS     (16U)   // Bucket k counts [2^(k-1), 2^k) us, bucket 0 is < 1 us
+
+typedef void (*cyclic_step_t)(void *arg);
+
+typedef struct {
+    const char *name;
+    uint32_t period_ms;
+    uint32_t deadline_us;           // Response time limit, 0 = the period
+    uint32_t budget_us;             // Execution time limit, 0 = not checked
+    cyclic_step_t step;             // One cycle of work, must not block
+    void *arg;
+} cyclic_task_config_t;
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t deadline_misses;
+    uint32_t budget_overruns;
+    uint32_t skipped_periods;       // Releases dropped because the task was a full period late
+    uint32_t exec_max_us;
+    uint32_t jitter_max_us;
+    uint32_t response_max_us;
+    uint32_t exec_hist[CYCLIC_HIST_BUCKETS];
+    uint32_t jitter_hist[CYCLIC_HIST_BUCKETS];
+} cyclic_task_stats_t;
+
+typedef struct {
+    const cyclic_task_config_t *config;
+    TaskHandle_t handle;
+    cyclic_task_stats_t stats;
+    volatile bool resetRequest;     // Set by CyclicTask_ResetStats, cleared by the task
+    StaticTask_t tcb;               // Used by CyclicTask_Create only
+} cyclic_task_t;
+
+// Start a new task that runs config->step every period, on a static stack
+status_t CyclicTask_Create(cyclic_task_t *task, const cyclic_task_config_t *config,
+                           UBaseType_t priority, StackType_t *stack, uint32_t stackDepth,
+                           TaskHandle_t *handle);
+
+// Turn the calling task into a cyclic task after its own setup. Never returns.
+void CyclicTask_Run(cyclic_task_t *task, const cyclic_task_config_t *config);
+
+// Statistics
+void CyclicTask_GetStats(const cyclic_task_t *task, cyclic_task_stats_t *stats);
+void CyclicTask_ResetStats(cyclic_task_t *task);
+
+// Debugging functions
+void CyclicTask_Show(void);
+
+#endif /* CYCLIC_TASK_H */
@@ -0,0 +1,40 @@
+#ifndef ECAT_BENCH_H
+#define ECAT_BENCH_H
+
+#include <stdint.h>
+#include "enet_raw.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Cycle-time capability of the master ("ecatbench" shell command): the shortest
+// EtherCAT period sustained for each process image size. A BRD counts the
+// slaves, then for every image size and period one LRW of the whole image is
+// exchanged per cycle for ECATBENCH_DEFAULT_POINT_MS. A point is sustained when
+// no cycle missed its deadline (frame back before the next release), the working
+// counter never differed from the one of a warm-up exchange, and the release
+// jitter stayed within the bound.
+//
+// Releases are timed on the DWT cycle counter (tick sleep, then a spin for the
+// last tick), so periods below the tick work, and the run takes a task priority
+// given as the third argument, the EtherCAT task priority by default. Tasks
+// below it do not run during a point: at the default, the CAN task and the
+// timer task (priority 2) stop, so joystick setpoints freeze, the CANopen
+// heartbeat is not sent and CAN frames beyond the RX queue are lost, and the
+// logger stops. The run sleeps ECATBENCH_POINT_GAP_MS after each point so they
+// catch up; ms_per_point bounds the outage. At priority 2 or 1 they preempt the
+// run and their load shows in the jitter instead. The Ethernet RX task is
+// suspended meanwhile. Against the simulated segment (sim/) the slave count
+// and the bytes each slave maps come from SIM_ECAT_SLAVES and SIM_ECAT_PD_BYTES;
+// a real segment must be configured with its FMMUs at logical address 0, else
+// LRW is answered with WKC 0, still a valid timing run.
+
+#define ECATBENCH_DEFAULT_JITTER_US (50U)
+#define ECATBENCH_DEFAULT_POINT_MS  (500U)      // Run time of one period and size
+#define ECATBENCH_MAX_POINT_MS      (10000U)
+#define ECATBENCH_WARMUP_US         (10000U)    // Reply timeout of the BRD and warm-up LRW
+#define ECATBENCH_POINT_GAP_MS      (20U)       // Sleep after each point, for the tasks below the run
+
+void EcatBench_Init(enet_raw_handle_t *handle, TaskHandle_t rxTask);
+void EcatBench_Run(uint32_t jitterUs, uint32_t pointMs, UBaseType_t runPriority);
+
+#endif /* ECAT_BENCH_H */
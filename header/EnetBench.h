@@ -0,0 +1,37 @@
+#ifndef ENET_BENCH_H
+#define ENET_BENCH_H
+
+#include <stdint.h>
+#include "enet_raw.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Benchmark of the enet_raw TX and RX paths ("enetbench" shell command). For each
+// frame size, synthetic EtherCAT frames (one BRD datagram) go out with
+// enet_raw_send_frame() and come back through enet_raw_receive_frame():
+//   - ping-pong: one frame in flight, CPU cycles of each call and the round
+//     trip latency percentiles (p50/p99/p999)
+//   - stream: ENETBENCH_WINDOW frames in flight, frames/s and wire Mbit/s
+// Receive is polled (timeout 0) so the cycles of a call are its processing time,
+// not the wait. Timing is the DWT cycle counter, the same code runs on the board
+// (frames through the EtherCAT segment, or a loopback plug) and on the host
+// simulation (sim/, the simulated segment). The rest of the firmware keeps
+// running, its preemption shows in the tail; only the Ethernet RX task, which
+// would take the frames, is suspended meanwhile. Frames of other senders are
+// released and counted as foreign. Lost counts the frames not back within
+// ENETBENCH_TIMEOUT_US and the sends that failed.
+
+#define ENETBENCH_DEFAULT_FRAMES    (1000U)     // Per size and mode, p999 wants 1000+
+#define ENETBENCH_MAX_FRAMES        (100000U)
+#define ENETBENCH_WINDOW            (ENET_RAW_RXBD_NUM / 2U)    // Stream frames in flight
+#define ENETBENCH_TIMEOUT_US        (10000U)    // A frame not back by then is lost
+
+// Latency histogram: exact below 16 cycles, then 16 buckets per power of two,
+// percentiles are bucket upper bounds, at most 1/16 high
+#define ENETBENCH_HIST_SUB_BITS     (4U)
+#define ENETBENCH_HIST_SIZE         ((32U - ENETBENCH_HIST_SUB_BITS + 1U) << ENETBENCH_HIST_SUB_BITS)
+
+void EnetBench_Init(enet_raw_handle_t *handle, TaskHandle_t rxTask);
+void EnetBench_Run(uint32_t frames);
+
+#endif /* ENET_BENCH_H */
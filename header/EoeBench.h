@@ -0,0 +1,35 @@
+#ifndef EOE_BENCH_H
+#define EOE_BENCH_H
+
+#include <stdint.h>
+#include "ecat_cycle.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// EoE throughput of the master ("eoebench" shell command). The slaves are
+// scanned and moved to PREOP, then an EoE endpoint (ecat_eoe.h) is attached to
+// the first slave with a mailbox and driven by the cyclic frame builder
+// (ecat_cycle.h): one frame per period, the process image LRW first and the EoE
+// fragments in the spare bytes. For each frame size, numbered test frames go out
+// one after the other and must come back in order and intact from an EoE
+// loopback slave; the report is the frames intact, the cycles per frame and the
+// one-way throughput.
+//
+// Like ecatbench, the run takes the EtherCAT task priority, releases are timed
+// on the DWT cycle counter, and the Ethernet RX task is suspended meanwhile. The
+// simulated segment (sim/) echoes EoE frames on every slave, with the mailbox
+// size of SIM_ECAT_MBX_SIZE; a real segment needs an EoE slave whose switch
+// port returns the test frames. The slaves are back in INIT afterwards.
+
+#define EOEBENCH_DEFAULT_FRAMES     (20U)       // Per frame size
+#define EOEBENCH_MAX_FRAMES         (1000U)
+#define EOEBENCH_DEFAULT_PERIOD_US  (1000U)
+#define EOEBENCH_MIN_PERIOD_US      (125U)
+#define EOEBENCH_IDLE_CYCLES        (1000U)     // Cycles without an echo before a size is given up
+#define EOEBENCH_TIMEOUT_US         (10000U)    // Reply timeout of the scan and state changes
+#define EOEBENCH_ETHERTYPE          (0x88B5U)   // Local experimental, test frames only
+
+void EoeBench_Init(ecat_cycle_t *cycle, TaskHandle_t rxTask);
+void EoeBench_Run(uint32_t frames, uint32_t periodUs);
+
+#endif /* EOE_BENCH_H */
@@ -0,0 +1,35 @@
+#ifndef FOE_UPDATE_H
+#define FOE_UPDATE_H
+
+#include <stdint.h>
+#include "ecat_cycle.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Firmware update of the slaves over FoE ("foe" shell command). The image is
+// read in place from the second 512 KB block of the program flash, which the
+// application must stay clear of (it is far smaller); it is written there
+// beforehand with the debugger. The slaves are scanned, their standard mailbox
+// size read in PREOP, then they are requested to BOOT and the receive mailbox
+// for the download chosen with ecat_foe_select_mbx_size(). Up to
+// ECAT_FOE_MAX_SESSIONS slaves are then written in parallel by the FoE engine
+// (ecat_foe.h), one session per slave, driven by the cyclic frame builder
+// (ecat_cycle.h): each period one frame carries a mailbox to and from every
+// slave as far as the spare bytes allow. The report gives the result of each
+// slave and the aggregate throughput; the slaves are left in INIT.
+//
+// Like ecatbench, the run takes the EtherCAT task priority and the Ethernet RX
+// task is suspended meanwhile. On the host simulation (sim/) the flash block
+// comes from SIM_FLASH_IMAGE and the simulated bootloaders compare every file
+// with it, printing the outcome on stderr.
+
+#define FOEUPDATE_IMAGE_ADDR        (0x00080000UL)
+#define FOEUPDATE_IMAGE_SIZE        (0x00080000UL)
+#define FOEUPDATE_PERIOD_US         (1000U)     // Frame builder cycle during the download
+#define FOEUPDATE_TIMEOUT_US        (10000U)    // Reply timeout of the scan and state changes
+#define FOEUPDATE_BOOT_TIMEOUT_US   (3000000U)  // Bootloaders may take a while to start
+
+void FoeUpdate_Init(ecat_cycle_t *cycle, TaskHandle_t rxTask);
+void FoeUpdate_Run(const char *filename, uint32_t bytes, uint8_t window);
+
+#endif /* FOE_UPDATE_H */
@@ -0,0 +1,35 @@
+#ifndef GATEWAY_BENCH_H
+#define GATEWAY_BENCH_H
+
+#include <stdint.h>
+#include "ecat_cycle.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// CAN to EtherCAT latency of the gateway ("gwbench" shell command). The slaves
+// are scanned, then the cyclic frame builder (ecat_cycle.h) runs with the
+// gateway output image (ecat_gateway.h) as the LRW outputs: every cycle takes an
+// ecat_gw_snapshot() right before ecat_cycle_exchange() builds the frame. On
+// each fresh snapshot, every signal updated since the previous one is aged from
+// its CAN reception stamp to the send, on the 1588 time base. The report gives
+// the age per signal, which is the CAN-to-wire latency, and the frames the
+// FlexCAN ISR routed meanwhile. This is the only consumer of the gateway image in
+// the firmware: routed signals go out on EtherCAT only while it runs, the
+// periodic Ethernet test cycle (main.c) sends test frames only.
+//
+// Like ecatbench, the run takes the EtherCAT task priority, releases are timed
+// on the DWT cycle counter, and the Ethernet RX task is suspended meanwhile.
+// Needs CAN traffic on a routed COB-ID: the joystick, or on the simulation (sim/)
+// its simulated node. A real segment needs the slaves' FMMUs mapping logical
+// address 0, the frame builder does not configure them.
+
+#define GWBENCH_DEFAULT_CYCLES      (1000U)
+#define GWBENCH_MAX_CYCLES          (100000U)
+#define GWBENCH_DEFAULT_PERIOD_US   (1000U)
+#define GWBENCH_MIN_PERIOD_US       (125U)
+#define GWBENCH_TIMEOUT_US          (10000U)    // Reply timeout of the scan
+
+void GatewayBench_Init(ecat_cycle_t *cycle, TaskHandle_t rxTask);
+void GatewayBench_Run(uint32_t cycles, uint32_t periodUs);
+
+#endif /* GATEWAY_BENCH_H */
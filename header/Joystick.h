@@ -0,0 +1,55 @@
+#ifndef JOYSTICK_H
+#define JOYSTICK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Joystick axes arrive as unsigned hundredths of percent: 0..10000, centred on 5000
+#define JOY_RAW_CENTER          (5000)
+#define JOY_RAW_HALF_RANGE      (5000)
+
+// Drive setpoint shaping
+#define JOY_DEADBAND_Q15        (983)       // 3% of full stroke
+#define JOY_MAX_SETPOINT        (1000)      // Setpoint at full stroke (per mille)
+#define JOY_RATE_LIMIT          (50)        // Max setpoint change per MOVES sample
+
+// Set to 1 to run the fixed-point vs float benchmark when the CAN task starts
+#ifndef JOYSTICK_BENCHMARK
+#define JOYSTICK_BENCHMARK      0
+#endif
+
+#define JOY_Q15_MAX             (32767)
+
+// Per-axis constants. Every division is folded into a multiply-shift at compile time
+typedef struct {
+    int32_t center;
+    int32_t halfRange;
+    int32_t normMul;        // Q15 per raw count, << 16
+    int32_t deadband;       // Q15
+    uint32_t deadbandMul;   // Re-expansion after the deadband, Q15
+    int32_t maxSetpoint;
+    int32_t rateLimit;
+} joystick_axis_cfg_t;
+
+#define JOY_AXIS_CONFIG(center, halfRange, deadbandQ15, maxSetpoint, rateLimit)        \
+    { (center), (halfRange),                                                           \
+      (int32_t)(((uint32_t)JOY_Q15_MAX << 16) / (uint32_t)(halfRange)),               \
+      (deadbandQ15),                                                                   \
+      (uint32_t)(((uint32_t)JOY_Q15_MAX << 15) / (uint32_t)(JOY_Q15_MAX - (deadbandQ15))), \
+      (maxSetpoint), (rateLimit) }
+
+// Per-axis state (rate limiter memory)
+typedef struct {
+    int16_t setpoint;
+} joystick_axis_t;
+
+// Signal pipeline
+int16_t Joystick_ToQ15(const joystick_axis_cfg_t *cfg, uint16_t raw);
+int16_t Joystick_Process(const joystick_axis_cfg_t *cfg, joystick_axis_t *axis, uint16_t raw);
+void Joystick_Update(uint16_t rawX, uint16_t rawY);
+void Joystick_GetSetpoints(int16_t *setpointX, int16_t *setpointY);
+
+// Benchmark of the fixed-point path against the previous float conversion
+void Joystick_Benchmark(void);
+
+#endif /* JOYSTICK_H */
@@ -0,0 +1,20 @@
+#ifndef MEM_BENCH_H
+#define MEM_BENCH_H
+
+#include <stdint.h>
+
+// CPU access cost of SRAM_L against SRAM_U ("membench" shell command). The same
+// frame-sized read, write and copy kernels run alternately on a buffer in each
+// half, timed with the DWT cycle counter, interrupts enabled. Run it while the
+// EtherCAT traffic is up to see what ENET DMA contention costs in SRAM_U; the
+// per-cycle effect of the placement shows in "cycle" and "prof" when the same
+// traffic is compared against a MEM_PLACEMENT_ENABLED 0 build.
+
+#define MEMBENCH_BUFFER_SIZE        (1536U)     // One ENET buffer
+#define MEMBENCH_DEFAULT_RUNS       (256U)
+#define MEMBENCH_MAX_RUNS           (65536U)
+
+void MemBench_Init(void);
+void MemBench_Run(uint32_t runs);
+
+#endif /* MEM_BENCH_H */
@@ -0,0 +1,74 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include "cycles.h"
+
+// Hot path profiler on the DWT cycle counter. A probe is a begin/end pair in
+// one block:
+//   PROF_BEGIN(ENET_TX);
+//   ...measured code...
+//   PROF_END(ENET_TX);
+// PROF_BEGIN is one counter load into a local, PROF_END one load and a call
+// that folds the difference into the probe statistics with interrupts masked
+// (about 30 cycles), so probes can sit in tasks and ISRs alike. With
+// PROFILER_ENABLED 0 both expand to nothing. Results: "prof" shell command.
+
+// Probes are built in debug builds unless set explicitly
+#ifndef PROFILER_ENABLED
+#ifdef DEBUG
+#define PROFILER_ENABLED        1
+#else
+#define PROFILER_ENABLED        0
+#endif
+#endif
+
+#define PROF_HIST_BUCKETS       (16U)   // Bucket k counts [2^(k-1), 2^k) cycles, the last one everything above
+
+// Probe ids, add the name to profProbeNames in Profiler.c as well
+typedef enum {
+    PROF_PROBE_ENET_RX = 0,     // enet_raw_receive_frame once a frame is signalled, drops included
+    PROF_PROBE_ENET_TX,         // ENET_SendFrame
+    PROF_PROBE_LOG_WRITE,       // Log ring push
+    PROF_PROBE_LOG_DEFER,       // UART_DPRINTF call site
+    PROF_PROBE_LOG_FLUSH,       // Rendering of one deferred entry
+    PROF_PROBE_GW_ROUTE,        // ecat_gw_route_frame, CAN frame into the process image
+    PROF_PROBE_COUNT
+} prof_probe_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint32_t hist[PROF_HIST_BUCKETS];
+} prof_stats_t;
+
+#if PROFILER_ENABLED
+
+// The probe name is pasted at once so it can never be expanded as a macro
+#define PROF_BEGIN(probe)       uint32_t profStart_##probe = Cycles_Now()
+#define PROF_END(probe)         Profiler_Record(PROF_PROBE_##probe, Cycles_Now() - profStart_##probe)
+
+// Setup, before the scheduler starts
+void Profiler_Init(void);
+
+// Recording, through PROF_END
+void Profiler_Record(prof_probe_t probe, uint32_t cycles);
+
+// Results
+void Profiler_GetStats(prof_probe_t probe, prof_stats_t *stats);
+void Profiler_Reset(void);
+
+// Debugging functions
+void Profiler_Show(void);
+
+#else
+
+#define PROF_BEGIN(probe)
+#define PROF_END(probe)
+#define Profiler_Init()
+
+#endif /* PROFILER_ENABLED */
+
+#endif /* PROFILER_H */
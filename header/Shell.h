@@ -0,0 +1,42 @@
+#ifndef SHELL_H
+#define SHELL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fsl_common.h"
+
+// Command table
+#define SHELL_MAX_COMMANDS      (24U)
+#define SHELL_HASH_SIZE         (64U)   // Power of two, at least twice SHELL_MAX_COMMANDS
+
+// Line input
+#define SHELL_LINE_SIZE         (80U)
+#define SHELL_MAX_ARGS          (8U)
+#define SHELL_PROMPT            "> "
+
+// Handler return values
+#define SHELL_OK                (0)
+#define SHELL_USAGE             (-1)    // Bad arguments, the shell prints the command help
+
+// argv[0] is the command name, arguments are split on spaces
+typedef int (*shell_handler_t)(int argc, char *argv[]);
+
+typedef struct {
+    const char *name;
+    const char *help;           // "args - description", printed by "help"
+    shell_handler_t handler;
+} shell_command_t;
+
+// Registration, from any task. The command must stay valid (static const)
+status_t Shell_RegisterCommand(const shell_command_t *command);
+
+// Dispatch of one line, the shell task calls it for every line received
+int Shell_Execute(char *line);
+
+// Helper for handlers: parse a decimal or 0x prefixed number
+bool Shell_ParseU32(const char *text, uint32_t *value);
+
+// Task reading UART0 through the RX ring
+void shell_task(void *pvParameters);
+
+#endif /* SHELL_H */
@@ -0,0 +1,87 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Kernel instrumentation, included by FreeRTOSConfig.h so it must stay free of
+// SDK and kernel headers.
+//
+// Run-time stats: the FreeRTOS run-time counter is the DWT cycle counter,
+// extended to 64 bits in software and scaled down by TRACE_RUNTIME_SHIFT so the
+// 32-bit kernel counter wraps after ~76 min instead of ~35 s. The extension
+// needs a read at least every 35 s, every context switch reads it.
+//
+// Trace recorder: the kernel switch-in hook and TRACE_ISR_ENTER/EXIT markers
+// append 8-byte events to a RAM ring. "trace start" arms it, "trace stop"
+// freezes it and "trace dump" prints the last TRACE_RING_SIZE events as text
+// for tools/tracedump. A switch-in also ends the previous task, so switch-out
+// events are not recorded.
+
+#define TRACE_RUNTIME_SHIFT     (7U)        // 120 MHz / 128 = 0.94 MHz run-time counter
+
+// Recorder built in debug builds unless set explicitly
+#ifndef TRACE_ENABLED
+#ifdef DEBUG
+#define TRACE_ENABLED           1
+#else
+#define TRACE_ENABLED           0
+#endif
+#endif
+
+#define TRACE_RING_SIZE         (1024U)     // Events, power of two (8 KB)
+#define TRACE_MAX_TASKS         (16U)       // Tasks listed by "tasks" and "trace dump"
+
+typedef enum {
+    TRACE_EVENT_SWITCH_IN = 1,  // id: FreeRTOS task number
+    TRACE_EVENT_ISR_ENTER = 2,  // id: trace_isr_t
+    TRACE_EVENT_ISR_EXIT  = 3
+} trace_event_type_t;
+
+typedef enum {
+    TRACE_ISR_UART = 0,
+    TRACE_ISR_CAN,
+    TRACE_ISR_ENET,
+    TRACE_ISR_COUNT
+} trace_isr_t;
+
+typedef struct {
+    uint32_t timestamp;         // DWT cycles
+    uint8_t type;               // trace_event_type_t
+    uint8_t id;
+    uint16_t reserved;
+} trace_event_t;
+
+// Setup, before the scheduler starts: registers the "tasks" and "trace" commands
+void Trace_Init(void);
+
+// FreeRTOS run-time counter (portCONFIGURE_TIMER_FOR_RUN_TIME_STATS / portGET_RUN_TIME_COUNTER_VALUE)
+void Trace_RunTimeInit(void);
+uint32_t Trace_RunTimeCounter(void);
+
+// Debugging functions
+void Trace_ShowTasks(void);
+
+#if TRACE_ENABLED
+
+// Kernel hook, from traceTASK_SWITCHED_IN
+void Trace_TaskSwitchedIn(uint32_t taskNumber);
+
+// ISR markers, first and last statement of the instrumented handlers
+void Trace_IsrEvent(trace_event_type_t type, trace_isr_t isr);
+#define TRACE_ISR_ENTER(isr)    Trace_IsrEvent(TRACE_EVENT_ISR_ENTER, (isr))
+#define TRACE_ISR_EXIT(isr)     Trace_IsrEvent(TRACE_EVENT_ISR_EXIT, (isr))
+
+// Recorder control
+void Trace_Start(void);
+void Trace_Stop(void);
+void Trace_Dump(void);
+
+#else
+
+#define TRACE_ISR_ENTER(isr)
+#define TRACE_ISR_EXIT(isr)
+
+#endif /* TRACE_ENABLED */
+
+#endif /* TRACE_H */
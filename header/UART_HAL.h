@@ -4,41 +4,37 @@
 #include "fsl_uart.h"
 #include "fsl_clock.h"
 #include "board.h"
+#include "FreeRTOS.h"
+#include "task.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
 
-#define BUFFER_SIZE 256U
-
-/*! Welcome message displayed at the console */
-#define welcomeMsg "\r\n\r\nThis example is a simple echo using UART\r\n\
-it will send back any character you send to it.\r\n\
-The board will greet you if you send 'Hello Board'\r\
-\nNow you can begin typing:\r\n"
-
-extern uint8_t buffer[BUFFER_SIZE];     /*!< RX buffer for console input */
-extern uint8_t bufferIdx;               /*!< Current index in RX buffer */
+#define UART_IRQ_PRIORITY           (7U)    /* Lowest urgency, below the CAN ISR */
+#define UART_TX_FIFO_WATERMARK      (2U)    /* TX interrupt fires when the FIFO drains to this */
+#define UART_RX_RING_SIZE           (128U)  /* Power of two */
 
 /*******************************************************************************
  * API Functions
  ******************************************************************************/
 
 /*!
- * @brief Check if data is available to read
- * @return true if data available, false otherwise
+ * @brief Enable interrupt-driven reception into the RX ring
+ * @param notifyTask Task notified (xTaskNotifyGive) when bytes arrive, may be NULL
  */
-bool UART_DataAvailable(void);
+void UART_RxInit(TaskHandle_t notifyTask);
 
 /*!
- * @brief Read a line from UART (blocking until newline or buffer full)
- * @return Number of bytes read
+ * @brief Take one received byte, never blocks
+ * @param ch Destination
+ * @return true if a byte was available
  */
-size_t UART_ReadLine(void);
+bool UART_RxGetChar(uint8_t *ch);
 
 /*!
- * @brief Clear the RX buffer
+ * @brief Bytes lost to a full RX ring or a hardware overrun
  */
-void UART_ClearBuffer(void);
+uint32_t UART_RxGetDropped(void);
 
 /*!
  * @brief Send message using blocking method
@@ -60,15 +56,13 @@ status_t UART_Write_NonBlocking(const char* message);
 void UART_Write(const char *message);
 
 /*!
- * @brief Echo received data back to sender with command processing
+ * @brief Configure the TX FIFO watermark and enable the UART0 interrupt
  */
-void UART_echo(void);
+void UART_TxInterruptInit(void);
 
 /*!
- * @brief Simple test function for development
- * @param data Character to test
- * @return true if data is 'b', false otherwise
+ * @brief Start sending queued log bytes from the TX interrupt
  */
-bool UART_HAL_send_data(char data);
+void UART_TxStart(void);
 
 #endif /*UART_HAL_H*/
@@ -9,20 +9,154 @@
 //==============================================================================
 // UART Logging System Configuration
 //==============================================================================
-#define UART_LOG_BUFFER_SIZE 4096
+#define UART_LOG_BUFFER_SIZE 4096        // Power of two
 #define UART_MAX_LOG_ENTRY_SIZE 64
+#define UART_LOG_DEFER_SLOTS 32          // Pending UART_DPRINTF entries, power of two
+
+// 0: the logger task formats deferred entries into text on UART0
+// 1: UART0 carries COBS framed binary records for the host decoder (log_record.h)
+#ifndef UART_LOG_BINARY
+#define UART_LOG_BINARY 0
+#endif
 
 //==============================================================================
 // UART Logging Macros
 //==============================================================================
 #define UART_LOG(msg) UART_LogMessage(msg)
 
+// Output longer than the buffer is cut short
 #define UART_PRINTF(fmt, ...) do { \
     char uart_log_buf[128]; \
-    sprintf(uart_log_buf, fmt, __VA_ARGS__); \
+    snprintf(uart_log_buf, sizeof(uart_log_buf), fmt, ##__VA_ARGS__); \
     UART_LogMessage(uart_log_buf); \
 } while(0)
 
+// Deferred printf for hot paths: stores the format string address, a timestamp
+// and up to 6 arguments as raw words, formatting happens later in the logger
+// task (or on the host in binary mode). Arguments must be integers or pointers
+// to strings that outlive the call (literals); no floats, no 64-bit integers.
+// A word is 32 bits on the target and pointer wide on a 64-bit host (sim/), so
+// %s arguments reach the logger task whole there too.
+#if UINTPTR_MAX > UINT32_MAX
+typedef uintptr_t uart_log_word_t;
+#else
+typedef uint32_t uart_log_word_t;
+#endif
+
+#define UART_DPRINTF(fmt, ...) do { \
+    UART_LogCheckFormat("" fmt "", ##__VA_ARGS__); \
+    const uart_log_word_t uart_log_args[] = { 0 UART_LOG_CAT(UART_LOG_ARGS_, UART_LOG_NARGS(0, ##__VA_ARGS__))(__VA_ARGS__) }; \
+    UART_LogDeferred("" fmt "", &uart_log_args[1], UART_LOG_NARGS(0, ##__VA_ARGS__)); \
+} while(0)
+
+// Lets the compiler check UART_DPRINTF arguments against the format as they are
+// passed, before they become words; generates no code. The words themselves
+// are formatted as they are: on a 64-bit host a %d or %X reads the low half of
+// a pointer wide word, which holds the converted argument.
+__attribute__((format(printf, 1, 2)))
+static inline void UART_LogCheckFormat(const char *format, ...)
+{
+    (void)format;
+}
+
+// Argument counting and conversion helpers for UART_DPRINTF
+#define UART_LOG_NARGS(...) UART_LOG_NARGS_(__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define UART_LOG_NARGS_(x, a, b, c, d, e, f, n, ...) n
+#define UART_LOG_CAT(a, b) UART_LOG_CAT_(a, b)
+#define UART_LOG_CAT_(a, b) a##b
+#define UART_LOG_WORD(x) ((uart_log_word_t)(uintptr_t)(x))
+#define UART_LOG_ARGS_0()
+#define UART_LOG_ARGS_1(a) , UART_LOG_WORD(a)
+#define UART_LOG_ARGS_2(a, b) UART_LOG_ARGS_1(a), UART_LOG_WORD(b)
+#define UART_LOG_ARGS_3(a, b, c) UART_LOG_ARGS_2(a, b), UART_LOG_WORD(c)
+#define UART_LOG_ARGS_4(a, b, c, d) UART_LOG_ARGS_3(a, b, c), UART_LOG_WORD(d)
+#define UART_LOG_ARGS_5(a, b, c, d, e) UART_LOG_ARGS_4(a, b, c, d), UART_LOG_WORD(e)
+#define UART_LOG_ARGS_6(a, b, c, d, e, f) UART_LOG_ARGS_5(a, b, c, d, e), UART_LOG_WORD(f)
+
+//==============================================================================
+// Log Levels and Modules
+//==============================================================================
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_VERBOSE 5
+
+// Calls above the compile level sit behind a constant false C if (LOG_ENABLED
+// below), which the compiler drops as dead code, arguments included. Each
+// module can override it with LOG_LEVEL_COMPILE_<module>
+#ifndef LOG_LEVEL_COMPILE
+#ifdef DEBUG
+#define LOG_LEVEL_COMPILE LOG_LEVEL_VERBOSE
+#else
+#define LOG_LEVEL_COMPILE LOG_LEVEL_DEBUG
+#endif
+#endif
+
+// Runtime level of every module after boot, see UART_LogSetLevel()
+#define LOG_LEVEL_DEFAULT LOG_LEVEL_INFO
+
+typedef enum {
+    LOG_MODULE_APP = 0,
+    LOG_MODULE_LOG,
+    LOG_MODULE_ENET,
+    LOG_MODULE_ECAT,
+    LOG_MODULE_CAN,
+    LOG_MODULE_CANOPEN,
+    LOG_MODULE_COUNT
+} log_module_t;
+
+#ifndef LOG_LEVEL_COMPILE_APP
+#define LOG_LEVEL_COMPILE_APP LOG_LEVEL_COMPILE
+#endif
+#ifndef LOG_LEVEL_COMPILE_LOG
+#define LOG_LEVEL_COMPILE_LOG LOG_LEVEL_COMPILE
+#endif
+#ifndef LOG_LEVEL_COMPILE_ENET
+#define LOG_LEVEL_COMPILE_ENET LOG_LEVEL_COMPILE
+#endif
+#ifndef LOG_LEVEL_COMPILE_ECAT
+#define LOG_LEVEL_COMPILE_ECAT LOG_LEVEL_COMPILE
+#endif
+#ifndef LOG_LEVEL_COMPILE_CAN
+#define LOG_LEVEL_COMPILE_CAN LOG_LEVEL_COMPILE
+#endif
+#ifndef LOG_LEVEL_COMPILE_CANOPEN
+#define LOG_LEVEL_COMPILE_CANOPEN LOG_LEVEL_COMPILE
+#endif
+
+extern volatile uint8_t uartLogLevels[LOG_MODULE_COUNT];
+
+// True if a call at this level would print. The first test is a constant, so a
+// call above the compile level is dead code; otherwise it costs one byte compare.
+// Module names are pasted straight away since some (ENET, ...) are also
+// peripheral macros that would expand if passed on as is
+#define LOG_ENABLED(module, level) \
+    LOG_ENABLED_(LOG_LEVEL_COMPILE_##module, LOG_MODULE_##module, level)
+#define LOG_ENABLED_(compileLevel, moduleId, level) \
+    (((level) <= (compileLevel)) && ((level) <= uartLogLevels[moduleId]))
+
+#define LOG_PRINTF(module, level, fmt, ...) \
+    LOG_PRINTF_(LOG_LEVEL_COMPILE_##module, LOG_MODULE_##module, level, fmt, ##__VA_ARGS__)
+#define LOG_PRINTF_(compileLevel, moduleId, level, fmt, ...) do { \
+    if (LOG_ENABLED_(compileLevel, moduleId, level)) { \
+        UART_PRINTF(fmt, ##__VA_ARGS__); \
+    } \
+} while(0)
+
+// Usage: LOG_WARN(ENET, "Link down\r\n"); module names without the LOG_MODULE_ prefix
+#define LOG_ERROR(module, fmt, ...) \
+    LOG_PRINTF_(LOG_LEVEL_COMPILE_##module, LOG_MODULE_##module, LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_WARN(module, fmt, ...) \
+    LOG_PRINTF_(LOG_LEVEL_COMPILE_##module, LOG_MODULE_##module, LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_INFO(module, fmt, ...) \
+    LOG_PRINTF_(LOG_LEVEL_COMPILE_##module, LOG_MODULE_##module, LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(module, fmt, ...) \
+    LOG_PRINTF_(LOG_LEVEL_COMPILE_##module, LOG_MODULE_##module, LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_VERBOSE(module, fmt, ...) \
+    LOG_PRINTF_(LOG_LEVEL_COMPILE_##module, LOG_MODULE_##module, LOG_LEVEL_VERBOSE, fmt, ##__VA_ARGS__)
+
 //==============================================================================
 // UART Logging System Functions
 //==============================================================================
@@ -31,13 +165,21 @@
 void UART_LogInit(void);
 void UART_LogSetEnabled(bool enabled);
 bool UART_LogIsEnabled(void);
+void UART_LogSetLevel(log_module_t module, uint8_t level);
+uint8_t UART_LogGetLevel(log_module_t module);
 
 // Core logging functions
 void UART_LogMessage(const char* message);
+void UART_LogDeferred(const char *format, const uart_log_word_t *args, uint32_t argc);
 void UART_LogProcess(void);
 
 // Status and utility functions
 bool UART_LogHasMessages(void);
+uint32_t UART_LogGetDropped(void);
+
+// Transmitter side, used by the UART TX interrupt
+uint16_t UART_LogPeek(const uint8_t **data);
+void UART_LogConsume(uint16_t count);
 
 //==============================================================================
 // Utility Functions
@@ -0,0 +1,40 @@
+#ifndef CYCLES_H
+#define CYCLES_H
+
+#include <stdint.h>
+#include "fsl_common.h"
+
+// Cycle-accurate timing with the DWT cycle counter (core clock, 120 MHz).
+// 32 bits wrap after ~35 s, differences of two readings are valid below that.
+
+#define CYCLES_PER_US           (SystemCoreClock / 1000000U)
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Cycles_Init
+ * Description   : Start the cycle counter. Idempotent, never resets the count
+ *                 so other users keep a monotonic time base.
+ *
+ *END**************************************************************************/
+static inline void Cycles_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t Cycles_Now(void)
+{
+    return DWT->CYCCNT;
+}
+
+static inline uint32_t Cycles_ToUs(uint32_t cycles)
+{
+    return cycles / CYCLES_PER_US;
+}
+
+static inline uint32_t Cycles_FromUs(uint32_t us)
+{
+    return us * CYCLES_PER_US;
+}
+
+#endif /* CYCLES_H */
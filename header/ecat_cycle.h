@@ -0,0 +1,176 @@
+/*
+ * EtherCAT Cyclic Frame Builder for FRDM-K64F
+ * One frame per cycle: the process image first, mailbox traffic in the spare bytes
+ */
+
+#ifndef ECAT_CYCLE_H
+#define ECAT_CYCLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "enet_raw.h"
+#include "ecat_mbx.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define ECAT_CYCLE_MAX_SLAVES       16
+#define ECAT_CYCLE_MAX_IMAGE        256   /* Process image bytes, each direction */
+#define ECAT_CYCLE_FRAME_BUDGET     (ETHERCAT_MAX_FRAME_SIZE - 4)  /* Frame bytes without FCS */
+#define ECAT_CYCLE_STATION_BASE     0x1001U  /* Station address of the first slave */
+#define ECAT_CYCLE_MAX_DATAGRAMS    (1 + 3 * ECAT_CYCLE_MAX_SLAVES)
+
+/* AL states (ETG.1000.6) */
+#define ECAT_AL_STATE_INIT          0x01U
+#define ECAT_AL_STATE_PREOP         0x02U
+#define ECAT_AL_STATE_BOOT          0x03U
+#define ECAT_AL_STATE_SAFEOP        0x04U
+#define ECAT_AL_STATE_OP            0x08U
+
+/* Return Status Codes */
+typedef enum {
+    ECAT_CYCLE_SUCCESS = 0,
+    ECAT_CYCLE_ERROR_INVALID_PARAM = -1,
+    ECAT_CYCLE_ERROR_SEND = -2,
+    ECAT_CYCLE_ERROR_TIMEOUT = -3,      /* Frame not back before the deadline */
+    ECAT_CYCLE_ERROR_WKC = -4,          /* Not every slave answered */
+    ECAT_CYCLE_ERROR_STATE = -5         /* AL state not reached */
+} ecat_cycle_status_t;
+
+/*
+ * Mailbox protocol attached to one slave. fill() stages a mailbox into the frame
+ * if one is ready and the spare bytes hold it, returning its length (0: nothing
+ * staged); confirm() reports whether the slave took it; receive() hands over a
+ * mailbox read back from the slave.
+ */
+typedef struct {
+    uint16_t (*fill)(void *ctx, uint8_t *buf, uint16_t spare_bytes);
+    void (*confirm)(void *ctx, bool accepted);
+    void (*receive)(void *ctx, const uint8_t *mbx, uint16_t length);
+} ecat_mbx_client_t;
+
+/* Slave found by ecat_cycle_scan() */
+typedef struct {
+    uint16_t station_addr;
+    uint16_t sm0_addr;          /* Receive mailbox (master -> slave), 0 size = none */
+    uint16_t sm0_size;
+    uint16_t sm1_addr;          /* Send mailbox (slave -> master) */
+    uint16_t sm1_size;
+    bool in_full;               /* SM1 status of the last cycle */
+    const ecat_mbx_client_t *client;
+    void *ctx;
+} ecat_cycle_slave_t;
+
+/* Cycle Statistics */
+typedef struct {
+    uint32_t cycles;            /* Frames exchanged */
+    uint32_t lost;              /* Frames not back before the deadline */
+    uint32_t mbx_written;       /* Mailboxes taken by the slaves */
+    uint32_t mbx_busy;          /* Mailbox writes refused, SM0 still full */
+    uint32_t mbx_read;          /* Mailboxes read from the slaves */
+    uint32_t mbx_deferred;      /* Mailbox slots left for a later cycle, frame full */
+    uint16_t lrw_wkc;           /* Working counter of the last process image exchange */
+} ecat_cycle_stats_t;
+
+/* Datagram staged in the current frame */
+typedef struct {
+    uint16_t offset;            /* Datagram header in the frame */
+    uint16_t length;            /* Data bytes */
+    uint8_t slave;
+    uint8_t kind;
+} ecat_cycle_datagram_t;
+
+/* Cyclic Frame Builder */
+typedef struct {
+    enet_raw_handle_t *handle;
+
+    ecat_cycle_slave_t slaves[ECAT_CYCLE_MAX_SLAVES];
+    uint16_t slave_count;
+
+    /* Process image, exchanged by one LRW at logical address 0 */
+    uint8_t outputs[ECAT_CYCLE_MAX_IMAGE];
+    uint8_t inputs[ECAT_CYCLE_MAX_IMAGE];
+    uint16_t image_size;
+
+    /* Frame of the current cycle */
+    uint8_t frame[ETHERCAT_MAX_FRAME_SIZE];
+    uint16_t length;
+    uint16_t budget;            /* Bytes the frame may use */
+    ecat_cycle_datagram_t datagrams[ECAT_CYCLE_MAX_DATAGRAMS];
+    uint16_t datagram_count;
+    uint16_t next_slot;         /* Mailbox rotation resumes at this slave */
+    uint8_t index;
+
+    ecat_cycle_stats_t stats;
+} ecat_cycle_t;
+
+/*******************************************************************************
+ * API Functions
+ ******************************************************************************/
+
+/**
+ * @brief Initialize a frame builder on an initialized interface
+ * @param cycle Pointer to frame builder
+ * @param handle Interface the frames go out on
+ * @param image_size Process image bytes exchanged every cycle (0 = no LRW)
+ * @return ECAT_CYCLE_SUCCESS on success, error code otherwise
+ */
+ecat_cycle_status_t ecat_cycle_init(ecat_cycle_t *cycle, enet_raw_handle_t *handle, uint16_t image_size);
+
+/**
+ * @brief Count the slaves, assign station addresses and read their mailbox sync managers
+ *
+ * Detaches every mailbox client and clears the statistics. Frames of other users
+ * must not be in flight.
+ *
+ * @param cycle Pointer to frame builder
+ * @param timeout_us Reply timeout of each register access
+ * @return ECAT_CYCLE_SUCCESS on success, error code otherwise
+ */
+ecat_cycle_status_t ecat_cycle_scan(ecat_cycle_t *cycle, uint32_t timeout_us);
+
+/**
+ * @brief Request an AL state from all slaves and check they reached it
+ *
+ * The mailbox sync managers are read again, the sizes may depend on the state.
+ *
+ * @param cycle Pointer to frame builder
+ * @param state ECAT_AL_STATE_xxx
+ * @param timeout_us Time the slaves are given to reach the state
+ * @return ECAT_CYCLE_SUCCESS on success, ECAT_CYCLE_ERROR_STATE if a slave did not follow
+ */
+ecat_cycle_status_t ecat_cycle_request_state(ecat_cycle_t *cycle, uint8_t state, uint32_t timeout_us);
+
+/**
+ * @brief Attach a mailbox protocol to a slave
+ * @param cycle Pointer to frame builder
+ * @param slave Slave position
+ * @param client Mailbox protocol (NULL detaches)
+ * @param ctx Passed back to the client
+ * @return ECAT_CYCLE_SUCCESS on success, ECAT_CYCLE_ERROR_INVALID_PARAM if the slave has no mailbox
+ */
+ecat_cycle_status_t ecat_cycle_attach(ecat_cycle_t *cycle, uint16_t slave,
+                                      const ecat_mbx_client_t *client, void *ctx);
+
+/**
+ * @brief Build, send and receive the frame of one cycle
+ *
+ * The frame holds the LRW of the process image, the SM1 status of every slave with
+ * a mailbox client, then mailbox reads and writes in turn as long as the spare
+ * bytes hold them. The clients are called with the outcome before returning.
+ *
+ * @param cycle Pointer to frame builder
+ * @param timeout_us Time the frame is given to come back
+ * @return ECAT_CYCLE_SUCCESS if the frame came back, error code otherwise
+ */
+ecat_cycle_status_t ecat_cycle_exchange(ecat_cycle_t *cycle, uint32_t timeout_us);
+
+/**
+ * @brief Get cycle statistics
+ * @param cycle Pointer to frame builder
+ * @param stats Pointer to statistics structure
+ */
+void ecat_cycle_get_stats(const ecat_cycle_t *cycle, ecat_cycle_stats_t *stats);
+
+#endif /* ECAT_CYCLE_H */
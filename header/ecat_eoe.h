@@ -0,0 +1,150 @@
+/*
+ * EtherCAT EoE (Ethernet over EtherCAT) Tunnel for FRDM-K64F
+ * Fragments and reassembles Ethernet frames through slave mailboxes
+ */
+
+#ifndef ECAT_EOE_H
+#define ECAT_EOE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ecat_mbx.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* EoE header follows the mailbox header (ETG.1000.6) */
+#define ECAT_EOE_HEADER_SIZE        4
+#define ECAT_EOE_MAX_FRAME_SIZE     1518
+#define ECAT_EOE_FRAGMENT_UNIT      32    /* Non-final fragments are multiples of 32 bytes */
+
+/* EoE frame types */
+#define ECAT_EOE_TYPE_FRAGMENT      0x00U
+#define ECAT_EOE_TYPE_INIT_REQ      0x02U
+#define ECAT_EOE_TYPE_INIT_RSP      0x03U
+
+/* Return Status Codes */
+typedef enum {
+    ECAT_EOE_SUCCESS = 0,
+    ECAT_EOE_ERROR_INVALID_PARAM = -1,
+    ECAT_EOE_ERROR_BUSY = -2,
+    ECAT_EOE_ERROR_FRAME_SIZE = -3,
+    ECAT_EOE_ERROR_PROTOCOL = -4
+} ecat_eoe_status_t;
+
+/* Callback invoked once a complete Ethernet frame has been reassembled */
+typedef void (*ecat_eoe_rx_callback_t)(const uint8_t *frame, uint16_t length, void *userData);
+
+/* Tunnel Statistics */
+typedef struct {
+    uint32_t tx_frames;       /* Ethernet frames fully sent */
+    uint32_t tx_fragments;    /* Mailbox fragments confirmed by the slave */
+    uint32_t tx_retries;      /* Fragments repeated because the mailbox was busy */
+    uint32_t tx_deferred;     /* Cycles where the spare bytes could not hold a mailbox */
+    uint32_t rx_frames;       /* Ethernet frames reassembled */
+    uint32_t rx_fragments;    /* Fragments received */
+    uint32_t rx_errors;       /* Out-of-sequence or malformed fragments */
+} ecat_eoe_stats_t;
+
+/* EoE Endpoint (one per EoE capable slave) */
+typedef struct {
+    /* Slave addressing */
+    uint16_t station_addr;
+    uint16_t mbx_size;          /* Slave receive mailbox size in bytes */
+    uint8_t port;
+    uint8_t mbx_counter;
+
+    /* Transmit state (master -> slave) */
+    uint8_t tx_frame[ECAT_EOE_MAX_FRAME_SIZE];
+    uint16_t tx_length;
+    uint16_t tx_offset;         /* Bytes confirmed so far */
+    uint16_t tx_staged;         /* Bytes in the fragment awaiting confirmation */
+    uint8_t tx_fragment;
+    uint8_t tx_frame_no;
+    bool tx_busy;
+
+    /* Receive state (slave -> master) */
+    uint8_t rx_frame[ECAT_EOE_MAX_FRAME_SIZE];
+    uint16_t rx_offset;
+    uint16_t rx_size;           /* Announced complete size, rounded to 32 bytes */
+    uint8_t rx_fragment;
+    uint8_t rx_frame_no;
+    bool rx_active;
+
+    ecat_eoe_rx_callback_t rx_callback;
+    void *userData;
+
+    ecat_eoe_stats_t stats;
+} ecat_eoe_endpoint_t;
+
+/*******************************************************************************
+ * API Functions
+ ******************************************************************************/
+
+/**
+ * @brief Initialize an EoE endpoint
+ * @param ep Pointer to endpoint
+ * @param station_addr Configured station address of the slave
+ * @param mbx_size Size of the slave receive mailbox in bytes
+ * @param rx_callback Called with each reassembled Ethernet frame (may be NULL)
+ * @param userData Passed back to rx_callback
+ * @return ECAT_EOE_SUCCESS on success, error code otherwise
+ */
+ecat_eoe_status_t ecat_eoe_init(ecat_eoe_endpoint_t *ep, uint16_t station_addr, uint16_t mbx_size,
+                                ecat_eoe_rx_callback_t rx_callback, void *userData);
+
+/**
+ * @brief Queue an Ethernet frame for tunnelling to the slave
+ * @param ep Pointer to endpoint
+ * @param frame Ethernet frame (without FCS)
+ * @param length Frame length in bytes
+ * @return ECAT_EOE_SUCCESS if queued, ECAT_EOE_ERROR_BUSY while a previous frame is in flight
+ */
+ecat_eoe_status_t ecat_eoe_send(ecat_eoe_endpoint_t *ep, const uint8_t *frame, uint16_t length);
+
+/**
+ * @brief Stage the next fragment into the spare bytes of a cyclic frame
+ *
+ * The fragment is only written if the whole mailbox fits in the spare bytes, so
+ * tunnelled traffic never lengthens the cycle. Nothing advances until
+ * ecat_eoe_tx_confirm() reports the outcome of the mailbox write.
+ *
+ * @param ep Pointer to endpoint
+ * @param buf Destination for the mailbox (mbx_size bytes are written)
+ * @param spare_bytes Bytes still free in the current cyclic frame
+ * @return Number of bytes written (the slave mailbox size), 0 if nothing was staged
+ */
+uint16_t ecat_eoe_fill_mailbox(ecat_eoe_endpoint_t *ep, uint8_t *buf, uint16_t spare_bytes);
+
+/**
+ * @brief Report the outcome of the mailbox write staged by ecat_eoe_fill_mailbox()
+ * @param ep Pointer to endpoint
+ * @param accepted true if the working counter shows the slave took the mailbox
+ */
+void ecat_eoe_tx_confirm(ecat_eoe_endpoint_t *ep, bool accepted);
+
+/**
+ * @brief Process a mailbox read back from the slave
+ * @param ep Pointer to endpoint
+ * @param mbx Mailbox contents, starting with the mailbox header
+ * @param length Number of valid bytes in mbx
+ * @return ECAT_EOE_SUCCESS if the fragment was accepted, error code otherwise
+ */
+ecat_eoe_status_t ecat_eoe_process_mailbox(ecat_eoe_endpoint_t *ep, const uint8_t *mbx, uint16_t length);
+
+/**
+ * @brief Check whether a frame is still being fragmented
+ * @param ep Pointer to endpoint
+ * @return true if a frame is in flight
+ */
+bool ecat_eoe_tx_pending(const ecat_eoe_endpoint_t *ep);
+
+/**
+ * @brief Get tunnel statistics
+ * @param ep Pointer to endpoint
+ * @param stats Pointer to statistics structure
+ */
+void ecat_eoe_get_stats(const ecat_eoe_endpoint_t *ep, ecat_eoe_stats_t *stats);
+
+#endif /* ECAT_EOE_H */
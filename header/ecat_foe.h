@@ -0,0 +1,189 @@
+/*
+ * EtherCAT FoE (File access over EtherCAT) Download Engine for FRDM-K64F
+ * Streams a flash-resident image to several slaves in parallel
+ */
+
+#ifndef ECAT_FOE_H
+#define ECAT_FOE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ecat_mbx.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* FoE header follows the mailbox header (ETG.1000.6) */
+#define ECAT_FOE_HEADER_SIZE        6
+#define ECAT_FOE_MAX_FILENAME       32
+
+/* Engine Configuration */
+#define ECAT_FOE_MAX_SESSIONS       8     /* Slaves updated in parallel */
+#define ECAT_FOE_DEFAULT_WINDOW     1     /* DATA packets in flight per slave (1 = strict FoE) */
+#define ECAT_FOE_MAX_WINDOW         4
+#define ECAT_FOE_TIMEOUT_CYCLES     500   /* Cycles without progress before resending */
+#define ECAT_FOE_MAX_RETRIES        5
+
+/* FoE opcodes */
+#define ECAT_FOE_OP_RRQ             1U
+#define ECAT_FOE_OP_WRQ             2U
+#define ECAT_FOE_OP_DATA            3U
+#define ECAT_FOE_OP_ACK             4U
+#define ECAT_FOE_OP_ERR             5U
+#define ECAT_FOE_OP_BUSY            6U
+
+/* Return Status Codes */
+typedef enum {
+    ECAT_FOE_SUCCESS = 0,
+    ECAT_FOE_ERROR_INVALID_PARAM = -1,
+    ECAT_FOE_ERROR_BUSY = -2,
+    ECAT_FOE_ERROR_PROTOCOL = -3,
+    ECAT_FOE_ERROR_SLAVE = -4,
+    ECAT_FOE_ERROR_TIMEOUT = -5
+} ecat_foe_status_t;
+
+/* Session State */
+typedef enum {
+    ECAT_FOE_STATE_IDLE = 0,
+    ECAT_FOE_STATE_WRQ,         /* Write request queued or awaiting ACK 0 */
+    ECAT_FOE_STATE_STREAMING,   /* DATA packets flowing */
+    ECAT_FOE_STATE_DONE,
+    ECAT_FOE_STATE_ERROR
+} ecat_foe_state_t;
+
+/* Per-slave download session */
+typedef struct {
+    /* Slave addressing */
+    uint16_t station_addr;
+    uint16_t mbx_size;          /* Negotiated receive mailbox size */
+    uint8_t mbx_counter;
+
+    /* Request */
+    char filename[ECAT_FOE_MAX_FILENAME];
+    uint8_t filename_len;
+    uint32_t password;
+    const uint8_t *image;       /* Flash-resident, shared by all sessions */
+    uint32_t image_size;
+
+    /* Transfer state */
+    ecat_foe_state_t state;
+    uint16_t packet_size;       /* Data bytes per DATA packet */
+    uint32_t packet_count;      /* Including a trailing empty packet if needed */
+    uint32_t next_packet;       /* Next DATA packet to send (1-based) */
+    uint32_t acked_packet;      /* Highest packet acknowledged by the slave */
+    uint32_t highest_sent;      /* Highest packet the slave has taken */
+    uint32_t staged_packet;     /* Packet awaiting write confirmation (0 = WRQ) */
+    bool staged;
+    bool wrq_sent;
+    uint8_t window;
+    uint16_t idle_cycles;
+    uint8_t retries;
+    uint32_t error_code;        /* Code from an FoE ERR packet */
+
+    /* Statistics */
+    uint32_t packets_sent;
+    uint32_t packets_resent;
+} ecat_foe_session_t;
+
+/* Engine driving several sessions round-robin */
+typedef struct {
+    ecat_foe_session_t sessions[ECAT_FOE_MAX_SESSIONS];
+    uint8_t session_count;
+    uint8_t next_session;
+} ecat_foe_engine_t;
+
+/*******************************************************************************
+ * API Functions
+ ******************************************************************************/
+
+/**
+ * @brief Pick the largest usable receive mailbox for a download
+ * @param std_mbx_size Standard receive mailbox size from the SII
+ * @param boot_mbx_size Bootstrap receive mailbox size from the SII (0 if absent)
+ * @param boot_state true if the slave is (or will be) in BOOT state
+ * @return Mailbox size to configure in SM0, clamped to the supported range
+ */
+uint16_t ecat_foe_select_mbx_size(uint16_t std_mbx_size, uint16_t boot_mbx_size, bool boot_state);
+
+/**
+ * @brief Initialize an engine with no sessions
+ * @param engine Pointer to engine
+ */
+void ecat_foe_engine_init(ecat_foe_engine_t *engine);
+
+/**
+ * @brief Add a download session to the engine
+ * @param engine Pointer to engine
+ * @param station_addr Configured station address of the slave
+ * @param mbx_size Negotiated receive mailbox size (see ecat_foe_select_mbx_size)
+ * @param filename File name expected by the slave bootloader
+ * @param password FoE password (0 if unused)
+ * @param image Firmware image, typically in flash
+ * @param image_size Image size in bytes
+ * @return Pointer to the new session, NULL if the engine is full or a parameter is invalid
+ */
+ecat_foe_session_t *ecat_foe_engine_add(ecat_foe_engine_t *engine, uint16_t station_addr,
+                                        uint16_t mbx_size, const char *filename, uint32_t password,
+                                        const uint8_t *image, uint32_t image_size);
+
+/**
+ * @brief Select the next session with a packet ready to send (round-robin)
+ * @param engine Pointer to engine
+ * @return Session to fill next, NULL if no session can send this cycle
+ */
+ecat_foe_session_t *ecat_foe_engine_next(ecat_foe_engine_t *engine);
+
+/**
+ * @brief Check whether all sessions have finished (successfully or not)
+ * @param engine Pointer to engine
+ * @return true when no session is still transferring
+ */
+bool ecat_foe_engine_finished(const ecat_foe_engine_t *engine);
+
+/**
+ * @brief Set the number of DATA packets allowed in flight before an ACK
+ * @param session Pointer to session
+ * @param window 1 for strict FoE, up to ECAT_FOE_MAX_WINDOW for slaves that queue ACKs
+ */
+void ecat_foe_set_window(ecat_foe_session_t *session, uint8_t window);
+
+/**
+ * @brief Stage the next WRQ or DATA packet into a mailbox
+ * @param session Pointer to session
+ * @param buf Destination for the mailbox (mbx_size bytes are written)
+ * @param spare_bytes Bytes still free in the current frame
+ * @return Number of bytes written (the slave mailbox size), 0 if nothing was staged
+ */
+uint16_t ecat_foe_fill_mailbox(ecat_foe_session_t *session, uint8_t *buf, uint16_t spare_bytes);
+
+/**
+ * @brief Report the outcome of the mailbox write staged by ecat_foe_fill_mailbox()
+ * @param session Pointer to session
+ * @param accepted true if the working counter shows the slave took the mailbox
+ */
+void ecat_foe_tx_confirm(ecat_foe_session_t *session, bool accepted);
+
+/**
+ * @brief Process a mailbox read back from the slave (ACK, BUSY or ERR)
+ * @param session Pointer to session
+ * @param mbx Mailbox contents, starting with the mailbox header
+ * @param length Number of valid bytes in mbx
+ * @return ECAT_FOE_SUCCESS if the packet was handled, error code otherwise
+ */
+ecat_foe_status_t ecat_foe_process_mailbox(ecat_foe_session_t *session, const uint8_t *mbx, uint16_t length);
+
+/**
+ * @brief Advance the session timeout once per cycle
+ * @param session Pointer to session
+ */
+void ecat_foe_tick(ecat_foe_session_t *session);
+
+/**
+ * @brief Get download progress in bytes acknowledged
+ * @param session Pointer to session
+ * @return Number of image bytes acknowledged by the slave
+ */
+uint32_t ecat_foe_bytes_acked(const ecat_foe_session_t *session);
+
+#endif /* ECAT_FOE_H */
@@ -0,0 +1,121 @@
+/*
+ * CAN to EtherCAT Gateway for FRDM-K64F
+ * Routes decoded CAN signals straight into the EtherCAT output process image
+ */
+
+#ifndef ECAT_GATEWAY_H
+#define ECAT_GATEWAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fsl_flexcan.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*
+ * Gateway mode: CAN frames are routed from the FlexCAN ISR, in addition to being
+ * queued for the CAN task. The image reaches the wire only through a frame
+ * builder that snapshots it; in this firmware that is the gwbench shell command
+ * (GatewayBench.h), the periodic Ethernet test cycle does not exchange process data.
+ */
+#ifndef ECAT_GATEWAY_ENABLE
+#define ECAT_GATEWAY_ENABLE         1
+#endif
+
+/* Image Configuration */
+#define ECAT_GW_IMAGE_SIZE          32    /* Output process image bytes owned by the gateway */
+#define ECAT_GW_MAX_ROUTES          8
+#define ECAT_GW_MAX_SIGNALS         16
+
+/* Return Status Codes */
+typedef enum {
+    ECAT_GW_SUCCESS = 0,
+    ECAT_GW_ERROR_INVALID_PARAM = -1,
+    ECAT_GW_ERROR_TABLE_FULL = -2,
+    ECAT_GW_ERROR_NO_ROUTE = -3
+} ecat_gw_status_t;
+
+/* One CAN signal copied bit for bit into the output image */
+typedef struct {
+    uint8_t can_bit_offset;     /* CANopen bit numbering, bit 0 = LSB of data byte 0 */
+    uint8_t bit_length;         /* 1..32 */
+    uint16_t image_bit_offset;  /* Little-endian bit position in the output image */
+    uint8_t signal;             /* Index for age tracking, < ECAT_GW_MAX_SIGNALS */
+} ecat_gw_signal_t;
+
+/* All signals carried by one COB-ID */
+typedef struct {
+    uint16_t cob_id;
+    uint8_t signal_count;
+    const ecat_gw_signal_t *signals;
+} ecat_gw_route_t;
+
+/* Consistent copy of the output image taken by the EtherCAT cycle */
+typedef struct {
+    uint8_t data[ECAT_GW_IMAGE_SIZE];
+    uint64_t stamp_ns[ECAT_GW_MAX_SIGNALS];   /* 1588 time of the last update, 0 = never */
+    uint32_t generation;                      /* Incremented by every routed frame */
+} ecat_gw_image_t;
+
+/* Gateway Statistics */
+typedef struct {
+    uint32_t frames_routed;
+    uint32_t frames_unrouted;
+} ecat_gw_stats_t;
+
+/*******************************************************************************
+ * API Functions
+ ******************************************************************************/
+
+/**
+ * @brief Initialize the gateway with a route table
+ * @param routes Route table (must stay valid)
+ * @param count Number of routes
+ * @return ECAT_GW_SUCCESS on success, error code otherwise
+ */
+ecat_gw_status_t ecat_gw_init(const ecat_gw_route_t *routes, uint8_t count);
+
+/**
+ * @brief Route one received CAN frame into the next output image slot
+ *
+ * Single writer: call from one context only (the FlexCAN ISR in gateway mode).
+ * The update is published with one atomic exchange, it never blocks and takes
+ * no lock.
+ *
+ * @param frame Received frame
+ * @param rx_time_ns Hardware reception time on the 1588 time base
+ * @return ECAT_GW_SUCCESS if routed, ECAT_GW_ERROR_NO_ROUTE for unknown COB-IDs
+ */
+ecat_gw_status_t ecat_gw_route_frame(const flexcan_frame_t *frame, uint64_t rx_time_ns);
+
+/**
+ * @brief Take a consistent copy of the output image
+ *
+ * To be called by the EtherCAT cycle right before the output datagram is built,
+ * so a CAN signal reaches the wire at most one cycle after its frame was
+ * received. Here only the gwbench command does (GatewayBench.h).
+ * Wait-free, single reader.
+ *
+ * @param image Destination
+ * @return true if the image changed since the previous snapshot
+ */
+bool ecat_gw_snapshot(ecat_gw_image_t *image);
+
+/**
+ * @brief Age of a signal in a snapshot
+ * @param image Snapshot from ecat_gw_snapshot()
+ * @param signal Signal index
+ * @param now_ns Current 1588 time (enet_raw_time_ns())
+ * @return Age in microseconds, UINT32_MAX if the signal was never received
+ */
+uint32_t ecat_gw_signal_age_us(const ecat_gw_image_t *image, uint8_t signal, uint64_t now_ns);
+
+/**
+ * @brief Get gateway statistics
+ * @param stats Pointer to statistics structure
+ */
+void ecat_gw_get_stats(ecat_gw_stats_t *stats);
+
+#endif /* ECAT_GATEWAY_H */
@@ -0,0 +1,92 @@
+/*
+ * EtherCAT Mailbox Layer for FRDM-K64F EtherCAT Implementation
+ * Mailbox header encoding shared by the EoE/FoE/CoE protocol engines
+ */
+
+#ifndef ECAT_MBX_H
+#define ECAT_MBX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Mailbox header is 6 bytes on the wire (ETG.1000.4) */
+#define ECAT_MBX_HEADER_SIZE    6
+
+/* Smallest and largest mailbox sizes accepted from SII/slave configuration */
+#define ECAT_MBX_MIN_SIZE       32
+#define ECAT_MBX_MAX_SIZE       1486  /* Largest mailbox that fits in one datagram */
+
+/* Mailbox protocol types */
+typedef enum {
+    ECAT_MBX_TYPE_ERR = 0x00,
+    ECAT_MBX_TYPE_AOE = 0x01,
+    ECAT_MBX_TYPE_EOE = 0x02,
+    ECAT_MBX_TYPE_COE = 0x03,
+    ECAT_MBX_TYPE_FOE = 0x04,
+    ECAT_MBX_TYPE_SOE = 0x05,
+    ECAT_MBX_TYPE_VOE = 0x0F
+} ecat_mbx_type_t;
+
+/* Decoded mailbox header */
+typedef struct {
+    uint16_t length;        /* Length of the service data following the header */
+    uint16_t address;       /* Station address of the originator */
+    uint8_t channel;        /* Channel (0 = default) */
+    uint8_t priority;       /* Priority (0 = lowest) */
+    uint8_t type;           /* Protocol type, see ecat_mbx_type_t */
+    uint8_t counter;        /* Sequence counter 1..7 (0 = not used) */
+} ecat_mbx_header_t;
+
+/*******************************************************************************
+ * API Functions
+ ******************************************************************************/
+
+/**
+ * @brief Encode a mailbox header into a buffer
+ * @param buf Destination buffer (at least ECAT_MBX_HEADER_SIZE bytes)
+ * @param hdr Header to encode
+ */
+void ecat_mbx_write_header(uint8_t *buf, const ecat_mbx_header_t *hdr);
+
+/**
+ * @brief Decode a mailbox header from a buffer
+ * @param buf Source buffer
+ * @param len Number of valid bytes in buffer
+ * @param hdr Decoded header
+ * @return true if the header is complete and its length fits in the buffer
+ */
+bool ecat_mbx_read_header(const uint8_t *buf, uint16_t len, ecat_mbx_header_t *hdr);
+
+/**
+ * @brief Advance a mailbox sequence counter (cycles 1..7, skipping 0)
+ * @param counter Pointer to the per-slave counter
+ * @return New counter value to place in the next header
+ */
+uint8_t ecat_mbx_next_counter(uint8_t *counter);
+
+/*******************************************************************************
+ * Utility Macros
+ ******************************************************************************/
+
+/* EtherCAT is little-endian on the wire */
+#define ECAT_GET_U16(p) ((uint16_t)((p)[0] | ((uint16_t)(p)[1] << 8)))
+#define ECAT_GET_U32(p) ((uint32_t)((p)[0] | ((uint32_t)(p)[1] << 8) | \
+                                    ((uint32_t)(p)[2] << 16) | ((uint32_t)(p)[3] << 24)))
+
+#define ECAT_PUT_U16(p, v) do { \
+    (p)[0] = (uint8_t)((v) & 0xFFU); \
+    (p)[1] = (uint8_t)(((v) >> 8) & 0xFFU); \
+} while(0)
+
+#define ECAT_PUT_U32(p, v) do { \
+    (p)[0] = (uint8_t)((v) & 0xFFU); \
+    (p)[1] = (uint8_t)(((v) >> 8) & 0xFFU); \
+    (p)[2] = (uint8_t)(((v) >> 16) & 0xFFU); \
+    (p)[3] = (uint8_t)(((v) >> 24) & 0xFFU); \
+} while(0)
+
+#endif /* ECAT_MBX_H */
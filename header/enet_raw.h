@@ -27,6 +27,11 @@
 #define ENET_RAW_RXBD_NUM       8
 #define ENET_RAW_TXBD_NUM       8
 #define ENET_RAW_BUFFER_SIZE    1536  /* Must accommodate max Ethernet frame */
+#define ENET_RAW_RX_POOL_NUM    4     /* Received frames held by the application at once, 1..32 */
+
+/* IEEE 1588 Timer (free running, wraps every second, the wrap interrupt extends it) */
+#define ENET_RAW_TIME_PERIOD_NS 1000000000UL
+#define ENET_RAW_TIME_IRQ_PRIORITY 5U  /* Not above configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY */
 
 /* Timeout Values */
 #define ENET_RAW_TX_TIMEOUT_MS  10
@@ -57,7 +62,7 @@ typedef struct {
     uint32_t rx_frames;     /* Received frames */
     uint32_t tx_errors;     /* Transmission errors */
     uint32_t rx_errors;     /* Reception errors */
-    uint32_t rx_dropped;    /* Dropped frames (buffer full) */
+    uint32_t rx_dropped;    /* Dropped frames (RX frame pool empty) */
     uint32_t non_ethercat;  /* Non-EtherCAT frames filtered */
 } enet_raw_stats_t;
 
@@ -70,6 +75,8 @@ typedef struct {
     /* Synchronization */
     SemaphoreHandle_t tx_mutex;
     SemaphoreHandle_t rx_semaphore;
+    StaticSemaphore_t tx_mutex_buffer;
+    StaticSemaphore_t rx_semaphore_buffer;
 
     /* Statistics */
     enet_raw_stats_t stats;
@@ -153,6 +160,25 @@ void enet_raw_get_stats(enet_raw_handle_t *handle, enet_raw_stats_t *stats);
  */
 void enet_raw_reset_stats(enet_raw_handle_t *handle);
 
+/*******************************************************************************
+ * IEEE 1588 Time Functions
+ ******************************************************************************/
+
+/**
+ * @brief Start the ENET 1588 timer as a free running nanosecond clock
+ * @note Called by enet_raw_init(); the ENET clock must be enabled
+ */
+void enet_raw_time_start(void);
+
+/**
+ * @brief Read the 1588 time
+ * @return Nanoseconds since enet_raw_time_start(), 0 if the timer is not running
+ * @note Safe from tasks and from ISRs up to configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ *       Timer wraps are counted by the 1588 timer interrupt, there is no minimum
+ *       call rate.
+ */
+uint64_t enet_raw_time_ns(void);
+
 /*******************************************************************************
  * Testing and Debug Functions
  ******************************************************************************/
@@ -174,9 +200,14 @@ enet_raw_status_t enet_raw_send_ping_frame(enet_raw_handle_t *handle);
 
 /**
  * @brief Dump frame contents to debug console
+ *
+ * Output is deferred (UART_DPRINTF): the bytes are captured at the call, the
+ * text is formatted later by the logger task. Logged at LOG_LEVEL_VERBOSE for
+ * LOG_MODULE_ENET, so nothing is printed until that level is enabled.
+ *
  * @param frame Pointer to frame data
  * @param length Frame length
- * @param label Description label for output
+ * @param label Description label for output, must be a literal or static string
  */
 void enet_raw_dump_frame(const uint8_t *frame, uint16_t length, const char *label);
 
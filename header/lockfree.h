@@ -0,0 +1,93 @@
+#ifndef LOCKFREE_H
+#define LOCKFREE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Lock-free primitives shared by the producers and consumers that run in both
+// task and interrupt context. On the target they map onto the Cortex-M4
+// exclusive monitor (LDREX/STREX): an exception entry or exit clears the
+// monitor, so a producer preempted between load and store simply retries.
+// On the host (stress tests, simulation) the same API is built on GCC atomics.
+
+#if defined(__arm__)
+
+#include "fsl_common.h"
+
+// Memory barrier: stores before it are visible before stores after it
+#define LF_BARRIER()                __DMB()
+
+// Atomic add, returns the previous value
+static inline uint32_t LF_FetchAdd(volatile uint32_t *value, uint32_t delta)
+{
+    uint32_t old;
+
+    do {
+        old = __LDREXW(value);
+    } while (__STREXW(old + delta, value) != 0U);
+
+    return old;
+}
+
+// Atomic compare and swap, returns true if *value was expected and is now desired
+static inline bool LF_CompareSwap(volatile uint32_t *value, uint32_t expected, uint32_t desired)
+{
+    do {
+        if (__LDREXW(value) != expected) {
+            __CLREX();
+            return false;
+        }
+    } while (__STREXW(desired, value) != 0U);
+
+    return true;
+}
+
+// Atomic exchange, returns the previous value
+static inline uint32_t LF_Exchange(volatile uint32_t *value, uint32_t desired)
+{
+    uint32_t old;
+
+    do {
+        old = __LDREXW(value);
+    } while (__STREXW(desired, value) != 0U);
+
+    return old;
+}
+
+#else
+
+// A host stress test may define LF_PREEMPT_HOOK and provide LF_PreemptHook():
+// it runs ahead of every primitive, where an interrupt could take over on the
+// target, and can yield there to force the interleavings a single core rarely
+// produces on its own
+#if defined(LF_PREEMPT_HOOK)
+void LF_PreemptHook(void);
+#define LF_PREEMPT()                LF_PreemptHook()
+#else
+#define LF_PREEMPT()                ((void)0)
+#endif
+
+#define LF_BARRIER()                do { LF_PREEMPT(); __atomic_thread_fence(__ATOMIC_SEQ_CST); } while (0)
+
+static inline uint32_t LF_FetchAdd(volatile uint32_t *value, uint32_t delta)
+{
+    LF_PREEMPT();
+    return __atomic_fetch_add(value, delta, __ATOMIC_SEQ_CST);
+}
+
+static inline bool LF_CompareSwap(volatile uint32_t *value, uint32_t expected, uint32_t desired)
+{
+    LF_PREEMPT();
+    return __atomic_compare_exchange_n(value, &expected, desired, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t LF_Exchange(volatile uint32_t *value, uint32_t desired)
+{
+    LF_PREEMPT();
+    return __atomic_exchange_n(value, desired, __ATOMIC_SEQ_CST);
+}
+
+#endif
+
+#endif /* LOCKFREE_H */
@@ -0,0 +1,99 @@
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Binary log stream, sent on UART0 when UART_LOG_BINARY is set.
+// Every record is COBS encoded and followed by a 0x00 delimiter, so a reader
+// can resynchronise on the next delimiter after lost or corrupted bytes.
+//
+// Decoded record, all fields little-endian:
+//   [0]      type
+//   [1..4]   timestamp, DWT cycle counter at the call site (wraps every ~35 s)
+//   FORMAT:  [5..8] address of the format string in flash, [9..] 32-bit args
+//   TEXT:    [5..]  message bytes, not NUL terminated
+//
+// The format address is resolved against the firmware ELF by the host decoder
+// in tools/logdecode, which builds against this header.
+
+#define LOG_RECORD_FORMAT           (0x01U)
+#define LOG_RECORD_TEXT             (0x02U)
+
+#define LOG_RECORD_HEADER_SIZE      (5U)        // Type + timestamp
+#define LOG_RECORD_MAX_ARGS         (6U)
+#define LOG_RECORD_MAX_SIZE         (LOG_RECORD_HEADER_SIZE + 64U)
+
+// Worst case COBS output for n input bytes, without the delimiter
+#define LOG_COBS_MAX_SIZE(n)        ((n) + ((n) / 254U) + 1U)
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : LogCobs_Encode
+ * Description   : COBS encode len bytes of src into dst, which must hold
+ *                 LOG_COBS_MAX_SIZE(len) bytes. No delimiter is appended.
+ *                 Returns the encoded length.
+ *
+ *END**************************************************************************/
+static inline size_t LogCobs_Encode(const uint8_t *src, size_t len, uint8_t *dst)
+{
+    size_t code = 0;        // Position of the pending code byte
+    size_t out = 1;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (src[i] == 0U) {
+            dst[code] = (uint8_t)(out - code);
+            code = out++;
+        } else {
+            dst[out++] = src[i];
+            if ((out - code) == 0xFFU) {
+                dst[code] = 0xFFU;
+                code = out++;
+            }
+        }
+    }
+    dst[code] = (uint8_t)(out - code);
+
+    return out;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : LogCobs_Decode
+ * Description   : Decode one COBS frame (delimiter removed) into dst. Returns
+ *                 the decoded length, or -1 if the frame is malformed or does
+ *                 not fit in dstSize bytes.
+ *
+ *END**************************************************************************/
+static inline int32_t LogCobs_Decode(const uint8_t *src, size_t len, uint8_t *dst, size_t dstSize)
+{
+    size_t in = 0;
+    size_t out = 0;
+    uint8_t code;
+    uint8_t i;
+
+    while (in < len) {
+        code = src[in++];
+        if ((code == 0U) || ((in + code - 1U) > len)) {
+            return -1;
+        }
+        for (i = 1; i < code; i++) {
+            if ((src[in] == 0U) || (out >= dstSize)) {
+                return -1;
+            }
+            dst[out++] = src[in++];
+        }
+        // A zero follows every group except a full one and the last one
+        if ((code != 0xFFU) && (in < len)) {
+            if (out >= dstSize) {
+                return -1;
+            }
+            dst[out++] = 0;
+        }
+    }
+
+    return (int32_t)out;
+}
+
+#endif /* LOG_RECORD_H */
@@ -0,0 +1,65 @@
+#ifndef MEM_PLACEMENT_H
+#define MEM_PLACEMENT_H
+
+// RAM placement on the K64F. The two SRAM halves are separate slaves:
+//   SRAM_L  0x1FFF0000   64K  reached by the core over the code bus
+//   SRAM_U  0x20000000  192K  reached by the core over the system bus, through
+//                             the crossbar port it shares with the ENET DMA
+// Other bus masters reach SRAM_L through the crossbar backdoor. Keeping the ENET
+// descriptors and DMA buffers in SRAM_U and the data the CPU touches every cycle
+// (task stacks, the process image, the received frame pool, per-cycle statistics)
+// in SRAM_L means DMA bursts and CPU loads/stores go to different memories and
+// never wait for each other. ISRs run on the main stack, which the linker
+// settings put at the top of SRAM_L as well.
+//
+// The section names are the ones the MCUXpresso managed linker script already
+// collects (.bss.$SRAM_LOWER* into .bss_RAM2, .data.$SRAM_LOWER* into
+// .data_RAM2, copied and zeroed by the startup code); anything else in .bss* and
+// .data* lands in SRAM_U. Usage:
+//   static uint8_t image[64] MEM_SRAM_L_BSS;
+//   static triple_buffer_t channel MEM_SRAM_L_DATA = TRIPLE_BUFFER_INIT(slots);
+//   MEM_SRAM_U_DMA(static enet_rx_bd_struct_t descriptors[N], ENET_BUFF_ALIGNMENT);
+// SRAM_L is 64K: check the headroom with tools/ram_report.py after adding to it.
+
+// Hot data goes to SRAM_L unless set explicitly; 0 builds everything into SRAM_U
+// for an A/B comparison ("membench", "cycle" and "prof" shell commands)
+#ifndef MEM_PLACEMENT_ENABLED
+#define MEM_PLACEMENT_ENABLED   1
+#endif
+
+#if MEM_PLACEMENT_ENABLED
+#define MEM_SRAM_L_BSS          __attribute__((section(".bss.$SRAM_LOWER")))   // Zero-initialized
+#define MEM_SRAM_L_DATA         __attribute__((section(".data.$SRAM_LOWER")))  // With an initializer
+#else
+#define MEM_SRAM_L_BSS
+#define MEM_SRAM_L_DATA
+#endif
+
+// ENET descriptors and DMA buffers, always in SRAM_U. Replaces the SDK
+// AT_NONCACHEABLE_SECTION_ALIGN (the K64F has no data cache to avoid).
+#define MEM_SRAM_U_DMA(var, alignbytes) \
+    __attribute__((section(".bss.$SRAM_UPPER"))) var __attribute__((aligned(alignbytes)))
+
+// Functions run from SRAM_L: copied from flash with .data_RAM2 at startup and
+// fetched over the code bus with no wait states, where flash at 120 MHz stalls
+// on every taken branch the prefetch buffer did not guess. For the short,
+// branchy code of every EtherCAT cycle and its ISRs only; SRAM_L is shared with
+// the hot data. Usage:
+//   MEM_RAMFUNC void hot_function(void) { ... }
+//   static MEM_RAMFUNC void hot_helper(void) { ... }
+// noinline keeps the body in RAM instead of in a flash caller. Calls between
+// flash and SRAM_L are out of BL range, the linker inserts long-branch veneers
+// (a few cycles per crossing call, so keep callees of RAM code in RAM too).
+// Measure in an optimized build: at -O0 the static inline helpers (Cycles_Now,
+// LF_CompareSwap, ...) are out-of-line flash functions called through veneers.
+#ifndef MEM_RAMFUNC_ENABLED
+#define MEM_RAMFUNC_ENABLED     MEM_PLACEMENT_ENABLED
+#endif
+
+#if MEM_RAMFUNC_ENABLED
+#define MEM_RAMFUNC             __attribute__((section(".ramfunc.$SRAM_LOWER"), noinline))
+#else
+#define MEM_RAMFUNC
+#endif
+
+#endif /* MEM_PLACEMENT_H */
@@ -10,22 +10,34 @@
 #define ETHERCAT_TASK_PRIORITY      (3)
 #define CAN_MONITOR_TASK_PRIORITY   (2)
 #define LOGGER_TASK_PRIORITY        (1)
+#define SHELL_TASK_PRIORITY         (1)
+#define ETH_RX_TASK_PRIORITY        (ETHERCAT_TASK_PRIORITY + 1)
+
+/* Stack multiplier of the host simulation build (sim/Makefile), whose tasks run
+ * on pthread stacks with a much larger minimum */
+#ifndef TASK_STACK_SCALE
+#define TASK_STACK_SCALE            (1)
+#endif
 
 /* Task stack sizes (in words, not bytes) */
-#define ETHERCAT_TASK_STACK_SIZE    (4096 / sizeof(StackType_t))
-#define CAN_TASK_STACK_SIZE         (2048 / sizeof(StackType_t))
-#define LOGGER_TASK_STACK_SIZE      (2048 / sizeof(StackType_t))
+#define ETHERCAT_TASK_STACK_SIZE    (TASK_STACK_SCALE * 4096 / sizeof(StackType_t))
+#define CAN_TASK_STACK_SIZE         (TASK_STACK_SCALE * 2048 / sizeof(StackType_t))
+#define LOGGER_TASK_STACK_SIZE      (TASK_STACK_SCALE * 2048 / sizeof(StackType_t))
+#define SHELL_TASK_STACK_SIZE       (TASK_STACK_SCALE * 2048 / sizeof(StackType_t))
+#define ETH_RX_TASK_STACK_SIZE      (TASK_STACK_SCALE * 2048 / sizeof(StackType_t))
 
-/* Task periods */
+/* Task periods and execution budgets of the cyclic tasks (CyclicTask.h),
+ * the deadline is the period. The CAN task is interrupt driven. */
 #define ETHERCAT_PERIOD_MS          (4)    // 4ms cycle time
-#define CAN_POLL_PERIOD_MS          (50)   // 50ms polling
+#define ETHERCAT_BUDGET_US          (1000)
 #define LOGGER_PERIOD_MS            (10)   // 10ms log processing
+#define LOGGER_BUDGET_US            (200)
 
 /* Global handles */
 extern TaskHandle_t g_ethercat_task_handle;
 extern TaskHandle_t g_can_task_handle;
 extern TaskHandle_t g_logger_task_handle;
-extern SemaphoreHandle_t g_can_data_mutex;
+extern TaskHandle_t g_shell_task_handle;
 
 /* Shared control data structure */
 typedef struct {
@@ -38,14 +50,14 @@ typedef struct {
     uint32_t last_update_ms;
 } shared_control_data_t;
 
-extern shared_control_data_t g_control_data;
-
 /* Task functions */
 void ethercat_task(void *pvParameters);
 void can_monitor_task(void *pvParameters);
 void logger_task(void *pvParameters);
 
-/* Utility functions */
+/* Control data exchange, wait-free (triple buffer). Single writer (CAN task) and single
+ * reader (EtherCAT task). get always copies the latest value and returns true if it
+ * changed since the previous get. */
 _Bool get_control_data_safe(shared_control_data_t *data);
 void set_control_data_safe(const shared_control_data_t *data);
 
@@ -0,0 +1,85 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lockfree.h"
+
+// Wait-free snapshot channel between one producer and one consumer, for any
+// plain data type. Three slots: the producer owns one, the consumer owns one,
+// and the third ("middle") holds the latest published value. Publishing and
+// fetching are a single atomic exchange of the middle slot index, so neither
+// side ever waits for the other, whatever their priorities. The consumer always
+// gets the most recent complete value; intermediate ones may be skipped.
+//
+// Usage:
+//   static my_type_t slots[3] = { INIT, INIT, INIT };
+//   static triple_buffer_t channel = TRIPLE_BUFFER_INIT(slots);
+//
+//   producer: my_type_t *w = TripleBuffer_WriteSlot(&channel); fill *w; TripleBuffer_Publish(&channel);
+//   consumer: const my_type_t *r = TripleBuffer_Read(&channel, &fresh);
+
+#define TRIPLE_BUFFER_FRESH     (0x80000000UL)  // Middle slot flag: published, not read yet
+
+typedef struct {
+    uint8_t *slots;                 // 3 consecutive slots of size bytes
+    uint32_t size;
+    volatile uint32_t middle;       // Slot index | TRIPLE_BUFFER_FRESH
+    uint32_t write;                 // Producer only
+    uint32_t read;                  // Consumer only
+} triple_buffer_t;
+
+#define TRIPLE_BUFFER_INIT(slotArray) \
+    { (uint8_t *)(slotArray), sizeof((slotArray)[0]), 1U, 0U, 2U }
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : TripleBuffer_WriteSlot
+ * Description   : Slot the producer fills next. Its content is stale (two
+ *                 publications old at most), overwrite it completely.
+ *
+ *END**************************************************************************/
+static inline void *TripleBuffer_WriteSlot(triple_buffer_t *tb)
+{
+    return &tb->slots[tb->write * tb->size];
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : TripleBuffer_Publish
+ * Description   : Make the write slot the latest value and take the previous
+ *                 middle slot as the next write slot.
+ *
+ *END**************************************************************************/
+static inline void TripleBuffer_Publish(triple_buffer_t *tb)
+{
+    // Slot content must be visible before its index
+    LF_BARRIER();
+    tb->write = LF_Exchange(&tb->middle, tb->write | TRIPLE_BUFFER_FRESH) & ~TRIPLE_BUFFER_FRESH;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : TripleBuffer_Read
+ * Description   : Latest published value. The pointer stays valid and
+ *                 unchanged until the next TripleBuffer_Read() call.
+ *                 fresh (optional) is set if a new value was published since
+ *                 the previous read.
+ *
+ *END**************************************************************************/
+static inline const void *TripleBuffer_Read(triple_buffer_t *tb, bool *fresh)
+{
+    bool isFresh = (tb->middle & TRIPLE_BUFFER_FRESH) != 0U;
+
+    if (isFresh) {
+        tb->read = LF_Exchange(&tb->middle, tb->read) & ~TRIPLE_BUFFER_FRESH;
+        LF_BARRIER();
+    }
+    if (fresh != NULL) {
+        *fresh = isFresh;
+    }
+    return &tb->slots[tb->read * tb->size];
+}
+
+#endif /* TRIPLE_BUFFER_H */
@@ -0,0 +1,98 @@
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/*-----------------------------------------------------------
+ * FreeRTOS configuration of the host simulation build (sim/Makefile), for the
+ * FreeRTOS POSIX port. Kept as close to source/FreeRTOSConfig.h as the port
+ * allows so the scheduler behaves like on the target:
+ *   - same tick rate, preemption, time slicing and kernel features
+ *   - one more priority level, above every firmware task, for the task that
+ *     delivers the interrupts of the simulated devices (sim_hal.c)
+ *   - stacks sized for host threads: the POSIX port runs every task on its own
+ *     stack as a pthread stack (at least PTHREAD_STACK_MIN), and StackType_t is
+ *     8 bytes. The firmware task stacks are scaled by TASK_STACK_SCALE (rtos.h).
+ *   - the idle hook sleeps so an idle simulation does not spin a host core
+ *----------------------------------------------------------*/
+
+#include <stdint.h>
+extern uint32_t SystemCoreClock;
+
+#define configUSE_PREEMPTION                    1
+#define configUSE_TICKLESS_IDLE                 0
+#define configCPU_CLOCK_HZ                      (SystemCoreClock)
+#define configTICK_RATE_HZ                      ((TickType_t)1000)
+#define configMAX_PRIORITIES                    6
+#define configMINIMAL_STACK_SIZE                ((unsigned short)4096)
+#define configMAX_TASK_NAME_LEN                 16
+#define configUSE_16_BIT_TICKS                  0
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configUSE_MUTEXES                       1
+#define configUSE_RECURSIVE_MUTEXES             1
+#define configUSE_COUNTING_SEMAPHORES           1
+#define configUSE_ALTERNATIVE_API               0 /* Deprecated! */
+#define configQUEUE_REGISTRY_SIZE               8
+#define configUSE_QUEUE_SETS                    0
+#define configUSE_TIME_SLICING                  0
+#define configUSE_NEWLIB_REENTRANT              0
+#define configENABLE_BACKWARD_COMPATIBILITY     1
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 5
+#define configUSE_APPLICATION_TASK_TAG          0
+
+/* Memory allocation related definitions. */
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
+#define configAPPLICATION_ALLOCATED_HEAP        0
+
+/* Hook function related definitions. */
+#define configUSE_IDLE_HOOK                     1
+#define configUSE_TICK_HOOK                     1
+#define configCHECK_FOR_STACK_OVERFLOW          2
+#define configUSE_MALLOC_FAILED_HOOK            0
+#define configUSE_DAEMON_TASK_STARTUP_HOOK      0
+
+/* Run time and task stats gathering related definitions: the simulated DWT
+ * cycle counter counts host time at SystemCoreClock, as on the target. */
+#define configGENERATE_RUN_TIME_STATS           1
+#define configUSE_TRACE_FACILITY                1
+#define configUSE_STATS_FORMATTING_FUNCTIONS    1
+
+#include "Trace.h"
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()    Trace_RunTimeInit()
+#define portGET_RUN_TIME_COUNTER_VALUE()            Trace_RunTimeCounter()
+#if TRACE_ENABLED
+    #define traceTASK_SWITCHED_IN()                 Trace_TaskSwitchedIn(pxCurrentTCB->uxTCBNumber)
+#endif
+
+/* Co-routine related definitions. */
+#define configUSE_CO_ROUTINES                   0
+#define configMAX_CO_ROUTINE_PRIORITIES         2
+
+/* Software timer related definitions. */
+#define configUSE_TIMERS                        1
+#define configTIMER_TASK_PRIORITY               2
+#define configTIMER_QUEUE_LENGTH                10
+#define configTIMER_TASK_STACK_DEPTH            4096
+
+/* Define to trap errors during development. */
+void Sim_AssertFailed(const char *file, int line);
+#define configASSERT(x) if((x) == 0) {Sim_AssertFailed(__FILE__, __LINE__);}
+
+/* Optional functions - most linkers will remove unused functions anyway. */
+#define INCLUDE_vTaskPrioritySet                1
+#define INCLUDE_uxTaskPriorityGet               1
+#define INCLUDE_vTaskDelete                     1
+#define INCLUDE_vTaskSuspend                    1
+#define INCLUDE_vTaskDelayUntil                 1
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
+#define INCLUDE_xTaskGetIdleTaskHandle          0
+#define INCLUDE_eTaskGetState                   0
+#define INCLUDE_xTimerPendFunctionCall          1
+#define INCLUDE_xTaskAbortDelay                 0
+#define INCLUDE_xTaskGetHandle                  0
+#define INCLUDE_xTaskResumeFromISR              1
+
+#endif /* FREERTOS_CONFIG_H */
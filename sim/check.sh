@@ -0,0 +1,109 @@
+#!/bin/sh
+# Checks run against the host simulation (make check): shell commands are piped
+# into ./sim, each run ends with "quit", and its output is matched.
+
+cd "$(dirname "$0")" || exit 1
+
+TIMEOUT=120
+failed=0
+
+# run <commands> [VAR=value...]: output of one simulation run
+run() {
+    commands=$1
+    shift
+    printf '%s\nquit\n' "$commands" | env "$@" timeout $TIMEOUT ./sim 2>&1
+}
+
+fail() {
+    echo "FAIL: $1"
+    echo "$2" | sed -n '/^> /,$p'
+    failed=1
+}
+
+# Log ring: eight threads writing at once against one consumer, no simulation
+if out=$(timeout $TIMEOUT ./logstress 2>&1); then
+    echo "ok: log ring, concurrent producers"
+else
+    echo "FAIL: log ring, concurrent producers"
+    echo "$out"
+    failed=1
+fi
+
+# EoE round trip: every frame size must come back intact and in order
+check_eoe() {
+    mbx=$1
+    out=$(run "eoebench 10 250" SIM_ECAT_MBX_SIZE="$mbx")
+    for size in 60 97 256 512 1024 1514; do
+        if ! echo "$out" | grep -Eq "^ +$size +10 +10 "; then
+            fail "eoebench, $mbx byte mailboxes, $size byte frames" "$out"
+            return
+        fi
+    done
+    if ! echo "$out" | grep -q "fragments, 0 errors"; then
+        fail "eoebench, $mbx byte mailboxes, endpoint errors" "$out"
+        return
+    fi
+    echo "ok: eoebench, $mbx byte mailboxes"
+}
+
+check_eoe 128
+check_eoe 512
+
+out=$(run "eoebench" SIM_ECAT_MBX_SIZE=0)
+if echo "$out" | grep -q "has a mailbox"; then
+    echo "ok: eoebench, no mailbox"
+else
+    fail "eoebench, no mailbox" "$out"
+fi
+
+# FoE download to all four slaves in parallel: each bootloader must have received
+# exactly the flash image and the master must report every session done
+check_foe() {
+    bytes=$1
+    window=$2
+    shift 2
+    out=$(run "foe fw.bin $bytes $window" "$@")
+    for slave in 0 1 2 3; do
+        if ! echo "$out" | grep -q "slave $slave FoE 'fw.bin' $bytes bytes: matches flash"; then
+            fail "foe, $bytes bytes, window $window $*, slave $slave" "$out"
+            return
+        fi
+    done
+    if ! echo "$out" | grep -q "4 of 4 slaves updated"; then
+        fail "foe, $bytes bytes, window $window $*, report" "$out"
+        return
+    fi
+    echo "ok: foe, $bytes bytes, window $window $*"
+}
+
+check_foe 100000 1
+check_foe 100000 4
+check_foe 10120 2                               # 10 full packets and an empty one
+check_foe 30000 4 SIM_ECAT_BOOT_MBX_SIZE=256
+
+out=$(run "foe fw.bin 5000" SIM_ECAT_MBX_SIZE=0 SIM_ECAT_BOOT_MBX_SIZE=0)
+if echo "$out" | grep -q "has a boot mailbox"; then
+    echo "ok: foe, no mailbox"
+else
+    fail "foe, no mailbox" "$out"
+fi
+
+# Gateway: the joystick signals must reach the LRW, each update within two cycles
+out=$(run "gwbench 500 1000")
+if ! echo "$out" | grep -q "LRW WKC 12,"; then
+    fail "gwbench, process image" "$out"
+elif [ "$(echo "$out" | awk '$3 ~ /^[0-9]+\/[0-9]+\/[0-9]+/ { split($3, age, "/"); if ($2 > 0 && age[3] + 0 < 2000) n++ } END { print n + 0 }')" -ne 3 ]; then
+    fail "gwbench, signal age" "$out"
+else
+    echo "ok: gwbench"
+fi
+
+# 1588 time across wraps with nobody reading it: no CAN traffic, the shell asleep
+out=$(run "sleep 3500" SIM_CAN_JOYSTICK_MS=0)
+if echo "$out" | awk '/1588 time/ { d = $4 - $8; ok = (d > -100 && d < 100) } END { exit !ok }'; then
+    echo "ok: 1588 time, idle bus"
+else
+    fail "1588 time, idle bus" "$out"
+fi
+
+exit $failed
@@ -0,0 +1,14 @@
+#ifndef SIM_BOARD_H
+#define SIM_BOARD_H
+
+// Host simulation stand-in for board/board.h
+
+#include "fsl_common.h"
+#include "fsl_clock.h"
+
+#define BOARD_NAME                      "FRDM-K64F (host simulation)"
+#define BOARD_DEBUG_UART_BAUDRATE       115200
+
+void BOARD_InitDebugConsole(void);
+
+#endif /* SIM_BOARD_H */
@@ -0,0 +1,8 @@
+#ifndef SIM_CLOCK_CONFIG_H
+#define SIM_CLOCK_CONFIG_H
+
+// Host simulation stand-in for board/clock_config.h
+
+void BOARD_InitBootClocks(void);
+
+#endif /* SIM_CLOCK_CONFIG_H */
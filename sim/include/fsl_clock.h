@@ -0,0 +1,18 @@
+#ifndef SIM_FSL_CLOCK_H
+#define SIM_FSL_CLOCK_H
+
+// Host simulation stand-in for the SDK fsl_clock.h: every clock is the core clock
+
+#include "fsl_common.h"
+
+typedef enum {
+    kCLOCK_CoreSysClk,
+    kCLOCK_BusClk,
+    kCLOCK_Osc0ErClk,
+} clock_name_t;
+
+#define UART0_CLK_SRC                   kCLOCK_CoreSysClk
+
+uint32_t CLOCK_GetFreq(clock_name_t name);
+
+#endif /* SIM_FSL_CLOCK_H */
@@ -0,0 +1,126 @@
+#ifndef SIM_FSL_COMMON_H
+#define SIM_FSL_COMMON_H
+
+// Host simulation stand-in for the SDK fsl_common.h and the CMSIS core: only
+// what the firmware sources use. Status codes keep the SDK values. The DWT cycle
+// counter and the NVIC are simulated in sim_hal.c.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+/*******************************************************************************
+ * Status codes
+ ******************************************************************************/
+typedef int32_t status_t;
+
+#define MAKE_STATUS(group, code)    ((((group) * 100) + (code)))
+
+enum {
+    kStatusGroup_Generic = 0,
+    kStatusGroup_UART = 10,
+    kStatusGroup_ENET = 40,
+    kStatusGroup_PHY = 41,
+    kStatusGroup_FLEXCAN = 53,
+};
+
+enum {
+    kStatus_Success = MAKE_STATUS(kStatusGroup_Generic, 0),
+    kStatus_Fail = MAKE_STATUS(kStatusGroup_Generic, 1),
+    kStatus_ReadOnly = MAKE_STATUS(kStatusGroup_Generic, 2),
+    kStatus_OutOfRange = MAKE_STATUS(kStatusGroup_Generic, 3),
+    kStatus_InvalidArgument = MAKE_STATUS(kStatusGroup_Generic, 4),
+    kStatus_Timeout = MAKE_STATUS(kStatusGroup_Generic, 5),
+    kStatus_NoTransferInProgress = MAKE_STATUS(kStatusGroup_Generic, 6),
+    kStatus_Busy = MAKE_STATUS(kStatusGroup_Generic, 7),
+};
+
+/*******************************************************************************
+ * Alignment and sections
+ ******************************************************************************/
+#define SDK_SIZEALIGN(var, alignbytes) \
+    ((unsigned int)((var) + ((alignbytes)-1U)) & (unsigned int)(~(unsigned int)((alignbytes)-1U)))
+#define SDK_ALIGN(var, alignbytes)      var __attribute__((aligned(alignbytes)))
+#define AT_NONCACHEABLE_SECTION(var)    var
+#define AT_NONCACHEABLE_SECTION_ALIGN(var, alignbytes) SDK_ALIGN(var, alignbytes)
+#define SDK_ISR_EXIT_BARRIER
+
+/*******************************************************************************
+ * CMSIS intrinsics
+ ******************************************************************************/
+#define __REV(x)                        __builtin_bswap32((uint32_t)(x))
+#define __CLZ(x)                        ((uint32_t)(((x) == 0U) ? 32 : __builtin_clz((uint32_t)(x))))
+#define __DMB()                         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __DSB()                         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __ISB()                         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __NOP()                         __asm volatile ("nop")
+
+static inline uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+    uint32_t i;
+
+    for (i = 0; i < 32U; i++) {
+        result = (result << 1) | ((value >> i) & 1U);
+    }
+    return result;
+}
+
+static inline uint32_t __UNALIGNED_UINT32_READ(const void *address)
+{
+    uint32_t value;
+
+    memcpy(&value, address, sizeof(value));
+    return value;
+}
+
+/*******************************************************************************
+ * Interrupts: the simulated devices raise them from the "IRQ" task (sim_hal.c),
+ * priorities and enables are recorded but not enforced
+ ******************************************************************************/
+typedef enum {
+    UART0_RX_TX_IRQn = 31,
+    CAN0_ORed_Message_buffer_IRQn = 75,
+    CAN0_Bus_Off_IRQn = 76,
+    CAN0_Error_IRQn = 77,
+    CAN0_Tx_Warning_IRQn = 78,
+    CAN0_Rx_Warning_IRQn = 79,
+    CAN0_Wake_Up_IRQn = 80,
+    ENET_1588_Timer_IRQn = 82,
+    ENET_Transmit_IRQn = 83,
+    ENET_Receive_IRQn = 84,
+    ENET_Error_IRQn = 85,
+    SIM_IRQ_COUNT = 86
+} IRQn_Type;
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+status_t EnableIRQ(IRQn_Type irq);
+status_t DisableIRQ(IRQn_Type irq);
+
+/*******************************************************************************
+ * Core clock and DWT cycle counter, counting host time at SystemCoreClock
+ ******************************************************************************/
+extern uint32_t SystemCoreClock;
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+// Every access to DWT reads the host clock into CYCCNT first
+DWT_Type *Sim_DwtRegs(void);
+extern CoreDebug_Type Sim_CoreDebug;
+
+#define DWT                             (Sim_DwtRegs())
+#define CoreDebug                       (&Sim_CoreDebug)
+
+#endif /* SIM_FSL_COMMON_H */
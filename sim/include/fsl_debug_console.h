@@ -0,0 +1,10 @@
+#ifndef SIM_FSL_DEBUG_CONSOLE_H
+#define SIM_FSL_DEBUG_CONSOLE_H
+
+// Host simulation stand-in for the SDK debug console: straight to stdout
+
+#include <stdio.h>
+
+#define PRINTF                          printf
+
+#endif /* SIM_FSL_DEBUG_CONSOLE_H */
@@ -0,0 +1,9 @@
+#ifndef SIM_FSL_DEVICE_REGISTERS_H
+#define SIM_FSL_DEVICE_REGISTERS_H
+
+// Host simulation stand-in for the MK64F12 device header: the core and
+// peripheral definitions used by the firmware live in fsl_common.h
+
+#include "fsl_common.h"
+
+#endif /* SIM_FSL_DEVICE_REGISTERS_H */
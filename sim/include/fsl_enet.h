@@ -0,0 +1,174 @@
+#ifndef SIM_FSL_ENET_H
+#define SIM_FSL_ENET_H
+
+// Host simulation stand-in for the SDK fsl_enet.h. The configuration and buffer
+// structures keep the SDK fields used by enet_raw.c; the driver functions are
+// implemented on a simulated EtherCAT segment in sim_hal.c. Received frames are
+// written into the buffers given to ENET_Init like the DMA would.
+
+#include "fsl_common.h"
+
+enum {
+    kStatus_ENET_RxFrameError = MAKE_STATUS(kStatusGroup_ENET, 1U),
+    kStatus_ENET_RxFrameFail = MAKE_STATUS(kStatusGroup_ENET, 2U),
+    kStatus_ENET_RxFrameEmpty = MAKE_STATUS(kStatusGroup_ENET, 3U),
+    kStatus_ENET_TxFrameBusy = MAKE_STATUS(kStatusGroup_ENET, 4U),
+    kStatus_ENET_TxFrameOverLen = MAKE_STATUS(kStatusGroup_ENET, 5U),
+    kStatus_ENET_TxFrameFail = MAKE_STATUS(kStatusGroup_ENET, 6U),
+};
+
+#define ENET_BUFF_ALIGNMENT             (16U)
+
+/*******************************************************************************
+ * Registers: the IEEE 1588 timer and its wrap interrupt only
+ ******************************************************************************/
+typedef struct {
+    volatile uint32_t EIR;
+    volatile uint32_t EIMR;
+    volatile uint32_t ATCR;
+    volatile uint32_t ATVR;
+    volatile uint32_t ATOFF;
+    volatile uint32_t ATPER;
+    volatile uint32_t ATCOR;
+    volatile uint32_t ATINC;
+} ENET_Type;
+
+#define ENET_ATCR_EN_MASK               (0x1U)
+#define ENET_ATCR_PEREN_MASK            (0x10U)
+#define ENET_ATCR_CAPTURE_MASK          (0x800U)
+#define ENET_ATINC_INC(x)               (((uint32_t)(x)) & 0x7FU)
+#define ENET_ATINC_INC_CORR(x)          ((((uint32_t)(x)) << 8) & 0x7F00U)
+#define ENET_EIR_TS_TIMER_MASK          (0x8000U)
+
+enum {
+    kENET_TsTimerInterrupt = ENET_EIR_TS_TIMER_MASK,
+};
+
+// Every access to ENET completes a pending ATCR capture from the host clock and
+// raises TS_TIMER in EIR if ATVR wrapped since the previous access
+ENET_Type *Sim_EnetRegs(void);
+
+#define ENET                            (Sim_EnetRegs())
+
+/*******************************************************************************
+ * Configuration
+ ******************************************************************************/
+typedef enum {
+    kENET_MiiMode = 0U,
+    kENET_RmiiMode = 1U,
+} enet_mii_mode_t;
+
+typedef enum {
+    kENET_MiiSpeed10M = 0U,
+    kENET_MiiSpeed100M = 1U,
+} enet_mii_speed_t;
+
+typedef enum {
+    kENET_MiiHalfDuplex = 0U,
+    kENET_MiiFullDuplex = 1U,
+} enet_mii_duplex_t;
+
+typedef enum {
+    kENET_ControlFlowControlEnable = 0x0001U,
+    kENET_ControlRxPayloadCheckEnable = 0x0002U,
+    kENET_ControlRxPadRemoveEnable = 0x0004U,
+    kENET_ControlRxBroadCastRejectEnable = 0x0008U,
+    kENET_ControlMacAddrInsert = 0x0010U,
+    kENET_ControlStoreAndFwdDisable = 0x0020U,
+    kENET_ControlSMIPreambleDisable = 0x0040U,
+    kENET_ControlPromiscuousEnable = 0x0080U,
+} enet_special_control_flag_t;
+
+typedef enum _enet_event {
+    kENET_RxEvent,
+    kENET_TxEvent,
+    kENET_ErrEvent,
+    kENET_WakeUpEvent,
+    kENET_TimeStampEvent,
+    kENET_TimeStampAvailEvent
+} enet_event_t;
+
+typedef struct _enet_config {
+    uint32_t macSpecialConfig;
+    uint32_t interrupt;
+    uint16_t rxMaxFrameLen;
+    enet_mii_mode_t miiMode;
+    enet_mii_speed_t miiSpeed;
+    enet_mii_duplex_t miiDuplex;
+    uint8_t rxAccelerConfig;
+    uint8_t txAccelerConfig;
+    uint16_t pauseDuration;
+} enet_config_t;
+
+typedef struct _enet_rx_bd_struct {
+    uint16_t length;
+    uint16_t control;
+    uint32_t buffer;
+} enet_rx_bd_struct_t;
+
+typedef struct _enet_tx_bd_struct {
+    uint16_t length;
+    uint16_t control;
+    uint32_t buffer;
+} enet_tx_bd_struct_t;
+
+typedef struct enet_frame_info {
+    void *context;
+} enet_frame_info_t;
+
+typedef struct _enet_buffer_config {
+    uint16_t rxBdNumber;
+    uint16_t txBdNumber;
+    uint16_t rxBuffSizeAlign;
+    uint16_t txBuffSizeAlign;
+    volatile enet_rx_bd_struct_t *rxBdStartAddrAlign;
+    volatile enet_tx_bd_struct_t *txBdStartAddrAlign;
+    uint8_t *rxBufferAlign;
+    uint8_t *txBufferAlign;
+    bool rxMaintainEnable;
+    bool txMaintainEnable;
+    enet_frame_info_t *txFrameInfo;
+} enet_buffer_config_t;
+
+typedef struct _enet_handle enet_handle_t;
+
+typedef void (*enet_callback_t)(ENET_Type *base,
+                                enet_handle_t *handle,
+                                enet_event_t event,
+                                enet_frame_info_t *frameInfo,
+                                void *userData);
+
+// Receive ring filled by the simulated segment, transmit count for ENET_TxFrameBusy
+struct _enet_handle {
+    enet_buffer_config_t buffConfig;
+    enet_callback_t callback;
+    void *userData;
+    uint16_t rxLength[32];
+    uint16_t txLength[32];
+    volatile uint32_t rxHead;
+    volatile uint32_t rxTail;
+    volatile uint32_t txHead;
+    volatile uint32_t txTail;
+};
+
+/*******************************************************************************
+ * Driver API used by enet_raw.c
+ ******************************************************************************/
+void ENET_GetDefaultConfig(enet_config_t *config);
+status_t ENET_Init(ENET_Type *base, enet_handle_t *handle, const enet_config_t *config,
+                   const enet_buffer_config_t *bufferConfig, uint8_t *macAddr, uint32_t srcClock_Hz);
+void ENET_Deinit(ENET_Type *base);
+void ENET_SetCallback(enet_handle_t *handle, enet_callback_t callback, void *userData);
+void ENET_ActiveRead(ENET_Type *base);
+status_t ENET_SendFrame(ENET_Type *base, enet_handle_t *handle, const uint8_t *data, uint32_t length,
+                        uint8_t ringId, bool tsFlag, void *context);
+status_t ENET_GetRxFrameSize(enet_handle_t *handle, uint32_t *length, uint8_t ringId);
+status_t ENET_ReadFrame(ENET_Type *base, enet_handle_t *handle, uint8_t *data, uint32_t length,
+                        uint8_t ringId, uint32_t *ts);
+
+// EIR is write-1-to-clear on the MAC, which a plain struct cannot do
+void ENET_EnableInterrupts(ENET_Type *base, uint32_t mask);
+uint32_t ENET_GetInterruptStatus(ENET_Type *base);
+void ENET_ClearInterruptStatus(ENET_Type *base, uint32_t mask);
+
+#endif /* SIM_FSL_ENET_H */
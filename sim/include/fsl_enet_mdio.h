@@ -0,0 +1,26 @@
+#ifndef SIM_FSL_ENET_MDIO_H
+#define SIM_FSL_ENET_MDIO_H
+
+// Host simulation stand-in for mdio/fsl_enet_mdio.h
+
+#include "fsl_common.h"
+
+typedef struct _mdio_operations mdio_operations_t;
+
+typedef struct _mdio_resource {
+    void *base;
+    uint32_t csrClock_Hz;
+} mdio_resource_t;
+
+typedef struct _mdio_handle {
+    mdio_resource_t resource;
+    const mdio_operations_t *ops;
+} mdio_handle_t;
+
+struct _mdio_operations {
+    const char *name;
+};
+
+extern const mdio_operations_t enet_ops;
+
+#endif /* SIM_FSL_ENET_MDIO_H */
@@ -0,0 +1,152 @@
+#ifndef SIM_FSL_FLEXCAN_H
+#define SIM_FSL_FLEXCAN_H
+
+// Host simulation stand-in for the SDK fsl_flexcan.h. Frames and transfers keep
+// the SDK layout so the firmware packs and decodes them unchanged; the FlexCAN
+// transactional driver is implemented on a simulated bus in sim_hal.c.
+
+#include "fsl_common.h"
+
+enum {
+    kStatus_FLEXCAN_TxBusy = MAKE_STATUS(kStatusGroup_FLEXCAN, 0),
+    kStatus_FLEXCAN_TxIdle = MAKE_STATUS(kStatusGroup_FLEXCAN, 1),
+    kStatus_FLEXCAN_RxFifoBusy = MAKE_STATUS(kStatusGroup_FLEXCAN, 6),
+    kStatus_FLEXCAN_RxFifoIdle = MAKE_STATUS(kStatusGroup_FLEXCAN, 7),
+    kStatus_FLEXCAN_RxFifoOverflow = MAKE_STATUS(kStatusGroup_FLEXCAN, 8),
+};
+
+/*******************************************************************************
+ * Registers: the free-running timer and CTRL1 only
+ ******************************************************************************/
+typedef struct {
+    volatile uint32_t CTRL1;
+    volatile uint32_t TIMER;
+} CAN_Type;
+
+#define CAN_CTRL1_TSYN_MASK             (0x20U)
+#define CAN_TIMER_TIMER_MASK            (0xFFFFU)
+#define CAN_ID_STD_MASK                 (0x1FFC0000U)
+#define CAN_ID_STD_SHIFT                (18U)
+#define CAN_ID_EXT_MASK                 (0x3FFFFU)
+#define CAN_ID_EXT_SHIFT                (0U)
+
+// Every access to CAN0 reads the host clock into TIMER first (one count per bit time)
+CAN_Type *Sim_CanRegs(void);
+
+#define CAN0                            (Sim_CanRegs())
+
+/*******************************************************************************
+ * Frames and configuration
+ ******************************************************************************/
+#define FLEXCAN_ID_STD(id) \
+    (((uint32_t)(((uint32_t)(id)) << CAN_ID_STD_SHIFT)) & CAN_ID_STD_MASK)
+#define FLEXCAN_ID_EXT(id) \
+    (((uint32_t)(((uint32_t)(id)) << CAN_ID_EXT_SHIFT)) & (CAN_ID_EXT_MASK | CAN_ID_STD_MASK))
+#define FLEXCAN_RX_FIFO_STD_MASK_TYPE_A(id, rtr, ide) \
+    (((uint32_t)((uint32_t)(rtr) << 31) | (uint32_t)((uint32_t)(ide) << 30)) | (FLEXCAN_ID_STD(id) << 1))
+#define FLEXCAN_RX_FIFO_STD_FILTER_TYPE_A(id, rtr, ide) FLEXCAN_RX_FIFO_STD_MASK_TYPE_A(id, rtr, ide)
+
+typedef enum {
+    kFLEXCAN_FrameFormatStandard = 0x0U,
+    kFLEXCAN_FrameFormatExtend = 0x1U,
+} flexcan_frame_format_t;
+
+typedef enum {
+    kFLEXCAN_FrameTypeData = 0x0U,
+    kFLEXCAN_FrameTypeRemote = 0x1U,
+} flexcan_frame_type_t;
+
+typedef enum {
+    kFLEXCAN_RxFifoFilterTypeA = 0x0U,
+    kFLEXCAN_RxFifoFilterTypeB = 0x1U,
+    kFLEXCAN_RxFifoFilterTypeC = 0x2U,
+    kFLEXCAN_RxFifoFilterTypeD = 0x3U,
+} flexcan_rx_fifo_filter_type_t;
+
+typedef enum {
+    kFLEXCAN_RxFifoPrioLow = 0x0U,
+    kFLEXCAN_RxFifoPrioHigh = 0x1U,
+} flexcan_rx_fifo_priority_t;
+
+typedef struct _flexcan_frame {
+    struct {
+        uint32_t timestamp : 16;
+        uint32_t length : 4;
+        uint32_t type : 1;
+        uint32_t format : 1;
+        uint32_t : 1;
+        uint32_t idhit : 9;
+    };
+    struct {
+        uint32_t id : 29;
+        uint32_t : 3;
+    };
+    union {
+        struct {
+            uint32_t dataWord0;
+            uint32_t dataWord1;
+        };
+        struct {
+            uint8_t dataByte3;
+            uint8_t dataByte2;
+            uint8_t dataByte1;
+            uint8_t dataByte0;
+            uint8_t dataByte7;
+            uint8_t dataByte6;
+            uint8_t dataByte5;
+            uint8_t dataByte4;
+        };
+    };
+} flexcan_frame_t;
+
+typedef struct _flexcan_config {
+    uint32_t bitRate;
+    uint8_t maxMbNum;
+    bool enableLoopBack;
+    bool disableSelfReception;
+} flexcan_config_t;
+
+typedef struct _flexcan_rx_fifo_config {
+    uint32_t *idFilterTable;
+    uint8_t idFilterNum;
+    flexcan_rx_fifo_filter_type_t idFilterType;
+    flexcan_rx_fifo_priority_t priority;
+} flexcan_rx_fifo_config_t;
+
+typedef struct _flexcan_mb_transfer {
+    flexcan_frame_t *frame;
+    uint8_t mbIdx;
+} flexcan_mb_transfer_t;
+
+typedef struct _flexcan_fifo_transfer {
+    flexcan_frame_t *frame;
+} flexcan_fifo_transfer_t;
+
+typedef struct _flexcan_handle flexcan_handle_t;
+
+#define FLEXCAN_CALLBACK(x) \
+    void(x)(CAN_Type * base, flexcan_handle_t * handle, status_t status, uint32_t result, void *userData)
+typedef void (*flexcan_transfer_callback_t)(
+    CAN_Type *base, flexcan_handle_t *handle, status_t status, uint32_t result, void *userData);
+
+struct _flexcan_handle {
+    flexcan_transfer_callback_t callback;
+    void *userData;
+    flexcan_frame_t *volatile rxFifoFrameBuf;
+};
+
+/*******************************************************************************
+ * Driver API used by CANopen_HAL.c
+ ******************************************************************************/
+void FLEXCAN_EnterFreezeMode(CAN_Type *base);
+void FLEXCAN_ExitFreezeMode(CAN_Type *base);
+void FLEXCAN_SetRxFifoGlobalMask(CAN_Type *base, uint32_t mask);
+void FLEXCAN_SetRxFifoConfig(CAN_Type *base, const flexcan_rx_fifo_config_t *pRxFifoConfig, bool enable);
+void FLEXCAN_SetTxMbConfig(CAN_Type *base, uint8_t mbIdx, bool enable);
+void FLEXCAN_TransferCreateHandle(CAN_Type *base, flexcan_handle_t *handle,
+                                  flexcan_transfer_callback_t callback, void *userData);
+status_t FLEXCAN_TransferSendNonBlocking(CAN_Type *base, flexcan_handle_t *handle, flexcan_mb_transfer_t *pMbXfer);
+status_t FLEXCAN_TransferReceiveFifoNonBlocking(CAN_Type *base, flexcan_handle_t *handle,
+                                                flexcan_fifo_transfer_t *pFifoXfer);
+
+#endif /* SIM_FSL_FLEXCAN_H */
@@ -0,0 +1,46 @@
+#ifndef SIM_FSL_PHY_H
+#define SIM_FSL_PHY_H
+
+// Host simulation stand-in for phy/fsl_phy.h: the link to the simulated segment
+// is always up, 100M full duplex
+
+#include "fsl_common.h"
+#include "fsl_enet_mdio.h"
+
+typedef struct _phy_operations phy_operations_t;
+
+typedef enum _phy_speed {
+    kPHY_Speed10M = 0U,
+    kPHY_Speed100M,
+    kPHY_Speed1000M
+} phy_speed_t;
+
+typedef enum _phy_duplex {
+    kPHY_HalfDuplex = 0U,
+    kPHY_FullDuplex
+} phy_duplex_t;
+
+typedef struct _phy_config {
+    uint32_t phyAddr;
+    phy_speed_t speed;
+    phy_duplex_t duplex;
+    bool autoNeg;
+    bool enableEEE;
+} phy_config_t;
+
+typedef struct _phy_handle {
+    uint32_t phyAddr;
+    mdio_handle_t *mdioHandle;
+    const phy_operations_t *ops;
+} phy_handle_t;
+
+struct _phy_operations {
+    const char *name;
+};
+
+status_t PHY_Init(phy_handle_t *handle, const phy_config_t *config);
+status_t PHY_GetAutoNegotiationStatus(phy_handle_t *handle, bool *status);
+status_t PHY_GetLinkStatus(phy_handle_t *handle, bool *status);
+status_t PHY_GetLinkSpeedDuplex(phy_handle_t *handle, phy_speed_t *speed, phy_duplex_t *duplex);
+
+#endif /* SIM_FSL_PHY_H */
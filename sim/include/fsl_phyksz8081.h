@@ -0,0 +1,10 @@
+#ifndef SIM_FSL_PHYKSZ8081_H
+#define SIM_FSL_PHYKSZ8081_H
+
+// Host simulation stand-in for phy/fsl_phyksz8081.h
+
+#include "fsl_phy.h"
+
+extern const phy_operations_t phyksz8081_ops;
+
+#endif /* SIM_FSL_PHYKSZ8081_H */
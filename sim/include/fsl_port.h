@@ -0,0 +1,8 @@
+#ifndef SIM_FSL_PORT_H
+#define SIM_FSL_PORT_H
+
+// Host simulation stand-in for the SDK fsl_port.h: pins need no muxing
+
+#include "fsl_common.h"
+
+#endif /* SIM_FSL_PORT_H */
@@ -0,0 +1,18 @@
+#ifndef SIM_FSL_SYSMPU_H
+#define SIM_FSL_SYSMPU_H
+
+// Host simulation stand-in for the SDK fsl_sysmpu.h: there is no MPU to turn off
+
+#include "fsl_common.h"
+
+typedef struct _sim_sysmpu SYSMPU_Type;
+
+#define SYSMPU                          ((SYSMPU_Type *)0)
+
+static inline void SYSMPU_Enable(SYSMPU_Type *base, bool enable)
+{
+    (void)base;
+    (void)enable;
+}
+
+#endif /* SIM_FSL_SYSMPU_H */
@@ -0,0 +1,14 @@
+#ifndef SIM_FSL_UART_H
+#define SIM_FSL_UART_H
+
+// Host simulation stand-in for the SDK fsl_uart.h. UART_HAL.c drives the UART0
+// registers directly and is replaced as a whole by sim_uart.c, so only the
+// instance name is needed.
+
+#include "fsl_common.h"
+
+typedef struct _sim_uart UART_Type;
+
+#define UART0                           ((UART_Type *)0)
+
+#endif /* SIM_FSL_UART_H */
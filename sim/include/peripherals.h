@@ -0,0 +1,20 @@
+#ifndef SIM_PERIPHERALS_H
+#define SIM_PERIPHERALS_H
+
+// Host simulation stand-in for board/peripherals.h. BOARD_InitBootPeripherals
+// starts the simulated devices (sim_hal.c).
+
+#include "fsl_common.h"
+#include "fsl_flexcan.h"
+#include "fsl_clock.h"
+#include "fsl_uart.h"
+
+#define CAN0_PERIPHERAL CAN0
+#define UART0_PERIPHERAL UART0
+
+extern const flexcan_config_t CAN0_config;
+
+void BOARD_InitPeripherals(void);
+void BOARD_InitBootPeripherals(void);
+
+#endif /* SIM_PERIPHERALS_H */
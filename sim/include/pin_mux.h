@@ -0,0 +1,8 @@
+#ifndef SIM_PIN_MUX_H
+#define SIM_PIN_MUX_H
+
+// Host simulation stand-in for board/pin_mux.h
+
+void BOARD_InitBootPins(void);
+
+#endif /* SIM_PIN_MUX_H */
@@ -0,0 +1,3 @@
+// INIT_HAL.h includes "utilities.h", which only resolves to Utilities.h on the
+// case-insensitive file systems MCUXpresso usually runs on
+#include "Utilities.h"
@@ -0,0 +1,253 @@
+#include "UART_HAL.h"
+#include "Utilities.h"
+#include "Profiler.h"
+#include "fsl_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+// Host stress test of the lock-free log ring (make logstress, run by make
+// check). Source/Utilities.c is linked alone, without the kernel or the rest
+// of the simulation: LOGSTRESS_PRODUCERS threads write numbered messages with
+// UART_LogMessage() as fast as they can while one consumer thread drains the
+// ring with UART_LogPeek()/UART_LogConsume(), as the TX interrupt does. Every
+// delivered message must be intact and in order for its producer, and the
+// delivered plus the dropped ones must add up to all of them. The ring is
+// built with the lockfree.h preemption hook, which yields at random ahead of
+// the atomics so that producers get interrupted mid-claim and mid-write even
+// on a single core.
+
+#define LOGSTRESS_PRODUCERS         (8U)
+#define LOGSTRESS_MESSAGES          (200000U)   // Per producer
+#define LOGSTRESS_LINE_MAX          (UART_MAX_LOG_ENTRY_SIZE)
+#define LOGSTRESS_STALL_TRIES       (100000U)   // Empty drains before a leftover is stuck
+#define LOGSTRESS_PREEMPT_MASK      (7U)        // Yield at one hook call in eight
+
+typedef struct {
+    uint64_t delivered;
+    uint64_t corrupt;
+    uint64_t reordered;
+    uint32_t stuck;                     // Set if what was left never committed
+    uint32_t lastSeq[LOGSTRESS_PRODUCERS];
+    uint8_t seen[LOGSTRESS_PRODUCERS];
+    char line[LOGSTRESS_LINE_MAX];
+    uint32_t lineLen;
+} logstress_check_t;
+
+static volatile uint32_t producersDone = 0;
+static logstress_check_t check;
+static __thread uint32_t preemptState = 0;
+
+// What Utilities.c needs besides the ring: no TX interrupt, no profiler, and
+// a DWT that does not count
+static DWT_Type logStressDwt;
+CoreDebug_Type Sim_CoreDebug;
+
+DWT_Type *Sim_DwtRegs(void)
+{
+    return &logStressDwt;
+}
+
+void UART_TxInterruptInit(void)
+{
+}
+
+void UART_TxStart(void)
+{
+}
+
+void Profiler_Record(prof_probe_t probe, uint32_t cycles)
+{
+    (void)probe;
+    (void)cycles;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : LF_PreemptHook
+ * Description   : Called ahead of every lock-free primitive of the ring: give
+ *                 the core away now and then, as an interrupt would
+ *
+ *END**************************************************************************/
+void LF_PreemptHook(void)
+{
+    uint32_t x = preemptState;
+
+    if (x == 0U) {
+        x = (uint32_t)(uintptr_t)&preemptState | 1U;
+    }
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    preemptState = x;
+    if ((x & LOGSTRESS_PREEMPT_MASK) == 0U) {
+        sched_yield();
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : LogStress_Producer
+ * Description   : Write "P<id> <seq> <id repeated>" lines, seq counting up. The
+ *                 padding varies the record length and makes torn text visible.
+ *
+ *END**************************************************************************/
+static void *LogStress_Producer(void *arg)
+{
+    const uint32_t id = (uint32_t)(uintptr_t)arg;
+    char message[LOGSTRESS_LINE_MAX];
+    uint32_t dropped;
+    uint32_t seq;
+    int length;
+
+    for (seq = 0; seq < LOGSTRESS_MESSAGES; seq++) {
+        length = snprintf(message, sizeof(message), "P%u %u ", (unsigned)id, (unsigned)seq);
+        memset(&message[length], (int)('a' + id), seq % 24U);
+        length += (int)(seq % 24U);
+        message[length++] = '\n';
+        message[length] = '\0';
+
+        // On a drop, here or elsewhere, let the consumer catch up: the ring
+        // keeps cycling instead of staying full, also on a single core
+        dropped = UART_LogGetDropped();
+        UART_LogMessage(message);
+        if (UART_LogGetDropped() != dropped) {
+            sched_yield();
+        }
+    }
+    __atomic_add_fetch(&producersDone, 1U, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : LogStress_CheckLine
+ * Description   : Parse one delivered line and check it against its producer
+ *
+ *END**************************************************************************/
+static void LogStress_CheckLine(const char *line, uint32_t length)
+{
+    unsigned id;
+    unsigned seq;
+    int offset;
+    uint32_t i;
+
+    check.delivered++;
+    if (sscanf(line, "P%u %u %n", &id, &seq, &offset) != 2 || id >= LOGSTRESS_PRODUCERS ||
+        seq >= LOGSTRESS_MESSAGES || length != (uint32_t)offset + seq % 24U) {
+        check.corrupt++;
+        return;
+    }
+    for (i = (uint32_t)offset; i < length; i++) {
+        if (line[i] != (char)('a' + id)) {
+            check.corrupt++;
+            return;
+        }
+    }
+    if (check.seen[id] && seq <= check.lastSeq[id]) {
+        check.reordered++;
+    }
+    check.seen[id] = 1;
+    check.lastSeq[id] = seq;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : LogStress_Consume
+ * Description   : Take what is committed in the ring and split it into lines.
+ *                 Returns the bytes taken.
+ *
+ *END**************************************************************************/
+static uint32_t LogStress_Consume(void)
+{
+    const uint8_t *data;
+    uint32_t total = 0;
+    uint16_t count;
+    uint16_t i;
+
+    while ((count = UART_LogPeek(&data)) > 0U) {
+        for (i = 0; i < count; i++) {
+            if (data[i] == '\n') {
+                check.line[check.lineLen] = '\0';
+                LogStress_CheckLine(check.line, check.lineLen);
+                check.lineLen = 0;
+            } else if (check.lineLen < LOGSTRESS_LINE_MAX - 1U) {
+                check.line[check.lineLen++] = (char)data[i];
+            } else {
+                check.corrupt++;
+                check.lineLen = 0;
+            }
+        }
+        UART_LogConsume(count);
+        total += count;
+    }
+    return total;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : LogStress_Consumer
+ * Description   : Drain the ring until every producer is done and it is empty,
+ *                 or what is left stays uncommitted
+ *
+ *END**************************************************************************/
+static void *LogStress_Consumer(void *arg)
+{
+    uint32_t tries = 0;
+
+    (void)arg;
+
+    while (__atomic_load_n(&producersDone, __ATOMIC_ACQUIRE) < LOGSTRESS_PRODUCERS) {
+        if (LogStress_Consume() == 0U) {
+            sched_yield();
+        }
+    }
+    while (UART_LogHasMessages()) {
+        if (LogStress_Consume() > 0U) {
+            tries = 0;
+        } else if (++tries == LOGSTRESS_STALL_TRIES) {
+            check.stuck = 1;
+            break;
+        }
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    const uint64_t total = (uint64_t)LOGSTRESS_PRODUCERS * LOGSTRESS_MESSAGES;
+    pthread_t producers[LOGSTRESS_PRODUCERS];
+    pthread_t consumer;
+    uint64_t dropped;
+    uint32_t i;
+    int ok;
+
+    UART_LogInit();
+    if (pthread_create(&consumer, NULL, LogStress_Consumer, NULL) != 0) {
+        perror("logstress: consumer");
+        return 2;
+    }
+    for (i = 0; i < LOGSTRESS_PRODUCERS; i++) {
+        if (pthread_create(&producers[i], NULL, LogStress_Producer, (void *)(uintptr_t)i) != 0) {
+            perror("logstress: producer");
+            return 2;
+        }
+    }
+    for (i = 0; i < LOGSTRESS_PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    pthread_join(consumer, NULL);
+
+    dropped = UART_LogGetDropped();
+    ok = (check.corrupt == 0U && check.reordered == 0U && check.stuck == 0U && check.lineLen == 0U &&
+          check.delivered + dropped == total);
+    printf("logstress: %u producers, %llu messages: delivered %llu, dropped %llu, corrupt %llu, "
+           "out of order %llu%s\n", (unsigned)LOGSTRESS_PRODUCERS, (unsigned long long)total,
+           (unsigned long long)check.delivered, (unsigned long long)dropped,
+           (unsigned long long)check.corrupt, (unsigned long long)check.reordered,
+           check.stuck ? ", ring stuck on an uncommitted record" : "");
+    printf("logstress: %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
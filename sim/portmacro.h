@@ -0,0 +1,24 @@
+#ifndef SIM_PORTMACRO_H
+#define SIM_PORTMACRO_H
+
+// Found before the POSIX port's portmacro.h (sim/Makefile include order) and
+// includes it, then makes the FromISR interrupt mask a real one. The port
+// leaves portSET_INTERRUPT_MASK_FROM_ISR empty because its only ISR, the tick
+// signal handler, runs with signals blocked anyway. The firmware also uses the
+// mask in tasks to keep the device interrupts out of short sections (the CAN TX
+// engine, the 1588 time extension, the run-time counter), as BASEPRI does on the
+// Cortex-M4. Here the device interrupts are the SimIRQ task, which the tick can
+// switch to at any time, so the mask blocks the signals of the calling thread
+// until it is cleared.
+
+#include_next "portmacro.h"
+
+UBaseType_t Sim_SetInterruptMask(void);
+void Sim_ClearInterruptMask(UBaseType_t mask);
+
+#undef portSET_INTERRUPT_MASK_FROM_ISR
+#undef portCLEAR_INTERRUPT_MASK_FROM_ISR
+#define portSET_INTERRUPT_MASK_FROM_ISR()       Sim_SetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)    Sim_ClearInterruptMask(x)
+
+#endif /* SIM_PORTMACRO_H */
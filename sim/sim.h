@@ -0,0 +1,94 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fsl_common.h"
+
+// Host simulation of the board (sim/Makefile). The firmware sources build
+// unchanged against the stub SDK headers in sim/include; the devices behind them
+// are simulated here:
+//   ENET     frames sent go round a simulated EtherCAT segment (sim_ecat.c) and
+//            come back into the RX ring, like a cable to real slaves
+//   FlexCAN  TX mailboxes complete on the next tick, a simulated joystick node
+//            sends the MOVES and BUTTONS PDOs every SIM_CAN_JOYSTICK_MS
+//   UART0    the log drains to stdout at the UART baud rate, stdin is the shell
+// The interrupts of these devices are delivered by the "SimIRQ" task, above every
+// firmware task, woken every tick and at once when a frame is sent. The callbacks
+// and handlers therefore run in task context with the same FromISR API calls and
+// the same preemption of the firmware tasks as the real ISRs.
+//
+// Time follows the kernel tick, with host time in between: the DWT cycle
+// counter, the ENET 1588 timer and the FlexCAN timer all count it at their target
+// rates, so the cycle counts printed by the firmware are in 120 MHz cycles and
+// agree with the tick even when the host is late delivering it.
+
+#define SIM_IRQ_TASK_STACK_SIZE     (4096U)     // Words
+#define SIM_TICK_NS                 (1000000000ULL / configTICK_RATE_HZ)    // FreeRTOSConfig.h
+#define SIM_IDLE_SLEEP_US           (1000U)     // Idle hook sleep, bounded by the next tick anyway
+
+#define SIM_CAN_DEFAULT_JOYSTICK_MS (20U)       // SIM_CAN_JOYSTICK_MS, 0 disables the simulated joystick node
+#define SIM_CAN_RX_FIFO_DEPTH       (6U)        // Legacy RX FIFO of the FlexCAN
+
+#define SIM_UART_BAUD               (115200U)   // 0 drains the log at once
+
+// Simulated EtherCAT segment, overridden by the SIM_ECAT_SLAVES,
+// SIM_ECAT_PD_BYTES, SIM_ECAT_MBX_SIZE and SIM_ECAT_BOOT_MBX_SIZE environment
+// variables
+#define SIM_ECAT_DEFAULT_SLAVES     (4U)
+#define SIM_ECAT_DEFAULT_PD_BYTES   (8U)        // Process data bytes per slave, each direction
+#define SIM_ECAT_DEFAULT_MBX_SIZE   (128U)      // SM0 and SM1, 0 for slaves without mailbox
+#define SIM_ECAT_DEFAULT_BOOT_MBX_SIZE (1024U)  // SM0 in BOOT, SM1 keeps the standard size
+#define SIM_ECAT_MAX_SLAVES         (256U)
+#define SIM_ECAT_MAX_PD_BYTES       (256U)
+#define SIM_ECAT_MIN_MBX_SIZE       (32U)
+#define SIM_ECAT_MAX_MBX_SIZE       (1486U)
+#define SIM_ECAT_MBX_QUEUE          (4U)        // Mailboxes a slave holds for the master
+#define SIM_ECAT_REG_SIZE           (0x3000U)   // ESC registers and process RAM of one slave
+
+// Second 512 KB block of the program flash, mapped read-only at its target
+// address from the SIM_FLASH_IMAGE file (zero padded), else a fixed
+// pseudo-random pattern. The simulated FoE bootloader compares files with it.
+#define SIM_FLASH_ADDR              (0x00080000UL)
+#define SIM_FLASH_SIZE              (0x00080000UL)
+
+typedef struct {
+    uint32_t frames;                // EtherCAT frames processed
+    uint32_t datagrams;
+    uint32_t errors;                // Malformed frames, forwarded untouched
+    uint32_t other_frames;          // Non-EtherCAT frames, forwarded untouched
+    uint32_t mailboxes_in;          // Mailboxes taken by the slaves
+    uint32_t mailboxes_out;         // Mailboxes read by the master
+    uint32_t mailbox_errors;        // Mailboxes dropped, malformed or out of sequence
+    uint32_t eoe_frames;            // EoE frames echoed
+} sim_ecat_stats_t;
+
+// Host clock, ns since the start of the simulation
+uint64_t Sim_NowNs(void);
+
+// Wake the interrupt task now. From task context only (not with interrupts masked).
+void Sim_IrqKick(void);
+bool Sim_IrqIsEnabled(IRQn_Type irq);
+
+// Flash block at SIM_FLASH_ADDR, NULL if it could not be mapped
+const uint8_t *Sim_FlashBlock(void);
+
+// Device services, run by the interrupt task
+void Sim_EnetService(void);
+void Sim_CanService(void);
+void Sim_UartService(void);
+
+// Firmware interrupt handler the services call directly (enet_raw.c)
+void ENET_1588_Timer_IRQHandler(void);
+
+// Simulated EtherCAT segment
+void Sim_CanInit(uint32_t joystickPeriodMs);
+void Sim_EcatInit(uint32_t slaves, uint32_t pdBytes, uint32_t mbxSize, uint32_t bootMbxSize);
+void Sim_EcatProcess(uint8_t *frame, uint32_t length);
+uint32_t Sim_EcatGetSlaveCount(void);
+uint32_t Sim_EcatGetPdBytes(void);
+uint32_t Sim_EcatGetMbxSize(void);
+uint32_t Sim_EcatGetBootMbxSize(void);
+void Sim_EcatGetStats(sim_ecat_stats_t *stats);
+
+#endif /* SIM_H */
@@ -0,0 +1,286 @@
+#include "sim.h"
+#include "fsl_flexcan.h"
+#include "peripherals.h"
+#include "CANopen_HAL.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Simulated FlexCAN with the legacy RX FIFO and one node on the bus, a joystick
+// sending MOVES and BUTTONS. The transactional driver keeps the SDK behaviour
+// CANopen_HAL.c relies on:
+//   - a TX mailbox completes with kStatus_FLEXCAN_TxIdle and its index, here on
+//     the next run of the interrupt task (about a frame time at 250 kbit/s)
+//   - each FIFO frame is handed over with kStatus_FLEXCAN_RxFifoIdle into the
+//     buffer of the armed FIFO transfer, which the callback re-arms
+//   - frames wait in a 6-deep FIFO while no transfer is armed, then overflow
+//   - frames sent are received back when they pass the FIFO filters
+//     (self-reception is on in CAN0_config)
+// The timer counts one per bit time of host time, for the frame timestamps.
+
+static CAN_Type simCanRegs;
+static flexcan_handle_t *simCanHandle = NULL;
+
+// RX FIFO filter table, type A standard IDs
+static uint32_t simCanFilters[CAN_RX_FIFO_FILTER_NUM];
+static uint32_t simCanFilterNum = 0;
+static uint32_t simCanGlobalMask = 0;
+
+static flexcan_frame_t simCanFifo[SIM_CAN_RX_FIFO_DEPTH];
+static uint32_t simCanFifoHead = 0;
+static uint32_t simCanFifoTail = 0;
+static bool simCanFifoOverflow = false;
+
+static flexcan_frame_t simCanMailbox[CAN_TX_MAILBOX_END];
+static volatile uint32_t simCanTxPending = 0;
+
+static uint32_t simJoystickPeriodMs = SIM_CAN_DEFAULT_JOYSTICK_MS;
+static uint64_t simJoystickNextNs = 0;
+static uint32_t simJoystickStep = 0;
+
+void Sim_CanInit(uint32_t joystickPeriodMs)
+{
+    simJoystickPeriodMs = joystickPeriodMs;
+}
+
+/*******************************************************************************
+ * Registers
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_CanRegs
+ * Description   : CAN0 register block with the free-running timer brought up to
+ *                 date: one count per bit time, 16 bits
+ *
+ *END**************************************************************************/
+CAN_Type *Sim_CanRegs(void)
+{
+    simCanRegs.TIMER = (uint32_t)(Sim_NowNs() / (1000000000UL / CAN0_config.bitRate)) & CAN_TIMER_TIMER_MASK;
+    return &simCanRegs;
+}
+
+/*******************************************************************************
+ * Driver
+ ******************************************************************************/
+void FLEXCAN_EnterFreezeMode(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_ExitFreezeMode(CAN_Type *base)
+{
+    (void)base;
+}
+
+void FLEXCAN_SetRxFifoGlobalMask(CAN_Type *base, uint32_t mask)
+{
+    (void)base;
+    simCanGlobalMask = mask;
+}
+
+void FLEXCAN_SetRxFifoConfig(CAN_Type *base, const flexcan_rx_fifo_config_t *pRxFifoConfig, bool enable)
+{
+    uint32_t i;
+
+    (void)base;
+
+    simCanFilterNum = 0;
+    if (enable) {
+        for (i = 0; i < pRxFifoConfig->idFilterNum && i < CAN_RX_FIFO_FILTER_NUM; i++) {
+            simCanFilters[i] = pRxFifoConfig->idFilterTable[i];
+        }
+        simCanFilterNum = i;
+    }
+    simCanFifoHead = 0;
+    simCanFifoTail = 0;
+}
+
+void FLEXCAN_SetTxMbConfig(CAN_Type *base, uint8_t mbIdx, bool enable)
+{
+    (void)base;
+
+    if (!enable) {
+        simCanTxPending &= ~(1UL << mbIdx);
+    }
+}
+
+void FLEXCAN_TransferCreateHandle(CAN_Type *base, flexcan_handle_t *handle,
+                                  flexcan_transfer_callback_t callback, void *userData)
+{
+    (void)base;
+
+    memset(handle, 0, sizeof(*handle));
+    handle->callback = callback;
+    handle->userData = userData;
+    simCanHandle = handle;
+    simJoystickNextNs = Sim_NowNs();
+
+    (void)EnableIRQ(CAN0_ORed_Message_buffer_IRQn);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : FLEXCAN_TransferSendNonBlocking
+ * Description   : Load a TX mailbox. Called with the CAN interrupt masked, so
+ *                 the interrupt task picks the frame up on its next run.
+ *
+ *END**************************************************************************/
+status_t FLEXCAN_TransferSendNonBlocking(CAN_Type *base, flexcan_handle_t *handle, flexcan_mb_transfer_t *pMbXfer)
+{
+    (void)base;
+    (void)handle;
+
+    if (pMbXfer->mbIdx >= CAN_TX_MAILBOX_END) {
+        return kStatus_InvalidArgument;
+    }
+    if (simCanTxPending & (1UL << pMbXfer->mbIdx)) {
+        return kStatus_FLEXCAN_TxBusy;
+    }
+
+    simCanMailbox[pMbXfer->mbIdx] = *pMbXfer->frame;
+    __DMB();
+    simCanTxPending |= (1UL << pMbXfer->mbIdx);
+    return kStatus_Success;
+}
+
+status_t FLEXCAN_TransferReceiveFifoNonBlocking(CAN_Type *base, flexcan_handle_t *handle,
+                                                flexcan_fifo_transfer_t *pFifoXfer)
+{
+    (void)base;
+
+    if (handle->rxFifoFrameBuf != NULL) {
+        return kStatus_FLEXCAN_RxFifoBusy;
+    }
+    handle->rxFifoFrameBuf = pFifoXfer->frame;
+    return kStatus_Success;
+}
+
+/*******************************************************************************
+ * Bus side, run by the interrupt task
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_CanFifoPush
+ * Description   : A frame on the bus: into the RX FIFO if a filter accepts it
+ *
+ *END**************************************************************************/
+static void Sim_CanFifoPush(const flexcan_frame_t *frame)
+{
+    uint32_t id = FLEXCAN_RX_FIFO_STD_FILTER_TYPE_A(frame->id >> CAN_ID_STD_SHIFT, frame->type, frame->format);
+    uint32_t i;
+
+    for (i = 0; i < simCanFilterNum; i++) {
+        if (((id ^ simCanFilters[i]) & simCanGlobalMask) == 0U) {
+            break;
+        }
+    }
+    if (i == simCanFilterNum) {
+        return;
+    }
+
+    if ((simCanFifoHead - simCanFifoTail) >= SIM_CAN_RX_FIFO_DEPTH) {
+        simCanFifoOverflow = true;
+        return;
+    }
+    simCanFifo[simCanFifoHead % SIM_CAN_RX_FIFO_DEPTH] = *frame;
+    simCanFifo[simCanFifoHead % SIM_CAN_RX_FIFO_DEPTH].timestamp = simCanRegs.TIMER;
+    simCanFifo[simCanFifoHead % SIM_CAN_RX_FIFO_DEPTH].idhit = i;
+    simCanFifoHead++;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_CanJoystick
+ * Description   : The simulated joystick node: both axes sweep a triangle over
+ *                 four seconds around the centre, enable and E-stop released
+ *                 (bit set), speed toggling every five seconds
+ *
+ *END**************************************************************************/
+static void Sim_CanJoystick(uint64_t now)
+{
+    flexcan_frame_t frame;
+    uint32_t phase;
+    uint32_t x;
+    uint32_t y;
+    uint32_t buttons;
+
+    while (simJoystickPeriodMs != 0U && now >= simJoystickNextNs) {
+        simJoystickNextNs += (uint64_t)simJoystickPeriodMs * 1000000ULL;
+        simJoystickStep++;
+
+        phase = (simJoystickStep * simJoystickPeriodMs) % 4000U;
+        x = (phase < 2000U) ? (phase * 10000U / 2000U) : ((4000U - phase) * 10000U / 2000U);
+        y = 10000U - x;
+
+        memset(&frame, 0, sizeof(frame));
+        frame.format = kFLEXCAN_FrameFormatStandard;
+        frame.type = kFLEXCAN_FrameTypeData;
+        frame.length = 4;
+        frame.id = FLEXCAN_ID_STD(MOVES_ID);
+        frame.dataWord0 = __REV(y | (x << 16));
+        Sim_CanFifoPush(&frame);
+
+        buttons = (1UL << 0) | (1UL << 2) | (1UL << 4);     // Enable, E_Stop released, CAN_Enable
+        if (((simJoystickStep * simJoystickPeriodMs) / 5000U) & 1U) {
+            buttons |= (1UL << 1);                          // Speed
+        }
+        frame.id = FLEXCAN_ID_STD(BUTTONS_ID);
+        frame.dataWord0 = __REV(buttons << 24);
+        Sim_CanFifoPush(&frame);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_CanService
+ * Description   : Complete the loaded TX mailboxes, run the joystick node and
+ *                 hand the FIFO frames to the armed transfer, through the
+ *                 driver callback like the CAN0 ISR
+ *
+ *END**************************************************************************/
+void Sim_CanService(void)
+{
+    flexcan_handle_t *handle = simCanHandle;
+    uint32_t pending;
+    uint32_t mb;
+
+    if (handle == NULL || !Sim_IrqIsEnabled(CAN0_ORed_Message_buffer_IRQn)) {
+        return;
+    }
+    (void)Sim_CanRegs();
+
+    pending = simCanTxPending;
+    while (pending != 0U) {
+        mb = (uint32_t)__builtin_ctz(pending);
+        pending &= ~(1UL << mb);
+        __DMB();
+        if (!CAN0_config.disableSelfReception) {
+            Sim_CanFifoPush(&simCanMailbox[mb]);
+        }
+        simCanTxPending &= ~(1UL << mb);
+        if (handle->callback != NULL) {
+            handle->callback(&simCanRegs, handle, kStatus_FLEXCAN_TxIdle, mb, handle->userData);
+        }
+    }
+
+    Sim_CanJoystick(Sim_NowNs());
+
+    if (simCanFifoOverflow) {
+        simCanFifoOverflow = false;
+        if (handle->callback != NULL) {
+            handle->callback(&simCanRegs, handle, kStatus_FLEXCAN_RxFifoOverflow, 0, handle->userData);
+        }
+    }
+
+    while (simCanFifoTail != simCanFifoHead && handle->rxFifoFrameBuf != NULL) {
+        flexcan_frame_t *buffer = handle->rxFifoFrameBuf;
+
+        *buffer = simCanFifo[simCanFifoTail % SIM_CAN_RX_FIFO_DEPTH];
+        simCanFifoTail++;
+        handle->rxFifoFrameBuf = NULL;
+        if (handle->callback != NULL) {
+            handle->callback(&simCanRegs, handle, kStatus_FLEXCAN_RxFifoIdle, 0, handle->userData);
+        }
+    }
+}
@@ -0,0 +1,815 @@
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Simulated EtherCAT segment: a line of slaves, each an ESC register space and
+// a process data window in the logical address space. A frame is processed by
+// the slaves in turn, which gives the same result as the slaves working on it
+// on the fly. Modelled:
+//   APxx/FPxx/BRxx/ARMW/FRMW on the ESC registers, station address at 0x0010,
+//   AL control 0x0120 acknowledged at once in AL status 0x0130
+//   LRD/LWR/LRW on the process data: slave n owns logical bytes
+//   [n * pdBytes, (n + 1) * pdBytes), its inputs return the outputs of the
+//   previous write (a loopback I/O slave)
+//   mailboxes: SM0 (master to slave) at 0x1000 and SM1 (slave to master) right
+//   after it, mbxSize bytes each, SM0 bootMbxSize bytes in BOOT, set up as the
+//   master would from the SII and active outside INIT. A mailbox is written or
+//   read as a whole; writing a full SM0 or reading an empty SM1 is answered
+//   with WKC 0, the SM status bit 3 at 0x0805/0x080D shows full. The slaves
+//   serve their mailboxes after every frame:
+//     EoE  frames are reassembled and echoed back, fragmented to the slave
+//          mailbox size (an EoE loopback slave)
+//     FoE  a bootloader taking a file write: WRQ, then DATA packets in order,
+//          each acknowledged (queued ACKs coalesce), a short one ends the file.
+//          The file is compared with the flash block at SIM_FLASH_ADDR and the
+//          outcome printed on stderr, nothing is written.
+//   working counter: +1 per read, +1 per write, +3 per read/write
+// Not modelled: distributed clocks, SII EEPROM, FMMU setup (the logical mapping
+// is fixed), mailbox repeat, wire and forwarding delays.
+
+#define ECAT_ETHERTYPE_HI       (0x88U)
+#define ECAT_ETHERTYPE_LO       (0xA4U)
+#define ECAT_ETH_HEADER_SIZE    (14U)
+#define ECAT_HEADER_SIZE        (2U)
+#define ECAT_DATAGRAM_HEADER    (10U)
+#define ECAT_WKC_SIZE           (2U)
+
+#define ECAT_REG_TYPE           (0x0000U)
+#define ECAT_REG_STATION_ADDR   (0x0010U)
+#define ECAT_REG_AL_CONTROL     (0x0120U)
+#define ECAT_REG_AL_STATUS      (0x0130U)
+#define ECAT_REG_SM0            (0x0800U)
+#define ECAT_REG_SM1            (0x0808U)
+#define ECAT_AL_STATE_INIT      (0x01U)
+#define ECAT_ESC_TYPE           (0x11U)     // ET1100
+
+// Sync manager registers, from the SM base
+#define ECAT_SM_START           (0U)
+#define ECAT_SM_LENGTH          (2U)
+#define ECAT_SM_CONTROL         (4U)
+#define ECAT_SM_STATUS          (5U)
+#define ECAT_SM_ACTIVATE        (6U)
+#define ECAT_SM_CONTROL_MBX_OUT (0x26U)     // Mailbox, written by the master
+#define ECAT_SM_CONTROL_MBX_IN  (0x22U)     // Mailbox, read by the master
+#define ECAT_SM_STATUS_FULL     (0x08U)
+#define ECAT_MBX_START          (0x1000U)
+
+// Mailbox and EoE headers (ETG.1000.6)
+#define ECAT_MBX_HEADER_SIZE    (6U)
+#define ECAT_MBX_TYPE_EOE       (0x02U)
+#define ECAT_MBX_TYPE_FOE       (0x04U)
+#define ECAT_EOE_HEADER_SIZE    (4U)
+#define ECAT_EOE_LAST_FRAGMENT  (0x0100U)
+#define ECAT_EOE_TIME_APPENDED  (0x0200U)
+#define ECAT_EOE_UNIT           (32U)
+#define ECAT_EOE_MAX_FRAME      (1518U)
+#define ECAT_FOE_HEADER_SIZE    (6U)
+#define ECAT_FOE_OP_WRQ         (2U)
+#define ECAT_FOE_OP_DATA        (3U)
+#define ECAT_FOE_OP_ACK         (4U)
+#define ECAT_FOE_OP_ERR         (5U)
+#define ECAT_FOE_ERR_ILLEGAL    (0x8004U)
+#define ECAT_FOE_ERR_PACKET_NO  (0x8005U)
+#define ECAT_FOE_MAX_NAME       (32U)
+#define ECAT_AL_STATE_BOOT      (0x03U)
+
+typedef enum {
+    ECAT_CMD_NOP = 0, ECAT_CMD_APRD, ECAT_CMD_APWR, ECAT_CMD_APRW,
+    ECAT_CMD_FPRD, ECAT_CMD_FPWR, ECAT_CMD_FPRW,
+    ECAT_CMD_BRD, ECAT_CMD_BWR, ECAT_CMD_BRW,
+    ECAT_CMD_LRD, ECAT_CMD_LWR, ECAT_CMD_LRW,
+    ECAT_CMD_ARMW, ECAT_CMD_FRMW
+} sim_ecat_cmd_t;
+
+typedef struct {
+    uint8_t regs[SIM_ECAT_REG_SIZE];
+    uint8_t outputs[SIM_ECAT_MAX_PD_BYTES];
+    uint8_t inputs[SIM_ECAT_MAX_PD_BYTES];
+    uint16_t sm0Size;               // Mailbox sizes of the AL state
+    uint16_t sm1Size;
+
+    // Mailboxes waiting for SM1, oldest first
+    uint8_t outQueue[SIM_ECAT_MBX_QUEUE][SIM_ECAT_MAX_MBX_SIZE];
+    uint32_t outFirst;
+    uint32_t outCount;
+    uint8_t outCounter;
+
+    // EoE frame being reassembled, then echoed
+    uint8_t eoeFrame[ECAT_EOE_MAX_FRAME];
+    uint16_t eoeLength;
+    uint16_t eoeSize;               // Announced in the first fragment
+    uint16_t eoeEchoOffset;
+    uint8_t eoeFragment;
+    uint8_t eoeFrameNo;
+    bool eoeReceiving;
+    bool eoeEchoing;
+
+    // FoE file being written
+    char foeName[ECAT_FOE_MAX_NAME + 1U];
+    uint32_t foeNext;               // DATA packet expected
+    uint32_t foeBytes;
+    uint32_t foeMismatch;           // First byte differing from flash, or foeBytes
+    bool foeActive;
+} sim_ecat_slave_t;
+
+static sim_ecat_slave_t *simSlaves = NULL;
+static uint32_t simSlaveCount = 0;
+static uint32_t simPdBytes = 0;
+static uint32_t simMbxSize = 0;
+static uint32_t simBootMbxSize = 0;
+static sim_ecat_stats_t simEcatStats;
+
+static uint16_t Sim_Get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void Sim_Put16(uint8_t *p, uint16_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static uint32_t Sim_Get32(const uint8_t *p)
+{
+    return (uint32_t)Sim_Get16(p) | ((uint32_t)Sim_Get16(&p[2]) << 16);
+}
+
+static void Sim_Put32(uint8_t *p, uint32_t value)
+{
+    Sim_Put16(p, (uint16_t)value);
+    Sim_Put16(&p[2], (uint16_t)(value >> 16));
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatMailboxConfig
+ * Description   : Set up SM0 and SM1 for the AL state: active outside INIT, the
+ *                 boot mailbox in BOOT. Mailbox exchanges in flight are dropped
+ *                 when the mailboxes go off or move.
+ *
+ *END**************************************************************************/
+static void Sim_EcatMailboxConfig(sim_ecat_slave_t *slave)
+{
+    uint8_t *sm0 = &slave->regs[ECAT_REG_SM0];
+    uint8_t *sm1 = &slave->regs[ECAT_REG_SM1];
+    uint8_t state = slave->regs[ECAT_REG_AL_STATUS] & 0x0FU;
+    uint16_t sm0Size = (uint16_t)((state == ECAT_AL_STATE_BOOT) ? simBootMbxSize : simMbxSize);
+    bool active = (simMbxSize != 0U && state != ECAT_AL_STATE_INIT);
+    bool keep = (active && sm0Size == slave->sm0Size);
+    uint8_t sm0Status = keep ? sm0[ECAT_SM_STATUS] : 0U;
+    uint8_t sm1Status = keep ? sm1[ECAT_SM_STATUS] : 0U;
+
+    memset(sm0, 0, 16U);
+    slave->sm0Size = sm0Size;
+    slave->sm1Size = (uint16_t)simMbxSize;
+    if (simMbxSize == 0U) {
+        return;
+    }
+    Sim_Put16(&sm0[ECAT_SM_START], (uint16_t)ECAT_MBX_START);
+    Sim_Put16(&sm0[ECAT_SM_LENGTH], sm0Size);
+    sm0[ECAT_SM_CONTROL] = ECAT_SM_CONTROL_MBX_OUT;
+    sm0[ECAT_SM_STATUS] = sm0Status;
+    sm0[ECAT_SM_ACTIVATE] = active ? 1U : 0U;
+    Sim_Put16(&sm1[ECAT_SM_START], (uint16_t)(ECAT_MBX_START + sm0Size));
+    Sim_Put16(&sm1[ECAT_SM_LENGTH], slave->sm1Size);
+    sm1[ECAT_SM_CONTROL] = ECAT_SM_CONTROL_MBX_IN;
+    sm1[ECAT_SM_STATUS] = sm1Status;
+    sm1[ECAT_SM_ACTIVATE] = active ? 1U : 0U;
+
+    if (!keep) {
+        slave->outFirst = 0;
+        slave->outCount = 0;
+        slave->eoeReceiving = false;
+        slave->eoeEchoing = false;
+        slave->foeActive = false;
+    }
+}
+
+static bool Sim_EcatMailboxActive(const sim_ecat_slave_t *slave)
+{
+    return slave->regs[ECAT_REG_SM0 + ECAT_SM_ACTIVATE] != 0U;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatInit
+ * Description   : Build a segment of slaves in INIT, station address 0
+ *
+ *END**************************************************************************/
+void Sim_EcatInit(uint32_t slaves, uint32_t pdBytes, uint32_t mbxSize, uint32_t bootMbxSize)
+{
+    uint32_t i;
+
+    if (slaves > SIM_ECAT_MAX_SLAVES) {
+        slaves = SIM_ECAT_MAX_SLAVES;
+    }
+    if (pdBytes > SIM_ECAT_MAX_PD_BYTES) {
+        pdBytes = SIM_ECAT_MAX_PD_BYTES;
+    }
+    if (mbxSize != 0U && mbxSize < SIM_ECAT_MIN_MBX_SIZE) {
+        mbxSize = SIM_ECAT_MIN_MBX_SIZE;
+    }
+    if (mbxSize > SIM_ECAT_MAX_MBX_SIZE) {
+        mbxSize = SIM_ECAT_MAX_MBX_SIZE;
+    }
+    if (bootMbxSize < mbxSize) {
+        bootMbxSize = mbxSize;
+    }
+    if (bootMbxSize > SIM_ECAT_MAX_MBX_SIZE) {
+        bootMbxSize = SIM_ECAT_MAX_MBX_SIZE;
+    }
+
+    free(simSlaves);
+    simSlaves = (slaves > 0U) ? calloc(slaves, sizeof(sim_ecat_slave_t)) : NULL;
+    if (slaves > 0U && simSlaves == NULL) {
+        fprintf(stderr, "sim: no memory for %lu EtherCAT slaves\n", (unsigned long)slaves);
+        abort();
+    }
+    simSlaveCount = slaves;
+    simPdBytes = pdBytes;
+    simMbxSize = mbxSize;
+    simBootMbxSize = (mbxSize != 0U) ? bootMbxSize : 0U;
+    memset(&simEcatStats, 0, sizeof(simEcatStats));
+
+    for (i = 0; i < slaves; i++) {
+        simSlaves[i].regs[ECAT_REG_TYPE] = ECAT_ESC_TYPE;
+        simSlaves[i].regs[ECAT_REG_AL_STATUS] = ECAT_AL_STATE_INIT;
+        Sim_EcatMailboxConfig(&simSlaves[i]);
+    }
+}
+
+uint32_t Sim_EcatGetSlaveCount(void)
+{
+    return simSlaveCount;
+}
+
+uint32_t Sim_EcatGetPdBytes(void)
+{
+    return simPdBytes;
+}
+
+uint32_t Sim_EcatGetMbxSize(void)
+{
+    return simMbxSize;
+}
+
+uint32_t Sim_EcatGetBootMbxSize(void)
+{
+    return simBootMbxSize;
+}
+
+void Sim_EcatGetStats(sim_ecat_stats_t *stats)
+{
+    *stats = simEcatStats;
+}
+
+static bool Sim_EcatOverlaps(uint16_t offset, uint16_t length, uint32_t start, uint32_t size)
+{
+    return (uint32_t)offset < start + size && (uint32_t)offset + length > start;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatMailboxAccess
+ * Description   : Access touching an active mailbox, returns the working
+ *                 counter increment. Only a write of the whole empty SM0 and a
+ *                 read of the whole full SM1 are served, as the ESC does.
+ *
+ *END**************************************************************************/
+static uint16_t Sim_EcatMailboxAccess(sim_ecat_slave_t *slave, uint16_t offset, uint8_t *data,
+                                      uint16_t length, bool read, bool write)
+{
+    uint8_t *sm0Status = &slave->regs[ECAT_REG_SM0 + ECAT_SM_STATUS];
+    uint8_t *sm1Status = &slave->regs[ECAT_REG_SM1 + ECAT_SM_STATUS];
+
+    if (read == write) {
+        return 0;
+    }
+    if (write && offset == ECAT_MBX_START && length == slave->sm0Size &&
+        (*sm0Status & ECAT_SM_STATUS_FULL) == 0U) {
+        memcpy(&slave->regs[offset], data, length);
+        *sm0Status |= ECAT_SM_STATUS_FULL;
+        return 1;
+    }
+    if (read && offset == ECAT_MBX_START + slave->sm0Size && length == slave->sm1Size &&
+        (*sm1Status & ECAT_SM_STATUS_FULL) != 0U) {
+        memcpy(data, &slave->regs[offset], length);
+        *sm1Status &= (uint8_t)~ECAT_SM_STATUS_FULL;
+        simEcatStats.mailboxes_out++;
+        return 1;
+    }
+    return 0;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatRegisterAccess
+ * Description   : Read and/or write a register range of one slave, returns the
+ *                 working counter increment. Writing AL control sets AL status.
+ *
+ *END**************************************************************************/
+static uint16_t Sim_EcatRegisterAccess(sim_ecat_slave_t *slave, uint16_t offset, uint8_t *data,
+                                       uint16_t length, bool read, bool write, bool orRead)
+{
+    static uint8_t old[SIM_ECAT_REG_SIZE];
+    uint16_t i;
+
+    if ((uint32_t)offset + length > SIM_ECAT_REG_SIZE) {
+        return 0;
+    }
+    if (Sim_EcatMailboxActive(slave) &&
+        Sim_EcatOverlaps(offset, length, ECAT_MBX_START, (uint32_t)slave->sm0Size + slave->sm1Size)) {
+        return orRead ? 0U : Sim_EcatMailboxAccess(slave, offset, data, length, read, write);
+    }
+
+    if (read && write) {
+        memcpy(old, &slave->regs[offset], length);
+    }
+    if (write) {
+        memcpy(&slave->regs[offset], data, length);
+        if (offset <= ECAT_REG_AL_CONTROL && (uint32_t)offset + length > ECAT_REG_AL_CONTROL) {
+            slave->regs[ECAT_REG_AL_STATUS] = slave->regs[ECAT_REG_AL_CONTROL] & 0x0FU;
+            Sim_EcatMailboxConfig(slave);
+        }
+    }
+    if (read) {
+        const uint8_t *source = write ? old : &slave->regs[offset];
+
+        for (i = 0; i < length; i++) {
+            data[i] = orRead ? (uint8_t)(data[i] | source[i]) : source[i];
+        }
+    }
+
+    return (uint16_t)((read && write) ? 3U : 1U);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatLogicalAccess
+ * Description   : LRD/LWR/LRW on the process data window of one slave, returns
+ *                 the working counter increment
+ *
+ *END**************************************************************************/
+static uint16_t Sim_EcatLogicalAccess(uint32_t position, uint32_t address, uint8_t *data, uint16_t length,
+                                      bool read, bool write)
+{
+    sim_ecat_slave_t *slave = &simSlaves[position];
+    uint32_t start = position * simPdBytes;
+    uint32_t end = start + simPdBytes;
+    uint32_t first;
+    uint32_t last;
+    uint32_t i;
+
+    first = (address > start) ? address : start;
+    last = ((address + length) < end) ? (address + length) : end;
+    if (simPdBytes == 0U || first >= last) {
+        return 0;
+    }
+
+    for (i = first; i < last; i++) {
+        uint8_t *byte = &data[i - address];
+        uint8_t input = slave->inputs[i - start];
+
+        if (write) {
+            slave->outputs[i - start] = *byte;
+            slave->inputs[i - start] = *byte;
+        }
+        if (read) {
+            *byte = input;
+        }
+    }
+
+    return (uint16_t)((read && write) ? 3U : 1U);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatDatagram
+ * Description   : One datagram through one slave, returns the working counter
+ *                 increment. Auto-increment addresses are counted up here.
+ *
+ *END**************************************************************************/
+static uint16_t Sim_EcatDatagram(uint32_t position, uint8_t *header, uint8_t *data, uint16_t length)
+{
+    sim_ecat_slave_t *slave = &simSlaves[position];
+    uint8_t command = header[0];
+    uint16_t adp = Sim_Get16(&header[2]);
+    uint16_t ado = Sim_Get16(&header[4]);
+    uint32_t logical = (uint32_t)adp | ((uint32_t)ado << 16);
+    bool addressed;
+    uint16_t wkc = 0;
+
+    switch (command) {
+    case ECAT_CMD_APRD:
+    case ECAT_CMD_APWR:
+    case ECAT_CMD_APRW:
+    case ECAT_CMD_ARMW:
+        addressed = (adp == 0U);
+        Sim_Put16(&header[2], (uint16_t)(adp + 1U));
+        if (addressed) {
+            wkc = Sim_EcatRegisterAccess(slave, ado, data, length,
+                                         command != ECAT_CMD_APWR,
+                                         command == ECAT_CMD_APWR || command == ECAT_CMD_APRW, false);
+        } else if (command == ECAT_CMD_ARMW) {
+            // Every other slave writes what the addressed one read
+            wkc = Sim_EcatRegisterAccess(slave, ado, data, length, false, true, false);
+        }
+        break;
+
+    case ECAT_CMD_FPRD:
+    case ECAT_CMD_FPWR:
+    case ECAT_CMD_FPRW:
+    case ECAT_CMD_FRMW:
+        addressed = (Sim_Get16(&slave->regs[ECAT_REG_STATION_ADDR]) == adp);
+        if (addressed) {
+            wkc = Sim_EcatRegisterAccess(slave, ado, data, length,
+                                         command != ECAT_CMD_FPWR,
+                                         command == ECAT_CMD_FPWR || command == ECAT_CMD_FPRW, false);
+        } else if (command == ECAT_CMD_FRMW) {
+            wkc = Sim_EcatRegisterAccess(slave, ado, data, length, false, true, false);
+        }
+        break;
+
+    case ECAT_CMD_BRD:
+    case ECAT_CMD_BWR:
+    case ECAT_CMD_BRW:
+        Sim_Put16(&header[2], (uint16_t)(adp + 1U));
+        wkc = Sim_EcatRegisterAccess(slave, ado, data, length,
+                                     command != ECAT_CMD_BWR, command != ECAT_CMD_BRD, true);
+        break;
+
+    case ECAT_CMD_LRD:
+    case ECAT_CMD_LWR:
+    case ECAT_CMD_LRW:
+        wkc = Sim_EcatLogicalAccess(position, logical, data, length,
+                                    command != ECAT_CMD_LWR, command != ECAT_CMD_LRD);
+        break;
+
+    default:
+        break;
+    }
+
+    return wkc;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatQueueMailbox
+ * Description   : Append a mailbox for the master to the out queue, header
+ *                 written, service data zeroed. NULL if the queue is full.
+ *
+ *END**************************************************************************/
+static uint8_t *Sim_EcatQueueMailbox(sim_ecat_slave_t *slave, uint8_t type, uint16_t length)
+{
+    uint8_t *mbx;
+
+    if (slave->outCount >= SIM_ECAT_MBX_QUEUE) {
+        return NULL;
+    }
+    mbx = slave->outQueue[(slave->outFirst + slave->outCount) % SIM_ECAT_MBX_QUEUE];
+    slave->outCount++;
+
+    memset(mbx, 0, slave->sm1Size);
+    Sim_Put16(&mbx[0], length);
+    slave->outCounter = (uint8_t)((slave->outCounter % 7U) + 1U);
+    mbx[5] = (uint8_t)(type | (slave->outCounter << 4));
+    return mbx;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatEoeReceive
+ * Description   : One EoE fragment taken from SM0. A complete frame starts its
+ *                 echo; broken sequences are dropped and counted.
+ *
+ *END**************************************************************************/
+static void Sim_EcatEoeReceive(sim_ecat_slave_t *slave, const uint8_t *eoe, uint16_t length)
+{
+    uint16_t word0;
+    uint16_t word1;
+    uint16_t offset;
+    uint8_t fragment;
+
+    if (length < ECAT_EOE_HEADER_SIZE) {
+        simEcatStats.mailbox_errors++;
+        return;
+    }
+    word0 = Sim_Get16(&eoe[0]);
+    word1 = Sim_Get16(&eoe[2]);
+    if ((word0 & 0x000FU) != 0U) {
+        return;                     // Not a fragment: init and filter requests are not served
+    }
+    length -= ECAT_EOE_HEADER_SIZE;
+    if ((word0 & ECAT_EOE_LAST_FRAGMENT) != 0U && (word0 & ECAT_EOE_TIME_APPENDED) != 0U) {
+        length = (length >= 4U) ? (uint16_t)(length - 4U) : 0U;
+    }
+
+    fragment = (uint8_t)(word1 & 0x3FU);
+    offset = (uint16_t)(((word1 >> 6) & 0x3FU) * ECAT_EOE_UNIT);
+    if (fragment == 0U) {
+        // The first fragment carries the frame size instead of the offset
+        slave->eoeReceiving = true;
+        slave->eoeSize = offset;
+        slave->eoeLength = 0;
+        slave->eoeFragment = 0;
+        slave->eoeFrameNo = (uint8_t)(word1 >> 12);
+    } else if (!slave->eoeReceiving || fragment != slave->eoeFragment ||
+               (word1 >> 12) != slave->eoeFrameNo || offset != slave->eoeLength) {
+        slave->eoeReceiving = false;
+        simEcatStats.mailbox_errors++;
+        return;
+    }
+    if ((uint32_t)slave->eoeLength + length > slave->eoeSize ||
+        (uint32_t)slave->eoeLength + length > ECAT_EOE_MAX_FRAME) {
+        slave->eoeReceiving = false;
+        simEcatStats.mailbox_errors++;
+        return;
+    }
+
+    memcpy(&slave->eoeFrame[slave->eoeLength], &eoe[ECAT_EOE_HEADER_SIZE], length);
+    slave->eoeLength += length;
+    slave->eoeFragment++;
+    if ((word0 & ECAT_EOE_LAST_FRAGMENT) != 0U) {
+        slave->eoeReceiving = false;
+        slave->eoeEchoing = true;
+        slave->eoeEchoOffset = 0;
+        slave->eoeFragment = 0;
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatEoeEcho
+ * Description   : Queue the fragments of the frame being echoed while the out
+ *                 queue has room, the same frame number, sizes chosen like the
+ *                 master does: 32 byte multiples but for the last one
+ *
+ *END**************************************************************************/
+static void Sim_EcatEoeEcho(sim_ecat_slave_t *slave)
+{
+    const uint16_t capacity = (uint16_t)(slave->sm1Size - ECAT_MBX_HEADER_SIZE - ECAT_EOE_HEADER_SIZE);
+    uint8_t *mbx;
+    uint16_t remaining;
+    uint16_t payload;
+    uint16_t word1;
+    bool last;
+
+    while (slave->eoeEchoing && slave->outCount < SIM_ECAT_MBX_QUEUE) {
+        remaining = (uint16_t)(slave->eoeLength - slave->eoeEchoOffset);
+        last = (remaining <= capacity);
+        payload = last ? remaining : (uint16_t)(capacity & ~(ECAT_EOE_UNIT - 1U));
+        if (payload == 0U && !last) {
+            slave->eoeEchoing = false;      // Mailbox too small to fragment
+            simEcatStats.mailbox_errors++;
+            return;
+        }
+
+        word1 = (uint16_t)(slave->eoeFragment | ((uint16_t)slave->eoeFrameNo << 12));
+        if (slave->eoeFragment == 0U) {
+            word1 |= (uint16_t)(((slave->eoeLength + ECAT_EOE_UNIT - 1U) / ECAT_EOE_UNIT) << 6);
+        } else {
+            word1 |= (uint16_t)((slave->eoeEchoOffset / ECAT_EOE_UNIT) << 6);
+        }
+
+        mbx = Sim_EcatQueueMailbox(slave, ECAT_MBX_TYPE_EOE, (uint16_t)(ECAT_EOE_HEADER_SIZE + payload));
+        Sim_Put16(&mbx[ECAT_MBX_HEADER_SIZE], last ? ECAT_EOE_LAST_FRAGMENT : 0U);
+        Sim_Put16(&mbx[ECAT_MBX_HEADER_SIZE + 2U], word1);
+        memcpy(&mbx[ECAT_MBX_HEADER_SIZE + ECAT_EOE_HEADER_SIZE], &slave->eoeFrame[slave->eoeEchoOffset], payload);
+
+        slave->eoeEchoOffset += payload;
+        slave->eoeFragment++;
+        if (last) {
+            slave->eoeEchoing = false;
+            slave->eoeFragment = 0;
+            simEcatStats.eoe_frames++;
+        }
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatFoeReply
+ * Description   : Queue an FoE ACK or ERR. An ACK still waiting in the queue
+ *                 behind another ACK is replaced, ACKs are cumulative.
+ *
+ *END**************************************************************************/
+static void Sim_EcatFoeReply(sim_ecat_slave_t *slave, uint8_t opcode, uint32_t param)
+{
+    uint8_t *mbx;
+
+    if (slave->outCount > 0U && opcode == ECAT_FOE_OP_ACK) {
+        mbx = slave->outQueue[(slave->outFirst + slave->outCount - 1U) % SIM_ECAT_MBX_QUEUE];
+        if ((mbx[5] & 0x0FU) == ECAT_MBX_TYPE_FOE && mbx[ECAT_MBX_HEADER_SIZE] == ECAT_FOE_OP_ACK) {
+            Sim_Put32(&mbx[ECAT_MBX_HEADER_SIZE + 2U], param);
+            return;
+        }
+    }
+
+    mbx = Sim_EcatQueueMailbox(slave, ECAT_MBX_TYPE_FOE, ECAT_FOE_HEADER_SIZE);
+    if (mbx == NULL) {
+        simEcatStats.mailbox_errors++;
+        return;
+    }
+    mbx[ECAT_MBX_HEADER_SIZE] = opcode;
+    Sim_Put32(&mbx[ECAT_MBX_HEADER_SIZE + 2U], param);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatFoeReceive
+ * Description   : One FoE packet taken from SM0 by the bootloader: WRQ opens
+ *                 the file, DATA packets in order are compared with the flash
+ *                 block, the first one shorter than the mailbox allows ends it
+ *
+ *END**************************************************************************/
+static void Sim_EcatFoeReceive(sim_ecat_slave_t *slave, const uint8_t *foe, uint16_t length)
+{
+    const uint8_t *flash = Sim_FlashBlock();
+    const uint8_t *data = &foe[ECAT_FOE_HEADER_SIZE];
+    uint16_t maxData = (uint16_t)(slave->sm0Size - ECAT_MBX_HEADER_SIZE - ECAT_FOE_HEADER_SIZE);
+    uint16_t dataLength;
+    uint32_t packet;
+    uint32_t offset;
+    uint16_t i;
+
+    if (length < ECAT_FOE_HEADER_SIZE) {
+        simEcatStats.mailbox_errors++;
+        return;
+    }
+    packet = Sim_Get32(&foe[2]);
+    dataLength = (uint16_t)(length - ECAT_FOE_HEADER_SIZE);
+
+    switch (foe[0]) {
+    case ECAT_FOE_OP_WRQ:
+        if (dataLength > ECAT_FOE_MAX_NAME) {
+            dataLength = ECAT_FOE_MAX_NAME;
+        }
+        memcpy(slave->foeName, data, dataLength);
+        slave->foeName[dataLength] = '\0';
+        slave->foeActive = true;
+        slave->foeNext = 1;
+        slave->foeBytes = 0;
+        slave->foeMismatch = UINT32_MAX;
+        Sim_EcatFoeReply(slave, ECAT_FOE_OP_ACK, 0);
+        break;
+
+    case ECAT_FOE_OP_DATA:
+        if (!slave->foeActive) {
+            Sim_EcatFoeReply(slave, ECAT_FOE_OP_ERR, ECAT_FOE_ERR_ILLEGAL);
+            break;
+        }
+        if (packet < slave->foeNext) {
+            // Sent again after a timeout or BUSY: taken already, acknowledge again
+            Sim_EcatFoeReply(slave, ECAT_FOE_OP_ACK, slave->foeNext - 1U);
+            break;
+        }
+        if (packet != slave->foeNext) {
+            slave->foeActive = false;
+            Sim_EcatFoeReply(slave, ECAT_FOE_OP_ERR, ECAT_FOE_ERR_PACKET_NO);
+            break;
+        }
+
+        for (i = 0; i < dataLength && slave->foeMismatch == UINT32_MAX; i++) {
+            offset = slave->foeBytes + i;
+            if (flash == NULL || offset >= SIM_FLASH_SIZE || data[i] != flash[offset]) {
+                slave->foeMismatch = offset;
+            }
+        }
+        slave->foeBytes += dataLength;
+        slave->foeNext++;
+        Sim_EcatFoeReply(slave, ECAT_FOE_OP_ACK, packet);
+
+        if (dataLength < maxData) {
+            slave->foeActive = false;
+            if (slave->foeMismatch == UINT32_MAX) {
+                fprintf(stderr, "sim: slave %lu FoE '%s' %lu bytes: matches flash\n",
+                        (unsigned long)(slave - simSlaves), slave->foeName, (unsigned long)slave->foeBytes);
+            } else {
+                fprintf(stderr, "sim: slave %lu FoE '%s' %lu bytes: differs from flash at byte %lu\n",
+                        (unsigned long)(slave - simSlaves), slave->foeName, (unsigned long)slave->foeBytes,
+                        (unsigned long)slave->foeMismatch);
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatMailboxService
+ * Description   : The slave application between two frames: take the mailbox
+ *                 the master wrote to SM0, unless an echo is still going out or
+ *                 the out queue is full, and offer the next queued mailbox in SM1
+ *
+ *END**************************************************************************/
+static void Sim_EcatMailboxService(sim_ecat_slave_t *slave)
+{
+    uint8_t *sm0Status = &slave->regs[ECAT_REG_SM0 + ECAT_SM_STATUS];
+    uint8_t *sm1Status = &slave->regs[ECAT_REG_SM1 + ECAT_SM_STATUS];
+    const uint8_t *mbx = &slave->regs[ECAT_MBX_START];
+    uint16_t length;
+
+    if (!Sim_EcatMailboxActive(slave)) {
+        return;
+    }
+
+    if ((*sm0Status & ECAT_SM_STATUS_FULL) != 0U && !slave->eoeEchoing &&
+        slave->outCount < SIM_ECAT_MBX_QUEUE) {
+        *sm0Status &= (uint8_t)~ECAT_SM_STATUS_FULL;
+        simEcatStats.mailboxes_in++;
+
+        length = Sim_Get16(&mbx[0]);
+        if ((uint32_t)length + ECAT_MBX_HEADER_SIZE > slave->sm0Size) {
+            simEcatStats.mailbox_errors++;
+        } else if ((mbx[5] & 0x0FU) == ECAT_MBX_TYPE_EOE) {
+            Sim_EcatEoeReceive(slave, &mbx[ECAT_MBX_HEADER_SIZE], length);
+        } else if ((mbx[5] & 0x0FU) == ECAT_MBX_TYPE_FOE) {
+            Sim_EcatFoeReceive(slave, &mbx[ECAT_MBX_HEADER_SIZE], length);
+        }
+    }
+
+    Sim_EcatEoeEcho(slave);
+
+    if ((*sm1Status & ECAT_SM_STATUS_FULL) == 0U && slave->outCount > 0U) {
+        memcpy(&slave->regs[ECAT_MBX_START + slave->sm0Size], slave->outQueue[slave->outFirst], slave->sm1Size);
+        slave->outFirst = (slave->outFirst + 1U) % SIM_ECAT_MBX_QUEUE;
+        slave->outCount--;
+        *sm1Status |= ECAT_SM_STATUS_FULL;
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EcatProcess
+ * Description   : Pass a frame round the segment in place. Every slave
+ *                 processes all datagrams and serves its mailboxes, then the
+ *                 first slave marks the source MAC as returned. Malformed and non-EtherCAT frames are
+ *                 forwarded unchanged, like the ESCs do.
+ *
+ *END**************************************************************************/
+void Sim_EcatProcess(uint8_t *frame, uint32_t length)
+{
+    uint32_t end;
+    uint32_t offset;
+    uint32_t position;
+    uint16_t ecatHeader;
+    uint16_t datagramLength;
+    uint16_t wkc;
+    bool more;
+
+    if (length < ECAT_ETH_HEADER_SIZE + ECAT_HEADER_SIZE ||
+        frame[12] != ECAT_ETHERTYPE_HI || frame[13] != ECAT_ETHERTYPE_LO) {
+        simEcatStats.other_frames++;
+        return;
+    }
+
+    ecatHeader = Sim_Get16(&frame[ECAT_ETH_HEADER_SIZE]);
+    end = ECAT_ETH_HEADER_SIZE + ECAT_HEADER_SIZE + (ecatHeader & 0x07FFU);
+    if ((ecatHeader >> 12) != 1U || end > length) {
+        simEcatStats.errors++;
+        return;
+    }
+
+    // Check the datagram chain once before any slave touches it
+    offset = ECAT_ETH_HEADER_SIZE + ECAT_HEADER_SIZE;
+    do {
+        if (offset + ECAT_DATAGRAM_HEADER + ECAT_WKC_SIZE > end) {
+            simEcatStats.errors++;
+            return;
+        }
+        datagramLength = Sim_Get16(&frame[offset + 6]) & 0x07FFU;
+        more = (Sim_Get16(&frame[offset + 6]) & 0x8000U) != 0U;
+        offset += ECAT_DATAGRAM_HEADER + datagramLength + ECAT_WKC_SIZE;
+        if (offset > end) {
+            simEcatStats.errors++;
+            return;
+        }
+        simEcatStats.datagrams++;
+    } while (more);
+
+    for (position = 0; position < simSlaveCount; position++) {
+        offset = ECAT_ETH_HEADER_SIZE + ECAT_HEADER_SIZE;
+        do {
+            datagramLength = Sim_Get16(&frame[offset + 6]) & 0x07FFU;
+            more = (Sim_Get16(&frame[offset + 6]) & 0x8000U) != 0U;
+            wkc = Sim_EcatDatagram(position, &frame[offset], &frame[offset + ECAT_DATAGRAM_HEADER], datagramLength);
+            if (wkc != 0U) {
+                uint8_t *wkcField = &frame[offset + ECAT_DATAGRAM_HEADER + datagramLength];
+
+                Sim_Put16(wkcField, (uint16_t)(Sim_Get16(wkcField) + wkc));
+            }
+            offset += ECAT_DATAGRAM_HEADER + datagramLength + ECAT_WKC_SIZE;
+        } while (more);
+        Sim_EcatMailboxService(&simSlaves[position]);
+    }
+
+    if (simSlaveCount > 0U) {
+        frame[6] |= 0x02U;
+    }
+    simEcatStats.frames++;
+}
@@ -0,0 +1,308 @@
+#include "sim.h"
+#include "fsl_enet.h"
+#include "fsl_phy.h"
+#include "fsl_phyksz8081.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Simulated ENET MAC and PHY. Frames sent are copied into the TX buffers given
+// to ENET_Init, the interrupt task passes them round the simulated EtherCAT
+// segment and writes the returning frame into the next RX buffer, then calls the
+// driver callback with kENET_TxEvent and kENET_RxEvent like the ENET ISRs. A
+// frame arriving with the RX ring full is dropped, as by the MAC.
+
+const mdio_operations_t enet_ops = { "sim" };
+const phy_operations_t phyksz8081_ops = { "sim" };
+
+static ENET_Type simEnetRegs;
+static uint64_t simEnetPeriods = 0;     // ATVR wraps seen by the register accesses
+static enet_handle_t *simEnetHandle = NULL;
+static volatile bool simEnetActive = false;
+
+/*******************************************************************************
+ * Registers
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EnetRegs
+ * Description   : ENET register block. A capture requested in ATCR completes
+ *                 on the next access: ATVR takes the host time modulo ATPER.
+ *                 With the timer and its period event enabled, an access after
+ *                 a wrap raises TS_TIMER, once however many periods went by.
+ *
+ *END**************************************************************************/
+ENET_Type *Sim_EnetRegs(void)
+{
+    const uint32_t timerOn = ENET_ATCR_EN_MASK | ENET_ATCR_PEREN_MASK;
+    uint32_t period = (simEnetRegs.ATPER != 0U) ? simEnetRegs.ATPER : 1000000000U;
+    uint64_t now = Sim_NowNs();
+
+    if ((simEnetRegs.ATCR & timerOn) == timerOn && now / period != simEnetPeriods) {
+        simEnetRegs.EIR |= ENET_EIR_TS_TIMER_MASK;
+    }
+    simEnetPeriods = now / period;
+
+    if (simEnetRegs.ATCR & ENET_ATCR_CAPTURE_MASK) {
+        simEnetRegs.ATVR = (uint32_t)(now % period);
+        simEnetRegs.ATCR &= ~ENET_ATCR_CAPTURE_MASK;
+    }
+    return &simEnetRegs;
+}
+
+void ENET_EnableInterrupts(ENET_Type *base, uint32_t mask)
+{
+    base->EIMR |= mask;
+}
+
+uint32_t ENET_GetInterruptStatus(ENET_Type *base)
+{
+    return base->EIR;
+}
+
+void ENET_ClearInterruptStatus(ENET_Type *base, uint32_t mask)
+{
+    base->EIR &= ~mask;
+}
+
+/*******************************************************************************
+ * Driver
+ ******************************************************************************/
+void ENET_GetDefaultConfig(enet_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->miiMode = kENET_RmiiMode;
+    config->miiSpeed = kENET_MiiSpeed100M;
+    config->miiDuplex = kENET_MiiFullDuplex;
+    config->rxMaxFrameLen = 1518U;
+}
+
+status_t ENET_Init(ENET_Type *base, enet_handle_t *handle, const enet_config_t *config,
+                   const enet_buffer_config_t *bufferConfig, uint8_t *macAddr, uint32_t srcClock_Hz)
+{
+    (void)base;
+    (void)config;
+    (void)macAddr;
+    (void)srcClock_Hz;
+
+    if (bufferConfig->rxBdNumber > (sizeof(handle->rxLength) / sizeof(handle->rxLength[0])) ||
+        bufferConfig->txBdNumber > (sizeof(handle->txLength) / sizeof(handle->txLength[0]))) {
+        return kStatus_InvalidArgument;
+    }
+
+    memset(handle, 0, sizeof(*handle));
+    handle->buffConfig = *bufferConfig;
+    simEnetHandle = handle;
+    simEnetActive = false;
+
+    (void)EnableIRQ(ENET_Transmit_IRQn);
+    (void)EnableIRQ(ENET_Receive_IRQn);
+    (void)EnableIRQ(ENET_Error_IRQn);
+    return kStatus_Success;
+}
+
+void ENET_Deinit(ENET_Type *base)
+{
+    (void)base;
+
+    (void)DisableIRQ(ENET_Transmit_IRQn);
+    (void)DisableIRQ(ENET_Receive_IRQn);
+    (void)DisableIRQ(ENET_Error_IRQn);
+    simEnetActive = false;
+    simEnetHandle = NULL;
+}
+
+void ENET_SetCallback(enet_handle_t *handle, enet_callback_t callback, void *userData)
+{
+    handle->callback = callback;
+    handle->userData = userData;
+}
+
+void ENET_ActiveRead(ENET_Type *base)
+{
+    (void)base;
+    simEnetActive = true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : ENET_SendFrame
+ * Description   : Copy a frame into the next TX buffer and wake the interrupt
+ *                 task to put it on the wire. Busy when every TX buffer is
+ *                 still waiting.
+ *
+ *END**************************************************************************/
+status_t ENET_SendFrame(ENET_Type *base, enet_handle_t *handle, const uint8_t *data, uint32_t length,
+                        uint8_t ringId, bool tsFlag, void *context)
+{
+    const enet_buffer_config_t *config = &handle->buffConfig;
+    uint32_t head = handle->txHead;
+    uint32_t slot;
+
+    (void)base;
+    (void)ringId;
+    (void)tsFlag;
+    (void)context;
+
+    if (length > config->txBuffSizeAlign) {
+        return kStatus_ENET_TxFrameOverLen;
+    }
+    if ((head - handle->txTail) >= config->txBdNumber) {
+        return kStatus_ENET_TxFrameBusy;
+    }
+
+    slot = head % config->txBdNumber;
+    memcpy(&config->txBufferAlign[slot * config->txBuffSizeAlign], data, length);
+    handle->txLength[slot] = (uint16_t)length;
+    __DMB();
+    handle->txHead = head + 1U;
+
+    Sim_IrqKick();
+    return kStatus_Success;
+}
+
+status_t ENET_GetRxFrameSize(enet_handle_t *handle, uint32_t *length, uint8_t ringId)
+{
+    uint32_t tail = handle->rxTail;
+
+    (void)ringId;
+
+    if (tail == handle->rxHead) {
+        *length = 0;
+        return kStatus_ENET_RxFrameEmpty;
+    }
+    __DMB();
+    *length = handle->rxLength[tail % handle->buffConfig.rxBdNumber];
+    return kStatus_Success;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : ENET_ReadFrame
+ * Description   : Copy the oldest received frame out of its RX buffer and free
+ *                 the buffer. data NULL drops the frame.
+ *
+ *END**************************************************************************/
+status_t ENET_ReadFrame(ENET_Type *base, enet_handle_t *handle, uint8_t *data, uint32_t length,
+                        uint8_t ringId, uint32_t *ts)
+{
+    const enet_buffer_config_t *config = &handle->buffConfig;
+    uint32_t tail = handle->rxTail;
+    uint32_t slot;
+    status_t status = kStatus_Success;
+
+    (void)base;
+    (void)ringId;
+    (void)ts;
+
+    if (tail == handle->rxHead) {
+        return kStatus_ENET_RxFrameEmpty;
+    }
+    __DMB();
+
+    slot = tail % config->rxBdNumber;
+    if (data != NULL) {
+        if (length < handle->rxLength[slot]) {
+            status = kStatus_ENET_RxFrameFail;
+        } else {
+            memcpy(data, &config->rxBufferAlign[slot * config->rxBuffSizeAlign], handle->rxLength[slot]);
+        }
+    }
+    __DMB();
+    handle->rxTail = tail + 1U;
+    return status;
+}
+
+/*******************************************************************************
+ * Wire side, run by the interrupt task
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EnetService
+ * Description   : Raise the 1588 timer interrupt on a wrap, then send every
+ *                 waiting TX frame round the segment into the RX ring, with the
+ *                 TX and RX interrupt callbacks
+ *
+ *END**************************************************************************/
+void Sim_EnetService(void)
+{
+    enet_handle_t *handle = simEnetHandle;
+    ENET_Type *regs = Sim_EnetRegs();
+    const enet_buffer_config_t *config;
+    uint32_t tail;
+    uint32_t head;
+    uint32_t slot;
+    uint32_t length;
+    uint8_t *rxBuffer;
+
+    // 1588 timer wrap, pending since the register access above or an earlier one
+    if ((regs->EIR & regs->EIMR & ENET_EIR_TS_TIMER_MASK) && Sim_IrqIsEnabled(ENET_1588_Timer_IRQn)) {
+        ENET_1588_Timer_IRQHandler();
+    }
+
+    if (handle == NULL) {
+        return;
+    }
+    config = &handle->buffConfig;
+
+    for (tail = handle->txTail; tail != handle->txHead; tail++) {
+        __DMB();
+        slot = tail % config->txBdNumber;
+        length = handle->txLength[slot];
+
+        head = handle->rxHead;
+        if (simEnetActive && (head - handle->rxTail) < config->rxBdNumber && length <= config->rxBuffSizeAlign) {
+            rxBuffer = &config->rxBufferAlign[(head % config->rxBdNumber) * config->rxBuffSizeAlign];
+            memcpy(rxBuffer, &config->txBufferAlign[slot * config->txBuffSizeAlign], length);
+            Sim_EcatProcess(rxBuffer, length);
+            handle->rxLength[head % config->rxBdNumber] = (uint16_t)length;
+            __DMB();
+            handle->rxHead = head + 1U;
+        } else {
+            head = UINT32_MAX;      // Dropped by the MAC, no RX interrupt
+        }
+
+        __DMB();
+        handle->txTail = tail + 1U;
+
+        if (handle->callback != NULL && Sim_IrqIsEnabled(ENET_Transmit_IRQn)) {
+            handle->callback(&simEnetRegs, handle, kENET_TxEvent, NULL, handle->userData);
+        }
+        if (head != UINT32_MAX && handle->callback != NULL && Sim_IrqIsEnabled(ENET_Receive_IRQn)) {
+            handle->callback(&simEnetRegs, handle, kENET_RxEvent, NULL, handle->userData);
+        }
+    }
+}
+
+/*******************************************************************************
+ * PHY: link always up to the simulated segment
+ ******************************************************************************/
+status_t PHY_Init(phy_handle_t *handle, const phy_config_t *config)
+{
+    (void)handle;
+    (void)config;
+    return kStatus_Success;
+}
+
+status_t PHY_GetAutoNegotiationStatus(phy_handle_t *handle, bool *status)
+{
+    (void)handle;
+    *status = true;
+    return kStatus_Success;
+}
+
+status_t PHY_GetLinkStatus(phy_handle_t *handle, bool *status)
+{
+    (void)handle;
+    *status = true;
+    return kStatus_Success;
+}
+
+status_t PHY_GetLinkSpeedDuplex(phy_handle_t *handle, phy_speed_t *speed, phy_duplex_t *duplex)
+{
+    (void)handle;
+    *speed = kPHY_Speed100M;
+    *duplex = kPHY_FullDuplex;
+    return kStatus_Success;
+}
@@ -0,0 +1,337 @@
+#include "sim.h"
+#include "board.h"
+#include "pin_mux.h"
+#include "clock_config.h"
+#include "peripherals.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE         (0x100000)  // Linux 4.17, older glibc headers lack it
+#endif
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+uint32_t SystemCoreClock = 120000000U;
+CoreDebug_Type Sim_CoreDebug;
+
+const flexcan_config_t CAN0_config = {
+    .bitRate = 250000UL,
+    .maxMbNum = 16U,
+    .enableLoopBack = false,
+    .disableSelfReception = false,
+};
+
+static DWT_Type simDwt;
+static uint64_t simStartNs;
+static const uint8_t *simFlash = NULL;
+
+// Simulated time at the last tick, the host time it was taken at
+static volatile uint64_t simTickCount = 0;
+static volatile uint64_t simTickNs = 0;
+static volatile uint64_t simTickHostNs = 0;
+static volatile bool simIrqEnabled[SIM_IRQ_COUNT];
+static volatile uint8_t simIrqPriority[SIM_IRQ_COUNT];
+
+// Signal mask of the thread before its outermost Sim_SetInterruptMask
+static __thread sigset_t simMaskSaved;
+static __thread UBaseType_t simMaskDepth = 0;
+
+static TaskHandle_t simIrqTask = NULL;
+static StackType_t simIrqStack[SIM_IRQ_TASK_STACK_SIZE];
+static StaticTask_t simIrqTcb;
+
+/*******************************************************************************
+ * Clock and core
+ ******************************************************************************/
+
+static uint64_t Sim_HostNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_NowNs
+ * Description   : Simulated time, ns since BOARD_InitBootClocks. Host time until
+ *                 the first tick, then the kernel tick count with the host time
+ *                 since the last tick, at most a tick, in between: the host
+ *                 loses ticks under load (delivered late, merged signals), the
+ *                 DWT and peripheral timers stay in step with the kernel anyway.
+ *
+ *END**************************************************************************/
+uint64_t Sim_NowNs(void)
+{
+    uint64_t count;
+    uint64_t tickNs;
+    uint64_t sinceNs;
+
+    // The tick hook may run in between, on this very thread
+    do {
+        count = simTickCount;
+        tickNs = simTickNs;
+        sinceNs = Sim_HostNs() - simTickHostNs;
+    } while (count != simTickCount);
+
+    if (count == 0U) {
+        return Sim_HostNs() - simStartNs;
+    }
+    return tickNs + ((sinceNs < SIM_TICK_NS) ? sinceNs : SIM_TICK_NS);
+}
+
+void vApplicationTickHook(void)
+{
+    uint64_t host = Sim_HostNs();
+
+    // The first tick takes over from the host clock where it stands
+    simTickNs = (simTickCount == 0U) ? (host - simStartNs) : (simTickNs + SIM_TICK_NS);
+    simTickHostNs = host;
+    simTickCount++;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_DwtRegs
+ * Description   : DWT register block with CYCCNT brought up to date: host time
+ *                 counted at SystemCoreClock while CYCCNTENA is set
+ *
+ *END**************************************************************************/
+DWT_Type *Sim_DwtRegs(void)
+{
+    if (simDwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) {
+        simDwt.CYCCNT = (uint32_t)((Sim_NowNs() * (SystemCoreClock / 1000000U)) / 1000U);
+    }
+    return &simDwt;
+}
+
+uint32_t CLOCK_GetFreq(clock_name_t name)
+{
+    (void)name;
+    return SystemCoreClock;
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)
+{
+    simIrqPriority[irq] = (uint8_t)priority;
+}
+
+status_t EnableIRQ(IRQn_Type irq)
+{
+    simIrqEnabled[irq] = true;
+    return kStatus_Success;
+}
+
+status_t DisableIRQ(IRQn_Type irq)
+{
+    simIrqEnabled[irq] = false;
+    return kStatus_Success;
+}
+
+bool Sim_IrqIsEnabled(IRQn_Type irq)
+{
+    return simIrqEnabled[irq];
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_AssertFailed
+ * Description   : configASSERT of the simulation: report and stop, so the
+ *                 debugger or the core dump shows the failing call
+ *
+ *END**************************************************************************/
+void Sim_AssertFailed(const char *file, int line)
+{
+    fprintf(stderr, "sim: assertion failed at %s:%d\n", file, line);
+    abort();
+}
+
+/*******************************************************************************
+ * Interrupt delivery
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_IrqTaskMain
+ * Description   : Runs the device services like interrupts: highest priority,
+ *                 once per tick and whenever a device is kicked
+ *
+ *END**************************************************************************/
+static void Sim_IrqTaskMain(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        (void)ulTaskNotifyTake(pdTRUE, 1);
+        Sim_EnetService();
+        Sim_CanService();
+        Sim_UartService();
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_SetInterruptMask
+ * Description   : portSET_INTERRUPT_MASK_FROM_ISR of the simulation (portmacro.h):
+ *                 block every signal of the calling thread, tick included, so
+ *                 no switch to the interrupt task happens until the matching
+ *                 Sim_ClearInterruptMask. Nests.
+ *
+ *END**************************************************************************/
+UBaseType_t Sim_SetInterruptMask(void)
+{
+    sigset_t all;
+    sigset_t saved;
+
+    if (simMaskDepth == 0U) {
+        sigfillset(&all);
+        (void)pthread_sigmask(SIG_BLOCK, &all, &saved);
+        simMaskSaved = saved;
+    }
+    return simMaskDepth++;
+}
+
+void Sim_ClearInterruptMask(UBaseType_t mask)
+{
+    simMaskDepth = mask;
+    if (simMaskDepth == 0U) {
+        (void)pthread_sigmask(SIG_SETMASK, &simMaskSaved, NULL);
+    }
+}
+
+void Sim_IrqKick(void)
+{
+    if (simIrqTask != NULL && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING &&
+        xTaskGetCurrentTaskHandle() != simIrqTask) {
+        xTaskNotifyGive(simIrqTask);
+    }
+}
+
+void vApplicationIdleHook(void)
+{
+    // The next tick interrupts the sleep
+    (void)usleep(SIM_IDLE_SLEEP_US);
+}
+
+/*******************************************************************************
+ * Board initialization
+ ******************************************************************************/
+void BOARD_InitBootPins(void)
+{
+}
+
+void BOARD_InitBootClocks(void)
+{
+    simStartNs = Sim_HostNs();
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_EnvValue
+ * Description   : Numeric environment variable, or the default
+ *
+ *END**************************************************************************/
+static uint32_t Sim_EnvValue(const char *name, uint32_t value)
+{
+    const char *text = getenv(name);
+
+    return (text != NULL && *text != '\0') ? (uint32_t)strtoul(text, NULL, 0) : value;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_FlashInit
+ * Description   : Map the flash block at its target address and fill it from
+ *                 SIM_FLASH_IMAGE, or with a xorshift pattern, then make it
+ *                 read-only like flash
+ *
+ *END**************************************************************************/
+static void Sim_FlashInit(void)
+{
+    const char *path = getenv("SIM_FLASH_IMAGE");
+    uint32_t *words;
+    uint32_t state = 0x12345678U;
+    size_t length = 0;
+    size_t i;
+    FILE *file;
+    void *block;
+
+    block = mmap((void *)SIM_FLASH_ADDR, SIM_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (block != (void *)SIM_FLASH_ADDR) {
+        if (block != MAP_FAILED) {
+            (void)munmap(block, SIM_FLASH_SIZE);
+        }
+        fprintf(stderr, "sim: flash block at 0x%08lX not mapped, FoE updates will fail\n", SIM_FLASH_ADDR);
+        return;
+    }
+
+    if (path != NULL && *path != '\0') {
+        file = fopen(path, "rb");
+        if (file == NULL) {
+            fprintf(stderr, "sim: cannot open SIM_FLASH_IMAGE %s\n", path);
+            exit(1);
+        }
+        length = fread(block, 1, SIM_FLASH_SIZE, file);
+        (void)fclose(file);
+    } else {
+        words = (uint32_t *)block;
+        for (i = 0; i < SIM_FLASH_SIZE / sizeof(uint32_t); i++) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            words[i] = state;
+        }
+        length = SIM_FLASH_SIZE;
+    }
+
+    (void)mprotect(block, SIM_FLASH_SIZE, PROT_READ);
+    simFlash = (const uint8_t *)block;
+    fprintf(stderr, "sim: flash block at 0x%08lX, %lu bytes %s\n", SIM_FLASH_ADDR, (unsigned long)length,
+            (path != NULL && *path != '\0') ? path : "of pattern");
+}
+
+const uint8_t *Sim_FlashBlock(void)
+{
+    return simFlash;
+}
+
+void BOARD_InitBootPeripherals(void)
+{
+    BOARD_InitPeripherals();
+}
+
+void BOARD_InitPeripherals(void)
+{
+    if (simIrqTask != NULL) {
+        return;
+    }
+
+    Sim_CanInit(Sim_EnvValue("SIM_CAN_JOYSTICK_MS", SIM_CAN_DEFAULT_JOYSTICK_MS));
+    Sim_EcatInit(Sim_EnvValue("SIM_ECAT_SLAVES", SIM_ECAT_DEFAULT_SLAVES),
+                 Sim_EnvValue("SIM_ECAT_PD_BYTES", SIM_ECAT_DEFAULT_PD_BYTES),
+                 Sim_EnvValue("SIM_ECAT_MBX_SIZE", SIM_ECAT_DEFAULT_MBX_SIZE),
+                 Sim_EnvValue("SIM_ECAT_BOOT_MBX_SIZE", SIM_ECAT_DEFAULT_BOOT_MBX_SIZE));
+    fprintf(stderr, "sim: %s, EtherCAT segment of %lu slaves x %lu bytes, %lu byte mailboxes (%lu in BOOT)\n",
+            BOARD_NAME, (unsigned long)Sim_EcatGetSlaveCount(), (unsigned long)Sim_EcatGetPdBytes(),
+            (unsigned long)Sim_EcatGetMbxSize(), (unsigned long)Sim_EcatGetBootMbxSize());
+    Sim_FlashInit();
+
+    simIrqTask = xTaskCreateStatic(Sim_IrqTaskMain, "SimIRQ", SIM_IRQ_TASK_STACK_SIZE, NULL,
+                                   configMAX_PRIORITIES - 1, simIrqStack, &simIrqTcb);
+    configASSERT(simIrqTask != NULL);
+}
+
+void BOARD_InitDebugConsole(void)
+{
+}
@@ -0,0 +1,305 @@
+#include "sim.h"
+#include "UART_HAL.h"
+#include "Utilities.h"
+#include "Trace.h"
+#include "Shell.h"
+#include "enet_raw.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+// UART0 of the simulation, replacing UART_HAL.c behind the same API. Bytes typed
+// on stdin go through the RX ring to the shell task, the log ring drains to
+// stdout from the interrupt task at SIM_UART_BAUD, as the TX interrupt drains it
+// into the FIFO on the target. The blocking writes go straight to stdout.
+// The shell gets a "quit" command, which ends the simulation once the log is
+// out, so scripts can pipe commands in (sim/check.sh), and a "sleep" command to
+// let simulated time pass between them.
+
+#define SIM_UART_TX_BURST           (128U)      // Most bytes written per interrupt
+#define SIM_UART_BYTE_NS            (10000000000ULL / ((SIM_UART_BAUD != 0U) ? SIM_UART_BAUD : 1U))
+
+// RX ring, written by the stdin reader thread and read by one task
+static volatile uint8_t rxRing[UART_RX_RING_SIZE];
+static volatile uint32_t rxHead = 0;
+static volatile uint32_t rxTail = 0;
+static volatile uint32_t rxDropped = 0;
+static uint32_t rxNotified = 0;
+static TaskHandle_t rxNotifyTask = NULL;
+static pthread_t rxThread;
+static bool rxThreadStarted = false;
+
+static volatile bool txActive = false;
+static uint64_t txLastNs = 0;
+
+static int Sim_UartQuitCommand(int argc, char *argv[]);
+static int Sim_UartSleepCommand(int argc, char *argv[]);
+
+static const shell_command_t simQuitCommand = { "quit", "- end the simulation", Sim_UartQuitCommand };
+static const shell_command_t simSleepCommand = { "sleep", "<ms> - let simulated time pass", Sim_UartSleepCommand };
+
+/*******************************************************************************
+ * Reception Functions
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_UartReader
+ * Description   : stdin reader thread, the receiver of the simulated UART. Not a
+ *                 FreeRTOS task: only touches the RX ring.
+ *
+ *END**************************************************************************/
+static void *Sim_UartReader(void *arg)
+{
+    uint8_t buffer[64];
+    ssize_t count;
+    ssize_t i;
+
+    (void)arg;
+
+    while (1) {
+        count = read(STDIN_FILENO, buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        for (i = 0; i < count; i++) {
+            if ((rxHead - rxTail) < UART_RX_RING_SIZE) {
+                rxRing[rxHead & (UART_RX_RING_SIZE - 1U)] = buffer[i];
+                __DMB();
+                rxHead++;
+            } else {
+                rxDropped++;
+            }
+        }
+    }
+    return NULL;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : UART_RxInit
+ * Description   : Start the stdin reader. The given task is notified (task
+ *                 notification count) when bytes arrive.
+ *
+ *END**************************************************************************/
+void UART_RxInit(TaskHandle_t notifyTask)
+{
+    sigset_t all;
+    sigset_t saved;
+
+    rxNotifyTask = notifyTask;
+    rxTail = rxHead;
+    rxNotified = rxHead;
+
+    if (!rxThreadStarted) {
+        // The thread inherits the mask: keep the tick and the port signals away
+        sigfillset(&all);
+        (void)pthread_sigmask(SIG_BLOCK, &all, &saved);
+        rxThreadStarted = (pthread_create(&rxThread, NULL, Sim_UartReader, NULL) == 0);
+        (void)pthread_sigmask(SIG_SETMASK, &saved, NULL);
+    }
+    (void)EnableIRQ(UART0_RX_TX_IRQn);
+    (void)Shell_RegisterCommand(&simQuitCommand);
+    (void)Shell_RegisterCommand(&simSleepCommand);
+}
+
+bool UART_RxGetChar(uint8_t *ch)
+{
+    uint32_t tail = rxTail;
+
+    if (tail == rxHead) {
+        return false;
+    }
+    __DMB();
+
+    *ch = rxRing[tail & (UART_RX_RING_SIZE - 1U)];
+    rxTail = tail + 1U;
+    return true;
+}
+
+uint32_t UART_RxGetDropped(void)
+{
+    return rxDropped;
+}
+
+/*******************************************************************************
+ * Transmission Functions
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_UartOut
+ * Description   : Write bytes to stdout, through signal interruptions
+ *
+ *END**************************************************************************/
+static void Sim_UartOut(const uint8_t *data, size_t length)
+{
+    ssize_t written;
+
+    while (length > 0U) {
+        written = write(STDOUT_FILENO, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+}
+
+void UART_Write_Blocking(const char *message)
+{
+    if (!message) {
+        return;
+    }
+
+    Sim_UartOut((const uint8_t *)message, strlen(message));
+}
+
+status_t UART_Write_NonBlocking(const char* message)
+{
+    if (!message) {
+        return kStatus_Fail;
+    }
+
+    UART_Write_Blocking(message);
+    return kStatus_Success;
+}
+
+void UART_Write(const char *message)
+{
+    UART_Write_Blocking(message);
+}
+
+/*******************************************************************************
+ * Interrupt-driven Log Transmission
+ ******************************************************************************/
+
+void UART_TxInterruptInit(void)
+{
+    NVIC_SetPriority(UART0_RX_TX_IRQn, UART_IRQ_PRIORITY);
+    (void)EnableIRQ(UART0_RX_TX_IRQn);
+}
+
+void UART_TxStart(void)
+{
+    txActive = true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_UartService
+ * Description   : The UART0 interrupt: wake the reader for new RX bytes and
+ *                 drain the log ring to stdout, no faster than the baud rate
+ *                 (10 bits per byte) allows since the last run
+ *
+ *END**************************************************************************/
+void Sim_UartService(void)
+{
+    const uint8_t *data;
+    uint16_t count;
+    uint32_t space;
+    uint64_t now;
+
+    BaseType_t woken = pdFALSE;
+    uint32_t head = rxHead;
+
+    if (!Sim_IrqIsEnabled(UART0_RX_TX_IRQn)) {
+        return;
+    }
+    TRACE_ISR_ENTER(TRACE_ISR_UART);
+
+    if (head != rxNotified) {
+        rxNotified = head;
+        if (rxNotifyTask != NULL) {
+            vTaskNotifyGiveFromISR(rxNotifyTask, &woken);
+        }
+    }
+
+    if (txActive) {
+        // Byte times since the last run, 10 bits each, at most a burst
+        now = Sim_NowNs();
+        space = SIM_UART_TX_BURST;
+        if (SIM_UART_BAUD != 0U) {
+            if ((now - txLastNs) < (uint64_t)SIM_UART_TX_BURST * SIM_UART_BYTE_NS) {
+                space = (uint32_t)((now - txLastNs) / SIM_UART_BYTE_NS);
+            }
+            txLastNs = now - (now - txLastNs) % SIM_UART_BYTE_NS;
+        }
+
+        while (space > 0U) {
+            count = UART_LogPeek(&data);
+            if (count == 0U) {
+                txActive = false;
+                break;
+            }
+            if (count > space) {
+                count = (uint16_t)space;
+            }
+            Sim_UartOut(data, count);
+            UART_LogConsume(count);
+            space -= count;
+        }
+    } else {
+        txLastNs = Sim_NowNs();
+    }
+
+    TRACE_ISR_EXIT(TRACE_ISR_UART);
+    portYIELD_FROM_ISR(woken);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_UartQuitCommand
+ * Description   : "quit" command: wait for the log to drain, print the
+ *                 simulated segment counters and the 1588 time against the
+ *                 simulated time on stderr and exit
+ *
+ *END**************************************************************************/
+static int Sim_UartQuitCommand(int argc, char *argv[])
+{
+    const uint8_t *data;
+    sim_ecat_stats_t stats;
+
+    (void)argc;
+    (void)argv;
+
+    while (txActive || UART_LogPeek(&data) != 0U) {
+        vTaskDelay(1);
+    }
+
+    Sim_EcatGetStats(&stats);
+    fprintf(stderr, "sim: EtherCAT %lu frames, %lu datagrams, %lu errors, mailboxes %lu in %lu out "
+            "%lu dropped, %lu EoE frames echoed\n",
+            (unsigned long)stats.frames, (unsigned long)stats.datagrams, (unsigned long)stats.errors,
+            (unsigned long)stats.mailboxes_in, (unsigned long)stats.mailboxes_out,
+            (unsigned long)stats.mailbox_errors, (unsigned long)stats.eoe_frames);
+    fprintf(stderr, "sim: 1588 time %llu ms, simulated time %llu ms\n",
+            (unsigned long long)(enet_raw_time_ns() / 1000000U), (unsigned long long)(Sim_NowNs() / 1000000U));
+    exit(0);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : Sim_UartSleepCommand
+ * Description   : "sleep" command: block the shell for a number of ms
+ *
+ *END**************************************************************************/
+static int Sim_UartSleepCommand(int argc, char *argv[])
+{
+    uint32_t ms;
+
+    if (argc != 2 || !Shell_ParseU32(argv[1], &ms)) {
+        return SHELL_USAGE;
+    }
+    vTaskDelay(pdMS_TO_TICKS(ms));
+    return SHELL_OK;
+}
@@ -0,0 +1,40 @@
+#include "Bench.h"
+#include "cycles.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Bench_WaitUntil
+ * Description   :  Sleep whole ticks while more than two are left, then spin on
+ *                  the cycle counter up to the release
+ *
+ *END**************************************************************************/
+void Bench_WaitUntil(uint32_t release)
+{
+    const uint32_t cyclesPerTick = SystemCoreClock / configTICK_RATE_HZ;
+    int32_t remaining = (int32_t)(release - Cycles_Now());
+
+    if (remaining > (int32_t)(2U * cyclesPerTick)) {
+        vTaskDelay((TickType_t)((uint32_t)remaining / cyclesPerTick) - 1U);
+    }
+    while ((int32_t)(Cycles_Now() - release) < 0) {
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Bench_Drain
+ * Description   :  Take every frame left in the ring, late frames of a previous
+ *                  run included. Stops at the first call that returns no frame:
+ *                  only a returned frame is released.
+ *
+ *END**************************************************************************/
+void Bench_Drain(enet_raw_handle_t *handle)
+{
+    enet_raw_frame_t frame;
+
+    while (enet_raw_receive_frame(handle, &frame, 0) == ENET_RAW_SUCCESS) {
+        enet_raw_release_frame(handle, &frame);
+    }
+}
@@ -0,0 +1,236 @@
+#include "CAN_BusLoad.h"
+#include "string.h"
+#include "stdio.h"
+#include "Utilities.h"
+
+// Empty hash slot marker
+#define BUSLOAD_SLOT_EMPTY  (0xFFU)
+
+static busload_cob_stats_t cobStats[BUSLOAD_MAX_COB_IDS];
+static uint32_t cobCount = 0;
+static uint8_t cobHash[BUSLOAD_HASH_SIZE];
+static busload_stats_t busStats;
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  BusLoad_Find
+ * Description   :  Return the statistics entry of a COB-ID, creating it on first use.
+ *                  Same multiplicative hash and linear probing as the PDO table.
+ *
+ *END**************************************************************************/
+static busload_cob_stats_t *BusLoad_Find(uint16_t cobId)
+{
+    uint32_t slot = (((uint32_t)cobId * 2654435761UL) >> 24) & (BUSLOAD_HASH_SIZE - 1U);
+
+    while (cobHash[slot] != BUSLOAD_SLOT_EMPTY) {
+        if (cobStats[cobHash[slot]].cob_id == cobId) {
+            return &cobStats[cobHash[slot]];
+        }
+        slot = (slot + 1U) & (BUSLOAD_HASH_SIZE - 1U);
+    }
+
+    if (cobCount >= BUSLOAD_MAX_COB_IDS) {
+        return NULL;
+    }
+
+    cobHash[slot] = (uint8_t)cobCount;
+    cobStats[cobCount].cob_id = cobId;
+    cobStats[cobCount].min_interval_us = UINT32_MAX;
+    return &cobStats[cobCount++];
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  BusLoad_Log2Bucket
+ * Description   :  Histogram bucket of a jitter value in microseconds
+ *
+ *END**************************************************************************/
+static uint32_t BusLoad_Log2Bucket(uint32_t us)
+{
+    uint32_t bucket = (us == 0U) ? 0U : (32U - (uint32_t)__builtin_clz(us));
+
+    return (bucket < BUSLOAD_JITTER_BUCKETS) ? bucket : (BUSLOAD_JITTER_BUCKETS - 1U);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  BusLoad_Init
+ * Description   :  Clear all statistics. bitRate is the nominal rate from CAN0_config.
+ *
+ *END**************************************************************************/
+void BusLoad_Init(uint32_t bitRate)
+{
+    memset(cobStats, 0, sizeof(cobStats));
+    memset(cobHash, BUSLOAD_SLOT_EMPTY, sizeof(cobHash));
+    memset(&busStats, 0, sizeof(busStats));
+    cobCount = 0;
+    busStats.bit_rate = bitRate;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  BusLoad_FrameBits
+ * Description   :  Worst-case length on the wire of a standard data frame, including
+ *                  stuff bits and the 3 bit interframe space
+ *
+ *END**************************************************************************/
+uint32_t BusLoad_FrameBits(uint8_t dlc)
+{
+    uint32_t dataBits = 8U * ((dlc > 8U) ? 8U : dlc);
+
+    return 47U + dataBits + (34U + dataBits - 1U) / 4U;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  BusLoad_Record
+ * Description   :  Account one received frame. rxTimeNs is the hardware timestamp of
+ *                  the frame, nowNs the time it is being processed.
+ *
+ *END**************************************************************************/
+void BusLoad_Record(uint16_t cobId, uint8_t dlc, uint64_t rxTimeNs, uint64_t nowNs)
+{
+    busload_cob_stats_t *cob;
+    uint32_t interval;
+    uint32_t jitter;
+    uint32_t delay;
+
+    BusLoad_Update(nowNs);
+
+    busStats.frames++;
+    busStats.window_bits += BusLoad_FrameBits(dlc);
+
+    delay = (nowNs > rxTimeNs) ? (uint32_t)((nowNs - rxTimeNs) / 1000U) : 0U;
+    if (delay > busStats.max_queue_delay_us) {
+        busStats.max_queue_delay_us = delay;
+    }
+
+    cob = BusLoad_Find(cobId);
+    if (cob == NULL) {
+        busStats.unknown_cob_ids++;
+        return;
+    }
+
+    if (cob->frames > 0U && rxTimeNs > cob->last_rx_ns) {
+        interval = (uint32_t)((rxTimeNs - cob->last_rx_ns) / 1000U);
+
+        if (interval < cob->min_interval_us) {
+            cob->min_interval_us = interval;
+        }
+        if (interval > cob->max_interval_us) {
+            cob->max_interval_us = interval;
+        }
+
+        if (cob->frames > 1U) {
+            jitter = (interval > cob->last_interval_us) ? (interval - cob->last_interval_us)
+                                                        : (cob->last_interval_us - interval);
+            cob->jitter_hist[BusLoad_Log2Bucket(jitter)]++;
+        }
+        cob->last_interval_us = interval;
+    }
+
+    cob->last_rx_ns = rxTimeNs;
+    cob->frames++;
+    cob->window_frames++;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  BusLoad_Update
+ * Description   :  Close the statistics window once BUSLOAD_WINDOW_NS has elapsed.
+ *                  Called by BusLoad_Record and periodically so an idle bus reads 0.
+ *
+ *END**************************************************************************/
+void BusLoad_Update(uint64_t nowNs)
+{
+    uint64_t elapsed = nowNs - busStats.window_start_ns;
+    uint32_t i;
+
+    if (nowNs < busStats.window_start_ns || elapsed < BUSLOAD_WINDOW_NS) {
+        return;
+    }
+
+    if (busStats.bit_rate != 0U) {
+        busStats.load_permille = (uint32_t)(((uint64_t)busStats.window_bits * 1000ULL * 1000000000ULL) /
+                                            ((uint64_t)busStats.bit_rate * elapsed));
+        if (busStats.load_permille > busStats.peak_load_permille) {
+            busStats.peak_load_permille = busStats.load_permille;
+        }
+    }
+
+    for (i = 0; i < cobCount; i++) {
+        cobStats[i].fps = (uint32_t)(((uint64_t)cobStats[i].window_frames * 1000000000ULL) / elapsed);
+        cobStats[i].window_frames = 0;
+    }
+
+    busStats.window_bits = 0;
+    busStats.window_start_ns = nowNs;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  BusLoad_GetCobStats
+ * Description   :  Copy the statistics of one COB-ID. Returns false if never received.
+ *
+ *END**************************************************************************/
+bool BusLoad_GetCobStats(uint16_t cobId, busload_cob_stats_t *stats)
+{
+    uint32_t i;
+
+    for (i = 0; i < cobCount; i++) {
+        if (cobStats[i].cob_id == cobId) {
+            *stats = cobStats[i];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  BusLoad_GetStats
+ * Description   :  Copy the bus-wide statistics
+ *
+ *END**************************************************************************/
+void BusLoad_GetStats(busload_stats_t *stats)
+{
+    *stats = busStats;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  BusLoad_Show
+ * Description   :  This function is a simple debugging function that outputs the bus load
+ *                  and the rate and jitter of every COB-ID on the UART
+ *
+ *END**************************************************************************/
+void BusLoad_Show(void)
+{
+    char str[160];
+    uint32_t i;
+    uint32_t b;
+    int len;
+
+    sprintf(str, "CAN: %lu bit/s, load %lu.%lu%% (peak %lu.%lu%%), max delay %lu us, lost %lu\r\n",
+            (unsigned long)busStats.bit_rate,
+            (unsigned long)(busStats.load_permille / 10U), (unsigned long)(busStats.load_permille % 10U),
+            (unsigned long)(busStats.peak_load_permille / 10U), (unsigned long)(busStats.peak_load_permille % 10U),
+            (unsigned long)busStats.max_queue_delay_us, (unsigned long)busStats.unknown_cob_ids);
+    UART_LOG(str);
+
+    for (i = 0; i < cobCount; i++) {
+        busload_cob_stats_t *cob = &cobStats[i];
+
+        len = sprintf(str, " 0x%03X: %lu fps, interval %lu..%lu us, jitter",
+                      cob->cob_id, (unsigned long)cob->fps,
+                      (unsigned long)((cob->min_interval_us == UINT32_MAX) ? 0U : cob->min_interval_us),
+                      (unsigned long)cob->max_interval_us);
+
+        for (b = 0; b < BUSLOAD_JITTER_BUCKETS && len < (int)sizeof(str) - 14; b++) {
+            len += sprintf(&str[len], " %lu", (unsigned long)cob->jitter_hist[b]);
+        }
+        sprintf(&str[len], "\r\n");
+        UART_LOG(str);
+    }
+}
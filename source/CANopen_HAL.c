@@ -5,13 +5,47 @@
 #include "Utilities.h"
 #include "fsl_clock.h"
 #include "peripherals.h"
-
-#define SIZE_OF_AXE_X   256.0
-#define SIZE_OF_AXE_Y   256.0
-
-#define SCALE_OF_AXE_X  88.0
-#define SCALE_OF_AXE_Y  88.0
-#define DECALAGE_PWM    6.0
+#include "CANopen_PDO.h"
+#include "ecat_gateway.h"
+#include "CAN_BusLoad.h"
+#include "CANopen_Node.h"
+#include "Joystick.h"
+#include "enet_raw.h"
+#include "Trace.h"
+
+/* Received frame with its reception time on the 1588 time base */
+typedef struct {
+    flexcan_frame_t frame;
+    uint64_t rxTimeNs;
+} can_rx_entry_t;
+
+/* Lock-free single-producer (ISR) / single-consumer (CAN task) RX queue */
+typedef struct {
+    can_rx_entry_t entries[CAN_RX_QUEUE_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t overflows;
+} can_rx_queue_t;
+
+static flexcan_handle_t canHandle;
+static flexcan_frame_t rxFifoFrame;
+static flexcan_fifo_transfer_t rxFifoXfer;
+static can_rx_queue_t rxQueue;
+static TaskHandle_t rxNotifyTask = NULL;
+
+/* TX engine: mailbox pool above the RX FIFO and a software queue behind it */
+typedef struct {
+    flexcan_frame_t queue[CAN_TX_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t freeMask;          // Bit n set = mailbox CAN_FIRST_TX_MAILBOX + n is free
+    uint32_t sent;
+    uint32_t queued;
+    uint32_t dropped;
+} can_tx_engine_t;
+
+static can_tx_engine_t txEngine;
+static uint32_t canBitTimeNs = 0;
 
 /* Define receive frame buffers */
 flexcan_frame_t movesRecvFrame;
@@ -19,173 +53,447 @@ flexcan_frame_t ledRecvFrame;
 flexcan_frame_t buttonsRecvFrame;
 
 // Define variables that contain data received
-Moves moves = {50.0, 50.0};
+Moves moves = {JOY_RAW_CENTER, JOY_RAW_CENTER};
 Led led = {};
 Buttons buttons = {};
 
+/* RPDO mappings. Adding a CAN device only needs a new entry list and table line.
+ * Joystick axes stay raw unsigned hundredths for the fixed-point pipeline in Joystick.c,
+ * buttons and LEDs are bits of data byte 3. */
+static const pdo_map_entry_t movesMap[] = {
+    { .bit_offset = 16, .bit_length = 16, .type = PDO_TYPE_U16, .data = &moves.Axe_X },
+    { .bit_offset = 0,  .bit_length = 16, .type = PDO_TYPE_U16, .data = &moves.Axe_Y },
+};
+
+static const pdo_map_entry_t buttonsMap[] = {
+    { .bit_offset = 24, .bit_length = 1, .type = PDO_TYPE_BOOL, .data = &buttons.Enable },
+    { .bit_offset = 25, .bit_length = 1, .type = PDO_TYPE_BOOL, .data = &buttons.speed },
+    { .bit_offset = 26, .bit_length = 1, .type = PDO_TYPE_BOOL, .data = &buttons.E_Stop },
+    { .bit_offset = 27, .bit_length = 1, .type = PDO_TYPE_BOOL, .data = &buttons.Horn },
+    { .bit_offset = 28, .bit_length = 1, .type = PDO_TYPE_BOOL, .data = &buttons.CAN_Enable },
+};
+
+static const pdo_map_entry_t ledMap[] = {
+    { .bit_offset = 24, .bit_length = 1, .type = PDO_TYPE_BOOL, .data = &led.Yellow_Bat_Led },
+    { .bit_offset = 25, .bit_length = 1, .type = PDO_TYPE_BOOL, .data = &led.Red_Bat_Led },
+    { .bit_offset = 26, .bit_length = 1, .type = PDO_TYPE_BOOL, .data = &led.Overload_Led },
+    { .bit_offset = 27, .bit_length = 1, .type = PDO_TYPE_BOOL, .data = &led.Aux_Led },
+};
+
+#define PDO_ENTRIES(map)    (uint8_t)(sizeof(map) / sizeof(map[0])), (map)
+
+static void CAN_MovesReceived(const pdo_mapping_t *pdo);
+
+static const pdo_mapping_t canRpdoTable[] = {
+    { RX_MOVES_MSG_ID,   PDO_ENTRIES(movesMap),   &movesRecvFrame,   CAN_MovesReceived },
+    { RX_BUTTONS_MSG_ID, PDO_ENTRIES(buttonsMap), &buttonsRecvFrame, NULL },
+    { RX_LED_MSG_ID,     PDO_ENTRIES(ledMap),     &ledRecvFrame,     NULL },
+};
+
+#if ECAT_GATEWAY_ENABLE
+/* Gateway routes: raw joystick and button bits go straight into the EtherCAT output image */
+static const ecat_gw_signal_t movesSignals[] = {
+    { .can_bit_offset = 16, .bit_length = 16, .image_bit_offset = GW_IMAGE_AXE_X_BIT, .signal = GW_SIGNAL_AXE_X },
+    { .can_bit_offset = 0,  .bit_length = 16, .image_bit_offset = GW_IMAGE_AXE_Y_BIT, .signal = GW_SIGNAL_AXE_Y },
+};
+
+static const ecat_gw_signal_t buttonsSignals[] = {
+    { .can_bit_offset = 24, .bit_length = 5, .image_bit_offset = GW_IMAGE_BUTTONS_BIT, .signal = GW_SIGNAL_BUTTONS },
+};
+
+static const ecat_gw_route_t canGatewayRoutes[] = {
+    { RX_MOVES_MSG_ID,   (uint8_t)(sizeof(movesSignals) / sizeof(movesSignals[0])),     movesSignals },
+    { RX_BUTTONS_MSG_ID, (uint8_t)(sizeof(buttonsSignals) / sizeof(buttonsSignals[0])), buttonsSignals },
+};
+#endif
+
 /*FUNCTION**********************************************************************
  *
- * Function Name :  SendCANData
- * Description   :  This function take a mailbox, an ID and a data array and send the message
- *                  to the CAN bus
+ * Function Name :  CAN_HAL_TxPrepare
+ * Description   :  Build the constant part of a frame once, so sending only has to
+ *                  fill in the two data words
  *
  *END**************************************************************************/
-void SendCANData(uint32_t mailbox, uint32_t messageId, uint8_t * data, uint32_t len)
+void CAN_HAL_TxPrepare(can_tx_template_t *tpl, uint16_t cobId, uint8_t length)
 {
-    flexcan_frame_t txFrame;
-
-    // Clear the frame structure
-    memset(&txFrame, 0, sizeof(flexcan_frame_t));
-
-    // Set frame properties
-    txFrame.id = FLEXCAN_ID_STD(messageId);  // Standard frame format
-    txFrame.format = kFLEXCAN_FrameFormatStandard;
-    txFrame.type = kFLEXCAN_FrameTypeData;
-    txFrame.length = len;
-
-    // Copy data to frame (up to 8 bytes)
-    if (len > 0 && len <= 8) {
-        for (uint32_t i = 0; i < len; i++) {
-            if (i < 4) {
-                txFrame.dataWord0 |= ((uint32_t)data[3-i] << (i * 8));
-            } else {
-                txFrame.dataWord1 |= ((uint32_t)data[7-(i-4)] << ((i-4) * 8));
-            }
+    memset(&tpl->frame, 0, sizeof(flexcan_frame_t));
+    tpl->frame.id = FLEXCAN_ID_STD(cobId);
+    tpl->frame.format = kFLEXCAN_FrameFormatStandard;
+    tpl->frame.type = kFLEXCAN_FrameTypeData;
+    tpl->frame.length = (length > 8U) ? 8U : length;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CAN_TxStart
+ * Description   :  Write a frame into a free TX mailbox. Called with the CAN interrupt masked.
+ *
+ *END**************************************************************************/
+static status_t CAN_TxStart(uint8_t mbIdx, flexcan_frame_t *frame)
+{
+    flexcan_mb_transfer_t xfer;
+
+    xfer.mbIdx = mbIdx;
+    xfer.frame = frame;
+    return FLEXCAN_TransferSendNonBlocking(FLEXCAN_INSTANCE, &canHandle, &xfer);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CAN_HAL_TxSendWords
+ * Description   :  Queue a frame built from a template and two data words already in
+ *                  FlexCAN order (data byte 0 in the MSB of word0). The frame goes into the
+ *                  lowest free TX mailbox, or the software queue when all are busy.
+ *                  Callable from tasks and from ISRs up to configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ *
+ *END**************************************************************************/
+status_t CAN_HAL_TxSendWords(const can_tx_template_t *tpl, uint32_t word0, uint32_t word1)
+{
+    flexcan_frame_t frame = tpl->frame;
+    UBaseType_t saved;
+    status_t status = kStatus_Success;
+    uint32_t mb;
+
+    frame.dataWord0 = word0;
+    frame.dataWord1 = word1;
+
+    saved = portSET_INTERRUPT_MASK_FROM_ISR();
+
+    if (txEngine.freeMask != 0U) {
+        mb = __CLZ(__RBIT(txEngine.freeMask));
+        txEngine.freeMask &= ~(1UL << mb);
+        status = CAN_TxStart((uint8_t)(CAN_FIRST_TX_MAILBOX + mb), &frame);
+        if (status != kStatus_Success) {
+            txEngine.freeMask |= (1UL << mb);
         }
+    } else if ((txEngine.head - txEngine.tail) < CAN_TX_QUEUE_SIZE) {
+        txEngine.queue[txEngine.head & (CAN_TX_QUEUE_SIZE - 1U)] = frame;
+        txEngine.head++;
+        txEngine.queued++;
+    } else {
+        txEngine.dropped++;
+        status = kStatus_FLEXCAN_TxBusy;
     }
 
-    /* Configure TX message buffer if not already configured */
-    FLEXCAN_SetTxMbConfig(FLEXCAN_INSTANCE, mailbox, true);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(saved);
 
-    /* Send the frame */
-    FLEXCAN_WriteTxMb(FLEXCAN_INSTANCE, mailbox, &txFrame);
+    return status;
 }
 
 /*FUNCTION**********************************************************************
  *
- * Function Name :  FLEXCAN_Receive_Moves
- * Description   :  This function configures the data buffer and starts the receiving process
- *                  of the information at 0x28A ID. It waits until the receiving process
- *                  is done and update the moves variable that contains the values for both controller joysticks
+ * Function Name :  CAN_HAL_TxSend
+ * Description   :  Queue a frame built from a template and length bytes of data.
+ *                  The bytes are packed with word loads and __REV, no per-byte loop.
  *
  *END**************************************************************************/
-status_t FLEXCAN_Receive_Moves(void)
+status_t CAN_HAL_TxSend(const can_tx_template_t *tpl, const uint8_t *data)
 {
-    uint32_t flag = 1U << RX_MOVES_MAILBOX;
-    uint32_t timeout = 1000;  // Timeout counter
-
-    /* Wait until message is received or timeout */
-    while ((FLEXCAN_GetMbStatusFlags(FLEXCAN_INSTANCE, flag) == 0) && (timeout > 0)) {
-        timeout--;
-        // Small delay to prevent busy waiting
-        for (volatile int i = 0; i < 1000; i++);
-    }
+    uint32_t words[2] = {0U, 0U};
 
-    if (timeout == 0) {
-        return kStatus_Timeout;
-    }
+    memcpy(words, data, tpl->frame.length);
+    return CAN_HAL_TxSendWords(tpl, __REV(words[0]), __REV(words[1]));
+}
 
-    /* Read the received message */
-    status_t result = FLEXCAN_ReadRxMb(FLEXCAN_INSTANCE, RX_MOVES_MAILBOX, &movesRecvFrame);
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CAN_TxComplete
+ * Description   :  TX mailbox completion, runs in the CAN0 ISR. The mailbox is refilled
+ *                  straight from the software queue, or returned to the free pool.
+ *
+ *END**************************************************************************/
+static void CAN_TxComplete(uint32_t mbIdx)
+{
+    uint32_t mb = mbIdx - CAN_FIRST_TX_MAILBOX;
+    UBaseType_t saved;
 
-    /* Clear the flag */
-    FLEXCAN_ClearMbStatusFlags(FLEXCAN_INSTANCE, flag);
+    saved = portSET_INTERRUPT_MASK_FROM_ISR();
 
-    if (result == kStatus_Success || result == kStatus_FLEXCAN_RxOverflow) {
-        // Update moves structure from received data
-        // Assuming the data format is preserved from original implementation
-        uint8_t* dataBytes = (uint8_t*)&movesRecvFrame.dataWord0;
-        moves.Axe_X = (float)((dataBytes[0] << 8) | dataBytes[1]) / 100.0f;
-        moves.Axe_Y = (float)((dataBytes[2] << 8) | dataBytes[3]) / 100.0f;
+    txEngine.sent++;
+    if (txEngine.tail != txEngine.head &&
+        CAN_TxStart((uint8_t)mbIdx, &txEngine.queue[txEngine.tail & (CAN_TX_QUEUE_SIZE - 1U)]) == kStatus_Success) {
+        txEngine.tail++;
+    } else {
+        txEngine.freeMask |= (1UL << mb);
     }
 
-    return result;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(saved);
 }
 
 /*FUNCTION**********************************************************************
  *
- * Function Name :  FLEXCAN_Receive_Buttons
- * Description   :  This function configures the data buffer and starts the receiving process
- *                  of the information at 0x18A ID. It waits until the receiving process
- *                  is done and update the buttons variable that contains the values for the
- *                  enable, speed, starts, e-stop and horn.
+ * Function Name :  CAN_HAL_GetTxStats
+ * Description   :  Frames sent, frames that had to wait in the software queue and frames
+ *                  dropped because the queue was full
  *
  *END**************************************************************************/
-status_t FLEXCAN_Receive_Buttons(void)
+void CAN_HAL_GetTxStats(uint32_t *sent, uint32_t *queued, uint32_t *dropped)
 {
-    uint32_t flag = 1U << RX_BUTTONS_MAILBOX;
-    uint32_t timeout = 1000;  // Timeout counter
-
-    /* Wait until message is received or timeout */
-    while ((FLEXCAN_GetMbStatusFlags(FLEXCAN_INSTANCE, flag) == 0) && (timeout > 0)) {
-        timeout--;
-        // Small delay to prevent busy waiting
-        for (volatile int i = 0; i < 1000; i++);
+    *sent = txEngine.sent;
+    *queued = txEngine.queued;
+    *dropped = txEngine.dropped;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  SendCANData
+ * Description   :  This function take an ID and a data array and send the message
+ *                  to the CAN bus through the TX engine
+ *
+ *END**************************************************************************/
+void SendCANData(uint32_t messageId, uint8_t * data, uint32_t len)
+{
+    can_tx_template_t tpl;
+
+    CAN_HAL_TxPrepare(&tpl, (uint16_t)messageId, (uint8_t)len);
+    (void)CAN_HAL_TxSend(&tpl, data);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CAN_RxQueuePush
+ * Description   :  Single-producer push used by the FlexCAN ISR. The frame is copied
+ *                  before the head index is published, so the CAN task never sees a
+ *                  partially written slot. Drops the frame if the queue is full.
+ *
+ *END**************************************************************************/
+static inline bool CAN_RxQueuePush(const flexcan_frame_t *frame, uint64_t rxTimeNs)
+{
+    uint32_t head = rxQueue.head;
+
+    if ((head - rxQueue.tail) >= CAN_RX_QUEUE_SIZE) {
+        rxQueue.overflows++;
+        return false;
     }
 
-    if (timeout == 0) {
-        return kStatus_Timeout;
+    rxQueue.entries[head & (CAN_RX_QUEUE_SIZE - 1U)].frame = *frame;
+    rxQueue.entries[head & (CAN_RX_QUEUE_SIZE - 1U)].rxTimeNs = rxTimeNs;
+    __DMB();
+    rxQueue.head = head + 1U;
+    return true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CAN_RxQueuePop
+ * Description   :  Single-consumer pop used by the CAN task
+ *
+ *END**************************************************************************/
+static inline bool CAN_RxQueuePop(can_rx_entry_t *entry)
+{
+    uint32_t tail = rxQueue.tail;
+
+    if (tail == rxQueue.head) {
+        return false;
     }
 
-    /* Read the received message */
-    status_t result = FLEXCAN_ReadRxMb(FLEXCAN_INSTANCE, RX_BUTTONS_MAILBOX, &buttonsRecvFrame);
+    __DMB();
+    *entry = rxQueue.entries[tail & (CAN_RX_QUEUE_SIZE - 1U)];
+    __DMB();
+    rxQueue.tail = tail + 1U;
+    return true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CAN_FrameTimeNs
+ * Description   :  Convert the FlexCAN timestamp of a frame to the ENET 1588 time base.
+ *                  The free-running timer counts bit times, so the frame age is the
+ *                  timer distance from the stamp to now. Valid for ISR latencies up to
+ *                  65535 bit times (262 ms at 250 kbit/s).
+ *
+ *END**************************************************************************/
+static inline uint64_t CAN_FrameTimeNs(const flexcan_frame_t *frame)
+{
+    uint32_t nowTicks = FLEXCAN_INSTANCE->TIMER & CAN_TIMER_TIMER_MASK;
+    uint64_t nowNs = enet_raw_time_ns();
+    uint64_t ageNs = (uint64_t)((nowTicks - frame->timestamp) & CAN_TIMER_TIMER_MASK) * canBitTimeNs;
+
+    return (nowNs > ageNs) ? (nowNs - ageNs) : 0U;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CAN_TransferCallback
+ * Description   :  FlexCAN transfer callback, runs in the CAN0 ISR. Each RX FIFO frame
+ *                  is queued, the FIFO receive is re-armed and the CAN task is notified.
+ *                  The SDK IRQ handler keeps calling back while the FIFO holds frames.
+ *
+ *END**************************************************************************/
+static FLEXCAN_CALLBACK(CAN_TransferCallback)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    uint64_t rxTimeNs;
+
+    (void)userData;
+    TRACE_ISR_ENTER(TRACE_ISR_CAN);
+    switch (status)
+    {
+        case kStatus_FLEXCAN_RxFifoIdle:
+            rxTimeNs = CAN_FrameTimeNs(&rxFifoFrame);
+#if ECAT_GATEWAY_ENABLE
+            /* Straight into the next EtherCAT output image, no task hop */
+            (void)ecat_gw_route_frame(&rxFifoFrame, rxTimeNs);
+#endif
+            if (CAN_RxQueuePush(&rxFifoFrame, rxTimeNs) && (rxNotifyTask != NULL)) {
+                vTaskNotifyGiveFromISR(rxNotifyTask, &xHigherPriorityTaskWoken);
+            }
+            (void)FLEXCAN_TransferReceiveFifoNonBlocking(base, handle, &rxFifoXfer);
+            break;
 
-    /* Clear the flag */
-    FLEXCAN_ClearMbStatusFlags(FLEXCAN_INSTANCE, flag);
+        case kStatus_FLEXCAN_RxFifoOverflow:
+            rxQueue.overflows++;
+            break;
 
-    if (result == kStatus_Success || result == kStatus_FLEXCAN_RxOverflow) {
-        // Update buttons structure from received data
-        uint8_t* dataBytes = (uint8_t*)&buttonsRecvFrame.dataWord0;
-        buttons.Enable = (dataBytes[0] & 0x01) ? true : false;
-        buttons.speed = (dataBytes[0] & 0x02) ? true : false;
-        buttons.E_Stop = (dataBytes[0] & 0x04) ? true : false;
-        buttons.Horn = (dataBytes[0] & 0x08) ? true : false;
-        buttons.CAN_Enable = (dataBytes[0] & 0x10) ? true : false;
+        case kStatus_FLEXCAN_TxIdle:
+            CAN_TxComplete(result);
+            break;
+
+        default:
+            break;
     }
 
-    return result;
+    TRACE_ISR_EXIT(TRACE_ISR_CAN);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 /*FUNCTION**********************************************************************
  *
- * Function Name :  FLEXCAN_Receive_Led
- * Description   :  This function configures the data buffer and starts the receiving process
- *                  of the information at 0x30A ID. It waits until the receiving process
- *                  is done and update the Led variable that contains the values for all controler LEDs
+ * Function Name :  CAN_HAL_RxInit
+ * Description   :  This function replaces the per-ID RX mailboxes with the legacy RX FIFO,
+ *                  filtered on the COB-IDs of the RPDO table, and starts interrupt driven
+ *                  reception. notifyTask receives a task notification per queued frame.
+ *                  The remaining mailboxes become the TX engine pool.
  *
  *END**************************************************************************/
-status_t FLEXCAN_Receive_Led(void)
+status_t CAN_HAL_RxInit(TaskHandle_t notifyTask)
 {
-    uint32_t flag = 1U << RX_LED_MAILBOX;
-    uint32_t timeout = 1000;  // Timeout counter
-
-    /* Wait until message is received or timeout */
-    while ((FLEXCAN_GetMbStatusFlags(FLEXCAN_INSTANCE, flag) == 0) && (timeout > 0)) {
-        timeout--;
-        // Small delay to prevent busy waiting
-        for (volatile int i = 0; i < 1000; i++);
+    static uint32_t rxFifoFilter[CAN_RX_FIFO_FILTER_NUM];
+    flexcan_rx_fifo_config_t rxFifoConfig;
+    status_t status;
+    uint32_t rpdoCount;
+    uint32_t i;
+
+    rxNotifyTask = notifyTask;
+    rxQueue.head = 0;
+    rxQueue.tail = 0;
+    rxQueue.overflows = 0;
+
+    canBitTimeNs = 1000000000UL / CAN0_config.bitRate;
+    BusLoad_Init(CAN0_config.bitRate);
+
+    /* Timer sync would reset the timestamp base on every reception in the first free MB */
+    FLEXCAN_EnterFreezeMode(FLEXCAN_INSTANCE);
+    FLEXCAN_INSTANCE->CTRL1 &= ~CAN_CTRL1_TSYN_MASK;
+    FLEXCAN_ExitFreezeMode(FLEXCAN_INSTANCE);
+
+    if (PDO_Init(canRpdoTable, sizeof(canRpdoTable) / sizeof(canRpdoTable[0])) != PDO_SUCCESS) {
+        return kStatus_InvalidArgument;
+    }
+
+#if CANOPEN_NODE_ENABLE
+    /* NMT and SDO requests are dispatched like RPDOs and need their own filters */
+    if (CANopen_NodeInit() != kStatus_Success) {
+        return kStatus_Fail;
+    }
+#endif
+
+#if ECAT_GATEWAY_ENABLE
+    if (ecat_gw_init(canGatewayRoutes, (uint8_t)(sizeof(canGatewayRoutes) / sizeof(canGatewayRoutes[0]))) != ECAT_GW_SUCCESS) {
+        return kStatus_InvalidArgument;
+    }
+#endif
+
+    /* One filter per RPDO, unused slots repeat the first COB-ID */
+    rpdoCount = PDO_GetCount();
+    for (i = 0; i < CAN_RX_FIFO_FILTER_NUM; i++) {
+        rxFifoFilter[i] = FLEXCAN_RX_FIFO_STD_FILTER_TYPE_A(PDO_GetCobId((i < rpdoCount) ? i : 0U), 0, 0);
     }
 
-    if (timeout == 0) {
-        return kStatus_Timeout;
+    rxFifoConfig.idFilterTable = rxFifoFilter;
+    rxFifoConfig.idFilterNum = CAN_RX_FIFO_FILTER_NUM;
+    rxFifoConfig.idFilterType = kFLEXCAN_RxFifoFilterTypeA;
+    rxFifoConfig.priority = kFLEXCAN_RxFifoPrioHigh;
+
+    /* More RPDOs than filters: accept everything, unknown COB-IDs are dropped by PDO_Dispatch */
+    FLEXCAN_SetRxFifoGlobalMask(FLEXCAN_INSTANCE, FLEXCAN_RX_FIFO_STD_MASK_TYPE_A(
+                                (rpdoCount <= CAN_RX_FIFO_FILTER_NUM) ? 0x7FFU : 0U, 0, 0));
+    FLEXCAN_SetRxFifoConfig(FLEXCAN_INSTANCE, &rxFifoConfig, true);
+
+    /* TX mailboxes live above the FIFO and filter table, configured once */
+    memset(&txEngine, 0, sizeof(txEngine));
+    for (i = CAN_FIRST_TX_MAILBOX; i < CAN_TX_MAILBOX_END; i++) {
+        FLEXCAN_SetTxMbConfig(FLEXCAN_INSTANCE, (uint8_t)i, true);
+        txEngine.freeMask |= (1UL << (i - CAN_FIRST_TX_MAILBOX));
     }
 
-    /* Read the received message */
-    status_t result = FLEXCAN_ReadRxMb(FLEXCAN_INSTANCE, RX_LED_MAILBOX, &ledRecvFrame);
+    FLEXCAN_TransferCreateHandle(FLEXCAN_INSTANCE, &canHandle, CAN_TransferCallback, NULL);
+
+    /* The callback uses FreeRTOS FromISR API */
+    NVIC_SetPriority(CAN0_ORed_Message_buffer_IRQn, CAN_IRQ_PRIORITY);
+    NVIC_SetPriority(CAN0_Bus_Off_IRQn, CAN_IRQ_PRIORITY);
+    NVIC_SetPriority(CAN0_Error_IRQn, CAN_IRQ_PRIORITY);
+    NVIC_SetPriority(CAN0_Tx_Warning_IRQn, CAN_IRQ_PRIORITY);
+    NVIC_SetPriority(CAN0_Rx_Warning_IRQn, CAN_IRQ_PRIORITY);
+    NVIC_SetPriority(CAN0_Wake_Up_IRQn, CAN_IRQ_PRIORITY);
 
-    /* Clear the flag */
-    FLEXCAN_ClearMbStatusFlags(FLEXCAN_INSTANCE, flag);
+    rxFifoXfer.frame = &rxFifoFrame;
+    status = FLEXCAN_TransferReceiveFifoNonBlocking(FLEXCAN_INSTANCE, &canHandle, &rxFifoXfer);
 
-    if (result == kStatus_Success || result == kStatus_FLEXCAN_RxOverflow) {
-        // Update LED structure from received data
-        uint8_t* dataBytes = (uint8_t*)&ledRecvFrame.dataWord0;
-        led.Yellow_Bat_Led = (dataBytes[0] & 0x01) ? true : false;
-        led.Red_Bat_Led = (dataBytes[0] & 0x02) ? true : false;
-        led.Overload_Led = (dataBytes[0] & 0x04) ? true : false;
-        led.Aux_Led = (dataBytes[0] & 0x08) ? true : false;
+#if CANOPEN_NODE_ENABLE
+    if (status == kStatus_Success) {
+        CANopen_NodeStart();
     }
+#endif
 
-    return result;
+    return status;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CAN_HAL_ProcessRx
+ * Description   :  Drain the RX queue filled by the ISR and decode every frame through
+ *                  the RPDO table. Never blocks; returns the number of frames processed.
+ *
+ *END**************************************************************************/
+uint32_t CAN_HAL_ProcessRx(void)
+{
+    can_rx_entry_t entry;
+    uint32_t count = 0;
+
+    while (CAN_RxQueuePop(&entry)) {
+        BusLoad_Record((uint16_t)(entry.frame.id >> CAN_ID_STD_SHIFT), entry.frame.length,
+                       entry.rxTimeNs, enet_raw_time_ns());
+        (void)PDO_Dispatch(&entry.frame);
+        count++;
+    }
+
+    return count;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CAN_HAL_GetRxOverflows
+ * Description   :  Number of frames lost because the RX queue or hardware FIFO was full
+ *
+ *END**************************************************************************/
+uint32_t CAN_HAL_GetRxOverflows(void)
+{
+    return rxQueue.overflows;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CAN_HAL_GetRxTime
+ * Description   :  Reception time of the last frame with this COB-ID on the 1588 time
+ *                  base, 0 if none was received yet
+ *
+ *END**************************************************************************/
+uint64_t CAN_HAL_GetRxTime(uint16_t cobId)
+{
+    busload_cob_stats_t stats;
+
+    return BusLoad_GetCobStats(cobId, &stats) ? stats.last_rx_ns : 0U;
 }
 
 /*FUNCTION**********************************************************************
@@ -197,12 +505,10 @@ status_t FLEXCAN_Receive_Led(void)
  *END**************************************************************************/
 void Show_movesRecvBuffer(void)
 {
-    char str[64];
     uint8_t* dataBytes = (uint8_t*)&movesRecvFrame.dataWord0;
-    sprintf(str,"MOVES: %d %d %d %d %d %d %d %d\n",
-            dataBytes[0], dataBytes[1], dataBytes[2], dataBytes[3],
-            dataBytes[4], dataBytes[5], dataBytes[6], dataBytes[7]);
-    UART_LOG(str);
+    LOG_DEBUG(CAN, "MOVES: %d %d %d %d %d %d %d %d\n",
+              dataBytes[0], dataBytes[1], dataBytes[2], dataBytes[3],
+              dataBytes[4], dataBytes[5], dataBytes[6], dataBytes[7]);
 }
 
 /*FUNCTION**********************************************************************
@@ -214,12 +520,10 @@ void Show_movesRecvBuffer(void)
  *END**************************************************************************/
 void Show_buttonsRecvBuffer(void)
 {
-    char str[64];
     uint8_t* dataBytes = (uint8_t*)&buttonsRecvFrame.dataWord0;
-    sprintf(str,"BUTTONS: %d %d %d %d %d %d %d %d\n",
-            dataBytes[0], dataBytes[1], dataBytes[2], dataBytes[3],
-            dataBytes[4], dataBytes[5], dataBytes[6], dataBytes[7]);
-    UART_LOG(str);
+    LOG_DEBUG(CAN, "BUTTONS: %d %d %d %d %d %d %d %d\n",
+              dataBytes[0], dataBytes[1], dataBytes[2], dataBytes[3],
+              dataBytes[4], dataBytes[5], dataBytes[6], dataBytes[7]);
 }
 
 /*FUNCTION**********************************************************************
@@ -231,12 +535,10 @@ void Show_buttonsRecvBuffer(void)
  *END**************************************************************************/
 void Show_ledRecvBuffer(void)
 {
-    char str[64];
     uint8_t* dataBytes = (uint8_t*)&ledRecvFrame.dataWord0;
-    sprintf(str,"LED: %d %d %d %d %d %d %d %d\n",
-            dataBytes[0], dataBytes[1], dataBytes[2], dataBytes[3],
-            dataBytes[4], dataBytes[5], dataBytes[6], dataBytes[7]);
-    UART_LOG(str);
+    LOG_DEBUG(CAN, "LED: %d %d %d %d %d %d %d %d\n",
+              dataBytes[0], dataBytes[1], dataBytes[2], dataBytes[3],
+              dataBytes[4], dataBytes[5], dataBytes[6], dataBytes[7]);
 }
 
 bool get_enable(void)
@@ -255,13 +557,27 @@ bool get_speed(void)
     return buttons.speed;
 }
 
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CAN_MovesReceived
+ * Description   :  RPDO callback of MOVES, in the CAN task from PDO_Dispatch. Every
+ *                  sample goes through the joystick pipeline, also when one wake of
+ *                  the task drains several.
+ *
+ *END**************************************************************************/
+static void CAN_MovesReceived(const pdo_mapping_t *pdo)
+{
+    (void)pdo;
+    Joystick_Update(moves.Axe_X, moves.Axe_Y);
+}
+
 /*FUNCTION**********************************************************************
  *
  * Function Name :  get_Axe_X
- * Description   :  This function returns the X axis value
+ * Description   :  This function returns the raw X axis value in hundredths of percent
  *
  *END**************************************************************************/
-float get_Axe_X(void)
+uint16_t get_Axe_X(void)
 {
     return moves.Axe_X;
 }
@@ -269,10 +585,32 @@ float get_Axe_X(void)
 /*FUNCTION**********************************************************************
  *
  * Function Name :  get_Axe_Y
- * Description   :  This function returns the Y axis value
+ * Description   :  This function returns the raw Y axis value in hundredths of percent
  *
  *END**************************************************************************/
-float get_Axe_Y(void)
+uint16_t get_Axe_Y(void)
 {
     return moves.Axe_Y;
 }
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  get_E_Stop
+ * Description   :  This function returns the value of the emergency stop button
+ *
+ *END**************************************************************************/
+bool get_E_Stop(void)
+{
+    return buttons.E_Stop;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  get_Horn
+ * Description   :  This function returns the value of the horn button
+ *
+ *END**************************************************************************/
+bool get_Horn(void)
+{
+    return buttons.Horn;
+}
@@ -0,0 +1,435 @@
+#include "CANopen_Node.h"
+#include "CANopen_HAL.h"
+#include "CANopen_PDO.h"
+#include "Shell.h"
+#include "Utilities.h"
+#include "string.h"
+#include "FreeRTOS.h"
+#include "timers.h"
+
+// SDO command specifiers (byte 0, bits 7:5)
+#define SDO_CCS_DOWNLOAD_INIT   (1U)
+#define SDO_CCS_UPLOAD_INIT     (2U)
+#define SDO_CS_ABORT            (4U)
+#define SDO_SCS_UPLOAD_INIT     (2U)
+#define SDO_SCS_DOWNLOAD_INIT   (3U)
+
+// SDO byte 0 flags
+#define SDO_EXPEDITED           (0x02U)
+#define SDO_SIZE_INDICATED      (0x01U)
+#define SDO_SIZE_UNUSED(b)      (((b) >> 2) & 0x03U)
+
+// SDO abort codes
+#define SDO_ABORT_CMD           (0x05040001UL)
+#define SDO_ABORT_UNSUPPORTED   (0x06010000UL)
+#define SDO_ABORT_WRITE_ONLY    (0x06010001UL)
+#define SDO_ABORT_READ_ONLY     (0x06010002UL)
+#define SDO_ABORT_NO_OBJECT     (0x06020000UL)
+#define SDO_ABORT_LENGTH        (0x06070010UL)
+#define SDO_ABORT_NO_SUBINDEX   (0x06090011UL)
+
+// NMT commands
+#define NMT_CS_START            (0x01U)
+#define NMT_CS_STOP             (0x02U)
+#define NMT_CS_PRE_OPERATIONAL  (0x80U)
+#define NMT_CS_RESET_NODE       (0x81U)
+#define NMT_CS_RESET_COMM       (0x82U)
+
+// Communication objects
+static const uint32_t deviceType = 0x00000000UL;
+static uint8_t errorRegister = 0;
+static uint16_t heartbeatTimeMs = CANOPEN_HEARTBEAT_MS;
+static const uint8_t identityCount = 4;
+static const uint32_t identity[4] = { 0x00000000UL, 0x00000001UL, 0x00000001UL, 0x00000000UL };
+
+// Sub-index 0 of the manufacturer records
+static const uint8_t movesCount = 2;
+static const uint8_t buttonsCount = 5;
+
+// Object dictionary, sorted by index then subindex
+static const od_entry_t objectDictionary[] = {
+    { 0x1000, 0, OD_ATTR_READ, 4, (void *)&deviceType },
+    { 0x1001, 0, OD_ATTR_READ, 1, &errorRegister },
+    { 0x1017, 0, OD_ATTR_RW,   2, &heartbeatTimeMs },
+    { 0x1018, 0, OD_ATTR_READ, 1, (void *)&identityCount },
+    { 0x1018, 1, OD_ATTR_READ, 4, (void *)&identity[0] },   // Vendor ID
+    { 0x1018, 2, OD_ATTR_READ, 4, (void *)&identity[1] },   // Product code
+    { 0x1018, 3, OD_ATTR_READ, 4, (void *)&identity[2] },   // Revision
+    { 0x1018, 4, OD_ATTR_READ, 4, (void *)&identity[3] },   // Serial number
+    { 0x2000, 0, OD_ATTR_READ, 1, (void *)&movesCount },
+    { 0x2000, 1, OD_ATTR_READ, 2, &moves.Axe_X },           // UNSIGNED16, hundredths of percent
+    { 0x2000, 2, OD_ATTR_READ, 2, &moves.Axe_Y },
+    { 0x2001, 0, OD_ATTR_READ, 1, (void *)&buttonsCount },
+    { 0x2001, 1, OD_ATTR_READ, 1, &buttons.Enable },
+    { 0x2001, 2, OD_ATTR_READ, 1, &buttons.speed },
+    { 0x2001, 3, OD_ATTR_READ, 1, &buttons.E_Stop },
+    { 0x2001, 4, OD_ATTR_READ, 1, &buttons.Horn },
+    { 0x2001, 5, OD_ATTR_READ, 1, &buttons.CAN_Enable },
+};
+
+#define OD_ENTRY_COUNT  (sizeof(objectDictionary) / sizeof(objectDictionary[0]))
+#define OD_KEY(index, subindex)     (((uint32_t)(index) << 8) | (subindex))
+
+static volatile nmt_state_t nmtState = NMT_STATE_INITIALISING;
+static TimerHandle_t heartbeatTimer = NULL;
+static StaticTimer_t heartbeatTimerBuffer;
+static can_tx_template_t heartbeatTpl;
+static can_tx_template_t sdoTxTpl;
+
+// Frames received through the RPDO dispatcher
+static flexcan_frame_t nmtFrame;
+static flexcan_frame_t sdoFrame;
+
+static void CANopen_NmtReceived(const pdo_mapping_t *pdo);
+static void CANopen_SdoReceived(const pdo_mapping_t *pdo);
+
+static int CANopen_ShellSdo(int argc, char *argv[]);
+
+static const shell_command_t sdoCommand = {
+    "sdo", "read <index> <subindex> | write <index> <subindex> <value> - local object dictionary",
+    CANopen_ShellSdo
+};
+
+static const pdo_mapping_t nmtMapping = { CANOPEN_COB_NMT, 0, NULL, &nmtFrame, CANopen_NmtReceived };
+static const pdo_mapping_t sdoMapping = { CANOPEN_COB_SDO_RX + CANOPEN_NODE_ID, 0, NULL, &sdoFrame, CANopen_SdoReceived };
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CANopen_OdFind
+ * Description   :  Binary search of the object dictionary. Returns NULL if the index
+ *                  or the subindex does not exist.
+ *
+ *END**************************************************************************/
+const od_entry_t *CANopen_OdFind(uint16_t index, uint8_t subindex)
+{
+    uint32_t key = OD_KEY(index, subindex);
+    uint32_t lo = 0;
+    uint32_t hi = OD_ENTRY_COUNT;
+    uint32_t mid;
+    uint32_t midKey;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2U;
+        midKey = OD_KEY(objectDictionary[mid].index, objectDictionary[mid].subindex);
+
+        if (midKey == key) {
+            return &objectDictionary[mid];
+        } else if (midKey < key) {
+            lo = mid + 1U;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return NULL;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CANopen_OdIndexExists
+ * Description   :  Tell a missing object from a missing subindex for the abort code
+ *
+ *END**************************************************************************/
+static bool CANopen_OdIndexExists(uint16_t index)
+{
+    uint32_t i;
+
+    for (i = 0; i < OD_ENTRY_COUNT && objectDictionary[i].index <= index; i++) {
+        if (objectDictionary[i].index == index) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CANopen_SendHeartbeat
+ * Description   :  Heartbeat (or boot-up when initialising) with the current NMT state
+ *
+ *END**************************************************************************/
+static void CANopen_SendHeartbeat(void)
+{
+    (void)CAN_HAL_TxSendWords(&heartbeatTpl, (uint32_t)nmtState << 24, 0U);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CANopen_HeartbeatTimer
+ * Description   :  Software timer callback, runs in the timer service task which has a
+ *                  lower priority than the EtherCAT task
+ *
+ *END**************************************************************************/
+static void CANopen_HeartbeatTimer(TimerHandle_t timer)
+{
+    (void)timer;
+    CANopen_SendHeartbeat();
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CANopen_HeartbeatRestart
+ * Description   :  Apply object 0x1017, 0 disables the heartbeat. Never blocks.
+ *
+ *END**************************************************************************/
+static void CANopen_HeartbeatRestart(void)
+{
+    if (heartbeatTimer == NULL) {
+        return;
+    }
+
+    if (heartbeatTimeMs == 0U) {
+        (void)xTimerStop(heartbeatTimer, 0);
+    } else {
+        (void)xTimerChangePeriod(heartbeatTimer, pdMS_TO_TICKS(heartbeatTimeMs), 0);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CANopen_SdoAbort
+ * Description   :  Send an SDO abort transfer response
+ *
+ *END**************************************************************************/
+static void CANopen_SdoAbort(uint16_t index, uint8_t subindex, uint32_t code)
+{
+    uint32_t word0 = ((uint32_t)(SDO_CS_ABORT << 5) << 24) | ((uint32_t)(index & 0xFFU) << 16) |
+                     ((uint32_t)(index >> 8) << 8) | subindex;
+
+    (void)CAN_HAL_TxSendWords(&sdoTxTpl, word0, __REV(code));
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CANopen_SdoReceived
+ * Description   :  Expedited SDO server, runs in the CAN task from the RPDO dispatcher.
+ *                  Segmented and block transfers are answered with an abort.
+ *
+ *END**************************************************************************/
+static void CANopen_SdoReceived(const pdo_mapping_t *pdo)
+{
+    const flexcan_frame_t *frame = pdo->last_frame;
+    uint8_t cmd = (uint8_t)(frame->dataWord0 >> 24);
+    uint16_t index = (uint16_t)(((frame->dataWord0 >> 16) & 0xFFU) | (frame->dataWord0 & 0xFF00U));
+    uint8_t subindex = (uint8_t)frame->dataWord0;
+    const od_entry_t *entry;
+    uint32_t value = 0;
+    uint32_t size;
+
+    if (nmtState == NMT_STATE_STOPPED || frame->length != 8U) {
+        return;
+    }
+
+    if ((cmd >> 5) == SDO_CS_ABORT) {
+        return;
+    }
+
+    entry = CANopen_OdFind(index, subindex);
+    if (entry == NULL) {
+        CANopen_SdoAbort(index, subindex, CANopen_OdIndexExists(index) ? SDO_ABORT_NO_SUBINDEX : SDO_ABORT_NO_OBJECT);
+        return;
+    }
+
+    switch (cmd >> 5)
+    {
+        case SDO_CCS_UPLOAD_INIT:
+            if ((entry->attr & OD_ATTR_READ) == 0U) {
+                CANopen_SdoAbort(index, subindex, SDO_ABORT_WRITE_ONLY);
+                return;
+            }
+            memcpy(&value, entry->data, entry->size);
+            cmd = (uint8_t)((SDO_SCS_UPLOAD_INIT << 5) | ((4U - entry->size) << 2) | SDO_EXPEDITED | SDO_SIZE_INDICATED);
+            (void)CAN_HAL_TxSendWords(&sdoTxTpl, ((uint32_t)cmd << 24) | (frame->dataWord0 & 0x00FFFFFFUL), __REV(value));
+            break;
+
+        case SDO_CCS_DOWNLOAD_INIT:
+            if ((entry->attr & OD_ATTR_WRITE) == 0U) {
+                CANopen_SdoAbort(index, subindex, SDO_ABORT_READ_ONLY);
+                return;
+            }
+            if ((cmd & SDO_EXPEDITED) == 0U) {
+                CANopen_SdoAbort(index, subindex, SDO_ABORT_UNSUPPORTED);
+                return;
+            }
+            size = (cmd & SDO_SIZE_INDICATED) ? (4U - SDO_SIZE_UNUSED(cmd)) : entry->size;
+            if (size != entry->size) {
+                CANopen_SdoAbort(index, subindex, SDO_ABORT_LENGTH);
+                return;
+            }
+            value = __REV(frame->dataWord1);
+            memcpy(entry->data, &value, entry->size);
+            if (entry->data == &heartbeatTimeMs) {
+                CANopen_HeartbeatRestart();
+            }
+            cmd = (uint8_t)(SDO_SCS_DOWNLOAD_INIT << 5);
+            (void)CAN_HAL_TxSendWords(&sdoTxTpl, ((uint32_t)cmd << 24) | (frame->dataWord0 & 0x00FFFFFFUL), 0U);
+            break;
+
+        default:
+            CANopen_SdoAbort(index, subindex, SDO_ABORT_CMD);
+            break;
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CANopen_NmtReceived
+ * Description   :  NMT module control, runs in the CAN task from the RPDO dispatcher
+ *
+ *END**************************************************************************/
+static void CANopen_NmtReceived(const pdo_mapping_t *pdo)
+{
+    const flexcan_frame_t *frame = pdo->last_frame;
+    uint8_t command = (uint8_t)(frame->dataWord0 >> 24);
+    uint8_t node = (uint8_t)(frame->dataWord0 >> 16);
+
+    if (frame->length < 2U || (node != 0U && node != CANOPEN_NODE_ID)) {
+        return;
+    }
+
+    switch (command)
+    {
+        case NMT_CS_START:
+            nmtState = NMT_STATE_OPERATIONAL;
+            break;
+
+        case NMT_CS_STOP:
+            nmtState = NMT_STATE_STOPPED;
+            break;
+
+        case NMT_CS_PRE_OPERATIONAL:
+            nmtState = NMT_STATE_PRE_OPERATIONAL;
+            break;
+
+        case NMT_CS_RESET_NODE:
+        case NMT_CS_RESET_COMM:
+            // No persistent parameters: both resets restart communication with a boot-up
+            heartbeatTimeMs = CANOPEN_HEARTBEAT_MS;
+            nmtState = NMT_STATE_INITIALISING;
+            CANopen_SendHeartbeat();
+            nmtState = NMT_STATE_PRE_OPERATIONAL;
+            CANopen_HeartbeatRestart();
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CANopen_NodeInit
+ * Description   :  Register the NMT and SDO COB-IDs with the RPDO dispatcher, check the
+ *                  object dictionary order and create the heartbeat timer. Must run
+ *                  before the RX FIFO filters are built.
+ *
+ *END**************************************************************************/
+status_t CANopen_NodeInit(void)
+{
+    uint32_t i;
+
+    for (i = 1; i < OD_ENTRY_COUNT; i++) {
+        if (OD_KEY(objectDictionary[i - 1U].index, objectDictionary[i - 1U].subindex) >=
+            OD_KEY(objectDictionary[i].index, objectDictionary[i].subindex)) {
+            return kStatus_InvalidArgument;
+        }
+    }
+
+    if (PDO_Register(&nmtMapping) != PDO_SUCCESS || PDO_Register(&sdoMapping) != PDO_SUCCESS) {
+        return kStatus_Fail;
+    }
+
+    CAN_HAL_TxPrepare(&heartbeatTpl, CANOPEN_COB_HEARTBEAT + CANOPEN_NODE_ID, 1);
+    CAN_HAL_TxPrepare(&sdoTxTpl, CANOPEN_COB_SDO_TX + CANOPEN_NODE_ID, 8);
+
+    if (heartbeatTimer == NULL) {
+        heartbeatTimer = xTimerCreateStatic("Heartbeat", pdMS_TO_TICKS(CANOPEN_HEARTBEAT_MS), pdTRUE,
+                                            NULL, CANopen_HeartbeatTimer, &heartbeatTimerBuffer);
+        if (heartbeatTimer == NULL) {
+            return kStatus_Fail;
+        }
+    }
+
+    // Already present after a re-init, nothing to do then
+    (void)Shell_RegisterCommand(&sdoCommand);
+
+    nmtState = NMT_STATE_INITIALISING;
+    return kStatus_Success;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CANopen_NodeStart
+ * Description   :  Send the boot-up message and enter pre-operational. Called once the
+ *                  TX mailboxes are configured.
+ *
+ *END**************************************************************************/
+void CANopen_NodeStart(void)
+{
+    CANopen_SendHeartbeat();
+    nmtState = NMT_STATE_PRE_OPERATIONAL;
+    CANopen_HeartbeatRestart();
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CANopen_GetNmtState
+ * Description   :  This function returns the current NMT state
+ *
+ *END**************************************************************************/
+nmt_state_t CANopen_GetNmtState(void)
+{
+    return nmtState;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CANopen_ShellSdo
+ * Description   :  Shell command: read or write an entry of the local object dictionary
+ *                  with the same access rules as the SDO server
+ *
+ *END**************************************************************************/
+static int CANopen_ShellSdo(int argc, char *argv[])
+{
+    const od_entry_t *entry;
+    uint32_t index;
+    uint32_t subindex;
+    uint32_t value = 0;
+
+    if (argc < 4 || !Shell_ParseU32(argv[2], &index) || !Shell_ParseU32(argv[3], &subindex) ||
+        index > 0xFFFFU || subindex > 0xFFU) {
+        return SHELL_USAGE;
+    }
+
+    entry = CANopen_OdFind((uint16_t)index, (uint8_t)subindex);
+    if (entry == NULL) {
+        UART_LOG("SDO: no such object\r\n");
+        return SHELL_OK;
+    }
+
+    if (argc == 4 && strcmp(argv[1], "read") == 0) {
+        if ((entry->attr & OD_ATTR_READ) == 0U) {
+            UART_LOG("SDO: write only\r\n");
+            return SHELL_OK;
+        }
+        memcpy(&value, entry->data, entry->size);
+        UART_PRINTF("0x%04lX:%lu = %lu (0x%lX)\r\n", (unsigned long)index, (unsigned long)subindex,
+                    (unsigned long)value, (unsigned long)value);
+        return SHELL_OK;
+    }
+
+    if (argc == 5 && strcmp(argv[1], "write") == 0 && Shell_ParseU32(argv[4], &value)) {
+        if ((entry->attr & OD_ATTR_WRITE) == 0U) {
+            UART_LOG("SDO: read only\r\n");
+            return SHELL_OK;
+        }
+        memcpy(entry->data, &value, entry->size);
+        if (entry->data == &heartbeatTimeMs) {
+            CANopen_HeartbeatRestart();
+        }
+        return SHELL_OK;
+    }
+
+    return SHELL_USAGE;
+}
@@ -0,0 +1,326 @@
+#include "CANopen_PDO.h"
+#include "string.h"
+
+// Empty hash slot marker
+#define PDO_SLOT_EMPTY  (0xFFU)
+
+// Registered RPDOs and the COB-ID hash table indexing them
+static const pdo_mapping_t *rpdoTable[PDO_MAX_MAPPINGS];
+static uint32_t rpdoCount = 0;
+static uint8_t rpdoHash[PDO_HASH_SIZE];
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  PDO_Hash
+ * Description   :  Multiplicative hash of an 11-bit COB-ID into the slot table
+ *
+ *END**************************************************************************/
+static inline uint32_t PDO_Hash(uint16_t cobId)
+{
+    return (((uint32_t)cobId * 2654435761UL) >> 24) & (PDO_HASH_SIZE - 1U);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  PDO_Lookup
+ * Description   :  Find the RPDO registered for a COB-ID. The table is at most half
+ *                  full, so a lookup ends after a couple of probes.
+ *
+ *END**************************************************************************/
+static const pdo_mapping_t *PDO_Lookup(uint16_t cobId)
+{
+    uint32_t slot = PDO_Hash(cobId);
+
+    while (rpdoHash[slot] != PDO_SLOT_EMPTY) {
+        if (rpdoTable[rpdoHash[slot]]->cob_id == cobId) {
+            return rpdoTable[rpdoHash[slot]];
+        }
+        slot = (slot + 1U) & (PDO_HASH_SIZE - 1U);
+    }
+
+    return NULL;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  PDO_FrameToPayload
+ * Description   :  Gather the 8 data bytes of a frame into one little-endian word so
+ *                  that every mapped object is a shift and a mask
+ *
+ *END**************************************************************************/
+static inline uint64_t PDO_FrameToPayload(const flexcan_frame_t *frame)
+{
+    // dataWord0 holds data byte 0 in its most significant byte
+    return (uint64_t)__REV(frame->dataWord0) | ((uint64_t)__REV(frame->dataWord1) << 32);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  PDO_WriteEntry
+ * Description   :  Extract one mapped object from the payload and store it at its destination
+ *
+ *END**************************************************************************/
+static void PDO_WriteEntry(const pdo_map_entry_t *entry, uint64_t payload)
+{
+    uint32_t raw = (uint32_t)(payload >> entry->bit_offset);
+    uint32_t shift = 32U - entry->bit_length;
+
+    raw = (raw << shift) >> shift;
+
+    switch (entry->type)
+    {
+        case PDO_TYPE_BOOL:
+            *(bool *)entry->data = (raw != 0U);
+            break;
+
+        case PDO_TYPE_U8:
+            *(uint8_t *)entry->data = (uint8_t)raw;
+            break;
+
+        case PDO_TYPE_U16:
+            *(uint16_t *)entry->data = (uint16_t)raw;
+            break;
+
+        case PDO_TYPE_S16:
+            *(int16_t *)entry->data = (int16_t)((int32_t)(raw << shift) >> shift);
+            break;
+
+        case PDO_TYPE_U32:
+            *(uint32_t *)entry->data = raw;
+            break;
+
+        case PDO_TYPE_S32:
+            *(int32_t *)entry->data = (int32_t)(raw << shift) >> shift;
+            break;
+
+        case PDO_TYPE_FLOAT:
+            *(float *)entry->data = (float)raw * entry->scale;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  PDO_ReadEntry
+ * Description   :  Read one mapped object from its source, truncated to its bit length
+ *
+ *END**************************************************************************/
+static uint32_t PDO_ReadEntry(const pdo_map_entry_t *entry)
+{
+    uint32_t raw;
+
+    switch (entry->type)
+    {
+        case PDO_TYPE_BOOL:
+            raw = *(const bool *)entry->data ? 1U : 0U;
+            break;
+
+        case PDO_TYPE_U8:
+            raw = *(const uint8_t *)entry->data;
+            break;
+
+        case PDO_TYPE_U16:
+        case PDO_TYPE_S16:
+            raw = *(const uint16_t *)entry->data;
+            break;
+
+        case PDO_TYPE_U32:
+        case PDO_TYPE_S32:
+            raw = *(const uint32_t *)entry->data;
+            break;
+
+        case PDO_TYPE_FLOAT:
+            raw = (uint32_t)(*(const float *)entry->data / entry->scale);
+            break;
+
+        default:
+            raw = 0;
+            break;
+    }
+
+    return (entry->bit_length < 32U) ? (raw & ((1UL << entry->bit_length) - 1U)) : raw;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  PDO_CheckMapping
+ * Description   :  Every mapped object must fit in the 64 data bits of a frame
+ *
+ *END**************************************************************************/
+static bool PDO_CheckMapping(const pdo_mapping_t *pdo)
+{
+    uint32_t i;
+
+    if (pdo == NULL || pdo->cob_id > 0x7FFU || (pdo->entry_count > 0U && pdo->entries == NULL)) {
+        return false;
+    }
+
+    for (i = 0; i < pdo->entry_count; i++) {
+        const pdo_map_entry_t *entry = &pdo->entries[i];
+
+        if (entry->data == NULL || entry->bit_length == 0U || entry->bit_length > 32U ||
+            (uint32_t)entry->bit_offset + entry->bit_length > 64U) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  PDO_Init
+ * Description   :  Clear the RPDO table and register count mappings from rpdos
+ *
+ *END**************************************************************************/
+pdo_status_t PDO_Init(const pdo_mapping_t *rpdos, uint32_t count)
+{
+    pdo_status_t status;
+    uint32_t i;
+
+    rpdoCount = 0;
+    memset(rpdoHash, PDO_SLOT_EMPTY, sizeof(rpdoHash));
+
+    for (i = 0; i < count; i++) {
+        status = PDO_Register(&rpdos[i]);
+        if (status != PDO_SUCCESS) {
+            return status;
+        }
+    }
+
+    return PDO_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  PDO_Register
+ * Description   :  Add one RPDO mapping. The mapping must stay valid while registered.
+ *
+ *END**************************************************************************/
+pdo_status_t PDO_Register(const pdo_mapping_t *rpdo)
+{
+    uint32_t slot;
+
+    if (!PDO_CheckMapping(rpdo)) {
+        return PDO_ERROR_INVALID_PARAM;
+    }
+
+    if (rpdoCount >= PDO_MAX_MAPPINGS) {
+        return PDO_ERROR_TABLE_FULL;
+    }
+
+    if (PDO_Lookup(rpdo->cob_id) != NULL) {
+        return PDO_ERROR_DUPLICATE;
+    }
+
+    slot = PDO_Hash(rpdo->cob_id);
+    while (rpdoHash[slot] != PDO_SLOT_EMPTY) {
+        slot = (slot + 1U) & (PDO_HASH_SIZE - 1U);
+    }
+
+    rpdoTable[rpdoCount] = rpdo;
+    rpdoHash[slot] = (uint8_t)rpdoCount;
+    rpdoCount++;
+
+    return PDO_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  PDO_GetCount
+ * Description   :  Number of registered RPDOs
+ *
+ *END**************************************************************************/
+uint32_t PDO_GetCount(void)
+{
+    return rpdoCount;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  PDO_GetCobId
+ * Description   :  COB-ID of the RPDO at index, used to build the RX FIFO filters
+ *
+ *END**************************************************************************/
+uint16_t PDO_GetCobId(uint32_t index)
+{
+    return (index < rpdoCount) ? rpdoTable[index]->cob_id : 0U;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  PDO_Dispatch
+ * Description   :  Decode a received frame into the destinations of its RPDO mapping.
+ *                  Cost is one hash lookup plus one shift/mask per mapped object.
+ *
+ *END**************************************************************************/
+pdo_status_t PDO_Dispatch(const flexcan_frame_t *frame)
+{
+    const pdo_mapping_t *pdo;
+    uint64_t payload;
+    uint32_t i;
+
+    if (frame == NULL || frame->format != kFLEXCAN_FrameFormatStandard) {
+        return PDO_ERROR_INVALID_PARAM;
+    }
+
+    pdo = PDO_Lookup((uint16_t)(frame->id >> CAN_ID_STD_SHIFT));
+    if (pdo == NULL) {
+        return PDO_ERROR_UNKNOWN_COB_ID;
+    }
+
+    if (pdo->last_frame != NULL) {
+        *pdo->last_frame = *frame;
+    }
+
+    payload = PDO_FrameToPayload(frame);
+    for (i = 0; i < pdo->entry_count; i++) {
+        PDO_WriteEntry(&pdo->entries[i], payload);
+    }
+
+    if (pdo->callback != NULL) {
+        pdo->callback(pdo);
+    }
+
+    return PDO_SUCCESS;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  PDO_Encode
+ * Description   :  Build a TPDO frame from the current value of its mapped objects.
+ *                  The frame length covers the highest mapped bit.
+ *
+ *END**************************************************************************/
+pdo_status_t PDO_Encode(const pdo_mapping_t *tpdo, flexcan_frame_t *frame)
+{
+    uint64_t payload = 0;
+    uint32_t bits = 0;
+    uint32_t i;
+
+    if (frame == NULL || !PDO_CheckMapping(tpdo)) {
+        return PDO_ERROR_INVALID_PARAM;
+    }
+
+    for (i = 0; i < tpdo->entry_count; i++) {
+        const pdo_map_entry_t *entry = &tpdo->entries[i];
+
+        payload |= (uint64_t)PDO_ReadEntry(entry) << entry->bit_offset;
+        if ((uint32_t)entry->bit_offset + entry->bit_length > bits) {
+            bits = (uint32_t)entry->bit_offset + entry->bit_length;
+        }
+    }
+
+    memset(frame, 0, sizeof(flexcan_frame_t));
+    frame->id = FLEXCAN_ID_STD(tpdo->cob_id);
+    frame->format = kFLEXCAN_FrameFormatStandard;
+    frame->type = kFLEXCAN_FrameTypeData;
+    frame->length = (uint8_t)((bits + 7U) / 8U);
+    frame->dataWord0 = __REV((uint32_t)payload);
+    frame->dataWord1 = __REV((uint32_t)(payload >> 32));
+
+    return PDO_SUCCESS;
+}
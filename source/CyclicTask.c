@@ -0,0 +1,296 @@
+#include "CyclicTask.h"
+#include "Shell.h"
+#include "Utilities.h"
+#include "cycles.h"
+#include <string.h>
+#include <stdio.h>
+
+// Every cyclic task, for the "cycle" shell command
+static cyclic_task_t *cyclicTasks[CYCLIC_MAX_TASKS];
+static uint32_t cyclicCount = 0;
+
+static int CyclicTask_ShellCommand(int argc, char *argv[]);
+
+static const shell_command_t cycleCommand = { "cycle", "[reset] - cyclic task timing", CyclicTask_ShellCommand };
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CyclicTask_Log2Bucket
+ * Description   :  Histogram bucket of a time in microseconds
+ *
+ *END**************************************************************************/
+static uint32_t CyclicTask_Log2Bucket(uint32_t us)
+{
+    uint32_t bucket = (us == 0U) ? 0U : (32U - (uint32_t)__builtin_clz(us));
+
+    return (bucket < CYCLIC_HIST_BUCKETS) ? bucket : (CYCLIC_HIST_BUCKETS - 1U);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CyclicTask_Register
+ * Description   :  Add a task to the registry, the first one also registers the
+ *                  shell command. Tasks beyond CYCLIC_MAX_TASKS still run, they
+ *                  are only missing from the report.
+ *
+ *END**************************************************************************/
+static void CyclicTask_Register(cyclic_task_t *task)
+{
+    bool first;
+
+    taskENTER_CRITICAL();
+    first = (cyclicCount == 0U);
+    if (cyclicCount < CYCLIC_MAX_TASKS) {
+        cyclicTasks[cyclicCount++] = task;
+    }
+    taskEXIT_CRITICAL();
+
+    if (first) {
+        (void)Shell_RegisterCommand(&cycleCommand);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CyclicTask_Record
+ * Description   :  Account one cycle. All times are in cycles from the ideal release.
+ *
+ *END**************************************************************************/
+static void CyclicTask_Record(cyclic_task_t *task, uint32_t jitterCycles, uint32_t execCycles,
+                              uint32_t responseCycles, uint32_t deadlineCycles, uint32_t budgetCycles)
+{
+    cyclic_task_stats_t *stats = &task->stats;
+    uint32_t jitterUs = Cycles_ToUs(jitterCycles);
+    uint32_t execUs = Cycles_ToUs(execCycles);
+    uint32_t responseUs = Cycles_ToUs(responseCycles);
+
+    stats->cycles++;
+    if (responseCycles > deadlineCycles) {
+        stats->deadline_misses++;
+    }
+    if (budgetCycles != 0U && execCycles > budgetCycles) {
+        stats->budget_overruns++;
+    }
+
+    if (jitterUs > stats->jitter_max_us) {
+        stats->jitter_max_us = jitterUs;
+    }
+    if (execUs > stats->exec_max_us) {
+        stats->exec_max_us = execUs;
+    }
+    if (responseUs > stats->response_max_us) {
+        stats->response_max_us = responseUs;
+    }
+    stats->jitter_hist[CyclicTask_Log2Bucket(jitterUs)]++;
+    stats->exec_hist[CyclicTask_Log2Bucket(execUs)]++;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CyclicTask_Run
+ * Description   :  Cyclic loop of the calling task. Releases are absolute ticks, a
+ *                  release missed by a full period is dropped rather than run back
+ *                  to back, so a late cycle never turns into a burst. The ideal
+ *                  release in cycles is extrapolated from the earliest observed
+ *                  start, SysTick counts exactly SystemCoreClock / configTICK_RATE_HZ
+ *                  cycles per tick so both time bases stay locked.
+ *
+ *END**************************************************************************/
+void CyclicTask_Run(cyclic_task_t *task, const cyclic_task_config_t *config)
+{
+    const uint32_t cyclesPerTick = SystemCoreClock / configTICK_RATE_HZ;
+    const uint32_t deadlineUs = (config->deadline_us != 0U) ? config->deadline_us : (config->period_ms * 1000U);
+    const uint32_t deadlineCycles = Cycles_FromUs(deadlineUs);
+    const uint32_t budgetCycles = Cycles_FromUs(config->budget_us);
+    TickType_t periodTicks = pdMS_TO_TICKS(config->period_ms);
+    TickType_t lastWake;
+    TickType_t baseTick;
+    TickType_t missed;
+    uint32_t baseCycles;
+    uint32_t release;
+    uint32_t start;
+    uint32_t end;
+    int32_t jitter;
+
+    if (periodTicks == 0U) {
+        periodTicks = 1U;
+    }
+
+    task->config = config;
+    task->handle = xTaskGetCurrentTaskHandle();
+    memset(&task->stats, 0, sizeof(task->stats));
+    task->resetRequest = false;
+    CyclicTask_Register(task);
+
+    Cycles_Init();
+    lastWake = xTaskGetTickCount();
+    baseTick = lastWake;
+    baseCycles = Cycles_Now();      // Late by up to one tick, corrected by the first release
+
+    while (1) {
+        if (xTaskDelayUntil(&lastWake, periodTicks) == pdFALSE) {
+            // Already late: lastWake is the release we missed, skip to the current one
+            missed = (xTaskGetTickCount() - lastWake) / periodTicks;
+            lastWake += missed * periodTicks;
+            task->stats.skipped_periods += missed;
+        }
+
+        start = Cycles_Now();
+        release = baseCycles + (uint32_t)(lastWake - baseTick) * cyclesPerTick;
+        jitter = (int32_t)(start - release);
+        if (jitter < 0) {
+            // Started before the estimated release, so the estimate was late
+            baseCycles += (uint32_t)jitter;
+            release = start;
+        }
+
+        config->step(config->arg);
+        end = Cycles_Now();
+
+        if (task->resetRequest) {
+            memset(&task->stats, 0, sizeof(task->stats));
+            task->resetRequest = false;
+        }
+        CyclicTask_Record(task, start - release, end - start, end - release, deadlineCycles, budgetCycles);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CyclicTask_Entry
+ * Description   :  Task function of CyclicTask_Create
+ *
+ *END**************************************************************************/
+static void CyclicTask_Entry(void *pvParameters)
+{
+    cyclic_task_t *task = (cyclic_task_t *)pvParameters;
+
+    CyclicTask_Run(task, task->config);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CyclicTask_Create
+ * Description   :  Create a task running config->step every config->period_ms.
+ *                  task, config and the stack of stackDepth words must stay valid
+ *                  for the life of the task. The TCB lives in task.
+ *
+ *END**************************************************************************/
+status_t CyclicTask_Create(cyclic_task_t *task, const cyclic_task_config_t *config,
+                           UBaseType_t priority, StackType_t *stack, uint32_t stackDepth,
+                           TaskHandle_t *handle)
+{
+    TaskHandle_t created;
+
+    if (task == NULL || config == NULL || config->step == NULL || config->period_ms == 0U || stack == NULL) {
+        return kStatus_InvalidArgument;
+    }
+
+    task->config = config;
+    created = xTaskCreateStatic(CyclicTask_Entry, config->name, stackDepth, task, priority, stack, &task->tcb);
+    if (created == NULL) {
+        return kStatus_Fail;
+    }
+    if (handle != NULL) {
+        *handle = created;
+    }
+    return kStatus_Success;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CyclicTask_GetStats
+ * Description   :  Consistent copy of the statistics of a task
+ *
+ *END**************************************************************************/
+void CyclicTask_GetStats(const cyclic_task_t *task, cyclic_task_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    memcpy(stats, &task->stats, sizeof(*stats));
+    taskEXIT_CRITICAL();
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CyclicTask_ResetStats
+ * Description   :  Clear the statistics at the end of the next cycle of the task
+ *
+ *END**************************************************************************/
+void CyclicTask_ResetStats(cyclic_task_t *task)
+{
+    task->resetRequest = true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CyclicTask_ShowHistogram
+ * Description   :  Output one histogram line on the UART
+ *
+ *END**************************************************************************/
+static void CyclicTask_ShowHistogram(const char *label, const uint32_t *hist)
+{
+    char str[160];
+    uint32_t b;
+    int len;
+
+    len = sprintf(str, "   %s", label);
+    for (b = 0; b < CYCLIC_HIST_BUCKETS && len < (int)sizeof(str) - 14; b++) {
+        len += sprintf(&str[len], " %lu", (unsigned long)hist[b]);
+    }
+    sprintf(&str[len], "\r\n");
+    UART_LOG(str);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CyclicTask_Show
+ * Description   :  This function is a simple debugging function that outputs the timing
+ *                  of every cyclic task on the UART
+ *
+ *END**************************************************************************/
+void CyclicTask_Show(void)
+{
+    cyclic_task_stats_t stats;
+    uint32_t i;
+
+    for (i = 0; i < cyclicCount; i++) {
+        const cyclic_task_config_t *config = cyclicTasks[i]->config;
+
+        CyclicTask_GetStats(cyclicTasks[i], &stats);
+
+        UART_PRINTF("%s: %lu ms, %lu cycles, %lu deadline misses, %lu over budget, %lu skipped\r\n",
+                    config->name, (unsigned long)config->period_ms, (unsigned long)stats.cycles,
+                    (unsigned long)stats.deadline_misses, (unsigned long)stats.budget_overruns,
+                    (unsigned long)stats.skipped_periods);
+        UART_PRINTF("   max jitter %lu us, max exec %lu us (budget %lu)\r\n",
+                    (unsigned long)stats.jitter_max_us, (unsigned long)stats.exec_max_us,
+                    (unsigned long)config->budget_us);
+        UART_PRINTF("   max response %lu us (deadline %lu)\r\n", (unsigned long)stats.response_max_us,
+                    (unsigned long)((config->deadline_us != 0U) ? config->deadline_us : (config->period_ms * 1000U)));
+        CyclicTask_ShowHistogram("jitter", stats.jitter_hist);
+        CyclicTask_ShowHistogram("exec  ", stats.exec_hist);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  CyclicTask_ShellCommand
+ * Description   :  "cycle" command: show or clear the cyclic task statistics
+ *
+ *END**************************************************************************/
+static int CyclicTask_ShellCommand(int argc, char *argv[])
+{
+    uint32_t i;
+
+    if (argc == 1) {
+        CyclicTask_Show();
+        return SHELL_OK;
+    }
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        for (i = 0; i < cyclicCount; i++) {
+            CyclicTask_ResetStats(cyclicTasks[i]);
+        }
+        return SHELL_OK;
+    }
+    return SHELL_USAGE;
+}
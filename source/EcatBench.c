@@ -0,0 +1,336 @@
+#include "EcatBench.h"
+#include "Bench.h"
+#include "mem_placement.h"
+#include "cycles.h"
+#include "rtos.h"
+#include "Shell.h"
+#include "Utilities.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ECATBENCH_CMD_BRD           (0x07U)
+#define ECATBENCH_CMD_LRW           (0x0CU)
+#define ECATBENCH_ECAT_OFFSET       (14U)       // EtherCAT header after the Ethernet header
+#define ECATBENCH_DGRAM_OFFSET      (16U)
+#define ECATBENCH_DGRAM_HEADER      (10U)
+#define ECATBENCH_OVERHEAD          (28U)       // Ethernet, EtherCAT and datagram headers, WKC
+#define ECATBENCH_MAX_DATA          (ETHERCAT_MAX_FRAME_SIZE - 4U - ECATBENCH_OVERHEAD)    // 1486, one frame without FCS
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t missed;                // Frame not back before the next release, or not sent
+    uint32_t wkc_errors;
+    uint32_t jitter_max;            // Cycles after the ideal release
+    uint32_t response_max;          // Cycles from the ideal release to the frame back
+} ecatbench_point_t;
+
+// Process image sizes (LRW data bytes) and periods swept
+static const uint16_t ecatBenchSizes[] = { 16U, 64U, 256U, 1024U, ECATBENCH_MAX_DATA };
+static const uint16_t ecatBenchPeriodsUs[] = { 4000U, 2000U, 1000U, 500U, 250U, 125U };
+
+#define ECATBENCH_SIZE_COUNT        (sizeof(ecatBenchSizes) / sizeof(ecatBenchSizes[0]))
+#define ECATBENCH_PERIOD_COUNT      (sizeof(ecatBenchPeriodsUs) / sizeof(ecatBenchPeriodsUs[0]))
+
+static enet_raw_handle_t *ecatBenchHandle = NULL;
+static TaskHandle_t ecatBenchRxTask = NULL;
+
+// Sent from SRAM_L like the process image frames
+static uint8_t ecatBenchFrame[ETHERCAT_MAX_FRAME_SIZE] MEM_SRAM_L_BSS;
+static uint16_t ecatBenchLength;
+static uint16_t ecatBenchDataLength;
+
+static int EcatBench_ShellCommand(int argc, char *argv[]);
+
+static const shell_command_t ecatBenchCommand = { "ecatbench", "[jitter_us] [ms_per_point] [priority] - shortest EtherCAT period, CAN stops above priority 2", EcatBench_ShellCommand };
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EcatBench_Init
+ * Description   :  Register the "ecatbench" command for an initialized interface.
+ *                  rxTask, the task otherwise receiving on it, is suspended while
+ *                  the benchmark runs.
+ *
+ *END**************************************************************************/
+void EcatBench_Init(enet_raw_handle_t *handle, TaskHandle_t rxTask)
+{
+    ecatBenchHandle = handle;
+    ecatBenchRxTask = rxTask;
+    (void)Shell_RegisterCommand(&ecatBenchCommand);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EcatBench_BuildFrame
+ * Description   :  Broadcast EtherCAT frame with one datagram at address 0,
+ *                  padded to the Ethernet minimum
+ *
+ *END**************************************************************************/
+static void EcatBench_BuildFrame(uint8_t command, uint16_t dataLength)
+{
+    uint16_t ecatLength = (uint16_t)(ECATBENCH_DGRAM_HEADER + dataLength + 2U);
+    uint8_t *dgram = &ecatBenchFrame[ECATBENCH_DGRAM_OFFSET];
+
+    ecatBenchLength = (uint16_t)(dataLength + ECATBENCH_OVERHEAD);
+    if (ecatBenchLength < ETHERCAT_MIN_FRAME_SIZE) {
+        ecatBenchLength = ETHERCAT_MIN_FRAME_SIZE;
+    }
+    ecatBenchDataLength = dataLength;
+
+    memset(ecatBenchFrame, 0, ecatBenchLength);
+    memset(ecatBenchFrame, 0xFF, 6U);
+    memcpy(&ecatBenchFrame[6], ecatBenchHandle->mac_addr, 6U);
+    ecatBenchFrame[12] = (uint8_t)(ETHERCAT_ETHERTYPE >> 8);
+    ecatBenchFrame[13] = (uint8_t)(ETHERCAT_ETHERTYPE & 0xFFU);
+
+    // Length (11 bits) and type 1, little endian
+    ecatBenchFrame[ECATBENCH_ECAT_OFFSET] = (uint8_t)(ecatLength & 0xFFU);
+    ecatBenchFrame[ECATBENCH_ECAT_OFFSET + 1U] = (uint8_t)(0x10U | ((ecatLength >> 8) & 0x07U));
+
+    // Command, index, address 0, data length, IRQ, data, WKC
+    dgram[0] = command;
+    dgram[6] = (uint8_t)(dataLength & 0xFFU);
+    dgram[7] = (uint8_t)((dataLength >> 8) & 0x07U);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EcatBench_Exchange
+ * Description   :  Send the frame with the given datagram index and poll for it
+ *                  until deadline (cycles). Returns false if it did not come back,
+ *                  else its working counter and the time it was taken.
+ *
+ *END**************************************************************************/
+static bool EcatBench_Exchange(uint8_t index, uint32_t deadline, uint16_t *wkc, uint32_t *received)
+{
+    enet_raw_frame_t frame;
+    enet_raw_status_t status;
+    const uint8_t *data;
+    bool own;
+
+    ecatBenchFrame[ECATBENCH_DGRAM_OFFSET + 1U] = index;
+    if (enet_raw_send_frame(ecatBenchHandle, ecatBenchFrame, ecatBenchLength) != ENET_RAW_SUCCESS) {
+        return false;
+    }
+
+    while (1) {
+        status = enet_raw_receive_frame(ecatBenchHandle, &frame, 0);
+        *received = Cycles_Now();
+
+        if (status == ENET_RAW_SUCCESS) {
+            // Late frames of earlier cycles carry another index
+            data = frame.data;
+            own = (frame.length == ecatBenchLength &&
+                   data[ECATBENCH_DGRAM_OFFSET] == ecatBenchFrame[ECATBENCH_DGRAM_OFFSET] &&
+                   data[ECATBENCH_DGRAM_OFFSET + 1U] == index);
+            if (own) {
+                data += ECATBENCH_DGRAM_OFFSET + ECATBENCH_DGRAM_HEADER + ecatBenchDataLength;
+                *wkc = (uint16_t)(data[0] | ((uint16_t)data[1] << 8));
+            }
+            enet_raw_release_frame(ecatBenchHandle, &frame);
+            if (own) {
+                return true;
+            }
+        } else if ((int32_t)(*received - deadline) >= 0) {
+            return false;
+        }
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EcatBench_Point
+ * Description   :  Exchange the current frame every period for pointMs and
+ *                  account each cycle against the expected working counter
+ *
+ *END**************************************************************************/
+static void EcatBench_Point(uint32_t periodUs, uint32_t pointMs, uint16_t expectedWkc, ecatbench_point_t *point)
+{
+    const uint32_t period = Cycles_FromUs(periodUs);
+    const uint32_t count = (pointMs * 1000U) / periodUs;
+    uint32_t release;
+    uint32_t start;
+    uint32_t received;
+    uint32_t late;
+    uint16_t wkc;
+    uint8_t *outputs = &ecatBenchFrame[ECATBENCH_DGRAM_OFFSET + ECATBENCH_DGRAM_HEADER];
+
+    memset(point, 0, sizeof(*point));
+    release = Cycles_Now() + period;
+
+    while (point->cycles < count) {
+        Bench_WaitUntil(release);
+        start = Cycles_Now();
+
+        // Preempted past a whole period: those releases are missed, not run late
+        late = (start - release) / period;
+        if (late > 0U) {
+            point->cycles += late;
+            point->missed += late;
+            release += late * period;
+            if (point->cycles >= count) {
+                break;
+            }
+        }
+        if ((start - release) > point->jitter_max) {
+            point->jitter_max = start - release;
+        }
+
+        // Outputs change every cycle, like a real image
+        outputs[0] = (uint8_t)point->cycles;
+        if (!EcatBench_Exchange((uint8_t)point->cycles, release + period, &wkc, &received)) {
+            point->missed++;
+        } else {
+            if (wkc != expectedWkc) {
+                point->wkc_errors++;
+            }
+            if ((received - release) > point->response_max) {
+                point->response_max = received - release;
+            }
+        }
+
+        point->cycles++;
+        release += period;
+    }
+    Bench_Drain(ecatBenchHandle);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EcatBench_Run
+ * Description   :  Count the slaves, then sweep every image size over every
+ *                  period at the given task priority and print the capability
+ *                  table
+ *
+ *END**************************************************************************/
+void EcatBench_Run(uint32_t jitterUs, uint32_t pointMs, UBaseType_t runPriority)
+{
+    ecatbench_point_t point;
+    ecatbench_point_t best;
+    UBaseType_t priority;
+    char line[96];
+    uint32_t length;
+    uint32_t bestUs;
+    uint32_t received;
+    uint16_t slaves = 0;
+    uint16_t expectedWkc;
+    uint32_t s;
+    uint32_t p;
+    bool sustained;
+
+    if (ecatBenchHandle == NULL || !enet_raw_is_link_up(ecatBenchHandle)) {
+        UART_LOG("ecatbench: no Ethernet link\r\n");
+        return;
+    }
+
+    Cycles_Init();
+    if (ecatBenchRxTask != NULL) {
+        vTaskSuspend(ecatBenchRxTask);
+    }
+    priority = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, runPriority);
+    Bench_Drain(ecatBenchHandle);
+
+    EcatBench_BuildFrame(ECATBENCH_CMD_BRD, 2U);
+    if (!EcatBench_Exchange(0, Cycles_Now() + Cycles_FromUs(ECATBENCH_WARMUP_US), &slaves, &received)) {
+        UART_LOG("ecatbench: BRD not answered\r\n");
+        goto done;
+    }
+
+    UART_PRINTF("%u slaves (BRD WKC), %lu ms per point, jitter bound %lu us, priority %u\r\n",
+                (unsigned)slaves, (unsigned long)pointMs, (unsigned long)jitterUs, (unsigned)runPriority);
+    length = (uint32_t)snprintf(line, sizeof(line), "LRW bytes  WKC");
+    for (p = 0; p < ECATBENCH_PERIOD_COUNT; p++) {
+        length += (uint32_t)snprintf(&line[length], sizeof(line) - length, " %5u", (unsigned)ecatBenchPeriodsUs[p]);
+    }
+    (void)snprintf(&line[length], sizeof(line) - length, " us  shortest\r\n");
+    UART_LOG(line);
+
+    for (s = 0; s < ECATBENCH_SIZE_COUNT; s++) {
+        EcatBench_BuildFrame(ECATBENCH_CMD_LRW, ecatBenchSizes[s]);
+
+        // The working counter of a quiet exchange is the reference
+        if (!EcatBench_Exchange(0, Cycles_Now() + Cycles_FromUs(ECATBENCH_WARMUP_US), &expectedWkc, &received)) {
+            UART_PRINTF("%9u   no reply\r\n", (unsigned)ecatBenchSizes[s]);
+            continue;
+        }
+        Bench_Drain(ecatBenchHandle);
+
+        length = (uint32_t)snprintf(line, sizeof(line), "%9u %4u", (unsigned)ecatBenchSizes[s], (unsigned)expectedWkc);
+        bestUs = 0;
+        memset(&best, 0, sizeof(best));
+
+        for (p = 0; p < ECATBENCH_PERIOD_COUNT; p++) {
+            EcatBench_Point(ecatBenchPeriodsUs[p], pointMs, expectedWkc, &point);
+
+            // The spin starves every task below the run priority: let them catch up between points
+            vTaskDelay(pdMS_TO_TICKS(ECATBENCH_POINT_GAP_MS));
+
+            sustained = (point.missed == 0U && point.wkc_errors == 0U &&
+                         Cycles_ToUs(point.jitter_max) <= jitterUs);
+            if (sustained && (bestUs == 0U || ecatBenchPeriodsUs[p] < bestUs)) {
+                bestUs = ecatBenchPeriodsUs[p];
+                best = point;
+            }
+            if (point.missed != 0U || point.wkc_errors != 0U) {
+                length += (uint32_t)snprintf(&line[length], sizeof(line) - length, " %5s",
+                                             (point.missed != 0U) ? "miss" : "wkc");
+            } else {
+                length += (uint32_t)snprintf(&line[length], sizeof(line) - length, " %5lu",
+                                             (unsigned long)Cycles_ToUs(point.jitter_max));
+            }
+        }
+        if (bestUs != 0U) {
+            (void)snprintf(&line[length], sizeof(line) - length, " %6lu us\r\n", (unsigned long)bestUs);
+        } else {
+            (void)snprintf(&line[length], sizeof(line) - length, "   none\r\n");
+        }
+        UART_LOG(line);
+
+        if (bestUs != 0U) {
+            UART_PRINTF("          at %lu us: max jitter %lu us, max response %lu us\r\n",
+                        (unsigned long)bestUs, (unsigned long)Cycles_ToUs(best.jitter_max),
+                        (unsigned long)Cycles_ToUs(best.response_max));
+        }
+    }
+    UART_LOG("Max release jitter in us, miss: deadline missed, wkc: working counter error\r\n");
+
+done:
+    Bench_Drain(ecatBenchHandle);
+    vTaskPrioritySet(NULL, priority);
+    if (ecatBenchRxTask != NULL) {
+        vTaskResume(ecatBenchRxTask);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EcatBench_ShellCommand
+ * Description   :  "ecatbench" command
+ *
+ *END**************************************************************************/
+static int EcatBench_ShellCommand(int argc, char *argv[])
+{
+    uint32_t jitterUs = ECATBENCH_DEFAULT_JITTER_US;
+    uint32_t pointMs = ECATBENCH_DEFAULT_POINT_MS;
+    uint32_t priority = ETHERCAT_TASK_PRIORITY;
+
+    if (argc > 4) {
+        return SHELL_USAGE;
+    }
+    if (argc >= 2) {
+        jitterUs = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+    if (argc >= 3) {
+        pointMs = (uint32_t)strtoul(argv[2], NULL, 0);
+        if (pointMs == 0U || pointMs > ECATBENCH_MAX_POINT_MS) {
+            return SHELL_USAGE;
+        }
+    }
+    if (argc == 4 && (!Shell_ParseU32(argv[3], &priority) || priority < SHELL_TASK_PRIORITY ||
+                      priority > ETHERCAT_TASK_PRIORITY)) {
+        return SHELL_USAGE;
+    }
+    EcatBench_Run(jitterUs, pointMs, (UBaseType_t)priority);
+    return SHELL_OK;
+}
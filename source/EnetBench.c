@@ -0,0 +1,413 @@
+#include "EnetBench.h"
+#include "Bench.h"
+#include "mem_placement.h"
+#include "cycles.h"
+#include "Shell.h"
+#include "Utilities.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ENETBENCH_CMD_BRD           (0x07U)
+#define ENETBENCH_ECAT_OFFSET       (14U)       // EtherCAT header after the Ethernet header
+#define ENETBENCH_DGRAM_OFFSET      (16U)
+#define ENETBENCH_OVERHEAD          (28U)       // Ethernet, EtherCAT and datagram headers, WKC
+#define ENETBENCH_WIRE_EXTRA        (24U)       // FCS, preamble and inter-frame gap
+#define ENETBENCH_HIST_SUB_COUNT    (1UL << ENETBENCH_HIST_SUB_BITS)
+
+typedef struct {
+    uint32_t received;
+    uint32_t lost;
+    uint32_t send_errors;
+    uint64_t tx_cycles;             // Ping-pong: enet_raw_send_frame()
+    uint64_t rx_cycles;             // Ping-pong: enet_raw_receive_frame() that returned a frame
+    uint64_t elapsed_cycles;        // Stream
+    uint32_t latency_max;
+} enetbench_result_t;
+
+// Frame lengths passed to enet_raw_send_frame(), the FCS makes 68..1518 on the wire
+static const uint16_t enetBenchSizes[] = { 64U, 128U, 256U, 512U, 1024U, 1514U };
+
+static enet_raw_handle_t *enetBenchHandle = NULL;
+static TaskHandle_t enetBenchRxTask = NULL;
+static uint32_t enetBenchForeign;
+
+// Sent from SRAM_L like the process image frames
+static uint8_t enetBenchFrame[ETHERCAT_MAX_FRAME_SIZE] MEM_SRAM_L_BSS;
+static uint16_t enetBenchLength;
+static uint32_t enetBenchHist[ENETBENCH_HIST_SIZE];
+
+static int EnetBench_ShellCommand(int argc, char *argv[]);
+
+static const shell_command_t enetBenchCommand = { "enetbench", "[frames] - enet_raw TX/RX cycles, latency and throughput", EnetBench_ShellCommand };
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EnetBench_Init
+ * Description   :  Register the "enetbench" command for an initialized interface.
+ *                  rxTask, the task otherwise receiving on it, is suspended while
+ *                  the benchmark runs.
+ *
+ *END**************************************************************************/
+void EnetBench_Init(enet_raw_handle_t *handle, TaskHandle_t rxTask)
+{
+    enetBenchHandle = handle;
+    enetBenchRxTask = rxTask;
+    (void)Shell_RegisterCommand(&enetBenchCommand);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EnetBench_BuildFrame
+ * Description   :  Broadcast EtherCAT frame of the given length holding one BRD
+ *                  of register 0, harmless to a real segment
+ *
+ *END**************************************************************************/
+static void EnetBench_BuildFrame(uint16_t length)
+{
+    uint16_t dataLength = (uint16_t)(length - ENETBENCH_OVERHEAD);
+    uint16_t ecatLength = (uint16_t)(length - ENETBENCH_DGRAM_OFFSET);
+    uint8_t *dgram = &enetBenchFrame[ENETBENCH_DGRAM_OFFSET];
+
+    memset(enetBenchFrame, 0, length);
+    memset(enetBenchFrame, 0xFF, 6U);
+    memcpy(&enetBenchFrame[6], enetBenchHandle->mac_addr, 6U);
+    enetBenchFrame[12] = (uint8_t)(ETHERCAT_ETHERTYPE >> 8);
+    enetBenchFrame[13] = (uint8_t)(ETHERCAT_ETHERTYPE & 0xFFU);
+
+    // Length (11 bits) and type 1, little endian
+    enetBenchFrame[ENETBENCH_ECAT_OFFSET] = (uint8_t)(ecatLength & 0xFFU);
+    enetBenchFrame[ENETBENCH_ECAT_OFFSET + 1U] = (uint8_t)(0x10U | ((ecatLength >> 8) & 0x07U));
+
+    // Command, index, ADP, ADO 0, data length, IRQ, data, WKC
+    dgram[0] = ENETBENCH_CMD_BRD;
+    dgram[6] = (uint8_t)(dataLength & 0xFFU);
+    dgram[7] = (uint8_t)((dataLength >> 8) & 0x07U);
+
+    enetBenchLength = length;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EnetBench_IsOwn
+ * Description   :  Whether a received frame is a benchmark frame of the current
+ *                  length, and its datagram index
+ *
+ *END**************************************************************************/
+static bool EnetBench_IsOwn(const enet_raw_frame_t *frame, uint8_t *index)
+{
+    const uint8_t *data = frame->data;
+
+    if (frame->length != enetBenchLength ||
+        data[ENETBENCH_ECAT_OFFSET] != enetBenchFrame[ENETBENCH_ECAT_OFFSET] ||
+        data[ENETBENCH_ECAT_OFFSET + 1U] != enetBenchFrame[ENETBENCH_ECAT_OFFSET + 1U] ||
+        data[ENETBENCH_DGRAM_OFFSET] != ENETBENCH_CMD_BRD) {
+        return false;
+    }
+    *index = data[ENETBENCH_DGRAM_OFFSET + 1U];
+    return true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EnetBench_Poll
+ * Description   :  Poll for the next benchmark frame until deadline (cycles).
+ *                  Returns false on timeout, else its index and the cycles of
+ *                  the receive call that returned it.
+ *
+ *END**************************************************************************/
+static bool EnetBench_Poll(uint32_t deadline, uint8_t *index, uint32_t *rxCycles)
+{
+    enet_raw_frame_t frame;
+    enet_raw_status_t status;
+    uint32_t start;
+    uint32_t end;
+    bool own;
+
+    while (1) {
+        start = Cycles_Now();
+        status = enet_raw_receive_frame(enetBenchHandle, &frame, 0);
+        end = Cycles_Now();
+
+        if (status == ENET_RAW_SUCCESS) {
+            own = EnetBench_IsOwn(&frame, index);
+            enet_raw_release_frame(enetBenchHandle, &frame);
+            if (own) {
+                *rxCycles = end - start;
+                return true;
+            }
+            enetBenchForeign++;
+        } else if ((int32_t)(end - deadline) >= 0) {
+            return false;
+        }
+    }
+}
+
+/*******************************************************************************
+ * Latency histogram
+ ******************************************************************************/
+
+static uint32_t EnetBench_Bucket(uint32_t cycles)
+{
+    uint32_t shift;
+
+    if (cycles < ENETBENCH_HIST_SUB_COUNT) {
+        return cycles;
+    }
+    shift = (31U - (uint32_t)__builtin_clz(cycles)) - ENETBENCH_HIST_SUB_BITS;
+    return ((shift + 1U) << ENETBENCH_HIST_SUB_BITS) + ((cycles >> shift) & (ENETBENCH_HIST_SUB_COUNT - 1U));
+}
+
+static uint32_t EnetBench_BucketMax(uint32_t bucket)
+{
+    uint32_t shift;
+    uint64_t next;
+
+    if (bucket < ENETBENCH_HIST_SUB_COUNT) {
+        return bucket;
+    }
+    shift = (bucket >> ENETBENCH_HIST_SUB_BITS) - 1U;
+    next = (uint64_t)((bucket & (ENETBENCH_HIST_SUB_COUNT - 1U)) + ENETBENCH_HIST_SUB_COUNT + 1U) << shift;
+    return (uint32_t)(next - 1U);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EnetBench_Percentile
+ * Description   :  Latency below which permille of the count samples fall, as
+ *                  the upper bound of its bucket, no more than the maximum
+ *
+ *END**************************************************************************/
+static uint32_t EnetBench_Percentile(uint32_t count, uint32_t permille, uint32_t max)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)count * permille + 999U) / 1000U);
+    uint32_t seen = 0;
+    uint32_t bucket;
+
+    for (bucket = 0; bucket < ENETBENCH_HIST_SIZE; bucket++) {
+        seen += enetBenchHist[bucket];
+        if (seen >= rank && seen != 0U) {
+            break;
+        }
+    }
+    if (bucket == ENETBENCH_HIST_SIZE) {
+        return 0;
+    }
+    bucket = EnetBench_BucketMax(bucket);
+    return (bucket < max) ? bucket : max;
+}
+
+/*******************************************************************************
+ * Runs
+ ******************************************************************************/
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EnetBench_PingPong
+ * Description   :  One frame in flight: cycles of each call and the round trip
+ *                  latency, from the send call to the return of the receive call
+ *
+ *END**************************************************************************/
+static void EnetBench_PingPong(uint32_t frames, enetbench_result_t *result)
+{
+    const uint32_t timeout = Cycles_FromUs(ENETBENCH_TIMEOUT_US);
+    enet_raw_status_t status;
+    uint32_t start;
+    uint32_t sent;
+    uint32_t rxCycles;
+    uint32_t latency;
+    uint32_t i;
+    uint8_t index;
+    bool back;
+
+    memset(enetBenchHist, 0, sizeof(enetBenchHist));
+
+    for (i = 0; i < frames; i++) {
+        enetBenchFrame[ENETBENCH_DGRAM_OFFSET + 1U] = (uint8_t)i;
+
+        start = Cycles_Now();
+        status = enet_raw_send_frame(enetBenchHandle, enetBenchFrame, enetBenchLength);
+        sent = Cycles_Now();
+        if (status != ENET_RAW_SUCCESS) {
+            result->send_errors++;
+            vTaskDelay(1);
+            continue;
+        }
+        result->tx_cycles += sent - start;
+
+        // A late frame of an earlier index was already counted lost
+        do {
+            back = EnetBench_Poll(sent + timeout, &index, &rxCycles);
+        } while (back && index != (uint8_t)i);
+        if (!back) {
+            result->lost++;
+            continue;
+        }
+
+        latency = Cycles_Now() - start;
+        result->received++;
+        result->rx_cycles += rxCycles;
+        enetBenchHist[EnetBench_Bucket(latency)]++;
+        if (latency > result->latency_max) {
+            result->latency_max = latency;
+        }
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EnetBench_Stream
+ * Description   :  Keep ENETBENCH_WINDOW frames in flight until frames are sent,
+ *                  count what comes back and the time it took
+ *
+ *END**************************************************************************/
+static void EnetBench_Stream(uint32_t frames, enetbench_result_t *result)
+{
+    const uint32_t timeout = Cycles_FromUs(ENETBENCH_TIMEOUT_US);
+    enet_raw_status_t status;
+    uint32_t inFlight = 0;
+    uint32_t sent = 0;
+    uint32_t last = Cycles_Now();
+    uint32_t now;
+    uint32_t rxCycles;
+    uint8_t index;
+
+    while (sent < frames || inFlight > 0U) {
+        if (sent < frames && inFlight < ENETBENCH_WINDOW) {
+            status = enet_raw_send_frame(enetBenchHandle, enetBenchFrame, enetBenchLength);
+            if (status == ENET_RAW_SUCCESS) {
+                sent++;
+                inFlight++;
+                continue;
+            }
+            if (status != ENET_RAW_ERROR_NO_BUFFER || inFlight == 0U) {
+                result->send_errors++;
+                sent++;
+                continue;
+            }
+        }
+
+        if (EnetBench_Poll(Cycles_Now() + timeout, &index, &rxCycles)) {
+            result->received++;
+            inFlight--;
+        } else {
+            result->lost += inFlight;
+            inFlight = 0;
+        }
+
+        // 64 bits of elapsed time, the counter wraps every 35 s
+        now = Cycles_Now();
+        result->elapsed_cycles += now - last;
+        last = now;
+    }
+    result->elapsed_cycles += Cycles_Now() - last;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EnetBench_FormatUs
+ * Description   :  Cycles as microseconds with one decimal
+ *
+ *END**************************************************************************/
+static void EnetBench_FormatUs(char *text, uint32_t size, uint32_t cycles)
+{
+    uint32_t tenths = (uint32_t)(((uint64_t)cycles * 10U) / CYCLES_PER_US);
+
+    (void)snprintf(text, size, "%lu.%lu", (unsigned long)(tenths / 10U), (unsigned long)(tenths % 10U));
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EnetBench_Run
+ * Description   :  Ping-pong then stream frames of each size, and print one line
+ *                  per size
+ *
+ *END**************************************************************************/
+void EnetBench_Run(uint32_t frames)
+{
+    enetbench_result_t pingPong;
+    enetbench_result_t stream;
+    char p50[12];
+    char p99[12];
+    char p999[12];
+    char max[12];
+    uint64_t fps;
+    uint64_t mbps;
+    uint32_t s;
+
+    if (enetBenchHandle == NULL || !enet_raw_is_link_up(enetBenchHandle)) {
+        UART_LOG("enetbench: no Ethernet link\r\n");
+        return;
+    }
+
+    Cycles_Init();
+    if (enetBenchRxTask != NULL) {
+        vTaskSuspend(enetBenchRxTask);
+    }
+    enetBenchForeign = 0;
+
+    UART_PRINTF("%lu frames per size, %lu in flight when streaming, %lu cycles/us\r\n",
+                (unsigned long)frames, (unsigned long)ENETBENCH_WINDOW, (unsigned long)CYCLES_PER_US);
+    UART_LOG("size  tx cyc  rx cyc  p50 us  p99 us p999 us  max us lost |  frames/s Mbit/s lost\r\n");
+
+    for (s = 0; s < (sizeof(enetBenchSizes) / sizeof(enetBenchSizes[0])); s++) {
+        memset(&pingPong, 0, sizeof(pingPong));
+        memset(&stream, 0, sizeof(stream));
+
+        EnetBench_BuildFrame(enetBenchSizes[s]);
+        Bench_Drain(enetBenchHandle);
+        EnetBench_PingPong(frames, &pingPong);
+        Bench_Drain(enetBenchHandle);
+        EnetBench_Stream(frames, &stream);
+
+        EnetBench_FormatUs(p50, sizeof(p50), EnetBench_Percentile(pingPong.received, 500U, pingPong.latency_max));
+        EnetBench_FormatUs(p99, sizeof(p99), EnetBench_Percentile(pingPong.received, 990U, pingPong.latency_max));
+        EnetBench_FormatUs(p999, sizeof(p999), EnetBench_Percentile(pingPong.received, 999U, pingPong.latency_max));
+        EnetBench_FormatUs(max, sizeof(max), pingPong.latency_max);
+
+        fps = 0;
+        mbps = 0;
+        if (stream.elapsed_cycles != 0U) {
+            fps = ((uint64_t)stream.received * SystemCoreClock) / stream.elapsed_cycles;
+            mbps = (fps * (enetBenchSizes[s] + ENETBENCH_WIRE_EXTRA) * 8U) / 1000000U;
+        }
+
+        // One row in two parts, each within the UART_PRINTF buffer
+        UART_PRINTF("%4u %7lu %7lu %7s %7s %7s %7s %4lu | ",
+                    (unsigned)enetBenchSizes[s],
+                    (unsigned long)((pingPong.received + pingPong.lost) ? (pingPong.tx_cycles / (pingPong.received + pingPong.lost)) : 0U),
+                    (unsigned long)(pingPong.received ? (pingPong.rx_cycles / pingPong.received) : 0U),
+                    p50, p99, p999, max, (unsigned long)(pingPong.lost + pingPong.send_errors));
+        UART_PRINTF("%9lu %6lu %4lu\r\n",
+                    (unsigned long)fps, (unsigned long)mbps, (unsigned long)(stream.lost + stream.send_errors));
+    }
+    Bench_Drain(enetBenchHandle);
+
+    if (enetBenchRxTask != NULL) {
+        vTaskResume(enetBenchRxTask);
+    }
+    UART_PRINTF("Foreign frames %lu\r\n", (unsigned long)enetBenchForeign);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EnetBench_ShellCommand
+ * Description   :  "enetbench" command
+ *
+ *END**************************************************************************/
+static int EnetBench_ShellCommand(int argc, char *argv[])
+{
+    uint32_t frames = ENETBENCH_DEFAULT_FRAMES;
+
+    if (argc > 2) {
+        return SHELL_USAGE;
+    }
+    if (argc == 2) {
+        frames = (uint32_t)strtoul(argv[1], NULL, 0);
+        if (frames == 0U || frames > ENETBENCH_MAX_FRAMES) {
+            return SHELL_USAGE;
+        }
+    }
+    EnetBench_Run(frames);
+    return SHELL_OK;
+}
@@ -0,0 +1,282 @@
+#include "EoeBench.h"
+#include "Bench.h"
+#include "ecat_eoe.h"
+#include "cycles.h"
+#include "rtos.h"
+#include "Shell.h"
+#include "Utilities.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define EOEBENCH_HEADER_SIZE        (16U)       // Ethernet header and sequence number
+
+// Test frame sizes, without FCS: minimum, odd, one to many fragments, maximum
+static const uint16_t eoeBenchSizes[] = { 60U, 97U, 256U, 512U, 1024U, 1514U };
+
+#define EOEBENCH_SIZE_COUNT         (sizeof(eoeBenchSizes) / sizeof(eoeBenchSizes[0]))
+
+static ecat_cycle_t *eoeBenchCycle = NULL;
+static TaskHandle_t eoeBenchRxTask = NULL;
+
+static ecat_eoe_endpoint_t eoeBenchEndpoint;
+static uint8_t eoeBenchFrame[ECAT_EOE_MAX_FRAME_SIZE];
+static uint16_t eoeBenchSize;
+static uint32_t eoeBenchReceived;       // Echoes, the next one expected carries this number
+static uint32_t eoeBenchIntact;
+
+static uint16_t EoeBench_Fill(void *ctx, uint8_t *buf, uint16_t spareBytes);
+static void EoeBench_Confirm(void *ctx, bool accepted);
+static void EoeBench_Receive(void *ctx, const uint8_t *mbx, uint16_t length);
+static int EoeBench_ShellCommand(int argc, char *argv[]);
+
+static const ecat_mbx_client_t eoeBenchClient = { EoeBench_Fill, EoeBench_Confirm, EoeBench_Receive };
+
+static const shell_command_t eoeBenchCommand = { "eoebench", "[frames] [period_us] - EoE echo throughput per frame size", EoeBench_ShellCommand };
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EoeBench_Init
+ * Description   :  Register the "eoebench" command for a frame builder on an
+ *                  initialized interface. rxTask, the task otherwise receiving
+ *                  on it, is suspended while the benchmark runs.
+ *
+ *END**************************************************************************/
+void EoeBench_Init(ecat_cycle_t *cycle, TaskHandle_t rxTask)
+{
+    eoeBenchCycle = cycle;
+    eoeBenchRxTask = rxTask;
+    (void)Shell_RegisterCommand(&eoeBenchCommand);
+}
+
+// Mailbox client of the frame builder, the EoE endpoint behind it
+static uint16_t EoeBench_Fill(void *ctx, uint8_t *buf, uint16_t spareBytes)
+{
+    return ecat_eoe_fill_mailbox((ecat_eoe_endpoint_t *)ctx, buf, spareBytes);
+}
+
+static void EoeBench_Confirm(void *ctx, bool accepted)
+{
+    ecat_eoe_tx_confirm((ecat_eoe_endpoint_t *)ctx, accepted);
+}
+
+static void EoeBench_Receive(void *ctx, const uint8_t *mbx, uint16_t length)
+{
+    (void)ecat_eoe_process_mailbox((ecat_eoe_endpoint_t *)ctx, mbx, length);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EoeBench_Pattern
+ * Description   :  Byte of test frame number seq at offset, past the headers
+ *
+ *END**************************************************************************/
+static uint8_t EoeBench_Pattern(uint32_t seq, uint32_t offset)
+{
+    return (uint8_t)(seq * 31U + offset);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EoeBench_BuildFrame
+ * Description   :  Broadcast test frame number seq of the current size
+ *
+ *END**************************************************************************/
+static void EoeBench_BuildFrame(uint32_t seq)
+{
+    uint32_t i;
+
+    memset(eoeBenchFrame, 0xFF, 6U);
+    memcpy(&eoeBenchFrame[6], eoeBenchCycle->handle->mac_addr, 6U);
+    eoeBenchFrame[12] = (uint8_t)(EOEBENCH_ETHERTYPE >> 8);
+    eoeBenchFrame[13] = (uint8_t)(EOEBENCH_ETHERTYPE & 0xFFU);
+    eoeBenchFrame[14] = (uint8_t)(seq >> 8);
+    eoeBenchFrame[15] = (uint8_t)seq;
+    for (i = EOEBENCH_HEADER_SIZE; i < eoeBenchSize; i++) {
+        eoeBenchFrame[i] = EoeBench_Pattern(seq, i);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EoeBench_Received
+ * Description   :  Endpoint callback with a reassembled frame: intact if it is
+ *                  the next one in order, unchanged
+ *
+ *END**************************************************************************/
+static void EoeBench_Received(const uint8_t *frame, uint16_t length, void *userData)
+{
+    uint32_t seq = eoeBenchReceived++;
+    uint32_t i;
+
+    (void)userData;
+
+    if (length != eoeBenchSize || frame[12] != (uint8_t)(EOEBENCH_ETHERTYPE >> 8) ||
+        frame[14] != (uint8_t)(seq >> 8) || frame[15] != (uint8_t)seq) {
+        return;
+    }
+    for (i = EOEBENCH_HEADER_SIZE; i < length; i++) {
+        if (frame[i] != EoeBench_Pattern(seq, i)) {
+            return;
+        }
+    }
+    eoeBenchIntact++;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EoeBench_Size
+ * Description   :  Send frames of the current size one after the other, one
+ *                  frame builder cycle per period, until all came back or
+ *                  none did for EOEBENCH_IDLE_CYCLES. Returns the cycles run.
+ *
+ *END**************************************************************************/
+static uint32_t EoeBench_Size(uint32_t frames, uint32_t periodUs)
+{
+    const uint32_t period = Cycles_FromUs(periodUs);
+    uint32_t release = Cycles_Now() + period;
+    uint32_t sent = 0;
+    uint32_t cycles = 0;
+    uint32_t idle = 0;
+    uint32_t before;
+
+    eoeBenchReceived = 0;
+    eoeBenchIntact = 0;
+
+    while (eoeBenchReceived < frames && idle < EOEBENCH_IDLE_CYCLES) {
+        if (sent < frames && !ecat_eoe_tx_pending(&eoeBenchEndpoint)) {
+            EoeBench_BuildFrame(sent);
+            if (ecat_eoe_send(&eoeBenchEndpoint, eoeBenchFrame, eoeBenchSize) == ECAT_EOE_SUCCESS) {
+                sent++;
+            }
+        }
+
+        Bench_WaitUntil(release);
+        release += period;
+        if ((int32_t)(Cycles_Now() - release) >= 0) {
+            // Preempted past a whole period: restart the schedule from now
+            release = Cycles_Now() + period;
+        }
+
+        before = eoeBenchReceived;
+        (void)ecat_cycle_exchange(eoeBenchCycle, periodUs);
+        cycles++;
+        idle = (eoeBenchReceived != before) ? 0U : idle + 1U;
+    }
+    return cycles;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EoeBench_Run
+ * Description   :  Scan, move the slaves to PREOP, attach the endpoint to the
+ *                  first mailbox slave and measure every frame size
+ *
+ *END**************************************************************************/
+void EoeBench_Run(uint32_t frames, uint32_t periodUs)
+{
+    const ecat_cycle_slave_t *slave = NULL;
+    ecat_cycle_stats_t stats;
+    ecat_eoe_stats_t eoeStats;
+    UBaseType_t priority;
+    uint32_t cycles;
+    uint32_t kbits;
+    uint64_t elapsedUs;
+    uint16_t position;
+    uint32_t s;
+
+    if (eoeBenchCycle == NULL || !enet_raw_is_link_up(eoeBenchCycle->handle)) {
+        UART_LOG("eoebench: no Ethernet link\r\n");
+        return;
+    }
+
+    Cycles_Init();
+    if (eoeBenchRxTask != NULL) {
+        vTaskSuspend(eoeBenchRxTask);
+    }
+    priority = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, ETHERCAT_TASK_PRIORITY);
+    Bench_Drain(eoeBenchCycle->handle);
+
+    if (ecat_cycle_scan(eoeBenchCycle, EOEBENCH_TIMEOUT_US) != ECAT_CYCLE_SUCCESS ||
+        ecat_cycle_request_state(eoeBenchCycle, ECAT_AL_STATE_PREOP, EOEBENCH_TIMEOUT_US) != ECAT_CYCLE_SUCCESS) {
+        UART_LOG("eoebench: slaves not in PREOP\r\n");
+        goto done;
+    }
+    for (position = 0; position < eoeBenchCycle->slave_count; position++) {
+        if (ecat_eoe_init(&eoeBenchEndpoint, eoeBenchCycle->slaves[position].station_addr,
+                          eoeBenchCycle->slaves[position].sm0_size, EoeBench_Received, NULL) == ECAT_EOE_SUCCESS &&
+            ecat_cycle_attach(eoeBenchCycle, position, &eoeBenchClient, &eoeBenchEndpoint) == ECAT_CYCLE_SUCCESS) {
+            slave = &eoeBenchCycle->slaves[position];
+            break;
+        }
+    }
+    if (slave == NULL) {
+        UART_PRINTF("eoebench: none of %u slaves has a mailbox\r\n", (unsigned)eoeBenchCycle->slave_count);
+        goto done;
+    }
+
+    UART_PRINTF("EoE echo through slave %u (0x%04X), %u/%u byte mailboxes, %lu us cycle\r\n",
+                (unsigned)position, (unsigned)slave->station_addr, (unsigned)slave->sm0_size,
+                (unsigned)slave->sm1_size, (unsigned long)periodUs);
+    UART_LOG("    bytes  frames  intact  cycles/frame  kbit/s\r\n");
+
+    for (s = 0; s < EOEBENCH_SIZE_COUNT; s++) {
+        eoeBenchSize = eoeBenchSizes[s];
+        cycles = EoeBench_Size(frames, periodUs);
+
+        elapsedUs = (uint64_t)cycles * periodUs;
+        kbits = (elapsedUs > 0U) ? (uint32_t)((uint64_t)eoeBenchIntact * eoeBenchSize * 8000U / elapsedUs) : 0U;
+        UART_PRINTF("%9u %7lu %7lu %13lu %7lu\r\n", (unsigned)eoeBenchSize, (unsigned long)frames,
+                    (unsigned long)eoeBenchIntact, (unsigned long)(cycles / frames), (unsigned long)kbits);
+    }
+
+    ecat_cycle_get_stats(eoeBenchCycle, &stats);
+    ecat_eoe_get_stats(&eoeBenchEndpoint, &eoeStats);
+    UART_PRINTF("cycles %lu, lost %lu, mailboxes written %lu (busy %lu), read %lu, deferred %lu\r\n",
+                (unsigned long)stats.cycles, (unsigned long)stats.lost, (unsigned long)stats.mbx_written,
+                (unsigned long)stats.mbx_busy, (unsigned long)stats.mbx_read, (unsigned long)stats.mbx_deferred);
+    UART_PRINTF("EoE tx %lu frames %lu fragments, rx %lu frames %lu fragments, %lu errors\r\n",
+                (unsigned long)eoeStats.tx_frames, (unsigned long)eoeStats.tx_fragments,
+                (unsigned long)eoeStats.rx_frames, (unsigned long)eoeStats.rx_fragments,
+                (unsigned long)eoeStats.rx_errors);
+
+    (void)ecat_cycle_attach(eoeBenchCycle, position, NULL, NULL);
+
+done:
+    (void)ecat_cycle_request_state(eoeBenchCycle, ECAT_AL_STATE_INIT, EOEBENCH_TIMEOUT_US);
+    Bench_Drain(eoeBenchCycle->handle);
+    vTaskPrioritySet(NULL, priority);
+    if (eoeBenchRxTask != NULL) {
+        vTaskResume(eoeBenchRxTask);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  EoeBench_ShellCommand
+ * Description   :  "eoebench" command
+ *
+ *END**************************************************************************/
+static int EoeBench_ShellCommand(int argc, char *argv[])
+{
+    uint32_t frames = EOEBENCH_DEFAULT_FRAMES;
+    uint32_t periodUs = EOEBENCH_DEFAULT_PERIOD_US;
+
+    if (argc > 3) {
+        return SHELL_USAGE;
+    }
+    if (argc >= 2) {
+        frames = (uint32_t)strtoul(argv[1], NULL, 0);
+        if (frames == 0U || frames > EOEBENCH_MAX_FRAMES) {
+            return SHELL_USAGE;
+        }
+    }
+    if (argc == 3) {
+        periodUs = (uint32_t)strtoul(argv[2], NULL, 0);
+        if (periodUs < EOEBENCH_MIN_PERIOD_US) {
+            return SHELL_USAGE;
+        }
+    }
+    EoeBench_Run(frames, periodUs);
+    return SHELL_OK;
+}
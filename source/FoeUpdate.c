@@ -0,0 +1,231 @@
+#include "FoeUpdate.h"
+#include "Bench.h"
+#include "ecat_foe.h"
+#include "cycles.h"
+#include "rtos.h"
+#include "Shell.h"
+#include "Utilities.h"
+#include <stdlib.h>
+#include <string.h>
+
+static ecat_cycle_t *foeUpdateCycle = NULL;
+static TaskHandle_t foeUpdateRxTask = NULL;
+
+static ecat_foe_engine_t foeUpdateEngine;
+static uint16_t foeUpdateStdMbx[ECAT_CYCLE_MAX_SLAVES];
+static uint16_t foeUpdatePosition[ECAT_FOE_MAX_SESSIONS];  // Slave of each session
+
+static uint16_t FoeUpdate_Fill(void *ctx, uint8_t *buf, uint16_t spareBytes);
+static void FoeUpdate_Confirm(void *ctx, bool accepted);
+static void FoeUpdate_Receive(void *ctx, const uint8_t *mbx, uint16_t length);
+static int FoeUpdate_ShellCommand(int argc, char *argv[]);
+
+static const ecat_mbx_client_t foeUpdateClient = { FoeUpdate_Fill, FoeUpdate_Confirm, FoeUpdate_Receive };
+
+static const shell_command_t foeUpdateCommand = { "foe", "<file> <bytes> [window] - FoE update of the slaves from flash", FoeUpdate_ShellCommand };
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  FoeUpdate_Init
+ * Description   :  Register the "foe" command for a frame builder on an
+ *                  initialized interface. rxTask, the task otherwise receiving
+ *                  on it, is suspended while an update runs.
+ *
+ *END**************************************************************************/
+void FoeUpdate_Init(ecat_cycle_t *cycle, TaskHandle_t rxTask)
+{
+    foeUpdateCycle = cycle;
+    foeUpdateRxTask = rxTask;
+    (void)Shell_RegisterCommand(&foeUpdateCommand);
+}
+
+// Mailbox client of the frame builder, one FoE session behind each slave
+static uint16_t FoeUpdate_Fill(void *ctx, uint8_t *buf, uint16_t spareBytes)
+{
+    return ecat_foe_fill_mailbox((ecat_foe_session_t *)ctx, buf, spareBytes);
+}
+
+static void FoeUpdate_Confirm(void *ctx, bool accepted)
+{
+    ecat_foe_tx_confirm((ecat_foe_session_t *)ctx, accepted);
+}
+
+static void FoeUpdate_Receive(void *ctx, const uint8_t *mbx, uint16_t length)
+{
+    (void)ecat_foe_process_mailbox((ecat_foe_session_t *)ctx, mbx, length);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  FoeUpdate_AddSessions
+ * Description   :  One session per slave with a boot mailbox, up to the engine
+ *                  size, attached to the frame builder. Returns the count.
+ *
+ *END**************************************************************************/
+static uint8_t FoeUpdate_AddSessions(const char *filename, uint32_t bytes, uint8_t window)
+{
+    const ecat_cycle_slave_t *slave;
+    ecat_foe_session_t *session;
+    uint16_t mbxSize;
+    uint16_t position;
+
+    ecat_foe_engine_init(&foeUpdateEngine);
+    for (position = 0; position < foeUpdateCycle->slave_count; position++) {
+        slave = &foeUpdateCycle->slaves[position];
+
+        // SM0 as set up in BOOT is the bootstrap mailbox, never written beyond it
+        mbxSize = ecat_foe_select_mbx_size(foeUpdateStdMbx[position], slave->sm0_size, true);
+        if (mbxSize > slave->sm0_size) {
+            mbxSize = slave->sm0_size;
+        }
+        if (mbxSize < ECAT_MBX_MIN_SIZE) {
+            continue;
+        }
+
+        session = ecat_foe_engine_add(&foeUpdateEngine, slave->station_addr, mbxSize, filename, 0U,
+                                      (const uint8_t *)FOEUPDATE_IMAGE_ADDR, bytes);
+        if (session == NULL) {
+            break;
+        }
+        ecat_foe_set_window(session, window);
+        if (ecat_cycle_attach(foeUpdateCycle, position, &foeUpdateClient, session) != ECAT_CYCLE_SUCCESS) {
+            foeUpdateEngine.session_count--;
+            continue;
+        }
+        foeUpdatePosition[foeUpdateEngine.session_count - 1U] = position;
+    }
+    return foeUpdateEngine.session_count;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  FoeUpdate_Run
+ * Description   :  Write the first bytes of the flash image as filename to
+ *                  every slave with a mailbox, in parallel, and report
+ *
+ *END**************************************************************************/
+void FoeUpdate_Run(const char *filename, uint32_t bytes, uint8_t window)
+{
+    const uint32_t period = Cycles_FromUs(FOEUPDATE_PERIOD_US);
+    const ecat_foe_session_t *session;
+    ecat_cycle_stats_t stats;
+    UBaseType_t priority;
+    uint32_t release;
+    uint32_t cycles = 0;
+    uint32_t done = 0;
+    uint32_t elapsedUs;
+    uint32_t kbits;
+    uint16_t position;
+    uint8_t count;
+    uint8_t i;
+
+    if (foeUpdateCycle == NULL || !enet_raw_is_link_up(foeUpdateCycle->handle)) {
+        UART_LOG("foe: no Ethernet link\r\n");
+        return;
+    }
+
+    Cycles_Init();
+    if (foeUpdateRxTask != NULL) {
+        vTaskSuspend(foeUpdateRxTask);
+    }
+    priority = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, ETHERCAT_TASK_PRIORITY);
+    Bench_Drain(foeUpdateCycle->handle);
+
+    // Standard mailbox sizes in PREOP, the boot ones after the switch to BOOT
+    if (ecat_cycle_scan(foeUpdateCycle, FOEUPDATE_TIMEOUT_US) != ECAT_CYCLE_SUCCESS ||
+        ecat_cycle_request_state(foeUpdateCycle, ECAT_AL_STATE_PREOP, FOEUPDATE_TIMEOUT_US) != ECAT_CYCLE_SUCCESS) {
+        UART_LOG("foe: slaves not in PREOP\r\n");
+        goto done;
+    }
+    for (position = 0; position < foeUpdateCycle->slave_count; position++) {
+        foeUpdateStdMbx[position] = foeUpdateCycle->slaves[position].sm0_size;
+    }
+    if (ecat_cycle_request_state(foeUpdateCycle, ECAT_AL_STATE_BOOT, FOEUPDATE_BOOT_TIMEOUT_US) != ECAT_CYCLE_SUCCESS) {
+        UART_LOG("foe: slaves not in BOOT\r\n");
+        goto done;
+    }
+
+    count = FoeUpdate_AddSessions(filename, bytes, window);
+    if (count == 0U) {
+        UART_PRINTF("foe: none of %u slaves has a boot mailbox\r\n", (unsigned)foeUpdateCycle->slave_count);
+        goto done;
+    }
+    UART_PRINTF("FoE '%s', %lu bytes from 0x%08lX to %u slaves, window %u, %u us cycle\r\n", filename,
+                (unsigned long)bytes, (unsigned long)FOEUPDATE_IMAGE_ADDR, (unsigned)count, (unsigned)window,
+                (unsigned)FOEUPDATE_PERIOD_US);
+
+    // Every session ends on its own: done, error from the slave, or retries exhausted
+    release = Cycles_Now() + period;
+    while (!ecat_foe_engine_finished(&foeUpdateEngine)) {
+        Bench_WaitUntil(release);
+        release += period;
+        if ((int32_t)(Cycles_Now() - release) >= 0) {
+            release = Cycles_Now() + period;
+        }
+
+        (void)ecat_cycle_exchange(foeUpdateCycle, FOEUPDATE_PERIOD_US);
+        for (i = 0; i < count; i++) {
+            ecat_foe_tick(&foeUpdateEngine.sessions[i]);
+        }
+        cycles++;
+    }
+
+    for (i = 0; i < count; i++) {
+        session = &foeUpdateEngine.sessions[i];
+        if (session->state == ECAT_FOE_STATE_DONE) {
+            done++;
+            UART_PRINTF("  slave %u (0x%04X): done, %u byte mailbox, %lu packets, %lu resent\r\n",
+                        (unsigned)foeUpdatePosition[i], (unsigned)session->station_addr,
+                        (unsigned)session->mbx_size, (unsigned long)session->packets_sent,
+                        (unsigned long)session->packets_resent);
+        } else {
+            UART_PRINTF("  slave %u (0x%04X): failed, error 0x%08lX, %lu of %lu bytes acknowledged\r\n",
+                        (unsigned)foeUpdatePosition[i], (unsigned)session->station_addr,
+                        (unsigned long)session->error_code, (unsigned long)ecat_foe_bytes_acked(session),
+                        (unsigned long)bytes);
+        }
+        (void)ecat_cycle_attach(foeUpdateCycle, foeUpdatePosition[i], NULL, NULL);
+    }
+
+    elapsedUs = cycles * FOEUPDATE_PERIOD_US;
+    kbits = (elapsedUs > 0U) ? (uint32_t)((uint64_t)bytes * done * 8000U / elapsedUs) : 0U;
+    ecat_cycle_get_stats(foeUpdateCycle, &stats);
+    UART_PRINTF("%lu of %u slaves updated in %lu cycles, %lu kbit/s in total\r\n", (unsigned long)done,
+                (unsigned)count, (unsigned long)cycles, (unsigned long)kbits);
+    UART_PRINTF("mailboxes written %lu (busy %lu), read %lu, deferred %lu, frames lost %lu\r\n",
+                (unsigned long)stats.mbx_written, (unsigned long)stats.mbx_busy, (unsigned long)stats.mbx_read,
+                (unsigned long)stats.mbx_deferred, (unsigned long)stats.lost);
+
+done:
+    (void)ecat_cycle_request_state(foeUpdateCycle, ECAT_AL_STATE_INIT, FOEUPDATE_TIMEOUT_US);
+    Bench_Drain(foeUpdateCycle->handle);
+    vTaskPrioritySet(NULL, priority);
+    if (foeUpdateRxTask != NULL) {
+        vTaskResume(foeUpdateRxTask);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  FoeUpdate_ShellCommand
+ * Description   :  "foe" command
+ *
+ *END**************************************************************************/
+static int FoeUpdate_ShellCommand(int argc, char *argv[])
+{
+    uint32_t bytes;
+    uint32_t window = ECAT_FOE_DEFAULT_WINDOW;
+
+    if (argc < 3 || argc > 4 || strlen(argv[1]) > ECAT_FOE_MAX_FILENAME) {
+        return SHELL_USAGE;
+    }
+    if (!Shell_ParseU32(argv[2], &bytes) || bytes > FOEUPDATE_IMAGE_SIZE) {
+        return SHELL_USAGE;
+    }
+    if (argc == 4 && (!Shell_ParseU32(argv[3], &window) || window == 0U || window > ECAT_FOE_MAX_WINDOW)) {
+        return SHELL_USAGE;
+    }
+    FoeUpdate_Run(argv[1], bytes, (uint8_t)window);
+    return SHELL_OK;
+}
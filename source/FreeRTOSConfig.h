@@ -67,24 +67,36 @@
 #define configNUM_THREAD_LOCAL_STORAGE_POINTERS 5
 #define configUSE_APPLICATION_TASK_TAG          0
 
-/* Memory allocation related definitions. */
-#define configSUPPORT_STATIC_ALLOCATION         0
-#define configSUPPORT_DYNAMIC_ALLOCATION        1
-#define configTOTAL_HEAP_SIZE                   ((size_t)(32 * 1024))
+/* Memory allocation related definitions.
+ * Every kernel object is created from static storage and no heap_x.c file is
+ * built, so a dynamic allocation anywhere is a link error (tools/ram_report.py
+ * lists the RAM use per subsystem). */
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
 #define configAPPLICATION_ALLOCATED_HEAP        0
 
 /* Hook function related definitions. */
 #define configUSE_IDLE_HOOK                     0
 #define configUSE_TICK_HOOK                     0
 #define configCHECK_FOR_STACK_OVERFLOW          2
-#define configUSE_MALLOC_FAILED_HOOK            1
+#define configUSE_MALLOC_FAILED_HOOK            0
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
 /* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS           0
+#define configGENERATE_RUN_TIME_STATS           1
 #define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    1
 
+/* Run-time counter and trace recorder hooks, see header/Trace.h */
+#if defined(__ICCARM__)||defined(__CC_ARM)||defined(__GNUC__)
+    #include "Trace.h"
+    #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()    Trace_RunTimeInit()
+    #define portGET_RUN_TIME_COUNTER_VALUE()            Trace_RunTimeCounter()
+    #if TRACE_ENABLED
+        #define traceTASK_SWITCHED_IN()                 Trace_TaskSwitchedIn(pxCurrentTCB->uxTCBNumber)
+    #endif
+#endif
+
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                   0
 #define configMAX_CO_ROUTINE_PRIORITIES         2
@@ -107,7 +119,7 @@
 #define INCLUDE_vTaskDelay                      1
 #define INCLUDE_xTaskGetSchedulerState          1
 #define INCLUDE_xTaskGetCurrentTaskHandle       1
-#define INCLUDE_uxTaskGetStackHighWaterMark     0
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
 #define INCLUDE_xTaskGetIdleTaskHandle          0
 #define INCLUDE_eTaskGetState                   0
 #define INCLUDE_xTimerPendFunctionCall          1
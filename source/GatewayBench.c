@@ -0,0 +1,203 @@
+#include "GatewayBench.h"
+#include "Bench.h"
+#include "ecat_gateway.h"
+#include "cycles.h"
+#include "rtos.h"
+#include "Shell.h"
+#include "Utilities.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Age of one signal at the send, over the updates seen
+typedef struct {
+    uint32_t updates;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} gw_bench_age_t;
+
+static ecat_cycle_t *gwBenchCycle = NULL;
+static TaskHandle_t gwBenchRxTask = NULL;
+
+static ecat_gw_image_t gwBenchImage;
+static uint64_t gwBenchLastStamp[ECAT_GW_MAX_SIGNALS];
+static gw_bench_age_t gwBenchAge[ECAT_GW_MAX_SIGNALS];
+
+static int GatewayBench_ShellCommand(int argc, char *argv[]);
+
+static const shell_command_t gwBenchCommand = { "gwbench", "[cycles] [period_us] - CAN to EtherCAT signal age", GatewayBench_ShellCommand };
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  GatewayBench_Init
+ * Description   :  Register the "gwbench" command for a frame builder whose
+ *                  process image holds the gateway image. rxTask, the task
+ *                  otherwise receiving on the interface, is suspended while the
+ *                  benchmark runs.
+ *
+ *END**************************************************************************/
+void GatewayBench_Init(ecat_cycle_t *cycle, TaskHandle_t rxTask)
+{
+    gwBenchCycle = cycle;
+    gwBenchRxTask = rxTask;
+    (void)Shell_RegisterCommand(&gwBenchCommand);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  GatewayBench_Age
+ * Description   :  Account the signals of a fresh snapshot updated since the
+ *                  previous one, aged at nowNs
+ *
+ *END**************************************************************************/
+static void GatewayBench_Age(uint64_t nowNs)
+{
+    gw_bench_age_t *age;
+    uint32_t ageUs;
+    uint8_t signal;
+
+    for (signal = 0; signal < ECAT_GW_MAX_SIGNALS; signal++) {
+        if (gwBenchImage.stamp_ns[signal] == gwBenchLastStamp[signal]) {
+            continue;
+        }
+        gwBenchLastStamp[signal] = gwBenchImage.stamp_ns[signal];
+
+        ageUs = ecat_gw_signal_age_us(&gwBenchImage, signal, nowNs);
+        if (ageUs == UINT32_MAX) {
+            continue;
+        }
+        age = &gwBenchAge[signal];
+        if (age->updates == 0U || ageUs < age->min_us) {
+            age->min_us = ageUs;
+        }
+        if (ageUs > age->max_us) {
+            age->max_us = ageUs;
+        }
+        age->total_us += ageUs;
+        age->updates++;
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  GatewayBench_Run
+ * Description   :  Scan, then run the frame builder for a number of cycles with
+ *                  the gateway image as outputs and report the signal ages
+ *
+ *END**************************************************************************/
+void GatewayBench_Run(uint32_t cycles, uint32_t periodUs)
+{
+    const uint32_t period = Cycles_FromUs(periodUs);
+    ecat_cycle_stats_t stats;
+    ecat_gw_stats_t gwBefore;
+    ecat_gw_stats_t gwAfter;
+    UBaseType_t priority;
+    uint32_t release;
+    uint32_t fresh = 0;
+    uint32_t n;
+    uint8_t signal;
+
+    if (gwBenchCycle == NULL || !enet_raw_is_link_up(gwBenchCycle->handle)) {
+        UART_LOG("gwbench: no Ethernet link\r\n");
+        return;
+    }
+    if (gwBenchCycle->image_size < ECAT_GW_IMAGE_SIZE) {
+        UART_PRINTF("gwbench: process image of %u bytes, the gateway needs %u\r\n",
+                    (unsigned)gwBenchCycle->image_size, (unsigned)ECAT_GW_IMAGE_SIZE);
+        return;
+    }
+
+    Cycles_Init();
+    if (gwBenchRxTask != NULL) {
+        vTaskSuspend(gwBenchRxTask);
+    }
+    priority = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, ETHERCAT_TASK_PRIORITY);
+    Bench_Drain(gwBenchCycle->handle);
+
+    if (ecat_cycle_scan(gwBenchCycle, GWBENCH_TIMEOUT_US) != ECAT_CYCLE_SUCCESS) {
+        UART_LOG("gwbench: no slaves\r\n");
+        goto done;
+    }
+    UART_PRINTF("Gateway image as %u byte LRW to %u slaves, %lu cycles of %lu us\r\n",
+                (unsigned)gwBenchCycle->image_size, (unsigned)gwBenchCycle->slave_count,
+                (unsigned long)cycles, (unsigned long)periodUs);
+
+    // Updates received before the run are not aged, only those the cycles pick up
+    memset(gwBenchAge, 0, sizeof(gwBenchAge));
+    (void)ecat_gw_snapshot(&gwBenchImage);
+    memcpy(gwBenchLastStamp, gwBenchImage.stamp_ns, sizeof(gwBenchLastStamp));
+    ecat_gw_get_stats(&gwBefore);
+
+    release = Cycles_Now() + period;
+    for (n = 0; n < cycles; n++) {
+        Bench_WaitUntil(release);
+        release += period;
+        if ((int32_t)(Cycles_Now() - release) >= 0) {
+            release = Cycles_Now() + period;
+        }
+
+        // Snapshot right before the frame is built: the age at the send is the CAN-to-wire latency
+        if (ecat_gw_snapshot(&gwBenchImage)) {
+            fresh++;
+            GatewayBench_Age(enet_raw_time_ns());
+        }
+        memcpy(gwBenchCycle->outputs, gwBenchImage.data, ECAT_GW_IMAGE_SIZE);
+        (void)ecat_cycle_exchange(gwBenchCycle, periodUs);
+    }
+
+    ecat_cycle_get_stats(gwBenchCycle, &stats);
+    ecat_gw_get_stats(&gwAfter);
+    UART_PRINTF("cycles %lu, lost %lu, LRW WKC %u, fresh snapshots %lu\r\n", (unsigned long)stats.cycles,
+                (unsigned long)stats.lost, (unsigned)stats.lrw_wkc, (unsigned long)fresh);
+    UART_LOG("  signal  updates  age min/avg/max us\r\n");
+    for (signal = 0; signal < ECAT_GW_MAX_SIGNALS; signal++) {
+        if (gwBenchAge[signal].updates == 0U) {
+            continue;
+        }
+        UART_PRINTF("%8u %8lu  %lu/%lu/%lu\r\n", (unsigned)signal, (unsigned long)gwBenchAge[signal].updates,
+                    (unsigned long)gwBenchAge[signal].min_us,
+                    (unsigned long)(gwBenchAge[signal].total_us / gwBenchAge[signal].updates),
+                    (unsigned long)gwBenchAge[signal].max_us);
+    }
+    UART_PRINTF("CAN frames routed %lu, unrouted %lu\r\n",
+                (unsigned long)(gwAfter.frames_routed - gwBefore.frames_routed),
+                (unsigned long)(gwAfter.frames_unrouted - gwBefore.frames_unrouted));
+
+done:
+    Bench_Drain(gwBenchCycle->handle);
+    vTaskPrioritySet(NULL, priority);
+    if (gwBenchRxTask != NULL) {
+        vTaskResume(gwBenchRxTask);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  GatewayBench_ShellCommand
+ * Description   :  "gwbench" command
+ *
+ *END**************************************************************************/
+static int GatewayBench_ShellCommand(int argc, char *argv[])
+{
+    uint32_t cycles = GWBENCH_DEFAULT_CYCLES;
+    uint32_t periodUs = GWBENCH_DEFAULT_PERIOD_US;
+
+    if (argc > 3) {
+        return SHELL_USAGE;
+    }
+    if (argc >= 2) {
+        cycles = (uint32_t)strtoul(argv[1], NULL, 0);
+        if (cycles == 0U || cycles > GWBENCH_MAX_CYCLES) {
+            return SHELL_USAGE;
+        }
+    }
+    if (argc == 3) {
+        periodUs = (uint32_t)strtoul(argv[2], NULL, 0);
+        if (periodUs < GWBENCH_MIN_PERIOD_US) {
+            return SHELL_USAGE;
+        }
+    }
+    GatewayBench_Run(cycles, periodUs);
+    return SHELL_OK;
+}
@@ -0,0 +1,188 @@
+#include "Joystick.h"
+#include "Utilities.h"
+#include "fsl_device_registers.h"
+#include "cycles.h"
+
+// Both axes share the same shaping
+static const joystick_axis_cfg_t joyAxisCfg =
+    JOY_AXIS_CONFIG(JOY_RAW_CENTER, JOY_RAW_HALF_RANGE, JOY_DEADBAND_Q15, JOY_MAX_SETPOINT, JOY_RATE_LIMIT);
+
+static joystick_axis_t joyX;
+static joystick_axis_t joyY;
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Joystick_ToQ15
+ * Description   :  Centre and normalise a raw axis value to Q15, then apply the deadband
+ *                  and re-expand the remaining travel back to full scale
+ *
+ *END**************************************************************************/
+int16_t Joystick_ToQ15(const joystick_axis_cfg_t *cfg, uint16_t raw)
+{
+    int32_t delta = (int32_t)raw - cfg->center;
+    uint32_t magnitude;
+
+    if (delta > cfg->halfRange) {
+        delta = cfg->halfRange;
+    } else if (delta < -cfg->halfRange) {
+        delta = -cfg->halfRange;
+    }
+
+    // |delta| * normMul stays below 2^31 for any halfRange
+    magnitude = ((uint32_t)((delta < 0) ? -delta : delta) * (uint32_t)cfg->normMul) >> 16;
+
+    if (magnitude <= (uint32_t)cfg->deadband) {
+        return 0;
+    }
+
+    magnitude = ((magnitude - (uint32_t)cfg->deadband) * cfg->deadbandMul) >> 15;
+    if (magnitude > JOY_Q15_MAX) {
+        magnitude = JOY_Q15_MAX;
+    }
+
+    return (delta < 0) ? -(int16_t)magnitude : (int16_t)magnitude;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Joystick_Process
+ * Description   :  Full pipeline for one axis: Q15 conversion, scaling to the drive
+ *                  setpoint and rate limiting
+ *
+ *END**************************************************************************/
+int16_t Joystick_Process(const joystick_axis_cfg_t *cfg, joystick_axis_t *axis, uint16_t raw)
+{
+    int32_t target = ((int32_t)Joystick_ToQ15(cfg, raw) * cfg->maxSetpoint) >> 15;
+    int32_t step = target - axis->setpoint;
+
+    if (step > cfg->rateLimit) {
+        step = cfg->rateLimit;
+    } else if (step < -cfg->rateLimit) {
+        step = -cfg->rateLimit;
+    }
+
+    axis->setpoint = (int16_t)(axis->setpoint + step);
+    return axis->setpoint;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Joystick_Update
+ * Description   :  Run one received MOVES sample of both axes through the pipeline.
+ *                  Called once per sample, so the rate limit is per sample and not
+ *                  per wake of whoever reads the setpoints.
+ *
+ *END**************************************************************************/
+void Joystick_Update(uint16_t rawX, uint16_t rawY)
+{
+    (void)Joystick_Process(&joyAxisCfg, &joyX, rawX);
+    (void)Joystick_Process(&joyAxisCfg, &joyY, rawY);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Joystick_GetSetpoints
+ * Description   :  Drive setpoints after the last sample
+ *
+ *END**************************************************************************/
+void Joystick_GetSetpoints(int16_t *setpointX, int16_t *setpointY)
+{
+    *setpointX = joyX.setpoint;
+    *setpointY = joyY.setpoint;
+}
+
+#if JOYSTICK_BENCHMARK
+#define JOY_BENCH_ITERATIONS    (1000U)
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Joystick_TargetFloat
+ * Description   :  Reference float version of the conversion, starting from the previous
+ *                  (float)raw / 100.0f decode
+ *
+ *END**************************************************************************/
+static float Joystick_TargetFloat(uint16_t raw)
+{
+    float value = (float)raw / 100.0f - 50.0f;
+    float magnitude = (value < 0.0f) ? -value : value;
+    const float deadband = 50.0f * JOY_DEADBAND_Q15 / (float)JOY_Q15_MAX;
+
+    if (magnitude > 50.0f) {
+        magnitude = 50.0f;
+    }
+    magnitude = (magnitude <= deadband) ? 0.0f : (magnitude - deadband) / (50.0f - deadband);
+
+    return ((value < 0.0f) ? -magnitude : magnitude) * JOY_MAX_SETPOINT;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Joystick_ProcessFloat
+ * Description   :  Reference float version of the pipeline, with the same rate limiter
+ *
+ *END**************************************************************************/
+static int16_t Joystick_ProcessFloat(float *setpoint, uint16_t raw)
+{
+    float step = Joystick_TargetFloat(raw) - *setpoint;
+
+    if (step > JOY_RATE_LIMIT) {
+        step = JOY_RATE_LIMIT;
+    } else if (step < -JOY_RATE_LIMIT) {
+        step = -JOY_RATE_LIMIT;
+    }
+    *setpoint += step;
+
+    return (int16_t)*setpoint;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Joystick_Benchmark
+ * Description   :  Time both pipelines over a full stroke sweep with the DWT cycle counter
+ *                  and print cycles per sample and the worst disagreement in setpoint units
+ *
+ *END**************************************************************************/
+void Joystick_Benchmark(void)
+{
+    volatile int16_t sink;
+    joystick_axis_t axis = {0};
+    float setpoint = 0.0f;
+    uint32_t fixedCycles;
+    uint32_t floatCycles;
+    uint32_t start;
+    int32_t maxError = 0;
+    int32_t error;
+    uint32_t i;
+
+    Cycles_Init();
+
+    start = Cycles_Now();
+    for (i = 0; i < JOY_BENCH_ITERATIONS; i++) {
+        sink = Joystick_Process(&joyAxisCfg, &axis, (uint16_t)(i * 10U));
+    }
+    fixedCycles = Cycles_Now() - start;
+
+    start = Cycles_Now();
+    for (i = 0; i < JOY_BENCH_ITERATIONS; i++) {
+        sink = Joystick_ProcessFloat(&setpoint, (uint16_t)(i * 10U));
+    }
+    floatCycles = Cycles_Now() - start;
+    (void)sink;
+
+    // Accuracy of the conversion alone, without the rate limiter
+    for (i = 0; i <= 10000U; i += 10U) {
+        error = (((int32_t)Joystick_ToQ15(&joyAxisCfg, (uint16_t)i) * JOY_MAX_SETPOINT) >> 15) -
+                (int32_t)Joystick_TargetFloat((uint16_t)i);
+        if (error < 0) {
+            error = -error;
+        }
+        if (error > maxError) {
+            maxError = error;
+        }
+    }
+
+    UART_PRINTF("Joystick: fixed %lu cycles/sample, float %lu cycles/sample, max error %ld\r\n",
+                (unsigned long)(fixedCycles / JOY_BENCH_ITERATIONS),
+                (unsigned long)(floatCycles / JOY_BENCH_ITERATIONS), (long)maxError);
+}
+#endif /* JOYSTICK_BENCHMARK */
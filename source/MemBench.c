@@ -0,0 +1,182 @@
+#include "MemBench.h"
+#include "mem_placement.h"
+#include "cycles.h"
+#include "Shell.h"
+#include "Utilities.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MEMBENCH_WORDS              (MEMBENCH_BUFFER_SIZE / sizeof(uint32_t))
+
+typedef enum {
+    MEMBENCH_READ = 0,              // Word sum, like parsing a received frame
+    MEMBENCH_WRITE,                 // Word stores, like building a frame
+    MEMBENCH_COPY,                  // memcpy out of SRAM_U, like taking a frame off the DMA ring
+    MEMBENCH_KERNEL_COUNT
+} membench_kernel_t;
+
+typedef struct {
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+} membench_result_t;
+
+static const char *const memBenchKernelNames[MEMBENCH_KERNEL_COUNT] = { "read", "write", "copy" };
+
+// The source of the copy sits in SRAM_U like the ENET DMA buffers
+static uint32_t memBenchSource[MEMBENCH_WORDS];
+static uint32_t memBenchUpper[MEMBENCH_WORDS];
+static uint32_t memBenchLower[MEMBENCH_WORDS] MEM_SRAM_L_BSS;
+static volatile uint32_t memBenchSink;
+
+static int MemBench_ShellCommand(int argc, char *argv[]);
+
+static const shell_command_t memBenchCommand = { "membench", "[runs] - SRAM_L vs SRAM_U access cycles", MemBench_ShellCommand };
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  MemBench_Init
+ * Description   :  Register the "membench" command
+ *
+ *END**************************************************************************/
+void MemBench_Init(void)
+{
+    (void)Shell_RegisterCommand(&memBenchCommand);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  MemBench_Region
+ * Description   :  Name of the SRAM half holding an address
+ *
+ *END**************************************************************************/
+static const char *MemBench_Region(const void *address)
+{
+    uintptr_t a = (uintptr_t)address;
+
+    if (a >= 0x1FFF0000U && a < 0x20000000U) {
+        return "SRAM_L";
+    }
+    if (a >= 0x20000000U && a < 0x20030000U) {
+        return "SRAM_U";
+    }
+    return "?";
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  MemBench_Kernel
+ * Description   :  Cycles of one kernel over one buffer
+ *
+ *END**************************************************************************/
+static uint32_t MemBench_Kernel(membench_kernel_t kernel, uint32_t *buffer)
+{
+    uint32_t start;
+    uint32_t elapsed;
+    uint32_t sum = 0;
+    uint32_t i;
+
+    start = Cycles_Now();
+    switch (kernel) {
+    case MEMBENCH_READ:
+        for (i = 0; i < MEMBENCH_WORDS; i++) {
+            sum += buffer[i];
+        }
+        break;
+    case MEMBENCH_WRITE:
+        for (i = 0; i < MEMBENCH_WORDS; i++) {
+            buffer[i] = i;
+        }
+        break;
+    default:
+        memcpy(buffer, memBenchSource, MEMBENCH_BUFFER_SIZE);
+        break;
+    }
+    elapsed = Cycles_Now() - start;
+
+    memBenchSink = sum;
+    return elapsed;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  MemBench_Add
+ * Description   :  Fold one sample into a result
+ *
+ *END**************************************************************************/
+static void MemBench_Add(membench_result_t *result, uint32_t cycles)
+{
+    if (cycles < result->min_cycles) {
+        result->min_cycles = cycles;
+    }
+    if (cycles > result->max_cycles) {
+        result->max_cycles = cycles;
+    }
+    result->total_cycles += cycles;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  MemBench_Run
+ * Description   :  Run every kernel runs times on each half, alternating so both
+ *                  see the same bus traffic, and print min/mean/max cycles
+ *
+ *END**************************************************************************/
+void MemBench_Run(uint32_t runs)
+{
+    membench_result_t lower[MEMBENCH_KERNEL_COUNT];
+    membench_result_t upper[MEMBENCH_KERNEL_COUNT];
+    uint32_t stackProbe = 0;
+    uint32_t k;
+    uint32_t r;
+
+    Cycles_Init();
+    for (k = 0; k < MEMBENCH_KERNEL_COUNT; k++) {
+        lower[k].min_cycles = UINT32_MAX;
+        lower[k].max_cycles = 0;
+        lower[k].total_cycles = 0;
+        upper[k] = lower[k];
+    }
+
+    for (r = 0; r < runs; r++) {
+        for (k = 0; k < MEMBENCH_KERNEL_COUNT; k++) {
+            MemBench_Add(&lower[k], MemBench_Kernel((membench_kernel_t)k, memBenchLower));
+            MemBench_Add(&upper[k], MemBench_Kernel((membench_kernel_t)k, memBenchUpper));
+        }
+    }
+
+    UART_PRINTF("%lu B x %lu runs, cycles min/mean/max\r\n",
+                (unsigned long)MEMBENCH_BUFFER_SIZE, (unsigned long)runs);
+    for (k = 0; k < MEMBENCH_KERNEL_COUNT; k++) {
+        UART_PRINTF("%-5s SRAM_L %lu/%lu/%lu  SRAM_U %lu/%lu/%lu\r\n", memBenchKernelNames[k],
+                    (unsigned long)lower[k].min_cycles, (unsigned long)(lower[k].total_cycles / runs),
+                    (unsigned long)lower[k].max_cycles, (unsigned long)upper[k].min_cycles,
+                    (unsigned long)(upper[k].total_cycles / runs), (unsigned long)upper[k].max_cycles);
+    }
+    UART_PRINTF("Placement %s, task stack in %s, SRAM_L buffer in %s\r\n",
+                MEM_PLACEMENT_ENABLED ? "on" : "off", MemBench_Region(&stackProbe),
+                MemBench_Region(memBenchLower));
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  MemBench_ShellCommand
+ * Description   :  "membench" command
+ *
+ *END**************************************************************************/
+static int MemBench_ShellCommand(int argc, char *argv[])
+{
+    uint32_t runs = MEMBENCH_DEFAULT_RUNS;
+
+    if (argc > 2) {
+        return SHELL_USAGE;
+    }
+    if (argc == 2) {
+        runs = (uint32_t)strtoul(argv[1], NULL, 0);
+        if (runs == 0U || runs > MEMBENCH_MAX_RUNS) {
+            return SHELL_USAGE;
+        }
+    }
+    MemBench_Run(runs);
+    return SHELL_OK;
+}
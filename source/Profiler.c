@@ -0,0 +1,180 @@
+#include "Profiler.h"
+
+#if PROFILER_ENABLED
+
+#include "Shell.h"
+#include "Utilities.h"
+#include "FreeRTOS.h"
+#include "mem_placement.h"
+#include <string.h>
+#include <stdio.h>
+
+static prof_stats_t profStats[PROF_PROBE_COUNT] MEM_SRAM_L_BSS;
+static uint32_t profOverhead = 0;       // Cycles of an empty begin/end pair
+
+static const char *const profProbeNames[PROF_PROBE_COUNT] = {
+    "enet_rx", "enet_tx", "log_write", "log_defer", "log_flush", "gw_route"
+};
+
+static int Profiler_ShellCommand(int argc, char *argv[]);
+
+static const shell_command_t profCommand = { "prof", "[reset] - hot path cycle counts", Profiler_ShellCommand };
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Profiler_Log2Bucket
+ * Description   :  Histogram bucket of a cycle count
+ *
+ *END**************************************************************************/
+static uint32_t Profiler_Log2Bucket(uint32_t cycles)
+{
+    uint32_t bucket = (cycles == 0U) ? 0U : (32U - (uint32_t)__builtin_clz(cycles));
+
+    return (bucket < PROF_HIST_BUCKETS) ? bucket : (PROF_HIST_BUCKETS - 1U);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Profiler_Reset
+ * Description   :  Clear the statistics of every probe
+ *
+ *END**************************************************************************/
+void Profiler_Reset(void)
+{
+    UBaseType_t mask;
+    uint32_t i;
+
+    mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    memset(profStats, 0, sizeof(profStats));
+    for (i = 0; i < PROF_PROBE_COUNT; i++) {
+        profStats[i].min_cycles = UINT32_MAX;
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Profiler_Init
+ * Description   :  Start the cycle counter, measure the cost of an empty probe
+ *                  so it can be taken off every sample, and register "prof"
+ *
+ *END**************************************************************************/
+void Profiler_Init(void)
+{
+    uint32_t i;
+
+    Cycles_Init();
+    Profiler_Reset();
+
+    profOverhead = UINT32_MAX;
+    for (i = 0; i < 8U; i++) {
+        uint32_t start = Cycles_Now();
+        uint32_t cycles = Cycles_Now() - start;
+
+        if (cycles < profOverhead) {
+            profOverhead = cycles;
+        }
+    }
+
+    (void)Shell_RegisterCommand(&profCommand);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Profiler_Record
+ * Description   :  Account one sample. Masks interrupts for the few stores so
+ *                  probes shared by tasks and ISRs stay consistent.
+ *
+ *END**************************************************************************/
+MEM_RAMFUNC void Profiler_Record(prof_probe_t probe, uint32_t cycles)
+{
+    prof_stats_t *stats = &profStats[probe];
+    UBaseType_t mask;
+
+    cycles = (cycles > profOverhead) ? (cycles - profOverhead) : 0U;
+
+    mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    stats->count++;
+    stats->total_cycles += cycles;
+    if (cycles < stats->min_cycles) {
+        stats->min_cycles = cycles;
+    }
+    if (cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+    stats->hist[Profiler_Log2Bucket(cycles)]++;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Profiler_GetStats
+ * Description   :  Consistent copy of the statistics of one probe
+ *
+ *END**************************************************************************/
+void Profiler_GetStats(prof_probe_t probe, prof_stats_t *stats)
+{
+    UBaseType_t mask;
+
+    mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    memcpy(stats, &profStats[probe], sizeof(*stats));
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Profiler_Show
+ * Description   :  This function is a simple debugging function that outputs the
+ *                  cycle counts of every probe that has samples on the UART
+ *
+ *END**************************************************************************/
+void Profiler_Show(void)
+{
+    prof_stats_t stats;
+    char str[160];
+    uint32_t i;
+    uint32_t b;
+    int len;
+
+    UART_PRINTF("Probe overhead %lu cycles (removed), %lu cycles/us\r\n",
+                (unsigned long)profOverhead, (unsigned long)CYCLES_PER_US);
+
+    for (i = 0; i < PROF_PROBE_COUNT; i++) {
+        Profiler_GetStats((prof_probe_t)i, &stats);
+        if (stats.count == 0U) {
+            continue;
+        }
+
+        UART_PRINTF("%-9s %lu calls, min %lu, mean %lu, max %lu cycles\r\n",
+                    profProbeNames[i], (unsigned long)stats.count, (unsigned long)stats.min_cycles,
+                    (unsigned long)(stats.total_cycles / stats.count), (unsigned long)stats.max_cycles);
+
+        len = sprintf(str, "   hist");
+        for (b = 0; b < PROF_HIST_BUCKETS && len < (int)sizeof(str) - 14; b++) {
+            len += sprintf(&str[len], " %lu", (unsigned long)stats.hist[b]);
+        }
+        sprintf(&str[len], "\r\n");
+        UART_LOG(str);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Profiler_ShellCommand
+ * Description   :  "prof" command: show or clear the probe statistics
+ *
+ *END**************************************************************************/
+static int Profiler_ShellCommand(int argc, char *argv[])
+{
+    if (argc == 1) {
+        Profiler_Show();
+        return SHELL_OK;
+    }
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        Profiler_Reset();
+        return SHELL_OK;
+    }
+    return SHELL_USAGE;
+}
+
+#endif /* PROFILER_ENABLED */
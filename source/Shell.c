@@ -0,0 +1,254 @@
+#include "Shell.h"
+#include "UART_HAL.h"
+#include "Utilities.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <string.h>
+#include <stdlib.h>
+
+// Commands are hashed by name with open addressing, so dispatch is one hash of
+// the first word and usually a single string compare
+static const shell_command_t *commandHash[SHELL_HASH_SIZE];
+static const shell_command_t *commandList[SHELL_MAX_COMMANDS];     // Registration order, for help
+static uint32_t commandCount = 0;
+
+static int Shell_Help(int argc, char *argv[]);
+static int Shell_Log(int argc, char *argv[]);
+
+static const shell_command_t helpCommand = { "help", "- list commands", Shell_Help };
+static const shell_command_t logCommand = { "log", "<app|log|enet|ecat|can|canopen|all> <0..5> - set a log level", Shell_Log };
+
+static const char *const logModuleNames[LOG_MODULE_COUNT] = { "app", "log", "enet", "ecat", "can", "canopen" };
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Shell_Hash
+ * Description   :  FNV-1a hash of a command name
+ *
+ *END**************************************************************************/
+static uint32_t Shell_Hash(const char *name)
+{
+    uint32_t hash = 2166136261UL;
+
+    while (*name != '\0') {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Shell_Find
+ * Description   :  Look up a command by name, NULL if it is not registered
+ *
+ *END**************************************************************************/
+static const shell_command_t *Shell_Find(const char *name)
+{
+    uint32_t slot = Shell_Hash(name) & (SHELL_HASH_SIZE - 1U);
+    uint32_t i;
+
+    for (i = 0; i < SHELL_HASH_SIZE; i++) {
+        const shell_command_t *command = commandHash[slot];
+
+        if (command == NULL) {
+            return NULL;
+        }
+        if (strcmp(command->name, name) == 0) {
+            return command;
+        }
+        slot = (slot + 1U) & (SHELL_HASH_SIZE - 1U);
+    }
+    return NULL;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Shell_RegisterCommand
+ * Description   :  Add a command to the table. Returns kStatus_Fail if the table is
+ *                  full or the name is already taken.
+ *
+ *END**************************************************************************/
+status_t Shell_RegisterCommand(const shell_command_t *command)
+{
+    uint32_t slot;
+    status_t status = kStatus_Success;
+
+    if (command == NULL || command->name == NULL || command->handler == NULL) {
+        return kStatus_InvalidArgument;
+    }
+
+    slot = Shell_Hash(command->name) & (SHELL_HASH_SIZE - 1U);
+
+    taskENTER_CRITICAL();
+    if (commandCount >= SHELL_MAX_COMMANDS || Shell_Find(command->name) != NULL) {
+        status = kStatus_Fail;
+    } else {
+        while (commandHash[slot] != NULL) {
+            slot = (slot + 1U) & (SHELL_HASH_SIZE - 1U);
+        }
+        commandList[commandCount++] = command;
+        commandHash[slot] = command;
+    }
+    taskEXIT_CRITICAL();
+
+    return status;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Shell_ParseU32
+ * Description   :  Parse a decimal or 0x prefixed hexadecimal number
+ *
+ *END**************************************************************************/
+bool Shell_ParseU32(const char *text, uint32_t *value)
+{
+    char *end;
+
+    if (text == NULL || *text == '\0') {
+        return false;
+    }
+    *value = strtoul(text, &end, 0);
+    return (*end == '\0');
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Shell_Execute
+ * Description   :  Split a line into arguments and run the matching command
+ *
+ *END**************************************************************************/
+int Shell_Execute(char *line)
+{
+    char *argv[SHELL_MAX_ARGS];
+    int argc = 0;
+    const shell_command_t *command;
+    int result;
+
+    while (*line != '\0' && argc < (int)SHELL_MAX_ARGS) {
+        while (*line == ' ') {
+            *line++ = '\0';
+        }
+        if (*line == '\0') {
+            break;
+        }
+        argv[argc++] = line;
+        while (*line != '\0' && *line != ' ') {
+            line++;
+        }
+    }
+
+    if (argc == 0) {
+        return SHELL_OK;
+    }
+
+    command = Shell_Find(argv[0]);
+    if (command == NULL) {
+        UART_PRINTF("Unknown command '%s', try 'help'\r\n", argv[0]);
+        return SHELL_USAGE;
+    }
+
+    result = command->handler(argc, argv);
+    if (result == SHELL_USAGE) {
+        UART_PRINTF("usage: %s %s\r\n", command->name, command->help);
+    }
+    return result;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Shell_Help
+ * Description   :  "help" command: list every registered command
+ *
+ *END**************************************************************************/
+static int Shell_Help(int argc, char *argv[])
+{
+    uint32_t i;
+
+    (void)argc;
+    (void)argv;
+
+    for (i = 0; i < commandCount; i++) {
+        UART_PRINTF("  %-8s %s\r\n", commandList[i]->name, commandList[i]->help);
+    }
+    return SHELL_OK;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Shell_Log
+ * Description   :  "log" command: set the runtime log level of a module
+ *
+ *END**************************************************************************/
+static int Shell_Log(int argc, char *argv[])
+{
+    uint32_t level;
+    uint32_t i;
+
+    if (argc != 3 || !Shell_ParseU32(argv[2], &level) || level > LOG_LEVEL_VERBOSE) {
+        return SHELL_USAGE;
+    }
+
+    if (strcmp(argv[1], "all") == 0) {
+        UART_LogSetLevel(LOG_MODULE_COUNT, (uint8_t)level);
+        return SHELL_OK;
+    }
+    for (i = 0; i < LOG_MODULE_COUNT; i++) {
+        if (strcmp(argv[1], logModuleNames[i]) == 0) {
+            UART_LogSetLevel((log_module_t)i, (uint8_t)level);
+            return SHELL_OK;
+        }
+    }
+    return SHELL_USAGE;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  shell_task
+ * Description   :  Line editor on UART0. Sleeps until the UART interrupt queues bytes,
+ *                  echoes them, handles backspace and runs the line on CR or LF.
+ *                  Runs at the lowest application priority so a command can never
+ *                  delay the EtherCAT or CAN tasks.
+ *
+ *END**************************************************************************/
+void shell_task(void *pvParameters)
+{
+    static char line[SHELL_LINE_SIZE];
+    uint32_t length = 0;
+    char echo[2] = { 0, 0 };
+    uint8_t ch;
+
+    (void)pvParameters;
+
+    (void)Shell_RegisterCommand(&helpCommand);
+    (void)Shell_RegisterCommand(&logCommand);
+
+    UART_RxInit(xTaskGetCurrentTaskHandle());
+    UART_LOG("Shell ready, type 'help'\r\n" SHELL_PROMPT);
+
+    while (1) {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (UART_RxGetChar(&ch)) {
+            if (ch == '\r' || ch == '\n') {
+                if (length == 0U && ch == '\n') {
+                    continue;   // LF of a CR LF pair
+                }
+                UART_LOG("\r\n");
+                line[length] = '\0';
+                (void)Shell_Execute(line);
+                length = 0;
+                UART_LOG(SHELL_PROMPT);
+            } else if (ch == '\b' || ch == 0x7FU) {
+                if (length > 0U) {
+                    length--;
+                    UART_LOG("\b \b");
+                }
+            } else if (ch >= ' ' && length < (SHELL_LINE_SIZE - 1U)) {
+                line[length++] = (char)ch;
+                echo[0] = (char)ch;
+                UART_LOG(echo);
+            }
+        }
+    }
+}
@@ -0,0 +1,319 @@
+#include "Trace.h"
+#include "Shell.h"
+#include "Utilities.h"
+#include "cycles.h"
+#include "mem_placement.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <string.h>
+#include <stdio.h>
+
+// Software extension of the cycle counter for the run-time stats
+static uint32_t runTimeLast = 0;
+static uint32_t runTimeHigh = 0;
+
+// Task table of the shell commands, with the run time at the previous "tasks"
+static TaskStatus_t taskStatus[TRACE_MAX_TASKS];
+static UBaseType_t taskPrevNumber[TRACE_MAX_TASKS];
+static uint32_t taskPrevRunTime[TRACE_MAX_TASKS];
+static UBaseType_t taskPrevCount = 0;
+static uint32_t taskPrevTotal = 0;
+
+static int Trace_TasksCommand(int argc, char *argv[]);
+
+static const shell_command_t tasksCommand = { "tasks", "- CPU load and stack margin per task", Trace_TasksCommand };
+
+#if TRACE_ENABLED
+static trace_event_t traceRing[TRACE_RING_SIZE] MEM_SRAM_L_BSS;   // Written on every context switch
+static uint32_t traceCount = 0;         // Events written since Trace_Start, runs past the ring size
+static volatile bool traceRunning = false;
+
+static int Trace_TraceCommand(int argc, char *argv[]);
+
+static const shell_command_t traceCommand = { "trace", "[start|stop|dump] - kernel event recorder", Trace_TraceCommand };
+#endif
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_Init
+ * Description   :  Register the shell commands
+ *
+ *END**************************************************************************/
+void Trace_Init(void)
+{
+    (void)Shell_RegisterCommand(&tasksCommand);
+#if TRACE_ENABLED
+    (void)Shell_RegisterCommand(&traceCommand);
+#endif
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_RunTimeInit
+ * Description   :  Run-time counter setup, called by vTaskStartScheduler
+ *
+ *END**************************************************************************/
+void Trace_RunTimeInit(void)
+{
+    Cycles_Init();
+    runTimeLast = Cycles_Now();
+    runTimeHigh = 0;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_RunTimeCounter
+ * Description   :  Run-time counter of the kernel: the extended cycle count
+ *                  >> TRACE_RUNTIME_SHIFT. Called on every context switch and
+ *                  by uxTaskGetSystemState, from any context.
+ *
+ *END**************************************************************************/
+uint32_t Trace_RunTimeCounter(void)
+{
+    UBaseType_t mask;
+    uint32_t now;
+    uint64_t cycles;
+
+    mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    now = Cycles_Now();
+    if (now < runTimeLast) {
+        runTimeHigh++;
+    }
+    runTimeLast = now;
+    cycles = ((uint64_t)runTimeHigh << 32) | now;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+
+    return (uint32_t)(cycles >> TRACE_RUNTIME_SHIFT);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_PrevRunTime
+ * Description   :  Run time of a task at the previous report, 0 if it is new
+ *
+ *END**************************************************************************/
+static uint32_t Trace_PrevRunTime(UBaseType_t taskNumber)
+{
+    UBaseType_t i;
+
+    for (i = 0; i < taskPrevCount; i++) {
+        if (taskPrevNumber[i] == taskNumber) {
+            return taskPrevRunTime[i];
+        }
+    }
+    return 0;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_ShowTasks
+ * Description   :  This function is a simple debugging function that outputs the
+ *                  CPU load since the previous call (since boot the first time)
+ *                  and the lowest free stack of every task on the UART
+ *
+ *END**************************************************************************/
+void Trace_ShowTasks(void)
+{
+    static const char stateNames[] = { 'X', 'R', 'B', 'S', 'D', '?' };
+    uint32_t total;
+    uint32_t elapsed;
+    uint32_t permille;
+    UBaseType_t count;
+    UBaseType_t i;
+
+    count = uxTaskGetSystemState(taskStatus, TRACE_MAX_TASKS, &total);
+    if (count == 0U) {
+        UART_PRINTF("More than %u tasks\r\n", (unsigned)TRACE_MAX_TASKS);
+        return;
+    }
+    elapsed = total - taskPrevTotal;
+
+    UART_LOG("Task             Pri St   CPU   Stack free\r\n");
+    for (i = 0; i < count; i++) {
+        const TaskStatus_t *task = &taskStatus[i];
+        uint32_t state = ((uint32_t)task->eCurrentState < sizeof(stateNames)) ? (uint32_t)task->eCurrentState : (sizeof(stateNames) - 1U);
+
+        permille = (elapsed == 0U) ? 0U :
+                   (uint32_t)(((uint64_t)(task->ulRunTimeCounter - Trace_PrevRunTime(task->xTaskNumber)) * 1000U) / elapsed);
+
+        UART_PRINTF("%-16s %3lu  %c %3lu.%lu%% %6lu B\r\n", task->pcTaskName,
+                    (unsigned long)task->uxCurrentPriority, stateNames[state],
+                    (unsigned long)(permille / 10U), (unsigned long)(permille % 10U),
+                    (unsigned long)(task->usStackHighWaterMark * sizeof(StackType_t)));
+    }
+    UART_PRINTF("Over the last %lu ms\r\n",
+                (unsigned long)(((uint64_t)elapsed << TRACE_RUNTIME_SHIFT) / (SystemCoreClock / 1000U)));
+
+    for (i = 0; i < count; i++) {
+        taskPrevNumber[i] = taskStatus[i].xTaskNumber;
+        taskPrevRunTime[i] = taskStatus[i].ulRunTimeCounter;
+    }
+    taskPrevCount = count;
+    taskPrevTotal = total;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_TasksCommand
+ * Description   :  "tasks" command
+ *
+ *END**************************************************************************/
+static int Trace_TasksCommand(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    Trace_ShowTasks();
+    return SHELL_OK;
+}
+
+#if TRACE_ENABLED
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_Write
+ * Description   :  Append one event. Interrupts up to the syscall priority are
+ *                  masked so nested writers keep the ring in time order.
+ *
+ *END**************************************************************************/
+static MEM_RAMFUNC void Trace_Write(trace_event_type_t type, uint32_t id)
+{
+    trace_event_t *event;
+    UBaseType_t mask;
+
+    mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    event = &traceRing[traceCount & (TRACE_RING_SIZE - 1U)];
+    event->timestamp = Cycles_Now();
+    event->type = (uint8_t)type;
+    event->id = (uint8_t)id;
+    event->reserved = 0;
+    traceCount++;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_TaskSwitchedIn
+ * Description   :  traceTASK_SWITCHED_IN hook, runs in the context switch
+ *
+ *END**************************************************************************/
+MEM_RAMFUNC void Trace_TaskSwitchedIn(uint32_t taskNumber)
+{
+    if (traceRunning) {
+        Trace_Write(TRACE_EVENT_SWITCH_IN, taskNumber);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_IsrEvent
+ * Description   :  ISR entry or exit marker
+ *
+ *END**************************************************************************/
+MEM_RAMFUNC void Trace_IsrEvent(trace_event_type_t type, trace_isr_t isr)
+{
+    if (traceRunning) {
+        Trace_Write(type, isr);
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_Start
+ * Description   :  Clear the ring and record from now on. The first event is the
+ *                  calling task so the host knows who runs until the next switch.
+ *
+ *END**************************************************************************/
+void Trace_Start(void)
+{
+    traceRunning = false;
+    traceCount = 0;
+    Trace_Write(TRACE_EVENT_SWITCH_IN, uxTaskGetTaskNumber(xTaskGetCurrentTaskHandle()));
+    traceRunning = true;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_Stop
+ * Description   :  Freeze the ring
+ *
+ *END**************************************************************************/
+void Trace_Stop(void)
+{
+    traceRunning = false;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_Dump
+ * Description   :  Print the task names and the last TRACE_RING_SIZE events as
+ *                  text lines for tools/tracedump. Waits for the UART every few
+ *                  lines so the log ring never overflows: shell task only.
+ *
+ *END**************************************************************************/
+void Trace_Dump(void)
+{
+    char str[UART_MAX_LOG_ENTRY_SIZE];
+    uint32_t first;
+    uint32_t index;
+    uint32_t total;
+    UBaseType_t count;
+    UBaseType_t i;
+    int len;
+
+    Trace_Stop();
+
+    first = (traceCount > TRACE_RING_SIZE) ? (traceCount - TRACE_RING_SIZE) : 0U;
+    UART_PRINTF("TRACE BEGIN %lu %lu\r\n", (unsigned long)SystemCoreClock, (unsigned long)(traceCount - first));
+
+    count = uxTaskGetSystemState(taskStatus, TRACE_MAX_TASKS, &total);
+    for (i = 0; i < count; i++) {
+        UART_PRINTF("N %lu %s\r\n", (unsigned long)taskStatus[i].xTaskNumber, taskStatus[i].pcTaskName);
+    }
+
+    for (index = first; index < traceCount; ) {
+        len = sprintf(str, "E");
+        for (i = 0; i < 4U && index < traceCount; i++, index++) {
+            const trace_event_t *event = &traceRing[index & (TRACE_RING_SIZE - 1U)];
+
+            len += sprintf(&str[len], " %08lX%02X%02X", (unsigned long)event->timestamp, event->type, event->id);
+        }
+        sprintf(&str[len], "\r\n");
+        UART_LOG(str);
+
+        if (((index - first) % 64U) == 0U) {
+            while (UART_LogHasMessages()) {
+                vTaskDelay(pdMS_TO_TICKS(5));
+            }
+        }
+    }
+    UART_LOG("TRACE END\r\n");
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name :  Trace_TraceCommand
+ * Description   :  "trace" command: control and dump the recorder
+ *
+ *END**************************************************************************/
+static int Trace_TraceCommand(int argc, char *argv[])
+{
+    if (argc == 1) {
+        UART_PRINTF("Trace %s, %lu events\r\n", traceRunning ? "running" : "stopped",
+                    (unsigned long)((traceCount > TRACE_RING_SIZE) ? TRACE_RING_SIZE : traceCount));
+        return SHELL_OK;
+    }
+    if (argc != 2) {
+        return SHELL_USAGE;
+    }
+    if (strcmp(argv[1], "start") == 0) {
+        Trace_Start();
+    } else if (strcmp(argv[1], "stop") == 0) {
+        Trace_Stop();
+    } else if (strcmp(argv[1], "dump") == 0) {
+        Trace_Dump();
+    } else {
+        return SHELL_USAGE;
+    }
+    return SHELL_OK;
+}
+#endif /* TRACE_ENABLED */
@@ -1,16 +1,24 @@
 #include "UART_HAL.h"
+#include "Utilities.h"
+#include "Trace.h"
 
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
 #define UART_INSTANCE          UART0
 #define UART_CLK_FREQ          CLOCK_GetFreq(UART0_CLK_SRC)
+#define UART_TX_FIFO_SIZE      FSL_FEATURE_UART_FIFO_SIZEn(UART0)
 
 /*******************************************************************************
  * Variables
  ******************************************************************************/
-uint8_t buffer[BUFFER_SIZE];
-uint8_t bufferIdx = 0;
+
+// RX ring, written by the UART interrupt and read by one task
+static volatile uint8_t rxRing[UART_RX_RING_SIZE];
+static volatile uint32_t rxHead = 0;
+static volatile uint32_t rxTail = 0;
+static volatile uint32_t rxDropped = 0;
+static TaskHandle_t rxNotifyTask = NULL;
 
 /*******************************************************************************
  * Reception Functions
@@ -18,58 +26,56 @@ uint8_t bufferIdx = 0;
 
 /*FUNCTION**********************************************************************
  *
- * Function Name : UART_DataAvailable
- * Description   : Check if data is available to read (non-blocking check)
+ * Function Name : UART_RxInit
+ * Description   : Enable interrupt-driven reception into the RX ring. The given
+ *                 task is notified (task notification count) when bytes arrive.
  *
- * Auteur: Simon Falardeau
  *END**************************************************************************/
-bool UART_DataAvailable(void)
+void UART_RxInit(TaskHandle_t notifyTask)
 {
-    return (UART_GetStatusFlags(UART_INSTANCE) & kUART_RxDataRegFullFlag);
+    rxNotifyTask = notifyTask;
+    rxHead = 0;
+    rxTail = 0;
+
+    // Drop anything received before the ring existed
+    UART_INSTANCE->CFIFO |= UART_CFIFO_RXFLUSH_MASK;
+    (void)UART_INSTANCE->S1;
+    (void)UART_INSTANCE->D;
+
+    // C2 is also written by the interrupt, keep it out of the read-modify-write
+    DisableIRQ(UART0_RX_TX_IRQn);
+    UART_INSTANCE->C2 |= UART_C2_RIE_MASK;
+    EnableIRQ(UART0_RX_TX_IRQn);
 }
 
 /*FUNCTION**********************************************************************
  *
- * Function Name : UART_ReadLine
- * Description   : Read a complete line from UART (up to newline or buffer full)
- *                 This is blocking - only call when data is available
+ * Function Name : UART_RxGetChar
+ * Description   : Take one byte from the RX ring. Never blocks.
  *
- * Auteur: Simon Falardeau
  *END**************************************************************************/
-size_t UART_ReadLine(void)
+bool UART_RxGetChar(uint8_t *ch)
 {
-    bufferIdx = 0;
-    uint8_t ch;
+    uint32_t tail = rxTail;
 
-    // Read characters until newline or buffer full
-    while (bufferIdx < (BUFFER_SIZE - 1)) {
-        // Blocking read of one character
-        if (UART_ReadBlocking(UART_INSTANCE, &ch, 1) == kStatus_Success) {
-            buffer[bufferIdx++] = ch;
-
-            // Stop at newline
-            if (ch == '\n') {
-                break;
-            }
-        }
+    if (tail == rxHead) {
+        return false;
     }
 
-    // Null terminate
-    buffer[bufferIdx] = '\0';
-    return bufferIdx;
+    *ch = rxRing[tail & (UART_RX_RING_SIZE - 1U)];
+    rxTail = tail + 1U;
+    return true;
 }
 
 /*FUNCTION**********************************************************************
  *
- * Function Name : UART_ClearBuffer
- * Description   : Clear the RX buffer
+ * Function Name : UART_RxGetDropped
+ * Description   : Bytes lost to a full RX ring or a hardware overrun
  *
- * Auteur: Simon Falardeau
  *END**************************************************************************/
-void UART_ClearBuffer(void)
+uint32_t UART_RxGetDropped(void)
 {
-    buffer[0] = 0;
-    bufferIdx = 0;
+    return rxDropped;
 }
 
 /*******************************************************************************
@@ -126,43 +132,110 @@ void UART_Write(const char *message)
 }
 
 /*******************************************************************************
- * Application Functions
+ * Interrupt-driven Log Transmission
  ******************************************************************************/
 
 /*FUNCTION**********************************************************************
  *
- * Function Name : UART_echo
- * Description   : Echo received data with command processing
- *                 Keeps your original S32Studio behavior
+ * Function Name : UART_TxInterruptInit
+ * Description   : Set the TX FIFO watermark and enable the UART0 interrupt in
+ *                 the NVIC. TIE stays off until UART_TxStart() is called.
  *
- * Auteur: Simon Falardeau
  *END**************************************************************************/
-void UART_echo(void)
+void UART_TxInterruptInit(void)
 {
-    if (bufferIdx == 0) {
-        return;
-    }
+    // TWFIFO may only be changed with the transmitter disabled
+    UART_EnableTx(UART_INSTANCE, false);
+    UART_INSTANCE->TWFIFO = UART_TX_FIFO_WATERMARK;
+    UART_EnableTx(UART_INSTANCE, true);
+
+    UART_DisableInterrupts(UART_INSTANCE, kUART_TxDataRegEmptyInterruptEnable);
+    NVIC_SetPriority(UART0_RX_TX_IRQn, UART_IRQ_PRIORITY);
+    EnableIRQ(UART0_RX_TX_IRQn);
+}
 
-    /* If the received string is "Hello Board", send back "pipeline" */
-    if(strcmp((char *)buffer, "Hello Board\n") == 0)
-    {
-        UART_Write_Blocking("pipeline \n");
-    }
-    else
-    {
-        /* Echo back the received data */
-        UART_Write_Blocking((char*)buffer);
-    }
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : UART_TxStart
+ * Description   : Enable the TX interrupt so queued log bytes get sent. The
+ *                 interrupt turns itself off once no committed text is left.
+ *
+ *END**************************************************************************/
+void UART_TxStart(void)
+{
+    // C2 is also written by the interrupt, keep it out of the read-modify-write
+    DisableIRQ(UART0_RX_TX_IRQn);
+    UART_INSTANCE->C2 |= UART_C2_TIE_MASK;
+    EnableIRQ(UART0_RX_TX_IRQn);
 }
 
 /*FUNCTION**********************************************************************
  *
- * Function Name : UART_HAL_send_data
- * Description   : Simple test function for development
+ * Function Name : UART0_RX_TX_IRQHandler
+ * Description   : Queue received bytes into the RX ring and wake the reader,
+ *                 and refill the TX FIFO straight from the log ring. TX fires
+ *                 when the FIFO drains down to the watermark, so at 115200 baud
+ *                 the CPU is only busy for a few cycles every ~0.5 ms while
+ *                 logging.
  *
- * Auteur: Simon Falardeau
  *END**************************************************************************/
-bool UART_HAL_send_data(char data)
+void UART0_RX_TX_IRQHandler(void)
 {
-    return (data == 'b');
+    const uint8_t *data;
+    uint16_t count;
+    uint16_t space;
+    uint16_t i;
+
+    BaseType_t woken = pdFALSE;
+    uint8_t status;
+
+    TRACE_ISR_ENTER(TRACE_ISR_UART);
+    status = UART_INSTANCE->S1;
+
+    // Reading S1 then D clears RDRF and OR. Bytes that do not fit are dropped
+    if (status & (UART_S1_RDRF_MASK | UART_S1_OR_MASK)) {
+        if (status & UART_S1_OR_MASK) {
+            rxDropped++;
+        }
+        while (UART_INSTANCE->RCFIFO > 0U) {
+            uint8_t ch = UART_INSTANCE->D;
+
+            if ((rxHead - rxTail) < UART_RX_RING_SIZE) {
+                rxRing[rxHead & (UART_RX_RING_SIZE - 1U)] = ch;
+                rxHead++;
+            } else {
+                rxDropped++;
+            }
+        }
+        if (rxNotifyTask != NULL) {
+            vTaskNotifyGiveFromISR(rxNotifyTask, &woken);
+        }
+    }
+
+    // TDRE was read with S1 above, the first half of its clear sequence
+    if ((UART_INSTANCE->C2 & UART_C2_TIE_MASK) && (status & UART_S1_TDRE_MASK)) {
+        space = UART_TX_FIFO_SIZE - UART_INSTANCE->TCFIFO;
+
+        while (space > 0U) {
+            // Nothing committed: stop rather than spin while a preempted
+            // producer finishes its record, UART_LogProcess() restarts us
+            count = UART_LogPeek(&data);
+            if (count == 0U) {
+                UART_INSTANCE->C2 &= (uint8_t)~UART_C2_TIE_MASK;
+                break;
+            }
+            if (count > space) {
+                count = space;
+            }
+            for (i = 0; i < count; i++) {
+                UART_INSTANCE->D = data[i];
+            }
+            UART_LogConsume(count);
+            space -= count;
+        }
+    }
+
+    TRACE_ISR_EXIT(TRACE_ISR_UART);
+    portYIELD_FROM_ISR(woken);
+    SDK_ISR_EXIT_BARRIER;
 }
@@ -1,37 +1,109 @@
 #include "Utilities.h"
 #include "UART_HAL.h"
+#include "lockfree.h"
+#include "log_record.h"
+#include "cycles.h"
+#include "Profiler.h"
 #include <string.h>
 #include <stdio.h>
 
 //==============================================================================
-// UART Logging System - Simplified for Blocking UART
+// UART Logging System - Lock-free multi-producer ring
 //==============================================================================
 
+// Each message is stored as a record: one header byte followed by the text.
+// Producers in any context (tasks or ISRs) claim space by advancing
+// reserveIndex with LDREX/STREX, copy their text, then set the commit flag in
+// the header. The UART TX interrupt is the only consumer: it sends committed
+// records in order straight out of the ring and zeroes what it has sent, so a
+// stale header can never look committed when the space is claimed again.
+// Indices run freely and are masked on access.
+#if (UART_LOG_BUFFER_SIZE & (UART_LOG_BUFFER_SIZE - 1)) != 0
+#error "UART_LOG_BUFFER_SIZE must be a power of two"
+#endif
+
+#define UART_LOG_MASK           (UART_LOG_BUFFER_SIZE - 1U)
+#define UART_LOG_COMMIT         (0x80U)     // Header: record fully written
+#define UART_LOG_LENGTH_MASK    (0x7FU)     // Header: text length
+
+// Longest record the ring accepts: a full text entry, or a COBS framed one
+#define UART_LOG_RECORD_MAX     (LOG_COBS_MAX_SIZE(LOG_RECORD_MAX_SIZE) + 1U)
+
+#if UART_LOG_RECORD_MAX > UART_LOG_LENGTH_MASK
+#error "UART_LOG_RECORD_MAX does not fit in the record header"
+#endif
+
 typedef struct {
-    char buffer[UART_LOG_BUFFER_SIZE];
-    volatile uint16_t writeIndex;
-    volatile uint16_t readIndex;
-    volatile bool overflow;
+    volatile uint8_t buffer[UART_LOG_BUFFER_SIZE];
+    volatile uint32_t reserveIndex;     // Producers, advanced with LF_CompareSwap
+    volatile uint32_t readIndex;        // Consumer only
+    volatile uint32_t dropped;          // Messages lost to a full ring
+    uint32_t recordRemaining;           // Consumer only, text bytes left in the current record
 } uart_log_t;
 
+// Deferred entries: format string address, timestamp and raw argument words.
+// Same scheme as the byte ring, with fixed-size slots and the logger task as
+// the only consumer, so the call site never runs sprintf.
+typedef struct {
+    volatile uint32_t committed;
+    const char *format;
+    uint32_t timestamp;
+    uint32_t argc;
+    uart_log_word_t args[LOG_RECORD_MAX_ARGS];
+} uart_log_deferred_t;
+
+typedef struct {
+    uart_log_deferred_t slots[UART_LOG_DEFER_SLOTS];
+    volatile uint32_t reserveIndex;
+    volatile uint32_t readIndex;
+} uart_log_defer_t;
+
+#if (UART_LOG_DEFER_SLOTS & (UART_LOG_DEFER_SLOTS - 1)) != 0
+#error "UART_LOG_DEFER_SLOTS must be a power of two"
+#endif
+
 // Static variables for UART logging system
 static uart_log_t uartLog = {0};
+static uart_log_defer_t uartDefer = {0};
 static bool uartLogEnabled = true;  // Enable by default
 
+// Runtime level per module, read inline by LOG_ENABLED()
+volatile uint8_t uartLogLevels[LOG_MODULE_COUNT] = { [0 ... LOG_MODULE_COUNT - 1] = LOG_LEVEL_DEFAULT };
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : UART_LogTimestamp
+ * Description   : Timestamp of a log call: the DWT cycle counter, one load.
+ *
+ *END**************************************************************************/
+static inline uint32_t UART_LogTimestamp(void)
+{
+    return Cycles_Now();
+}
+
 /*FUNCTION**********************************************************************
  *
  * Function Name : UART_LogInit
- * Description   : Initialize the UART logging system. Clears all buffers and
- *                 enables logging by default.
+ * Description   : Initialize the UART logging system. Clears all buffers,
+ *                 enables logging by default and hooks up the TX interrupt.
+ *                 Must run before any producer or the TX interrupt is active.
  *
  * Auteur: Simon Falardeau
  *END**************************************************************************/
 void UART_LogInit(void)
 {
-    uartLog.writeIndex = 0;
+    memset((void *)uartLog.buffer, 0, sizeof(uartLog.buffer));
+    uartLog.reserveIndex = 0;
     uartLog.readIndex = 0;
-    uartLog.overflow = false;
+    uartLog.dropped = 0;
+    uartLog.recordRemaining = 0;
+    memset(&uartDefer, 0, sizeof(uartDefer));
     uartLogEnabled = true;
+
+    // Cycle counter for timestamps
+    Cycles_Init();
+
+    UART_TxInterruptInit();
 }
 
 /*FUNCTION**********************************************************************
@@ -59,113 +131,351 @@ bool UART_LogIsEnabled(void)
     return uartLogEnabled;
 }
 
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : UART_LogSetLevel
+ * Description   : Set the runtime log level of one module, or of every module
+ *                 with LOG_MODULE_COUNT. Levels above the compile level of a
+ *                 module have no effect, those calls are not in the image.
+ *
+ *END**************************************************************************/
+void UART_LogSetLevel(log_module_t module, uint8_t level)
+{
+    uint32_t i;
+
+    if (module == LOG_MODULE_COUNT) {
+        for (i = 0; i < LOG_MODULE_COUNT; i++) {
+            uartLogLevels[i] = level;
+        }
+    } else if (module < LOG_MODULE_COUNT) {
+        uartLogLevels[module] = level;
+    }
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : UART_LogGetLevel
+ * Description   : Get the runtime log level of a module.
+ *
+ *END**************************************************************************/
+uint8_t UART_LogGetLevel(log_module_t module)
+{
+    return (module < LOG_MODULE_COUNT) ? uartLogLevels[module] : LOG_LEVEL_NONE;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : UART_LogWrite
+ * Description   : Queue raw bytes for the UART. Non-blocking and safe from any
+ *                 task or ISR: space is claimed with an exclusive
+ *                 compare-and-swap, never with a lock. The bytes are dropped
+ *                 and counted if the ring is full.
+ *
+ *END**************************************************************************/
+static void UART_LogWrite(const uint8_t *data, uint16_t length)
+{
+    uint32_t readIndex;
+    uint32_t reserve;
+    uint32_t index;
+    uint16_t i;
+    PROF_BEGIN(LOG_WRITE);
+
+    // Claim header + text. The read index is sampled before the reserve index
+    // so the free space can only be under-estimated, never wrap around
+    do {
+        readIndex = uartLog.readIndex;
+        reserve = uartLog.reserveIndex;
+        if ((reserve - readIndex) + length + 1U > UART_LOG_BUFFER_SIZE) {
+            LF_FetchAdd(&uartLog.dropped, 1U);
+            PROF_END(LOG_WRITE);
+            return; // Drop message to avoid corruption
+        }
+    } while (!LF_CompareSwap(&uartLog.reserveIndex, reserve, reserve + length + 1U));
+
+    // Header first, still uncommitted, then the text
+    uartLog.buffer[reserve & UART_LOG_MASK] = (uint8_t)length;
+    index = reserve + 1U;
+    for (i = 0; i < length; i++) {
+        uartLog.buffer[(index + i) & UART_LOG_MASK] = data[i];
+    }
+
+    // Text must be in memory before the consumer can see the commit flag
+    LF_BARRIER();
+    uartLog.buffer[reserve & UART_LOG_MASK] = (uint8_t)(UART_LOG_COMMIT | length);
+    PROF_END(LOG_WRITE);
+}
+
+#if UART_LOG_BINARY
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : UART_LogWriteRecord
+ * Description   : COBS frame a binary record and queue it with its delimiter.
+ *
+ *END**************************************************************************/
+static void UART_LogWriteRecord(const uint8_t *record, uint16_t length)
+{
+    uint8_t frame[UART_LOG_RECORD_MAX];
+    size_t frameLen;
+
+    frameLen = LogCobs_Encode(record, length, frame);
+    frame[frameLen++] = 0;
+    UART_LogWrite(frame, (uint16_t)frameLen);
+}
+#endif
+
 /*FUNCTION**********************************************************************
  *
  * Function Name : UART_LogMessage
- * Description   : Add a message to the UART log buffer. This function is
- *                 non-blocking and ISR-safe. Messages are stored in an internal
- *                 buffer and transmitted later by UART_LogProcess().
+ * Description   : Add a message to the UART log buffer. Non-blocking and safe
+ *                 from any task or ISR. In binary mode the text is sent as a
+ *                 timestamped TEXT record. Messages longer than an entry are
+ *                 queued as consecutive entries rather than cut.
  *
  * Auteur: Simon Falardeau
  *END**************************************************************************/
 void UART_LogMessage(const char* message)
 {
+    size_t remaining;
+    uint16_t msgLen;
+
     if (!uartLogEnabled || !message) {
         return;
     }
 
-    uint16_t msgLen = strlen(message);
-    if (msgLen >= UART_MAX_LOG_ENTRY_SIZE) {
-        msgLen = UART_MAX_LOG_ENTRY_SIZE - 1;
+    remaining = strlen(message);
+    while (remaining > 0U) {
+        msgLen = (remaining < UART_MAX_LOG_ENTRY_SIZE) ? (uint16_t)remaining : (UART_MAX_LOG_ENTRY_SIZE - 1);
+
+#if UART_LOG_BINARY
+        uint8_t record[LOG_RECORD_MAX_SIZE];
+        uint32_t timestamp = UART_LogTimestamp();
+
+        record[0] = LOG_RECORD_TEXT;
+        memcpy(&record[1], &timestamp, sizeof(timestamp));
+        memcpy(&record[LOG_RECORD_HEADER_SIZE], message, msgLen);
+        UART_LogWriteRecord(record, LOG_RECORD_HEADER_SIZE + msgLen);
+#else
+        UART_LogWrite((const uint8_t *)message, msgLen);
+#endif
+        message += msgLen;
+        remaining -= msgLen;
     }
+}
 
-    // Calculate space needed (length byte + message + null terminator)
-    uint16_t spaceNeeded = msgLen + 2;
-    uint16_t nextWriteIndex = (uartLog.writeIndex + spaceNeeded) % UART_LOG_BUFFER_SIZE;
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : UART_LogDeferred
+ * Description   : Queue a format string and its raw arguments for the logger
+ *                 task. Takes a timestamp, claims a slot and copies a few
+ *                 words: constant stack, no formatting at the call site. Safe
+ *                 from any task or ISR. Use through UART_DPRINTF.
+ *
+ *END**************************************************************************/
+void UART_LogDeferred(const char *format, const uart_log_word_t *args, uint32_t argc)
+{
+    uart_log_deferred_t *slot;
+    uint32_t timestamp = UART_LogTimestamp();
+    uint32_t readIndex;
+    uint32_t reserve;
+    uint32_t i;
+    PROF_BEGIN(LOG_DEFER);
 
-    // Check if buffer would overflow
-    if (((nextWriteIndex > uartLog.readIndex) &&
-         (uartLog.writeIndex < uartLog.readIndex)) ||
-        ((nextWriteIndex > uartLog.readIndex) &&
-         (uartLog.writeIndex >= uartLog.readIndex) &&
-         (nextWriteIndex - uartLog.readIndex >= UART_LOG_BUFFER_SIZE - spaceNeeded))) {
+    if (!uartLogEnabled) {
+        PROF_END(LOG_DEFER);
+        return;
+    }
 
-        uartLog.overflow = true;
-        return; // Drop message to avoid corruption
+    do {
+        readIndex = uartDefer.readIndex;
+        reserve = uartDefer.reserveIndex;
+        if ((reserve - readIndex) >= UART_LOG_DEFER_SLOTS) {
+            LF_FetchAdd(&uartLog.dropped, 1U);
+            PROF_END(LOG_DEFER);
+            return;
+        }
+    } while (!LF_CompareSwap(&uartDefer.reserveIndex, reserve, reserve + 1U));
+
+    slot = &uartDefer.slots[reserve & (UART_LOG_DEFER_SLOTS - 1U)];
+    slot->format = format;
+    slot->timestamp = timestamp;
+    slot->argc = argc;
+    for (i = 0; i < argc; i++) {
+        slot->args[i] = args[i];
     }
 
-    // Store message length first
-    uartLog.buffer[uartLog.writeIndex] = (char)msgLen;
-    uartLog.writeIndex = (uartLog.writeIndex + 1) % UART_LOG_BUFFER_SIZE;
+    LF_BARRIER();
+    slot->committed = 1U;
+    PROF_END(LOG_DEFER);
+}
 
-    // Store message
-    for (uint16_t i = 0; i < msgLen; i++) {
-        uartLog.buffer[uartLog.writeIndex] = message[i];
-        uartLog.writeIndex = (uartLog.writeIndex + 1) % UART_LOG_BUFFER_SIZE;
-    }
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : UART_LogFlushDeferred
+ * Description   : Logger task side: turn committed deferred entries into
+ *                 output, in order. Text mode formats them here, binary mode
+ *                 sends the raw words as FORMAT records for the host decoder.
+ *
+ *END**************************************************************************/
+static void UART_LogFlushDeferred(void)
+{
+    uart_log_deferred_t entry;
+    uart_log_deferred_t *slot;
+
+    while (uartDefer.readIndex != uartDefer.reserveIndex) {
+        slot = &uartDefer.slots[uartDefer.readIndex & (UART_LOG_DEFER_SLOTS - 1U)];
+        if (!slot->committed) {
+            break;  // Producer preempted mid-entry, pick it up next time
+        }
 
-    // Null terminator
-    uartLog.buffer[uartLog.writeIndex] = '\0';
-    uartLog.writeIndex = (uartLog.writeIndex + 1) % UART_LOG_BUFFER_SIZE;
+        LF_BARRIER();
+        memcpy(&entry, slot, sizeof(entry));
+        slot->committed = 0U;
+        LF_BARRIER();
+        uartDefer.readIndex++;
+
+        PROF_BEGIN(LOG_FLUSH);
+#if UART_LOG_BINARY
+        uint8_t record[LOG_RECORD_HEADER_SIZE + 4U + (4U * LOG_RECORD_MAX_ARGS)];
+        uint32_t address = (uint32_t)(uintptr_t)entry.format;
+        uint32_t word;
+        uint32_t i;
+
+        // The record carries 32-bit words, whatever the width of the slot
+        record[0] = LOG_RECORD_FORMAT;
+        memcpy(&record[1], &entry.timestamp, sizeof(entry.timestamp));
+        memcpy(&record[LOG_RECORD_HEADER_SIZE], &address, sizeof(address));
+        for (i = 0; i < entry.argc; i++) {
+            word = (uint32_t)entry.args[i];
+            memcpy(&record[LOG_RECORD_HEADER_SIZE + 4U + (4U * i)], &word, sizeof(word));
+        }
+        UART_LogWriteRecord(record, (uint16_t)(LOG_RECORD_HEADER_SIZE + 4U + (4U * entry.argc)));
+#else
+        char text[UART_MAX_LOG_ENTRY_SIZE];
+
+        // Unused trailing words are ignored by snprintf
+        snprintf(text, sizeof(text), entry.format,
+                 entry.args[0], entry.args[1], entry.args[2],
+                 entry.args[3], entry.args[4], entry.args[5]);
+        UART_LogMessage(text);
+#endif
+        PROF_END(LOG_FLUSH);
+    }
 }
 
 /*FUNCTION**********************************************************************
  *
  * Function Name : UART_LogProcess
- * Description   : Process and output all queued UART log messages using
- *                 blocking UART transmission. Much simpler than interrupt version.
+ * Description   : Render deferred entries, report lost messages and start
+ *                 the TX interrupt if output is queued. Returns quickly: the bytes are sent by the UART
+ *                 TX interrupt, which refills the FIFO straight from the ring.
  *
- * Auteur: Simon Falardeau (Simplified for blocking UART)
+ * Auteur: Simon Falardeau
  *END**************************************************************************/
 void UART_LogProcess(void)
 {
-    static bool overflowReported = false;
+    static uint32_t droppedReported = 0;
+    uint32_t dropped = uartLog.dropped;
+
+    UART_LogFlushDeferred();
 
     // Report log buffer overflow if it occurred
-    if (uartLog.overflow && !overflowReported) {
-        UART_Write_NonBlocking("UART_LOG: Buffer overflow - messages lost\r\n");
-        overflowReported = true;
-        uartLog.overflow = false;
+    if (dropped != droppedReported) {
+        LOG_WARN(LOG, "UART_LOG: Buffer overflow - %lu messages lost\r\n",
+                 (unsigned long)(dropped - droppedReported));
+        droppedReported = dropped;
     }
 
-    // Process all queued log messages - much simpler now!
-    while (uartLog.readIndex != uartLog.writeIndex) {
-        // Read message length
-        uint8_t msgLen = (uint8_t)uartLog.buffer[uartLog.readIndex];
-        uartLog.readIndex = (uartLog.readIndex + 1) % UART_LOG_BUFFER_SIZE;
+    if (UART_LogHasMessages()) {
+        UART_TxStart();
+    }
+}
 
-        // Sanity check
-        if (msgLen == 0 || msgLen >= UART_MAX_LOG_ENTRY_SIZE) {
-            UART_LogInit();
-            UART_Write_NonBlocking("UART_LOG: Buffer corrupted, reset\r\n");
-            return;
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : UART_LogHasMessages
+ * Description   : Check if there are records waiting in the UART log buffer,
+ *                 committed or still being written.
+ *
+ * Auteur: Simon Falardeau
+ *END**************************************************************************/
+bool UART_LogHasMessages(void)
+{
+    return (uartLog.readIndex != uartLog.reserveIndex);
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : UART_LogGetDropped
+ * Description   : Number of messages dropped because the ring was full.
+ *
+ *END**************************************************************************/
+uint32_t UART_LogGetDropped(void)
+{
+    return uartLog.dropped;
+}
+
+/*FUNCTION**********************************************************************
+ *
+ * Function Name : UART_LogPeek
+ * Description   : Get the contiguous run of committed text at the read index.
+ *                 Returns 0 when the next record is not committed yet, even if
+ *                 later ones are, so output keeps the order of reservation.
+ *                 Called by the UART TX interrupt (single consumer).
+ *
+ *END**************************************************************************/
+uint16_t UART_LogPeek(const uint8_t **data)
+{
+    uint32_t readIndex = uartLog.readIndex;
+    uint32_t count;
+    uint8_t header;
+
+    if (uartLog.recordRemaining == 0U) {
+        if (readIndex == uartLog.reserveIndex) {
+            return 0;
         }
 
-        // Read message from log buffer
-        char tempMsg[UART_MAX_LOG_ENTRY_SIZE];
-        for (uint8_t i = 0; i <= msgLen; i++) { // Include null terminator
-            tempMsg[i] = uartLog.buffer[uartLog.readIndex];
-            uartLog.readIndex = (uartLog.readIndex + 1) % UART_LOG_BUFFER_SIZE;
+        header = uartLog.buffer[readIndex & UART_LOG_MASK];
+        if ((header & UART_LOG_COMMIT) == 0U) {
+            return 0;
         }
 
-        // Send message using blocking UART - no retry logic needed!
-        UART_Write_NonBlocking(tempMsg);
+        // Text reads must not be hoisted above the commit flag read
+        LF_BARRIER();
+        uartLog.buffer[readIndex & UART_LOG_MASK] = 0;
+        uartLog.recordRemaining = header & UART_LOG_LENGTH_MASK;
+        readIndex++;
+        uartLog.readIndex = readIndex;
+    }
 
-        overflowReported = false;
+    count = UART_LOG_BUFFER_SIZE - (readIndex & UART_LOG_MASK);
+    if (count > uartLog.recordRemaining) {
+        count = uartLog.recordRemaining;
     }
+
+    *data = (const uint8_t *)&uartLog.buffer[readIndex & UART_LOG_MASK];
+    return (uint16_t)count;
 }
 
 /*FUNCTION**********************************************************************
  *
- * Function Name : UART_LogHasMessages
- * Description   : Check if there are messages waiting to be processed in the
- *                 UART log buffer.
+ * Function Name : UART_LogConsume
+ * Description   : Release bytes returned by UART_LogPeek() once they are in
+ *                 the UART TX FIFO.
  *
- * Auteur: Simon Falardeau
  *END**************************************************************************/
-bool UART_LogHasMessages(void)
+void UART_LogConsume(uint16_t count)
 {
-    return (uartLog.readIndex != uartLog.writeIndex);
+    uint32_t readIndex = uartLog.readIndex;
+    uint16_t i;
+
+    for (i = 0; i < count; i++) {
+        uartLog.buffer[(readIndex + i) & UART_LOG_MASK] = 0;
+    }
+    uartLog.recordRemaining -= count;
+
+    // Zeroed bytes must land before producers may claim them again
+    LF_BARRIER();
+    uartLog.readIndex = readIndex + count;
 }
 
 // Keep only the bit manipulation functions you actually use
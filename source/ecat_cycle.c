@@ -0,0 +1,546 @@
+/*
+ * EtherCAT Cyclic Frame Builder Implementation for FRDM-K64F
+ * Mailbox slots rotate over the slaves so a full frame never starves one of them
+ */
+
+#include <string.h>
+#include "ecat_cycle.h"
+#include "cycles.h"
+
+/*******************************************************************************
+ * Private Definitions
+ ******************************************************************************/
+
+#define ECAT_CYCLE_ECAT_OFFSET      14    /* EtherCAT header after the Ethernet header */
+#define ECAT_CYCLE_DGRAM_OFFSET     16
+#define ECAT_CYCLE_DGRAM_HEADER     10
+#define ECAT_CYCLE_DGRAM_OVERHEAD   12    /* Datagram header and working counter */
+#define ECAT_CYCLE_MIN_LENGTH       ETHERCAT_MIN_FRAME_SIZE  /* Shortest frame enet_raw sends */
+#define ECAT_CYCLE_DGRAM_MORE       0x8000U
+
+/* Datagram commands */
+#define ECAT_CMD_APWR               0x02U
+#define ECAT_CMD_FPRD               0x04U
+#define ECAT_CMD_FPWR               0x05U
+#define ECAT_CMD_BRD                0x07U
+#define ECAT_CMD_LRW                0x0CU
+
+/* ESC registers */
+#define ECAT_REG_STATION_ADDR       0x0010U
+#define ECAT_REG_AL_CONTROL         0x0120U
+#define ECAT_REG_AL_STATUS          0x0130U
+#define ECAT_REG_SM0                0x0800U
+#define ECAT_REG_SM1                0x0808U
+#define ECAT_REG_SM1_STATUS         0x080DU
+
+/* Sync manager registers, from the SM base */
+#define ECAT_SM_SIZE                8U
+#define ECAT_SM_CONTROL_MODE_MASK   0x03U
+#define ECAT_SM_CONTROL_MAILBOX     0x02U
+#define ECAT_SM_STATUS_FULL         0x08U
+
+/* What a staged datagram is for */
+#define ECAT_CYCLE_KIND_LRW         0U
+#define ECAT_CYCLE_KIND_STATUS      1U    /* SM1 status of a slave */
+#define ECAT_CYCLE_KIND_READ        2U    /* SM1 read */
+#define ECAT_CYCLE_KIND_WRITE       3U    /* SM0 write */
+#define ECAT_CYCLE_KIND_REGISTER    4U
+
+/*******************************************************************************
+ * Private Functions
+ ******************************************************************************/
+
+/**
+ * @brief Start a new frame: Ethernet header, no datagrams
+ */
+static void ecat_cycle_begin(ecat_cycle_t *cycle)
+{
+    memset(cycle->frame, 0xFF, 6);
+    memcpy(&cycle->frame[6], cycle->handle->mac_addr, 6);
+    cycle->frame[12] = (uint8_t)(ETHERCAT_ETHERTYPE >> 8);
+    cycle->frame[13] = (uint8_t)(ETHERCAT_ETHERTYPE & 0xFFU);
+    cycle->length = ECAT_CYCLE_DGRAM_OFFSET;
+    cycle->datagram_count = 0;
+}
+
+/**
+ * @brief Append a datagram header and working counter around data_length bytes
+ *
+ * The data bytes are left as they are, writers may have placed them already.
+ *
+ * @return The data of the datagram, NULL if it does not fit the frame budget
+ */
+static uint8_t *ecat_cycle_add(ecat_cycle_t *cycle, uint8_t command, uint16_t adp, uint16_t ado,
+                               uint16_t data_length, uint8_t slave, uint8_t kind)
+{
+    ecat_cycle_datagram_t *dgram;
+    uint8_t *header = &cycle->frame[cycle->length];
+    uint16_t previous;
+
+    if ((uint32_t)cycle->length + ECAT_CYCLE_DGRAM_OVERHEAD + data_length > cycle->budget ||
+        cycle->datagram_count >= ECAT_CYCLE_MAX_DATAGRAMS)
+    {
+        return NULL;
+    }
+
+    /* The previous datagram announces this one */
+    if (cycle->datagram_count > 0)
+    {
+        previous = cycle->datagrams[cycle->datagram_count - 1].offset;
+        cycle->frame[previous + 7] |= (uint8_t)(ECAT_CYCLE_DGRAM_MORE >> 8);
+    }
+
+    header[0] = command;
+    header[1] = cycle->index;
+    ECAT_PUT_U16(&header[2], adp);
+    ECAT_PUT_U16(&header[4], ado);
+    ECAT_PUT_U16(&header[6], data_length & 0x07FFU);
+    ECAT_PUT_U16(&header[8], 0U);
+    ECAT_PUT_U16(&header[ECAT_CYCLE_DGRAM_HEADER + data_length], 0U);
+
+    dgram = &cycle->datagrams[cycle->datagram_count++];
+    dgram->offset = cycle->length;
+    dgram->length = data_length;
+    dgram->slave = slave;
+    dgram->kind = kind;
+
+    cycle->length += ECAT_CYCLE_DGRAM_OVERHEAD + data_length;
+    return &header[ECAT_CYCLE_DGRAM_HEADER];
+}
+
+/**
+ * @brief Send the frame and poll for it until the timeout
+ * @param rx The frame back, to be released by the caller
+ * @return true if the own frame came back in rx
+ */
+static bool ecat_cycle_transfer(ecat_cycle_t *cycle, uint32_t timeout_us, enet_raw_frame_t *rx)
+{
+    uint16_t ecat_length = (uint16_t)(cycle->length - ECAT_CYCLE_DGRAM_OFFSET);
+    uint32_t deadline;
+    bool own;
+
+    /* Length (11 bits) and type 1, then padding to the Ethernet minimum */
+    ECAT_PUT_U16(&cycle->frame[ECAT_CYCLE_ECAT_OFFSET], (ecat_length & 0x07FFU) | 0x1000U);
+    if (cycle->length < ECAT_CYCLE_MIN_LENGTH)
+    {
+        memset(&cycle->frame[cycle->length], 0, ECAT_CYCLE_MIN_LENGTH - cycle->length);
+        cycle->length = ECAT_CYCLE_MIN_LENGTH;
+    }
+
+    deadline = Cycles_Now() + Cycles_FromUs(timeout_us);
+    if (enet_raw_send_frame(cycle->handle, cycle->frame, cycle->length) != ENET_RAW_SUCCESS)
+    {
+        return false;
+    }
+
+    while (1)
+    {
+        if (enet_raw_receive_frame(cycle->handle, rx, 0) == ENET_RAW_SUCCESS)
+        {
+            /* Late frames of earlier cycles carry another index */
+            own = (rx->length == cycle->length &&
+                   rx->data[ECAT_CYCLE_DGRAM_OFFSET] == cycle->frame[ECAT_CYCLE_DGRAM_OFFSET] &&
+                   rx->data[ECAT_CYCLE_DGRAM_OFFSET + 1] == cycle->index);
+            if (own)
+            {
+                return true;
+            }
+            enet_raw_release_frame(cycle->handle, rx);
+        }
+        else if ((int32_t)(Cycles_Now() - deadline) >= 0)
+        {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Working counter of a staged datagram in the frame back
+ */
+static uint16_t ecat_cycle_wkc(const uint8_t *data, const ecat_cycle_datagram_t *dgram)
+{
+    return ECAT_GET_U16(&data[dgram->offset + ECAT_CYCLE_DGRAM_HEADER + dgram->length]);
+}
+
+/**
+ * @brief One register datagram in a frame of its own
+ */
+static ecat_cycle_status_t ecat_cycle_register(ecat_cycle_t *cycle, uint8_t command, uint16_t adp,
+                                               uint16_t ado, uint8_t *data, uint16_t length,
+                                               uint16_t *wkc, uint32_t timeout_us)
+{
+    enet_raw_frame_t rx;
+    uint8_t *payload;
+
+    cycle->index++;
+    ecat_cycle_begin(cycle);
+    payload = ecat_cycle_add(cycle, command, adp, ado, length, 0, ECAT_CYCLE_KIND_REGISTER);
+    if (!payload)
+    {
+        return ECAT_CYCLE_ERROR_INVALID_PARAM;
+    }
+    memcpy(payload, data, length);
+
+    if (!ecat_cycle_transfer(cycle, timeout_us, &rx))
+    {
+        return ECAT_CYCLE_ERROR_TIMEOUT;
+    }
+    memcpy(data, &rx.data[cycle->datagrams[0].offset + ECAT_CYCLE_DGRAM_HEADER], length);
+    *wkc = ecat_cycle_wkc(rx.data, &cycle->datagrams[0]);
+    enet_raw_release_frame(cycle->handle, &rx);
+
+    return ECAT_CYCLE_SUCCESS;
+}
+
+/**
+ * @brief Read the mailbox sync managers of every slave, inactive ones count as no mailbox
+ */
+static ecat_cycle_status_t ecat_cycle_read_mailboxes(ecat_cycle_t *cycle, uint32_t timeout_us)
+{
+    ecat_cycle_slave_t *slave;
+    ecat_cycle_status_t status;
+    uint8_t sm[2 * ECAT_SM_SIZE];
+    const uint8_t *sm1 = &sm[ECAT_SM_SIZE];
+    uint16_t wkc;
+    uint16_t i;
+
+    for (i = 0; i < cycle->slave_count; i++)
+    {
+        slave = &cycle->slaves[i];
+        memset(sm, 0, sizeof(sm));
+        status = ecat_cycle_register(cycle, ECAT_CMD_FPRD, slave->station_addr, ECAT_REG_SM0,
+                                     sm, sizeof(sm), &wkc, timeout_us);
+        if (status != ECAT_CYCLE_SUCCESS)
+        {
+            return status;
+        }
+        if (wkc != 1)
+        {
+            return ECAT_CYCLE_ERROR_WKC;
+        }
+
+        slave->sm0_size = 0;
+        slave->sm1_size = 0;
+        slave->in_full = false;
+        if ((sm[4] & ECAT_SM_CONTROL_MODE_MASK) == ECAT_SM_CONTROL_MAILBOX && (sm[6] & 0x01U) &&
+            (sm1[4] & ECAT_SM_CONTROL_MODE_MASK) == ECAT_SM_CONTROL_MAILBOX && (sm1[6] & 0x01U))
+        {
+            slave->sm0_addr = ECAT_GET_U16(&sm[0]);
+            slave->sm0_size = ECAT_GET_U16(&sm[2]);
+            slave->sm1_addr = ECAT_GET_U16(&sm1[0]);
+            slave->sm1_size = ECAT_GET_U16(&sm1[2]);
+        }
+    }
+
+    return ECAT_CYCLE_SUCCESS;
+}
+
+/*******************************************************************************
+ * Public API Implementation
+ ******************************************************************************/
+
+ecat_cycle_status_t ecat_cycle_init(ecat_cycle_t *cycle, enet_raw_handle_t *handle, uint16_t image_size)
+{
+    if (!cycle || !handle || image_size > ECAT_CYCLE_MAX_IMAGE)
+    {
+        return ECAT_CYCLE_ERROR_INVALID_PARAM;
+    }
+
+    memset(cycle, 0, sizeof(*cycle));
+    cycle->handle = handle;
+    cycle->image_size = image_size;
+    cycle->budget = ECAT_CYCLE_FRAME_BUDGET;
+    Cycles_Init();
+
+    return ECAT_CYCLE_SUCCESS;
+}
+
+ecat_cycle_status_t ecat_cycle_scan(ecat_cycle_t *cycle, uint32_t timeout_us)
+{
+    ecat_cycle_status_t status;
+    uint8_t data[2] = { 0, 0 };
+    uint16_t count;
+    uint16_t wkc;
+    uint16_t i;
+
+    if (!cycle)
+    {
+        return ECAT_CYCLE_ERROR_INVALID_PARAM;
+    }
+
+    memset(cycle->slaves, 0, sizeof(cycle->slaves));
+    memset(&cycle->stats, 0, sizeof(cycle->stats));
+    cycle->slave_count = 0;
+    cycle->next_slot = 0;
+
+    /* Every slave increments the working counter of a broadcast read */
+    status = ecat_cycle_register(cycle, ECAT_CMD_BRD, 0, 0, data, sizeof(data), &count, timeout_us);
+    if (status != ECAT_CYCLE_SUCCESS)
+    {
+        return status;
+    }
+    if (count > ECAT_CYCLE_MAX_SLAVES)
+    {
+        count = ECAT_CYCLE_MAX_SLAVES;
+    }
+
+    /* Station addresses by position: auto-increment address 0 is the slave reached first */
+    for (i = 0; i < count; i++)
+    {
+        ECAT_PUT_U16(data, ECAT_CYCLE_STATION_BASE + i);
+        status = ecat_cycle_register(cycle, ECAT_CMD_APWR, (uint16_t)(0U - i), ECAT_REG_STATION_ADDR,
+                                     data, sizeof(data), &wkc, timeout_us);
+        if (status != ECAT_CYCLE_SUCCESS)
+        {
+            return status;
+        }
+        if (wkc != 1)
+        {
+            return ECAT_CYCLE_ERROR_WKC;
+        }
+        cycle->slaves[i].station_addr = (uint16_t)(ECAT_CYCLE_STATION_BASE + i);
+        cycle->slave_count = (uint16_t)(i + 1U);
+    }
+
+    return ecat_cycle_read_mailboxes(cycle, timeout_us);
+}
+
+ecat_cycle_status_t ecat_cycle_request_state(ecat_cycle_t *cycle, uint8_t state, uint32_t timeout_us)
+{
+    ecat_cycle_status_t status;
+    uint8_t data[2];
+    uint32_t deadline;
+    uint16_t wkc;
+    uint16_t i;
+
+    if (!cycle)
+    {
+        return ECAT_CYCLE_ERROR_INVALID_PARAM;
+    }
+
+    deadline = Cycles_Now() + Cycles_FromUs(timeout_us);
+    for (i = 0; i < cycle->slave_count; i++)
+    {
+        ECAT_PUT_U16(data, state);
+        status = ecat_cycle_register(cycle, ECAT_CMD_FPWR, cycle->slaves[i].station_addr,
+                                     ECAT_REG_AL_CONTROL, data, sizeof(data), &wkc, timeout_us);
+        if (status != ECAT_CYCLE_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    /* Each slave is polled on its own: a broadcast read would OR the states together */
+    for (i = 0; i < cycle->slave_count; i++)
+    {
+        do
+        {
+            data[0] = 0;
+            data[1] = 0;
+            status = ecat_cycle_register(cycle, ECAT_CMD_FPRD, cycle->slaves[i].station_addr,
+                                         ECAT_REG_AL_STATUS, data, sizeof(data), &wkc, timeout_us);
+            if (status == ECAT_CYCLE_SUCCESS && wkc == 1 && (data[0] & 0x0FU) == state)
+            {
+                break;
+            }
+            if ((int32_t)(Cycles_Now() - deadline) >= 0)
+            {
+                return ECAT_CYCLE_ERROR_STATE;
+            }
+        } while (1);
+    }
+
+    return ecat_cycle_read_mailboxes(cycle, timeout_us);
+}
+
+ecat_cycle_status_t ecat_cycle_attach(ecat_cycle_t *cycle, uint16_t slave,
+                                      const ecat_mbx_client_t *client, void *ctx)
+{
+    if (!cycle || slave >= cycle->slave_count)
+    {
+        return ECAT_CYCLE_ERROR_INVALID_PARAM;
+    }
+    if (client && (cycle->slaves[slave].sm0_size < ECAT_MBX_MIN_SIZE ||
+                   cycle->slaves[slave].sm1_size < ECAT_MBX_MIN_SIZE))
+    {
+        return ECAT_CYCLE_ERROR_INVALID_PARAM;
+    }
+
+    cycle->slaves[slave].client = client;
+    cycle->slaves[slave].ctx = ctx;
+    cycle->slaves[slave].in_full = false;
+    return ECAT_CYCLE_SUCCESS;
+}
+
+ecat_cycle_status_t ecat_cycle_exchange(ecat_cycle_t *cycle, uint32_t timeout_us)
+{
+    const ecat_cycle_datagram_t *dgram;
+    ecat_cycle_slave_t *slave;
+    enet_raw_frame_t rx;
+    const uint8_t *result;
+    uint8_t *payload;
+    uint16_t spare;
+    uint16_t staged;
+    uint16_t wkc;
+    uint16_t n;
+    uint16_t s;
+
+    if (!cycle)
+    {
+        return ECAT_CYCLE_ERROR_INVALID_PARAM;
+    }
+
+    cycle->index++;
+    ecat_cycle_begin(cycle);
+
+    /* Process image first, it must never wait for mailbox traffic */
+    if (cycle->image_size > 0)
+    {
+        payload = ecat_cycle_add(cycle, ECAT_CMD_LRW, 0, 0, cycle->image_size, 0, ECAT_CYCLE_KIND_LRW);
+        if (!payload)
+        {
+            return ECAT_CYCLE_ERROR_INVALID_PARAM;
+        }
+        memcpy(payload, cycle->outputs, cycle->image_size);
+    }
+
+    for (s = 0; s < cycle->slave_count; s++)
+    {
+        if (cycle->slaves[s].client)
+        {
+            payload = ecat_cycle_add(cycle, ECAT_CMD_FPRD, cycle->slaves[s].station_addr,
+                                     ECAT_REG_SM1_STATUS, 1, (uint8_t)s, ECAT_CYCLE_KIND_STATUS);
+            if (payload)
+            {
+                payload[0] = 0;
+            }
+        }
+    }
+
+    /* Mailbox slots in turn, from the first one a full frame left out last time */
+    for (n = 0; n < cycle->slave_count; n++)
+    {
+        s = (uint16_t)((cycle->next_slot + n) % cycle->slave_count);
+        slave = &cycle->slaves[s];
+        if (!slave->client)
+        {
+            continue;
+        }
+
+        if (slave->in_full)
+        {
+            payload = ecat_cycle_add(cycle, ECAT_CMD_FPRD, slave->station_addr, slave->sm1_addr,
+                                     slave->sm1_size, (uint8_t)s, ECAT_CYCLE_KIND_READ);
+            if (!payload)
+            {
+                break;
+            }
+            memset(payload, 0, slave->sm1_size);
+        }
+
+        spare = 0;
+        if ((uint32_t)cycle->length + ECAT_CYCLE_DGRAM_OVERHEAD < cycle->budget)
+        {
+            spare = (uint16_t)(cycle->budget - cycle->length - ECAT_CYCLE_DGRAM_OVERHEAD);
+        }
+        if (spare < slave->sm0_size)
+        {
+            break;
+        }
+        staged = slave->client->fill(slave->ctx, &cycle->frame[cycle->length + ECAT_CYCLE_DGRAM_HEADER], spare);
+        if (staged > 0)
+        {
+            /* A mailbox write always covers the whole sync manager area */
+            if (staged < slave->sm0_size)
+            {
+                memset(&cycle->frame[cycle->length + ECAT_CYCLE_DGRAM_HEADER + staged], 0,
+                       slave->sm0_size - staged);
+            }
+            (void)ecat_cycle_add(cycle, ECAT_CMD_FPWR, slave->station_addr, slave->sm0_addr,
+                                 slave->sm0_size, (uint8_t)s, ECAT_CYCLE_KIND_WRITE);
+        }
+    }
+    if (n < cycle->slave_count)
+    {
+        cycle->stats.mbx_deferred++;
+        cycle->next_slot = s;
+    }
+    else if (cycle->slave_count > 0)
+    {
+        cycle->next_slot = (uint16_t)((cycle->next_slot + 1U) % cycle->slave_count);
+    }
+
+    if (!ecat_cycle_transfer(cycle, timeout_us, &rx))
+    {
+        /* Whether the slaves took the mailboxes is unknown, they go out again */
+        for (n = 0; n < cycle->datagram_count; n++)
+        {
+            dgram = &cycle->datagrams[n];
+            if (dgram->kind == ECAT_CYCLE_KIND_WRITE)
+            {
+                slave = &cycle->slaves[dgram->slave];
+                slave->client->confirm(slave->ctx, false);
+            }
+        }
+        cycle->stats.lost++;
+        return ECAT_CYCLE_ERROR_TIMEOUT;
+    }
+
+    for (n = 0; n < cycle->datagram_count; n++)
+    {
+        dgram = &cycle->datagrams[n];
+        slave = &cycle->slaves[dgram->slave];
+        result = &rx.data[dgram->offset + ECAT_CYCLE_DGRAM_HEADER];
+        wkc = ecat_cycle_wkc(rx.data, dgram);
+
+        switch (dgram->kind)
+        {
+            case ECAT_CYCLE_KIND_LRW:
+                memcpy(cycle->inputs, result, cycle->image_size);
+                cycle->stats.lrw_wkc = wkc;
+                break;
+
+            case ECAT_CYCLE_KIND_STATUS:
+                slave->in_full = (wkc == 1 && (result[0] & ECAT_SM_STATUS_FULL));
+                break;
+
+            case ECAT_CYCLE_KIND_READ:
+                /* A slave with more to send has the next mailbox ready by the next cycle,
+                   so it is read again without waiting for the status; WKC 0 ends that */
+                slave->in_full = (wkc == 1);
+                if (wkc == 1)
+                {
+                    cycle->stats.mbx_read++;
+                    slave->client->receive(slave->ctx, result, dgram->length);
+                }
+                break;
+
+            case ECAT_CYCLE_KIND_WRITE:
+                if (wkc == 1)
+                {
+                    cycle->stats.mbx_written++;
+                }
+                else
+                {
+                    cycle->stats.mbx_busy++;
+                }
+                slave->client->confirm(slave->ctx, wkc == 1);
+                break;
+
+            default:
+                break;
+        }
+    }
+    enet_raw_release_frame(cycle->handle, &rx);
+    cycle->stats.cycles++;
+
+    return ECAT_CYCLE_SUCCESS;
+}
+
+void ecat_cycle_get_stats(const ecat_cycle_t *cycle, ecat_cycle_stats_t *stats)
+{
+    if (cycle && stats)
+    {
+        *stats = cycle->stats;
+    }
+}
@@ -0,0 +1,285 @@
+/*
+ * EtherCAT EoE Tunnel Implementation for FRDM-K64F
+ * Fragment sizes are chosen per cycle from the spare bytes of the cyclic frame
+ */
+
+#include <string.h>
+#include "ecat_eoe.h"
+
+/*******************************************************************************
+ * Private Definitions
+ ******************************************************************************/
+
+/* EoE header, first word */
+#define EOE_HDR_TYPE(w)             ((w) & 0x000FU)
+#define EOE_HDR_PORT(w)             (((w) >> 4) & 0x000FU)
+#define EOE_HDR_LAST_FRAGMENT       (1U << 8)
+#define EOE_HDR_TIME_APPENDED       (1U << 9)
+
+/* EoE header, second word */
+#define EOE_HDR_FRAGMENT(w)         ((w) & 0x003FU)
+#define EOE_HDR_OFFSET(w)           (((w) >> 6) & 0x003FU)
+#define EOE_HDR_FRAME_NO(w)         (((w) >> 12) & 0x000FU)
+
+#define EOE_TIMESTAMP_SIZE          4
+
+/*******************************************************************************
+ * Private Functions
+ ******************************************************************************/
+
+/**
+ * @brief Reset the reassembly state after a completed or broken frame
+ */
+static void ecat_eoe_rx_reset(ecat_eoe_endpoint_t *ep)
+{
+    ep->rx_active = false;
+    ep->rx_offset = 0;
+    ep->rx_size = 0;
+    ep->rx_fragment = 0;
+}
+
+/*******************************************************************************
+ * Public API Implementation
+ ******************************************************************************/
+
+ecat_eoe_status_t ecat_eoe_init(ecat_eoe_endpoint_t *ep, uint16_t station_addr, uint16_t mbx_size,
+                                ecat_eoe_rx_callback_t rx_callback, void *userData)
+{
+    if (!ep || mbx_size < ECAT_MBX_MIN_SIZE || mbx_size > ECAT_MBX_MAX_SIZE)
+    {
+        return ECAT_EOE_ERROR_INVALID_PARAM;
+    }
+
+    memset(ep, 0, sizeof(*ep));
+    ep->station_addr = station_addr;
+    ep->mbx_size = mbx_size;
+    ep->rx_callback = rx_callback;
+    ep->userData = userData;
+
+    return ECAT_EOE_SUCCESS;
+}
+
+ecat_eoe_status_t ecat_eoe_send(ecat_eoe_endpoint_t *ep, const uint8_t *frame, uint16_t length)
+{
+    if (!ep || !frame)
+    {
+        return ECAT_EOE_ERROR_INVALID_PARAM;
+    }
+
+    if (length == 0 || length > ECAT_EOE_MAX_FRAME_SIZE)
+    {
+        return ECAT_EOE_ERROR_FRAME_SIZE;
+    }
+
+    if (ep->tx_busy)
+    {
+        return ECAT_EOE_ERROR_BUSY;
+    }
+
+    memcpy(ep->tx_frame, frame, length);
+    ep->tx_length = length;
+    ep->tx_offset = 0;
+    ep->tx_staged = 0;
+    ep->tx_fragment = 0;
+    ep->tx_frame_no = (uint8_t)((ep->tx_frame_no + 1U) & 0x0FU);
+    ep->tx_busy = true;
+
+    return ECAT_EOE_SUCCESS;
+}
+
+uint16_t ecat_eoe_fill_mailbox(ecat_eoe_endpoint_t *ep, uint8_t *buf, uint16_t spare_bytes)
+{
+    ecat_mbx_header_t mbx;
+    uint16_t capacity;
+    uint16_t remaining;
+    uint16_t payload;
+    uint16_t word0;
+    uint16_t word1;
+    bool last;
+
+    if (!ep || !buf || !ep->tx_busy)
+    {
+        return 0;
+    }
+
+    /* A mailbox write always covers the whole sync manager area */
+    if (spare_bytes < ep->mbx_size)
+    {
+        ep->stats.tx_deferred++;
+        return 0;
+    }
+
+    capacity = ep->mbx_size - ECAT_MBX_HEADER_SIZE - ECAT_EOE_HEADER_SIZE;
+    remaining = ep->tx_length - ep->tx_offset;
+    last = (remaining <= capacity);
+    payload = last ? remaining : (uint16_t)(capacity & ~(ECAT_EOE_FRAGMENT_UNIT - 1U));
+
+    if (payload == 0)
+    {
+        /* Mailbox too small for a single 32 byte block */
+        ep->stats.tx_deferred++;
+        return 0;
+    }
+
+    word0 = ECAT_EOE_TYPE_FRAGMENT | ((uint16_t)(ep->port & 0x0FU) << 4);
+    if (last)
+    {
+        word0 |= EOE_HDR_LAST_FRAGMENT;
+    }
+
+    /* First fragment carries the complete size, later ones their offset, both in 32 byte blocks */
+    word1 = (uint16_t)(ep->tx_fragment & 0x3FU);
+    if (ep->tx_fragment == 0)
+    {
+        word1 |= (uint16_t)((((ep->tx_length + ECAT_EOE_FRAGMENT_UNIT - 1U) / ECAT_EOE_FRAGMENT_UNIT) & 0x3FU) << 6);
+    }
+    else
+    {
+        word1 |= (uint16_t)(((ep->tx_offset / ECAT_EOE_FRAGMENT_UNIT) & 0x3FU) << 6);
+    }
+    word1 |= (uint16_t)((ep->tx_frame_no & 0x0FU) << 12);
+
+    mbx.length = ECAT_EOE_HEADER_SIZE + payload;
+    mbx.address = 0;
+    mbx.channel = 0;
+    mbx.priority = 0;
+    mbx.type = ECAT_MBX_TYPE_EOE;
+    mbx.counter = ecat_mbx_next_counter(&ep->mbx_counter);
+    ecat_mbx_write_header(buf, &mbx);
+
+    ECAT_PUT_U16(&buf[ECAT_MBX_HEADER_SIZE], word0);
+    ECAT_PUT_U16(&buf[ECAT_MBX_HEADER_SIZE + 2], word1);
+    memcpy(&buf[ECAT_MBX_HEADER_SIZE + ECAT_EOE_HEADER_SIZE], &ep->tx_frame[ep->tx_offset], payload);
+
+    /* Pad the unused tail of the mailbox */
+    memset(&buf[ECAT_MBX_HEADER_SIZE + ECAT_EOE_HEADER_SIZE + payload], 0,
+           capacity - payload);
+
+    ep->tx_staged = payload;
+    return ep->mbx_size;
+}
+
+void ecat_eoe_tx_confirm(ecat_eoe_endpoint_t *ep, bool accepted)
+{
+    if (!ep || ep->tx_staged == 0)
+    {
+        return;
+    }
+
+    if (!accepted)
+    {
+        /* Slave mailbox still full - same fragment goes out next time */
+        ep->tx_staged = 0;
+        ep->stats.tx_retries++;
+        return;
+    }
+
+    ep->tx_offset += ep->tx_staged;
+    ep->tx_staged = 0;
+    ep->tx_fragment++;
+    ep->stats.tx_fragments++;
+
+    if (ep->tx_offset >= ep->tx_length)
+    {
+        ep->tx_busy = false;
+        ep->stats.tx_frames++;
+    }
+}
+
+ecat_eoe_status_t ecat_eoe_process_mailbox(ecat_eoe_endpoint_t *ep, const uint8_t *mbx, uint16_t length)
+{
+    ecat_mbx_header_t hdr;
+    const uint8_t *eoe;
+    uint16_t word0;
+    uint16_t word1;
+    uint16_t data_len;
+    uint8_t fragment;
+
+    if (!ep || !mbx)
+    {
+        return ECAT_EOE_ERROR_INVALID_PARAM;
+    }
+
+    if (!ecat_mbx_read_header(mbx, length, &hdr) || hdr.type != ECAT_MBX_TYPE_EOE ||
+        hdr.length < ECAT_EOE_HEADER_SIZE)
+    {
+        ep->stats.rx_errors++;
+        return ECAT_EOE_ERROR_PROTOCOL;
+    }
+
+    eoe = &mbx[ECAT_MBX_HEADER_SIZE];
+    word0 = ECAT_GET_U16(&eoe[0]);
+    word1 = ECAT_GET_U16(&eoe[2]);
+
+    if (EOE_HDR_TYPE(word0) != ECAT_EOE_TYPE_FRAGMENT)
+    {
+        /* Init/filter responses are not used by the tunnel */
+        return ECAT_EOE_SUCCESS;
+    }
+
+    data_len = hdr.length - ECAT_EOE_HEADER_SIZE;
+    if ((word0 & EOE_HDR_LAST_FRAGMENT) && (word0 & EOE_HDR_TIME_APPENDED))
+    {
+        data_len = (data_len >= EOE_TIMESTAMP_SIZE) ? (uint16_t)(data_len - EOE_TIMESTAMP_SIZE) : 0U;
+    }
+
+    fragment = (uint8_t)EOE_HDR_FRAGMENT(word1);
+    if (fragment == 0)
+    {
+        /* New frame - any partial frame is abandoned */
+        if (ep->rx_active)
+        {
+            ep->stats.rx_errors++;
+        }
+        ecat_eoe_rx_reset(ep);
+        ep->rx_size = (uint16_t)(EOE_HDR_OFFSET(word1) * ECAT_EOE_FRAGMENT_UNIT);
+        ep->rx_frame_no = (uint8_t)EOE_HDR_FRAME_NO(word1);
+        ep->rx_active = true;
+    }
+    else if (!ep->rx_active || fragment != ep->rx_fragment ||
+             EOE_HDR_FRAME_NO(word1) != ep->rx_frame_no ||
+             EOE_HDR_OFFSET(word1) * ECAT_EOE_FRAGMENT_UNIT != ep->rx_offset)
+    {
+        ecat_eoe_rx_reset(ep);
+        ep->stats.rx_errors++;
+        return ECAT_EOE_ERROR_PROTOCOL;
+    }
+
+    if ((uint32_t)ep->rx_offset + data_len > ECAT_EOE_MAX_FRAME_SIZE ||
+        (uint32_t)ep->rx_offset + data_len > ep->rx_size)
+    {
+        ecat_eoe_rx_reset(ep);
+        ep->stats.rx_errors++;
+        return ECAT_EOE_ERROR_FRAME_SIZE;
+    }
+
+    memcpy(&ep->rx_frame[ep->rx_offset], &eoe[ECAT_EOE_HEADER_SIZE], data_len);
+    ep->rx_offset += data_len;
+    ep->rx_fragment++;
+    ep->stats.rx_fragments++;
+
+    if (word0 & EOE_HDR_LAST_FRAGMENT)
+    {
+        ep->stats.rx_frames++;
+        if (ep->rx_callback)
+        {
+            ep->rx_callback(ep->rx_frame, ep->rx_offset, ep->userData);
+        }
+        ecat_eoe_rx_reset(ep);
+    }
+
+    return ECAT_EOE_SUCCESS;
+}
+
+bool ecat_eoe_tx_pending(const ecat_eoe_endpoint_t *ep)
+{
+    return ep && ep->tx_busy;
+}
+
+void ecat_eoe_get_stats(const ecat_eoe_endpoint_t *ep, ecat_eoe_stats_t *stats)
+{
+    if (ep && stats)
+    {
+        *stats = ep->stats;
+    }
+}
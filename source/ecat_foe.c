@@ -0,0 +1,366 @@
+/*
+ * EtherCAT FoE Download Engine Implementation for FRDM-K64F
+ * Data is streamed straight from the image, no intermediate copy per slave
+ */
+
+#include <string.h>
+#include "ecat_foe.h"
+
+/*******************************************************************************
+ * Private Functions
+ ******************************************************************************/
+
+/**
+ * @brief Check whether a session has a packet it may send now
+ */
+static bool ecat_foe_can_send(const ecat_foe_session_t *session)
+{
+    if (session->staged)
+    {
+        return false;
+    }
+
+    switch (session->state)
+    {
+        case ECAT_FOE_STATE_WRQ:
+            return !session->wrq_sent;
+
+        case ECAT_FOE_STATE_STREAMING:
+            return (session->next_packet <= session->packet_count) &&
+                   (session->next_packet - session->acked_packet <= session->window);
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Write mailbox and FoE headers, return pointer to the FoE payload
+ */
+static uint8_t *ecat_foe_write_headers(ecat_foe_session_t *session, uint8_t *buf,
+                                       uint8_t opcode, uint32_t param, uint16_t payload)
+{
+    ecat_mbx_header_t mbx;
+
+    mbx.length = ECAT_FOE_HEADER_SIZE + payload;
+    mbx.address = 0;
+    mbx.channel = 0;
+    mbx.priority = 0;
+    mbx.type = ECAT_MBX_TYPE_FOE;
+    mbx.counter = ecat_mbx_next_counter(&session->mbx_counter);
+    ecat_mbx_write_header(buf, &mbx);
+
+    buf[ECAT_MBX_HEADER_SIZE] = opcode;
+    buf[ECAT_MBX_HEADER_SIZE + 1] = 0;
+    ECAT_PUT_U32(&buf[ECAT_MBX_HEADER_SIZE + 2], param);
+
+    return &buf[ECAT_MBX_HEADER_SIZE + ECAT_FOE_HEADER_SIZE];
+}
+
+/*******************************************************************************
+ * Public API Implementation
+ ******************************************************************************/
+
+uint16_t ecat_foe_select_mbx_size(uint16_t std_mbx_size, uint16_t boot_mbx_size, bool boot_state)
+{
+    uint16_t size = std_mbx_size;
+
+    /* Bootloaders usually expose a much larger mailbox than the application */
+    if (boot_state && boot_mbx_size > size)
+    {
+        size = boot_mbx_size;
+    }
+
+    if (size > ECAT_MBX_MAX_SIZE)
+    {
+        size = ECAT_MBX_MAX_SIZE;
+    }
+
+    return (size < ECAT_MBX_MIN_SIZE) ? 0U : size;
+}
+
+void ecat_foe_engine_init(ecat_foe_engine_t *engine)
+{
+    if (engine)
+    {
+        memset(engine, 0, sizeof(*engine));
+    }
+}
+
+ecat_foe_session_t *ecat_foe_engine_add(ecat_foe_engine_t *engine, uint16_t station_addr,
+                                        uint16_t mbx_size, const char *filename, uint32_t password,
+                                        const uint8_t *image, uint32_t image_size)
+{
+    ecat_foe_session_t *session;
+    size_t name_len;
+
+    if (!engine || !filename || !image || engine->session_count >= ECAT_FOE_MAX_SESSIONS ||
+        mbx_size < ECAT_MBX_MIN_SIZE || mbx_size > ECAT_MBX_MAX_SIZE)
+    {
+        return NULL;
+    }
+
+    name_len = strlen(filename);
+    if (name_len == 0 || name_len > ECAT_FOE_MAX_FILENAME ||
+        name_len > (size_t)(mbx_size - ECAT_MBX_HEADER_SIZE - ECAT_FOE_HEADER_SIZE))
+    {
+        return NULL;
+    }
+
+    session = &engine->sessions[engine->session_count++];
+    memset(session, 0, sizeof(*session));
+
+    session->station_addr = station_addr;
+    session->mbx_size = mbx_size;
+    memcpy(session->filename, filename, name_len);
+    session->filename_len = (uint8_t)name_len;
+    session->password = password;
+    session->image = image;
+    session->image_size = image_size;
+
+    /* A packet shorter than packet_size ends the transfer, so an exact multiple needs an empty one */
+    session->packet_size = mbx_size - ECAT_MBX_HEADER_SIZE - ECAT_FOE_HEADER_SIZE;
+    session->packet_count = image_size / session->packet_size + 1U;
+    session->window = ECAT_FOE_DEFAULT_WINDOW;
+    session->state = ECAT_FOE_STATE_WRQ;
+
+    return session;
+}
+
+ecat_foe_session_t *ecat_foe_engine_next(ecat_foe_engine_t *engine)
+{
+    uint8_t i;
+    uint8_t idx;
+
+    if (!engine || engine->session_count == 0)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < engine->session_count; i++)
+    {
+        idx = (uint8_t)((engine->next_session + i) % engine->session_count);
+        if (ecat_foe_can_send(&engine->sessions[idx]))
+        {
+            engine->next_session = (uint8_t)((idx + 1U) % engine->session_count);
+            return &engine->sessions[idx];
+        }
+    }
+
+    return NULL;
+}
+
+bool ecat_foe_engine_finished(const ecat_foe_engine_t *engine)
+{
+    uint8_t i;
+
+    if (!engine)
+    {
+        return true;
+    }
+
+    for (i = 0; i < engine->session_count; i++)
+    {
+        if (engine->sessions[i].state == ECAT_FOE_STATE_WRQ ||
+            engine->sessions[i].state == ECAT_FOE_STATE_STREAMING)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ecat_foe_set_window(ecat_foe_session_t *session, uint8_t window)
+{
+    if (session)
+    {
+        if (window == 0)
+        {
+            window = 1;
+        }
+        session->window = (window > ECAT_FOE_MAX_WINDOW) ? ECAT_FOE_MAX_WINDOW : window;
+    }
+}
+
+uint16_t ecat_foe_fill_mailbox(ecat_foe_session_t *session, uint8_t *buf, uint16_t spare_bytes)
+{
+    uint8_t *payload;
+    uint32_t offset;
+    uint16_t data_len;
+    uint16_t used;
+
+    if (!session || !buf || spare_bytes < session->mbx_size || !ecat_foe_can_send(session))
+    {
+        return 0;
+    }
+
+    if (session->state == ECAT_FOE_STATE_WRQ)
+    {
+        payload = ecat_foe_write_headers(session, buf, ECAT_FOE_OP_WRQ, session->password,
+                                         session->filename_len);
+        memcpy(payload, session->filename, session->filename_len);
+        used = session->filename_len;
+        session->staged_packet = 0;
+    }
+    else
+    {
+        offset = (session->next_packet - 1U) * session->packet_size;
+        data_len = (offset < session->image_size) ?
+                   (uint16_t)((session->image_size - offset > session->packet_size) ?
+                              session->packet_size : session->image_size - offset) : 0U;
+
+        payload = ecat_foe_write_headers(session, buf, ECAT_FOE_OP_DATA, session->next_packet, data_len);
+        memcpy(payload, &session->image[offset], data_len);
+        used = data_len;
+        session->staged_packet = session->next_packet;
+    }
+
+    /* Pad the unused tail of the mailbox */
+    memset(&payload[used], 0, session->packet_size - used);
+
+    session->staged = true;
+    return session->mbx_size;
+}
+
+void ecat_foe_tx_confirm(ecat_foe_session_t *session, bool accepted)
+{
+    if (!session || !session->staged)
+    {
+        return;
+    }
+
+    session->staged = false;
+    if (!accepted)
+    {
+        return;
+    }
+
+    if (session->state == ECAT_FOE_STATE_WRQ)
+    {
+        session->wrq_sent = true;
+        return;
+    }
+
+    if (session->staged_packet <= session->highest_sent)
+    {
+        session->packets_resent++;
+    }
+    else
+    {
+        session->highest_sent = session->staged_packet;
+    }
+
+    session->packets_sent++;
+    session->next_packet = session->staged_packet + 1U;
+}
+
+ecat_foe_status_t ecat_foe_process_mailbox(ecat_foe_session_t *session, const uint8_t *mbx, uint16_t length)
+{
+    ecat_mbx_header_t hdr;
+    const uint8_t *foe;
+    uint32_t param;
+
+    if (!session || !mbx)
+    {
+        return ECAT_FOE_ERROR_INVALID_PARAM;
+    }
+
+    if (!ecat_mbx_read_header(mbx, length, &hdr) || hdr.type != ECAT_MBX_TYPE_FOE ||
+        hdr.length < ECAT_FOE_HEADER_SIZE)
+    {
+        return ECAT_FOE_ERROR_PROTOCOL;
+    }
+
+    foe = &mbx[ECAT_MBX_HEADER_SIZE];
+    param = ECAT_GET_U32(&foe[2]);
+
+    switch (foe[0])
+    {
+        case ECAT_FOE_OP_ACK:
+            if (session->state == ECAT_FOE_STATE_WRQ && param == 0 && session->wrq_sent)
+            {
+                session->state = ECAT_FOE_STATE_STREAMING;
+                session->next_packet = 1;
+            }
+            else if (session->state == ECAT_FOE_STATE_STREAMING &&
+                     param > session->acked_packet && param <= session->highest_sent)
+            {
+                /* ACKs are cumulative - one ACK can release several packets of the window */
+                session->acked_packet = param;
+                if (session->acked_packet >= session->packet_count)
+                {
+                    session->state = ECAT_FOE_STATE_DONE;
+                }
+            }
+            else
+            {
+                /* Stale or duplicate ACK */
+                return ECAT_FOE_SUCCESS;
+            }
+            session->idle_cycles = 0;
+            session->retries = 0;
+            return ECAT_FOE_SUCCESS;
+
+        case ECAT_FOE_OP_BUSY:
+            /* Slave is still writing flash - resend from the first unacknowledged packet */
+            if (session->state == ECAT_FOE_STATE_STREAMING)
+            {
+                session->next_packet = session->acked_packet + 1U;
+            }
+            session->idle_cycles = 0;
+            return ECAT_FOE_ERROR_BUSY;
+
+        case ECAT_FOE_OP_ERR:
+            session->error_code = param;
+            session->state = ECAT_FOE_STATE_ERROR;
+            return ECAT_FOE_ERROR_SLAVE;
+
+        default:
+            return ECAT_FOE_ERROR_PROTOCOL;
+    }
+}
+
+void ecat_foe_tick(ecat_foe_session_t *session)
+{
+    if (!session ||
+        (session->state != ECAT_FOE_STATE_WRQ && session->state != ECAT_FOE_STATE_STREAMING))
+    {
+        return;
+    }
+
+    if (++session->idle_cycles < ECAT_FOE_TIMEOUT_CYCLES)
+    {
+        return;
+    }
+
+    session->idle_cycles = 0;
+    if (++session->retries > ECAT_FOE_MAX_RETRIES)
+    {
+        session->state = ECAT_FOE_STATE_ERROR;
+        return;
+    }
+
+    /* Go back to the first unacknowledged packet */
+    if (session->state == ECAT_FOE_STATE_WRQ)
+    {
+        session->wrq_sent = false;
+    }
+    else
+    {
+        session->next_packet = session->acked_packet + 1U;
+    }
+}
+
+uint32_t ecat_foe_bytes_acked(const ecat_foe_session_t *session)
+{
+    uint32_t bytes;
+
+    if (!session)
+    {
+        return 0;
+    }
+
+    bytes = session->acked_packet * session->packet_size;
+    return (bytes > session->image_size) ? session->image_size : bytes;
+}
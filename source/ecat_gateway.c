@@ -0,0 +1,188 @@
+/*
+ * CAN to EtherCAT Gateway Implementation for FRDM-K64F
+ * Wait-free triple buffer between the FlexCAN ISR and the EtherCAT cycle
+ */
+
+#include <string.h>
+#include "ecat_gateway.h"
+#include "triple_buffer.h"
+#include "mem_placement.h"
+#include "Profiler.h"
+
+/*******************************************************************************
+ * Private Variables
+ ******************************************************************************/
+
+static const ecat_gw_route_t *s_routes = NULL;
+static uint8_t s_route_count = 0;
+
+/* Working image, owned by the writer, published through the triple buffer.
+ * Process image data is touched every cycle: SRAM_L. */
+static ecat_gw_image_t s_image MEM_SRAM_L_BSS;
+static ecat_gw_image_t s_slots[3] MEM_SRAM_L_BSS;
+static triple_buffer_t s_channel MEM_SRAM_L_DATA = TRIPLE_BUFFER_INIT(s_slots);
+
+static ecat_gw_stats_t s_stats MEM_SRAM_L_BSS;
+
+/*******************************************************************************
+ * Private Functions
+ ******************************************************************************/
+
+/**
+ * @brief Find the route of a COB-ID (the table holds a handful of entries)
+ */
+static MEM_RAMFUNC const ecat_gw_route_t *ecat_gw_find_route(uint16_t cob_id)
+{
+    uint8_t i;
+
+    for (i = 0; i < s_route_count; i++)
+    {
+        if (s_routes[i].cob_id == cob_id)
+        {
+            return &s_routes[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Copy one bit field from the CAN payload into the image
+ */
+static MEM_RAMFUNC void ecat_gw_write_signal(uint8_t *data, const ecat_gw_signal_t *sig, uint64_t payload)
+{
+    uint64_t value = (payload >> sig->can_bit_offset) & ((1ULL << sig->bit_length) - 1U);
+    uint16_t bit = sig->image_bit_offset;
+    uint8_t remaining = sig->bit_length;
+    uint8_t chunk;
+    uint8_t mask;
+
+    while (remaining > 0)
+    {
+        chunk = (uint8_t)(8U - (bit & 7U));
+        if (chunk > remaining)
+        {
+            chunk = remaining;
+        }
+        mask = (uint8_t)(((1U << chunk) - 1U) << (bit & 7U));
+
+        data[bit >> 3] = (uint8_t)((data[bit >> 3] & ~mask) | (((uint32_t)value << (bit & 7U)) & mask));
+
+        value >>= chunk;
+        bit += chunk;
+        remaining -= chunk;
+    }
+}
+
+/*******************************************************************************
+ * Public API Implementation
+ ******************************************************************************/
+
+ecat_gw_status_t ecat_gw_init(const ecat_gw_route_t *routes, uint8_t count)
+{
+    uint8_t i;
+    uint8_t j;
+
+    if ((!routes && count > 0) || count > ECAT_GW_MAX_ROUTES)
+    {
+        return ECAT_GW_ERROR_INVALID_PARAM;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        for (j = 0; j < routes[i].signal_count; j++)
+        {
+            const ecat_gw_signal_t *sig = &routes[i].signals[j];
+
+            if (sig->bit_length == 0 || sig->bit_length > 32 ||
+                sig->can_bit_offset + sig->bit_length > 64 ||
+                sig->image_bit_offset + sig->bit_length > ECAT_GW_IMAGE_SIZE * 8 ||
+                sig->signal >= ECAT_GW_MAX_SIGNALS)
+            {
+                return ECAT_GW_ERROR_INVALID_PARAM;
+            }
+        }
+    }
+
+    memset(&s_image, 0, sizeof(s_image));
+    memset(s_slots, 0, sizeof(s_slots));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_channel = (triple_buffer_t)TRIPLE_BUFFER_INIT(s_slots);
+    s_routes = routes;
+    s_route_count = count;
+
+    return ECAT_GW_SUCCESS;
+}
+
+MEM_RAMFUNC ecat_gw_status_t ecat_gw_route_frame(const flexcan_frame_t *frame, uint64_t rx_time_ns)
+{
+    const ecat_gw_route_t *route;
+    uint64_t payload;
+    uint8_t i;
+
+    if (!frame)
+    {
+        return ECAT_GW_ERROR_INVALID_PARAM;
+    }
+
+    PROF_BEGIN(GW_ROUTE);
+    route = ecat_gw_find_route((uint16_t)(frame->id >> CAN_ID_STD_SHIFT));
+    if (!route)
+    {
+        s_stats.frames_unrouted++;
+        PROF_END(GW_ROUTE);
+        return ECAT_GW_ERROR_NO_ROUTE;
+    }
+
+    /* dataWord0 holds data byte 0 in its most significant byte */
+    payload = (uint64_t)__REV(frame->dataWord0) | ((uint64_t)__REV(frame->dataWord1) << 32);
+    for (i = 0; i < route->signal_count; i++)
+    {
+        ecat_gw_write_signal(s_image.data, &route->signals[i], payload);
+        s_image.stamp_ns[route->signals[i].signal] = rx_time_ns;
+    }
+    s_image.generation++;
+
+    /* Publish a full copy, the free slot may be two updates old */
+    *(ecat_gw_image_t *)TripleBuffer_WriteSlot(&s_channel) = s_image;
+    TripleBuffer_Publish(&s_channel);
+
+    s_stats.frames_routed++;
+    PROF_END(GW_ROUTE);
+    return ECAT_GW_SUCCESS;
+}
+
+MEM_RAMFUNC bool ecat_gw_snapshot(ecat_gw_image_t *image)
+{
+    bool fresh;
+
+    if (!image)
+    {
+        return false;
+    }
+
+    /* Never waits: the ISR publishes into a slot the reader does not hold */
+    *image = *(const ecat_gw_image_t *)TripleBuffer_Read(&s_channel, &fresh);
+    return fresh;
+}
+
+uint32_t ecat_gw_signal_age_us(const ecat_gw_image_t *image, uint8_t signal, uint64_t now_ns)
+{
+    uint64_t age;
+
+    if (!image || signal >= ECAT_GW_MAX_SIGNALS || image->stamp_ns[signal] == 0)
+    {
+        return UINT32_MAX;
+    }
+
+    age = (now_ns > image->stamp_ns[signal]) ? (now_ns - image->stamp_ns[signal]) / 1000U : 0U;
+    return (age > UINT32_MAX) ? UINT32_MAX : (uint32_t)age;
+}
+
+void ecat_gw_get_stats(ecat_gw_stats_t *stats)
+{
+    if (stats)
+    {
+        *stats = s_stats;
+    }
+}
@@ -0,0 +1,42 @@
+/*
+ * EtherCAT Mailbox Layer Implementation for FRDM-K64F EtherCAT
+ */
+
+#include "ecat_mbx.h"
+
+/*******************************************************************************
+ * Public API Implementation
+ ******************************************************************************/
+
+void ecat_mbx_write_header(uint8_t *buf, const ecat_mbx_header_t *hdr)
+{
+    ECAT_PUT_U16(&buf[0], hdr->length);
+    ECAT_PUT_U16(&buf[2], hdr->address);
+    buf[4] = (uint8_t)((hdr->channel & 0x3FU) | ((hdr->priority & 0x03U) << 6));
+    buf[5] = (uint8_t)((hdr->type & 0x0FU) | ((hdr->counter & 0x07U) << 4));
+}
+
+bool ecat_mbx_read_header(const uint8_t *buf, uint16_t len, ecat_mbx_header_t *hdr)
+{
+    if (!buf || !hdr || len < ECAT_MBX_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    hdr->length = ECAT_GET_U16(&buf[0]);
+    hdr->address = ECAT_GET_U16(&buf[2]);
+    hdr->channel = buf[4] & 0x3FU;
+    hdr->priority = (buf[4] >> 6) & 0x03U;
+    hdr->type = buf[5] & 0x0FU;
+    hdr->counter = (buf[5] >> 4) & 0x07U;
+
+    return (uint32_t)hdr->length + ECAT_MBX_HEADER_SIZE <= len;
+}
+
+uint8_t ecat_mbx_next_counter(uint8_t *counter)
+{
+    uint8_t next = (uint8_t)((*counter % 7U) + 1U);
+
+    *counter = next;
+    return next;
+}
@@ -10,6 +10,10 @@
 #include "fsl_debug_console.h"
 #include "board.h"
 #include "Utilities.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "lockfree.h"
+#include "mem_placement.h"
 
 /*******************************************************************************
  * Private Definitions
@@ -33,6 +37,10 @@
  * Private Variables
  ******************************************************************************/
 
+/* 1588 timer software extension (seconds counted by the TS_TIMER interrupt on ATVR wrap) */
+static volatile bool s_time_running = false;
+static uint64_t s_time_seconds_ns = 0;
+
 void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
 {
     taskDISABLE_INTERRUPTS();
@@ -40,28 +48,33 @@ void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
     for(;;);
 }
 
-/* DMA Buffer Descriptors (must be in non-cacheable memory) */
-AT_NONCACHEABLE_SECTION_ALIGN(
+/* DMA Buffer Descriptors, in SRAM_U with the DMA buffers, away from the CPU hot data */
+MEM_SRAM_U_DMA(
     static enet_rx_bd_struct_t s_rxBuffDescrip[ENET_RAW_RXBD_NUM],
     ENET_BUFF_ALIGNMENT
 );
 
-AT_NONCACHEABLE_SECTION_ALIGN(
+MEM_SRAM_U_DMA(
     static enet_tx_bd_struct_t s_txBuffDescrip[ENET_RAW_TXBD_NUM],
     ENET_BUFF_ALIGNMENT
 );
 
-/* DMA Data Buffers (non-cacheable for zero-copy) */
-AT_NONCACHEABLE_SECTION_ALIGN(
+/* DMA Data Buffers */
+MEM_SRAM_U_DMA(
     static uint8_t s_rxDataBuff[ENET_RAW_RXBD_NUM][SDK_SIZEALIGN(ENET_RAW_BUFFER_SIZE, APP_ENET_BUFF_ALIGNMENT)],
     APP_ENET_BUFF_ALIGNMENT
 );
 
-AT_NONCACHEABLE_SECTION_ALIGN(
+MEM_SRAM_U_DMA(
     static uint8_t s_txDataBuff[ENET_RAW_TXBD_NUM][SDK_SIZEALIGN(ENET_RAW_BUFFER_SIZE, APP_ENET_BUFF_ALIGNMENT)],
     APP_ENET_BUFF_ALIGNMENT
 );
 
+/* Received frames handed to the application, one bit per free buffer. The copy
+ * out of the DMA buffer reads SRAM_U and writes SRAM_L, one bus each. */
+static uint8_t s_rxFramePool[ENET_RAW_RX_POOL_NUM][ENET_RAW_BUFFER_SIZE] MEM_SRAM_L_BSS;
+static volatile uint32_t s_rxFramePoolFree MEM_SRAM_L_DATA = 0xFFFFFFFFUL >> (32U - ENET_RAW_RX_POOL_NUM);
+
 /*******************************************************************************
  * Private Functions
  ******************************************************************************/
@@ -69,12 +82,13 @@ AT_NONCACHEABLE_SECTION_ALIGN(
 /**
  * @brief ENET interrupt callback for frame reception
  */
-static void enet_raw_callback(ENET_Type *base, enet_handle_t *enet_handle,
-                            enet_event_t event, enet_frame_info_t *frameInfo, void *userData)
+static MEM_RAMFUNC void enet_raw_callback(ENET_Type *base, enet_handle_t *enet_handle,
+                                          enet_event_t event, enet_frame_info_t *frameInfo, void *userData)
 {
     enet_raw_handle_t *handle = (enet_raw_handle_t *)userData;
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
+    TRACE_ISR_ENTER(TRACE_ISR_ENET);
     switch (event)
     {
         case kENET_RxEvent:
@@ -95,14 +109,79 @@ static void enet_raw_callback(ENET_Type *base, enet_handle_t *enet_handle,
             break;
     }
 
+    TRACE_ISR_EXIT(TRACE_ISR_ENET);
+
     /* Yield to higher priority task if needed */
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
+/**
+ * @brief Take a buffer from the RX frame pool, lock-free
+ * @return Buffer of ENET_RAW_BUFFER_SIZE bytes, NULL if all are in use
+ */
+static MEM_RAMFUNC uint8_t *enet_raw_pool_get(void)
+{
+    uint32_t free_mask;
+    uint32_t index;
+
+    do
+    {
+        free_mask = s_rxFramePoolFree;
+        if (free_mask == 0U)
+        {
+            return NULL;
+        }
+        index = (uint32_t)__builtin_ctz(free_mask);
+    } while (!LF_CompareSwap(&s_rxFramePoolFree, free_mask, free_mask & ~(1UL << index)));
+
+    return s_rxFramePool[index];
+}
+
+/**
+ * @brief Return a buffer obtained from enet_raw_pool_get()
+ *
+ * Anything else, a pointer outside the pool or into the middle of a buffer,
+ * is ignored rather than freeing the wrong buffer.
+ */
+static MEM_RAMFUNC void enet_raw_pool_put(const uint8_t *buffer)
+{
+    uintptr_t offset = (uintptr_t)buffer - (uintptr_t)&s_rxFramePool[0][0];
+    uint32_t index;
+    uint32_t free_mask;
+
+    if ((uintptr_t)buffer < (uintptr_t)&s_rxFramePool[0][0] ||
+        offset >= sizeof(s_rxFramePool) || (offset % ENET_RAW_BUFFER_SIZE) != 0U)
+    {
+        return;
+    }
+    index = (uint32_t)(offset / ENET_RAW_BUFFER_SIZE);
+
+    do
+    {
+        free_mask = s_rxFramePoolFree;
+    } while (!LF_CompareSwap(&s_rxFramePoolFree, free_mask, free_mask | (1UL << index)));
+}
+
+/**
+ * @brief Give the RX semaphore back while frames are left in the ring
+ *
+ * The semaphore is binary and the RX interrupt may come once for several
+ * frames, so without this a burst would leave frames behind until the next one.
+ */
+static MEM_RAMFUNC void enet_raw_rx_rearm(enet_raw_handle_t *handle)
+{
+    uint32_t length;
+
+    if (ENET_GetRxFrameSize(&handle->enet_handle, &length, 0) != kStatus_ENET_RxFrameEmpty)
+    {
+        xSemaphoreGive(handle->rx_semaphore);
+    }
+}
+
 /**
  * @brief Check if received frame is EtherCAT
  */
-static bool enet_raw_is_ethercat_frame(const uint8_t *frame, uint16_t length)
+static MEM_RAMFUNC bool enet_raw_is_ethercat_frame(const uint8_t *frame, uint16_t length)
 {
     if (length < 14) /* Minimum Ethernet header size */
     {
@@ -129,18 +208,18 @@ enet_raw_status_t enet_raw_init(enet_raw_handle_t *handle, const uint8_t *mac_ad
 
     if (!handle || !mac_addr)
     {
-        UART_LOG("ENET Init: Invalid parameters\n");
+        LOG_ERROR(ENET, "ENET Init: Invalid parameters\n");
         return ENET_RAW_ERROR_INVALID_PARAM;
     }
 
     SYSMPU_Enable(SYSMPU, false);
 
-    handle->tx_mutex = xSemaphoreCreateMutex();
-    handle->rx_semaphore = xSemaphoreCreateBinary();
+    handle->tx_mutex = xSemaphoreCreateMutexStatic(&handle->tx_mutex_buffer);
+    handle->rx_semaphore = xSemaphoreCreateBinaryStatic(&handle->rx_semaphore_buffer);
 
     if (!handle->tx_mutex || !handle->rx_semaphore)
     {
-        UART_LOG("ENET Init: Failed to create FreeRTOS synchronization objects\n");
+        LOG_ERROR(ENET, "ENET Init: Failed to create FreeRTOS synchronization objects\n");
         return ENET_RAW_ERROR_INIT;
     }
 
@@ -192,12 +271,12 @@ enet_raw_status_t enet_raw_init(enet_raw_handle_t *handle, const uint8_t *mac_ad
             } while (--count);
             if (!autonego)
             {
-                UART_LOG("ENET Init: PHY Auto-negotiation failed. Please check the cable connection and link partner setting.\n");
+                LOG_ERROR(ENET, "ENET Init: PHY Auto-negotiation failed. Please check the cable connection and link partner setting.\n");
             }
         }
     } while (!(link && autonego));
 
-    UART_LOG("ENET Init: PHY initialization successful\n");
+    LOG_INFO(ENET, "ENET Init: PHY initialization successful\n");
 
     /* Get the actual PHY link speed - exactly like NXP */
     PHY_GetLinkSpeedDuplex(&handle->phy_handle, &speed, &duplex);
@@ -206,7 +285,7 @@ enet_raw_status_t enet_raw_init(enet_raw_handle_t *handle, const uint8_t *mac_ad
     config.miiDuplex = (enet_mii_duplex_t)duplex;
     handle->link_up = true;
 
-    UART_PRINTF("ENET Init: Using actual link speed/duplex: %s/%s\r\n",
+    LOG_INFO(ENET, "ENET Init: Using actual link speed/duplex: %s/%s\r\n",
            (speed == kPHY_Speed100M) ? "100M" : "10M",
            (duplex == kPHY_FullDuplex) ? "Full" : "Half");
 
@@ -224,10 +303,12 @@ enet_raw_status_t enet_raw_init(enet_raw_handle_t *handle, const uint8_t *mac_ad
 
     ENET_ActiveRead(ENET);
 
+    enet_raw_time_start();
+
     /* Reset statistics */
     enet_raw_reset_stats(handle);
 
-    UART_LOG("ENET Init: Initialization completed successfully!\n");
+    LOG_INFO(ENET, "ENET Init: Initialization completed successfully!\n");
     return ENET_RAW_SUCCESS;
 }
 
@@ -238,6 +319,9 @@ enet_raw_status_t enet_raw_close(enet_raw_handle_t *handle)
         return ENET_RAW_ERROR_INVALID_PARAM;
     }
 
+    s_time_running = false;
+    DisableIRQ(ENET_1588_Timer_IRQn);
+
     /* Disable ENET peripheral */
     ENET_Deinit(ENET_RAW_BASE);
 
@@ -259,9 +343,9 @@ enet_raw_status_t enet_raw_close(enet_raw_handle_t *handle)
     return ENET_RAW_SUCCESS;
 }
 
-enet_raw_status_t enet_raw_send_frame(enet_raw_handle_t *handle,
-                                     const uint8_t *frame,
-                                     uint16_t length)
+MEM_RAMFUNC enet_raw_status_t enet_raw_send_frame(enet_raw_handle_t *handle,
+                                                 const uint8_t *frame,
+                                                 uint16_t length)
 {
     status_t status;
 
@@ -283,7 +367,9 @@ enet_raw_status_t enet_raw_send_frame(enet_raw_handle_t *handle,
     }
 
     /* Send frame (non-blocking) */
+    PROF_BEGIN(ENET_TX);
     status = ENET_SendFrame(ENET_RAW_BASE, &handle->enet_handle, frame, length, 0, false, NULL);
+    PROF_END(ENET_TX);
 
     /* Release TX mutex */
     xSemaphoreGive(handle->tx_mutex);
@@ -304,25 +390,18 @@ enet_raw_status_t enet_raw_send_frame(enet_raw_handle_t *handle,
     }
 }
 
-enet_raw_status_t enet_raw_receive_frame(enet_raw_handle_t *handle,
-                                        enet_raw_frame_t *frame,
-                                        uint32_t timeout_ms)
+/**
+ * @brief Copy the signalled frame out of the DMA ring into a pool buffer
+ *
+ * Every outcome returns through enet_raw_receive_frame(), which times it as the
+ * enet_rx probe: the drop and filter paths are part of the RX processing time.
+ */
+static MEM_RAMFUNC enet_raw_status_t enet_raw_read_frame(enet_raw_handle_t *handle, enet_raw_frame_t *frame)
 {
     status_t status;
     uint32_t length = 0;
     uint8_t *data_ptr;
 
-    if (!handle || !frame)
-    {
-        return ENET_RAW_ERROR_INVALID_PARAM;
-    }
-
-    /* Wait for frame reception with timeout */
-    if (xSemaphoreTake(handle->rx_semaphore, pdMS_TO_TICKS(timeout_ms)) != pdTRUE)
-    {
-        return ENET_RAW_ERROR_TIMEOUT;
-    }
-
     /* Check for received frame */
     status = ENET_GetRxFrameSize(&handle->enet_handle, &length, 0);
 
@@ -330,6 +409,7 @@ enet_raw_status_t enet_raw_receive_frame(enet_raw_handle_t *handle,
     {
         /* Handle RX error - discard frame */
         ENET_ReadFrame(ENET_RAW_BASE, &handle->enet_handle, NULL, 0, 0, NULL);
+        enet_raw_rx_rearm(handle);
         handle->stats.rx_errors++;
         return ENET_RAW_ERROR_INIT;
     }
@@ -339,21 +419,24 @@ enet_raw_status_t enet_raw_receive_frame(enet_raw_handle_t *handle,
         return ENET_RAW_ERROR_TIMEOUT;
     }
 
-    /* Allocate temporary buffer for frame validation */
-    data_ptr = pvPortMalloc(length);
+    /* Take a buffer from the static pool, the frame is copied out of the DMA ring */
+    data_ptr = (length <= ENET_RAW_BUFFER_SIZE) ? enet_raw_pool_get() : NULL;
     if (!data_ptr)
     {
         /* Release frame without reading */
         ENET_ReadFrame(ENET_RAW_BASE, &handle->enet_handle, NULL, 0, 0, NULL);
+        enet_raw_rx_rearm(handle);
+        handle->stats.rx_dropped++;
         return ENET_RAW_ERROR_NO_BUFFER;
     }
 
     /* Read frame data */
     status = ENET_ReadFrame(ENET_RAW_BASE, &handle->enet_handle, data_ptr, length, 0, NULL);
+    enet_raw_rx_rearm(handle);
 
     if (status != kStatus_Success)
     {
-        vPortFree(data_ptr);
+        enet_raw_pool_put(data_ptr);
         handle->stats.rx_errors++;
         return ENET_RAW_ERROR_INIT;
     }
@@ -361,7 +444,7 @@ enet_raw_status_t enet_raw_receive_frame(enet_raw_handle_t *handle,
     /* Filter for EtherCAT frames only */
     if (!enet_raw_is_ethercat_frame(data_ptr, length))
     {
-        vPortFree(data_ptr);
+        enet_raw_pool_put(data_ptr);
         handle->stats.non_ethercat++;
         return ENET_RAW_ERROR_TIMEOUT; /* Try again for EtherCAT frame */
     }
@@ -374,11 +457,36 @@ enet_raw_status_t enet_raw_receive_frame(enet_raw_handle_t *handle,
     return ENET_RAW_SUCCESS;
 }
 
-void enet_raw_release_frame(enet_raw_handle_t *handle, enet_raw_frame_t *frame)
+MEM_RAMFUNC enet_raw_status_t enet_raw_receive_frame(enet_raw_handle_t *handle,
+                                                    enet_raw_frame_t *frame,
+                                                    uint32_t timeout_ms)
+{
+    enet_raw_status_t result;
+
+    if (!handle || !frame)
+    {
+        return ENET_RAW_ERROR_INVALID_PARAM;
+    }
+
+    /* Wait for frame reception with timeout */
+    if (xSemaphoreTake(handle->rx_semaphore, pdMS_TO_TICKS(timeout_ms)) != pdTRUE)
+    {
+        return ENET_RAW_ERROR_TIMEOUT;
+    }
+
+    /* Profiled from here: the wait above is not processing time */
+    PROF_BEGIN(ENET_RX);
+    result = enet_raw_read_frame(handle, frame);
+    PROF_END(ENET_RX);
+
+    return result;
+}
+
+MEM_RAMFUNC void enet_raw_release_frame(enet_raw_handle_t *handle, enet_raw_frame_t *frame)
 {
     if (handle && frame && frame->data)
     {
-        vPortFree(frame->data);
+        enet_raw_pool_put(frame->data);
         frame->data = NULL;
         frame->length = 0;
     }
@@ -413,6 +521,88 @@ void enet_raw_reset_stats(enet_raw_handle_t *handle)
     }
 }
 
+void enet_raw_time_start(void)
+{
+    uint32_t clock_hz = ENET_RAW_CLOCK_FREQ;
+    uint32_t inc = ENET_RAW_TIME_PERIOD_NS / clock_hz;
+    uint32_t remainder = ENET_RAW_TIME_PERIOD_NS - inc * clock_hz;
+
+    /* Timer runs from the core clock (SIM_SOPT2[TIMESRC] = 0) */
+    ENET_RAW_BASE->ATCR = 0;
+    ENET_RAW_BASE->ATINC = ENET_ATINC_INC(inc);
+
+    /* Non-integer period: add one extra nanosecond every ATCOR ticks (120 MHz -> 8, 8, 9) */
+    if (remainder != 0U)
+    {
+        ENET_RAW_BASE->ATINC |= ENET_ATINC_INC_CORR(inc + 1U);
+        ENET_RAW_BASE->ATCOR = clock_hz / remainder;
+    }
+    else
+    {
+        ENET_RAW_BASE->ATCOR = 0;
+    }
+
+    ENET_RAW_BASE->ATPER = ENET_RAW_TIME_PERIOD_NS;
+    ENET_RAW_BASE->ATVR = 0;
+
+    /* Every wrap raises TS_TIMER, its interrupt counts the periods whether or not anybody reads the time */
+    s_time_seconds_ns = 0;
+    ENET_ClearInterruptStatus(ENET_RAW_BASE, kENET_TsTimerInterrupt);
+    ENET_EnableInterrupts(ENET_RAW_BASE, kENET_TsTimerInterrupt);
+    NVIC_SetPriority(ENET_1588_Timer_IRQn, ENET_RAW_TIME_IRQ_PRIORITY);
+    EnableIRQ(ENET_1588_Timer_IRQn);
+
+    ENET_RAW_BASE->ATCR = ENET_ATCR_PEREN_MASK | ENET_ATCR_EN_MASK;
+    s_time_running = true;
+}
+
+/**
+ * @brief 1588 timer interrupt: one more period on each ATVR wrap
+ *
+ * Replaces the weak SDK handler, the driver is not in enhanced descriptor mode
+ * and installs no 1588 timer ISR of its own.
+ */
+void ENET_1588_Timer_IRQHandler(void)
+{
+    if (ENET_GetInterruptStatus(ENET_RAW_BASE) & kENET_TsTimerInterrupt)
+    {
+        ENET_ClearInterruptStatus(ENET_RAW_BASE, kENET_TsTimerInterrupt);
+        s_time_seconds_ns += ENET_RAW_TIME_PERIOD_NS;
+    }
+    __DSB();
+}
+
+uint64_t enet_raw_time_ns(void)
+{
+    UBaseType_t saved;
+    uint32_t ns;
+    uint64_t now;
+
+    if (!s_time_running)
+    {
+        return 0;
+    }
+
+    saved = portSET_INTERRUPT_MASK_FROM_ISR();
+
+    ENET_RAW_BASE->ATCR |= ENET_ATCR_CAPTURE_MASK;
+    while (ENET_RAW_BASE->ATCR & ENET_ATCR_CAPTURE_MASK)
+    {
+    }
+    ns = ENET_RAW_BASE->ATVR;
+    now = s_time_seconds_ns + ns;
+
+    /* A wrap the masked interrupt has not counted yet: the capture is past it if it reads low */
+    if ((ENET_GetInterruptStatus(ENET_RAW_BASE) & kENET_TsTimerInterrupt) && ns < ENET_RAW_TIME_PERIOD_NS / 2U)
+    {
+        now += ENET_RAW_TIME_PERIOD_NS;
+    }
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(saved);
+
+    return now;
+}
+
 /*******************************************************************************
  * Testing and Debug Functions
  ******************************************************************************/
@@ -470,36 +660,48 @@ enet_raw_status_t enet_raw_send_ping_frame(enet_raw_handle_t *handle)
 
 void enet_raw_dump_frame(const uint8_t *frame, uint16_t length, const char *label)
 {
-    if (!frame || length == 0)
+    /* Verbose diagnostic: compiled out below LOG_LEVEL_VERBOSE, else off until enabled at runtime.
+     * Anything shorter than the 14-byte Ethernet header is not dumped. */
+    if (!LOG_ENABLED(ENET, LOG_LEVEL_VERBOSE) || !frame || length < 14)
     {
         return;
     }
 
-    UART_PRINTF("\r\n=== %s (Length: %d) ===\r\n", label ? label : "Frame", length);
+    /* Deferred: the dump costs a few slot copies here, formatting runs in the logger */
+    UART_DPRINTF("\r\n=== %s (Length: %d) ===\r\n", label ? label : "Frame", length);
 
     /* Dump Ethernet header */
-    UART_PRINTF("DST: %02X:%02X:%02X:%02X:%02X:%02X\r\n",
+    UART_DPRINTF("DST: %02X:%02X:%02X:%02X:%02X:%02X\r\n",
            frame[0], frame[1], frame[2], frame[3], frame[4], frame[5]);
-    UART_PRINTF("SRC: %02X:%02X:%02X:%02X:%02X:%02X\r\n",
+    UART_DPRINTF("SRC: %02X:%02X:%02X:%02X:%02X:%02X\r\n",
            frame[6], frame[7], frame[8], frame[9], frame[10], frame[11]);
-    UART_PRINTF("Type: 0x%04X", ENET_RAW_GET_ETHERTYPE(frame));
+    UART_DPRINTF("Type: 0x%04X%s\r\n", ENET_RAW_GET_ETHERTYPE(frame),
+           ENET_RAW_IS_ETHERCAT(frame) ? " (EtherCAT)" : "");
 
-    if (ENET_RAW_IS_ETHERCAT(frame))
+    /* Dump first 32 bytes of payload in hex, packed 4 bytes per argument word */
+    UART_DPRINTF("Data:");
+    const uint8_t *data = &frame[14];
+    uint16_t dump_len = (length > 46) ? 32 : (length - 14);
+    int i = 0;
+    for (; i + 16 <= dump_len; i += 16)
     {
-        UART_LOG(" (EtherCAT)\n");
+        UART_DPRINTF("\r\n  %08lX %08lX %08lX %08lX",
+               (unsigned long)__REV(__UNALIGNED_UINT32_READ(&data[i])),
+               (unsigned long)__REV(__UNALIGNED_UINT32_READ(&data[i + 4])),
+               (unsigned long)__REV(__UNALIGNED_UINT32_READ(&data[i + 8])),
+               (unsigned long)__REV(__UNALIGNED_UINT32_READ(&data[i + 12])));
     }
-    else
+    if (i < dump_len)
     {
-        UART_LOG("\n");
+        UART_DPRINTF("\r\n ");
     }
-
-    /* Dump first 32 bytes of payload in hex */
-    UART_LOG("Data: ");
-    uint16_t dump_len = (length > 46) ? 32 : (length - 14);
-    for (int i = 0; i < dump_len; i++)
+    for (; i + 4 <= dump_len; i += 4)
+    {
+        UART_DPRINTF(" %08lX", (unsigned long)__REV(__UNALIGNED_UINT32_READ(&data[i])));
+    }
+    for (; i < dump_len; i++)
     {
-        if (i % 16 == 0) UART_LOG("\r\n  ");
-        UART_PRINTF("%02X ", frame[14 + i]);
+        UART_DPRINTF(" %02X", data[i]);
     }
-    UART_LOG("\r\n");
+    UART_DPRINTF("\r\n");
 }
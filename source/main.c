@@ -10,77 +10,123 @@
 #include "Utilities.h"
 #include "rtos.h"
 #include "enet_raw.h"  // Add this include
-
-void vApplicationMallocFailedHook(void)
-{
-    taskDISABLE_INTERRUPTS();
-    UART_LOG("FATAL: FreeRTOS malloc failed\r\n");
-    for(;;);
-}
+#include "Shell.h"
+#include "CyclicTask.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "MemBench.h"
+#include "EnetBench.h"
+#include "EcatBench.h"
+#include "EoeBench.h"
+#include "FoeUpdate.h"
+#include "GatewayBench.h"
+#include "ecat_gateway.h"
+#include "ecat_cycle.h"
+#include "mem_placement.h"
 
 // Forward declarations for test tasks
 void ethernet_test_main_task(void *pvParameters);
 void ethernet_test_rx_task(void *pvParameters);
-void simple_logger_task(void *pvParameters);
+static void simple_logger_cycle(void *arg);
+static void ethernet_test_cycle(void *arg);
+
+static enet_raw_handle_t s_enet_handle MEM_SRAM_L_BSS;
+static ecat_cycle_t s_ecat_cycle MEM_SRAM_L_BSS;
+
+// Task stacks and TCBs, all static: nothing is allocated at run time.
+// In SRAM_L, off the bus the ENET DMA uses.
+static StackType_t s_ethercat_stack[ETHERCAT_TASK_STACK_SIZE] MEM_SRAM_L_BSS;
+static StaticTask_t s_ethercat_tcb MEM_SRAM_L_BSS;
+static StackType_t s_eth_rx_stack[ETH_RX_TASK_STACK_SIZE] MEM_SRAM_L_BSS;
+static StaticTask_t s_eth_rx_tcb MEM_SRAM_L_BSS;
+static StackType_t s_can_stack[CAN_TASK_STACK_SIZE] MEM_SRAM_L_BSS;
+static StaticTask_t s_can_tcb MEM_SRAM_L_BSS;
+static StackType_t s_logger_stack[LOGGER_TASK_STACK_SIZE] MEM_SRAM_L_BSS;
+static StackType_t s_shell_stack[SHELL_TASK_STACK_SIZE] MEM_SRAM_L_BSS;
+static StaticTask_t s_shell_tcb MEM_SRAM_L_BSS;
+
+// Cyclic tasks
+static const cyclic_task_config_t s_logger_cycle_config = {
+    "Logger", LOGGER_PERIOD_MS, 0, LOGGER_BUDGET_US, simple_logger_cycle, NULL
+};
+static const cyclic_task_config_t s_ethernet_cycle_config = {
+    "EthTest", ETHERCAT_PERIOD_MS, 0, ETHERCAT_BUDGET_US, ethernet_test_cycle, NULL
+};
+static cyclic_task_t s_logger_cycle MEM_SRAM_L_BSS;
+static cyclic_task_t s_ethernet_cycle MEM_SRAM_L_BSS;
+
+// Ethernet test schedule, in cycles of ETHERCAT_PERIOD_MS
+#define PING_INTERVAL_MS    (1000U)     // 1 second between pings
+#define STATS_INTERVAL_MS   (5000U)     // 5 seconds between stats
+#define MAX_PING_COUNT      (20U)       // Run 20 pings then repeat
+
+static void print_ethernet_stats(void);
+static int stats_shell_command(int argc, char *argv[]);
+
+static const shell_command_t stats_command = { "stats", "- Ethernet statistics", stats_shell_command };
 
 int main(void)
 {
     Init();
     UART_LogSetEnabled(true);
+    Profiler_Init();
+    Trace_Init();
+    MemBench_Init();
 
     #ifndef BOARD_INIT_DEBUG_CONSOLE_PERIPHERAL
     BOARD_InitDebugConsole();
     #endif
 
-    g_can_data_mutex = xSemaphoreCreateMutex();
-    if (g_can_data_mutex == NULL) {
-        UART_LOG("Failed to create CAN data mutex\r\n");
-        while(1);
-    }
-
-    BaseType_t result;
-
     // Create Ethernet test main task (replaces ethercat_task for now)
-    result = xTaskCreate(
+    g_ethercat_task_handle = xTaskCreateStatic(
         ethernet_test_main_task,        /* Task function */
         "EthTest",                      /* Task name */
-        ETHERCAT_TASK_STACK_SIZE,      /* Stack size (reuse your define) */
+        ETHERCAT_TASK_STACK_SIZE,      /* Stack size in words */
         NULL,                          /* Parameters */
-        ETHERCAT_TASK_PRIORITY,        /* Priority (reuse your define) */
-        &g_ethercat_task_handle        /* Handle */
+        ETHERCAT_TASK_PRIORITY,        /* Priority */
+        s_ethercat_stack,              /* Stack */
+        &s_ethercat_tcb                /* TCB */
     );
-    if (result != pdPASS) {
+    if (g_ethercat_task_handle == NULL) {
         UART_LogMessage("Failed to create Ethernet test task\r\n");
         while(1);
     }
 
-    // Skip CAN task for now (comment out)
-    /*
-    result = xTaskCreate(
+    // Create CAN task, woken by the FlexCAN RX FIFO interrupt
+    g_can_task_handle = xTaskCreateStatic(
         can_monitor_task,
         "CANMon",
         CAN_TASK_STACK_SIZE,
         NULL,
         CAN_MONITOR_TASK_PRIORITY,
-        &g_can_task_handle
+        s_can_stack,
+        &s_can_tcb
     );
-    if (result != pdPASS) {
-        UART_LogMessage("Failed to create CAN task\n");
+    if (g_can_task_handle == NULL) {
+        UART_LogMessage("Failed to create CAN task\r\n");
         while(1);
     }
-    */
 
-    // Create simple logger task
-    result = xTaskCreate(
-        simple_logger_task,
-        "Logger",
-        LOGGER_TASK_STACK_SIZE,
+    // Create simple logger task, cyclic every LOGGER_PERIOD_MS
+    if (CyclicTask_Create(&s_logger_cycle, &s_logger_cycle_config,
+                          LOGGER_TASK_PRIORITY, s_logger_stack, LOGGER_TASK_STACK_SIZE,
+                          &g_logger_task_handle) != kStatus_Success) {
+        UART_LogMessage("Failed to create Logger task\r\n");
+        while(1);
+    }
+
+    // Create the command shell, lowest priority like the logger
+    g_shell_task_handle = xTaskCreateStatic(
+        shell_task,
+        "Shell",
+        SHELL_TASK_STACK_SIZE,
         NULL,
-        LOGGER_TASK_PRIORITY,
-        &g_logger_task_handle
+        SHELL_TASK_PRIORITY,
+        s_shell_stack,
+        &s_shell_tcb
     );
-    if (result != pdPASS) {
-        UART_LogMessage("Failed to create Logger task\r\n");
+    if (g_shell_task_handle == NULL) {
+        UART_LogMessage("Failed to create Shell task\r\n");
         while(1);
     }
 
@@ -101,19 +147,13 @@ int main(void)
  * Task Implementations
  ******************************************************************************/
 
-// Simple logger task that just calls UART_LogProcess
-void simple_logger_task(void *pvParameters)
+// Simple logger cycle: kicks the interrupt-driven UART transmitter
+static void simple_logger_cycle(void *arg)
 {
-    UART_LOG("Logger task started\r\n");
-
-    while(1)
-    {
-        // Call your UART log processing function
-        UART_LogProcess();
+    (void)arg;
 
-        // Run every 10ms as specified in your plan
-        vTaskDelay(pdMS_TO_TICKS(10));
-    }
+    // Returns at once, the TX interrupt sends the queued text
+    UART_LogProcess();
 }
 
 // Ethernet test RX task (adapted from my original)
@@ -135,14 +175,14 @@ void ethernet_test_rx_task(void *pvParameters)
         {
             frame_count++;
 
-            UART_PRINTF("RX[%lu]: Frame received, length=%d\r\n",
-                       frame_count, rx_frame.length);
+            UART_DPRINTF("RX[%lu]: Frame received, length=%d\r\n",
+                       (unsigned long)frame_count, rx_frame.length);
 
             // Check if this is our test frame by looking at sequence number
             if (rx_frame.length >= 18)
             {
                 uint16_t sequence = (rx_frame.data[16] << 8) | rx_frame.data[17];
-                UART_PRINTF("  Test frame sequence: %d\r\n", sequence);
+                UART_DPRINTF("  Test frame sequence: %d\r\n", sequence);
             }
 
             // Release frame buffer
@@ -150,7 +190,7 @@ void ethernet_test_rx_task(void *pvParameters)
         }
         else if (status != ENET_RAW_ERROR_TIMEOUT)
         {
-            UART_PRINTF("RX Task: Receive error %d\r\n", status);
+            UART_DPRINTF("RX Task: Receive error %d\r\n", status);
         }
 
         // Small delay to prevent overwhelming the console
@@ -161,19 +201,10 @@ void ethernet_test_rx_task(void *pvParameters)
 // Main Ethernet test task (adapted from my original)
 void ethernet_test_main_task(void *pvParameters)
 {
-    static enet_raw_handle_t s_enet_handle;  // Static to persist
     enet_raw_status_t status;
-    enet_raw_stats_t stats;
-    uint32_t ping_count = 0;
-    uint32_t last_stats_time = 0;
-    uint32_t last_ping_time = 0;
-    uint32_t current_time;
+    TaskHandle_t rx_task;
     uint8_t test_mac[] = {0x02, 0x12, 0x13, 0x10, 0x15, 0x11};  // Test MAC
 
-    const uint32_t PING_INTERVAL_MS = 1000;   // 1 second between pings
-    const uint32_t STATS_INTERVAL_MS = 5000;  // 5 seconds between stats
-    const uint32_t MAX_PING_COUNT = 20;       // Run 20 pings then repeat
-
     UART_LOG("\n=== FRDM-K64F Ethernet Layer Test ===\r\n");
 
     // Initialize raw Ethernet interface
@@ -202,82 +233,117 @@ void ethernet_test_main_task(void *pvParameters)
     }
 
     // Start RX task
-    if (xTaskCreate(ethernet_test_rx_task, "EthRX", 2048, &s_enet_handle,
-                    ETHERCAT_TASK_PRIORITY + 1, NULL) != pdPASS)
+    rx_task = xTaskCreateStatic(ethernet_test_rx_task, "EthRX", ETH_RX_TASK_STACK_SIZE, &s_enet_handle,
+                                ETH_RX_TASK_PRIORITY, s_eth_rx_stack, &s_eth_rx_tcb);
+    if (rx_task == NULL)
     {
         UART_LOG("ERROR: Failed to create RX test task\r\n");
         goto test_cleanup;
     }
 
+    (void)Shell_RegisterCommand(&stats_command);
+    EnetBench_Init(&s_enet_handle, rx_task);
+    EcatBench_Init(&s_enet_handle, rx_task);
+#if ECAT_GATEWAY_ENABLE
+    // The frame builder carries the gateway output image in its LRW while gwbench
+    // runs; the test cycle below does not exchange process data
+    if (ecat_cycle_init(&s_ecat_cycle, &s_enet_handle, ECAT_GW_IMAGE_SIZE) == ECAT_CYCLE_SUCCESS)
+#else
+    if (ecat_cycle_init(&s_ecat_cycle, &s_enet_handle, 0) == ECAT_CYCLE_SUCCESS)
+#endif
+    {
+        EoeBench_Init(&s_ecat_cycle, rx_task);
+        FoeUpdate_Init(&s_ecat_cycle, rx_task);
+#if ECAT_GATEWAY_ENABLE
+        GatewayBench_Init(&s_ecat_cycle, rx_task);
+#endif
+    }
+
     UART_LOG("\nStarting test loop...\n");
-    UART_PRINTF("- Sending test EtherCAT frames every %lu ms\r\n", PING_INTERVAL_MS);
-    UART_PRINTF("- Displaying statistics every %lu ms\r\n", STATS_INTERVAL_MS);
+    UART_PRINTF("- Sending test EtherCAT frames every %lu ms\r\n", (unsigned long)PING_INTERVAL_MS);
+    UART_PRINTF("- Displaying statistics every %lu ms\r\n", (unsigned long)STATS_INTERVAL_MS);
+
+    // Main test loop, never returns
+    CyclicTask_Run(&s_ethernet_cycle, &s_ethernet_cycle_config);
+
+test_cleanup:
+    // Close Ethernet interface
+    enet_raw_close(&s_enet_handle);
+    UART_LOG("Ethernet interface closed\r\n");
 
-    last_stats_time = last_ping_time = xTaskGetTickCount();
+test_exit:
+    UART_LOG("Ethernet test finished. Task will idle.\r\n");
 
-    // Main test loop
+    // Task completed - just idle
     while (1)
     {
-        current_time = xTaskGetTickCount();
+        vTaskDelay(pdMS_TO_TICKS(10000));
+    }
+}
 
-        // Send test ping frames at regular intervals
-        if ((current_time - last_ping_time) >= pdMS_TO_TICKS(PING_INTERVAL_MS))
-        {
-            status = enet_raw_send_test_frame(&s_enet_handle, ping_count);
+// One cycle of the Ethernet test, every ETHERCAT_PERIOD_MS
+static void ethernet_test_cycle(void *arg)
+{
+    static uint32_t cycle = 0;
+    static uint32_t ping_count = 0;
+    enet_raw_status_t status;
 
-            if (status == ENET_RAW_SUCCESS)
-            {
-                UART_PRINTF("TX[%lu]: Test frame sent (seq=%lu)\r\n",
-                           ping_count + 1, ping_count);
-            }
-            else
-            {
-                UART_PRINTF("TX[%lu]: Send failed: %d\r\n", ping_count + 1, status);
-            }
+    (void)arg;
+    cycle++;
 
-            ping_count++;
-            if (ping_count >= MAX_PING_COUNT)
-            {
-                ping_count = 0;  // Reset and continue
-            }
+    // Send test ping frames at regular intervals
+    if ((cycle % (PING_INTERVAL_MS / ETHERCAT_PERIOD_MS)) == 0U)
+    {
+        status = enet_raw_send_test_frame(&s_enet_handle, ping_count);
 
-            last_ping_time = current_time;
+        if (status == ENET_RAW_SUCCESS)
+        {
+            UART_DPRINTF("TX[%lu]: Test frame sent (seq=%lu)\r\n",
+                       (unsigned long)(ping_count + 1), (unsigned long)ping_count);
+        }
+        else
+        {
+            UART_DPRINTF("TX[%lu]: Send failed: %d\r\n", (unsigned long)(ping_count + 1), status);
         }
 
-        // Display statistics periodically
-        if ((current_time - last_stats_time) >= pdMS_TO_TICKS(STATS_INTERVAL_MS))
+        ping_count++;
+        if (ping_count >= MAX_PING_COUNT)
         {
-            enet_raw_get_stats(&s_enet_handle, &stats);
-
-            UART_LOG("\n--- Statistics ---\n");
-            UART_PRINTF("TX Frames:    %lu\r\n", stats.tx_frames);
-            UART_PRINTF("RX Frames:    %lu\r\n", stats.rx_frames);
-            UART_PRINTF("TX Errors:    %lu\r\n", stats.tx_errors);
-            UART_PRINTF("RX Errors:    %lu\r\n", stats.rx_errors);
-            UART_PRINTF("RX Dropped:   %lu\r\n", stats.rx_dropped);
-            UART_PRINTF("Non-EtherCAT: %lu\r\n", stats.non_ethercat);
-            UART_PRINTF("Link Status:  %s\r\n",
-                       enet_raw_is_link_up(&s_enet_handle) ? "UP" : "DOWN");
-            UART_LOG("------------------\n");
-
-            last_stats_time = current_time;
+            ping_count = 0;  // Reset and continue
         }
+    }
 
-        // Small delay
-        vTaskDelay(pdMS_TO_TICKS(100));
+    // Display statistics periodically
+    if ((cycle % (STATS_INTERVAL_MS / ETHERCAT_PERIOD_MS)) == 0U)
+    {
+        print_ethernet_stats();
     }
+}
 
-test_cleanup:
-    // Close Ethernet interface
-    enet_raw_close(&s_enet_handle);
-    UART_LOG("Ethernet interface closed\r\n");
+// Ethernet statistics, printed periodically and by the "stats" shell command
+static void print_ethernet_stats(void)
+{
+    enet_raw_stats_t stats;
 
-test_exit:
-    UART_LOG("Ethernet test finished. Task will idle.\r\n");
+    enet_raw_get_stats(&s_enet_handle, &stats);
+
+    UART_LOG("\n--- Statistics ---\n");
+    UART_PRINTF("TX Frames:    %lu\r\n", (unsigned long)stats.tx_frames);
+    UART_PRINTF("RX Frames:    %lu\r\n", (unsigned long)stats.rx_frames);
+    UART_PRINTF("TX Errors:    %lu\r\n", (unsigned long)stats.tx_errors);
+    UART_PRINTF("RX Errors:    %lu\r\n", (unsigned long)stats.rx_errors);
+    UART_PRINTF("RX Dropped:   %lu\r\n", (unsigned long)stats.rx_dropped);
+    UART_PRINTF("Non-EtherCAT: %lu\r\n", (unsigned long)stats.non_ethercat);
+    UART_PRINTF("Link Status:  %s\r\n",
+               enet_raw_is_link_up(&s_enet_handle) ? "UP" : "DOWN");
+    UART_LOG("------------------\n");
+}
 
-    // Task completed - just idle
-    while (1)
-    {
-        vTaskDelay(pdMS_TO_TICKS(10000));
-    }
+static int stats_shell_command(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    print_ethernet_stats();
+    return SHELL_OK;
 }
@@ -1,40 +1,131 @@
 #include "rtos.h"
 #include "CANopen_HAL.h"
+#include "CAN_BusLoad.h"
+#include "Joystick.h"
+#include "enet_raw.h"
 #include "UART_HAL.h"
+#include "Utilities.h"
+#include "Shell.h"
+#include "triple_buffer.h"
+#include "mem_placement.h"
 
 /* Global task handles */
 TaskHandle_t g_ethercat_task_handle = NULL;
 TaskHandle_t g_can_task_handle = NULL;
 TaskHandle_t g_logger_task_handle = NULL;
-SemaphoreHandle_t g_can_data_mutex = NULL;
-
-/* Shared control data */
-shared_control_data_t g_control_data = {
-    .x_axis = 0,
-    .y_axis = 0,
-    .enable = 0,
-    .speed_mode = 0,
-    .estop = 1,  // Default to NOT emergency stopped
-    .horn = 0,
-    .last_update_ms = 0
+TaskHandle_t g_shell_task_handle = NULL;
+
+/* Kernel task memory (configSUPPORT_STATIC_ALLOCATION) */
+static StaticTask_t s_idle_tcb MEM_SRAM_L_BSS;
+static StackType_t s_idle_stack[configMINIMAL_STACK_SIZE] MEM_SRAM_L_BSS;
+static StaticTask_t s_timer_tcb MEM_SRAM_L_BSS;
+static StackType_t s_timer_stack[configTIMER_TASK_STACK_DEPTH] MEM_SRAM_L_BSS;
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+    *ppxIdleTaskTCBBuffer = &s_idle_tcb;
+    *ppxIdleTaskStackBuffer = s_idle_stack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize)
+{
+    *ppxTimerTaskTCBBuffer = &s_timer_tcb;
+    *ppxTimerTaskStackBuffer = s_timer_stack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
+/* Shared control data: written by the CAN task, read by the EtherCAT cycle */
+#define CONTROL_DATA_DEFAULT { \
+    .x_axis = 0, \
+    .y_axis = 0, \
+    .enable = 0, \
+    .speed_mode = 0, \
+    .estop = 1,  /* Default to NOT emergency stopped */ \
+    .horn = 0, \
+    .last_update_ms = 0 \
+}
+
+static shared_control_data_t s_control_slots[3] = {
+    CONTROL_DATA_DEFAULT, CONTROL_DATA_DEFAULT, CONTROL_DATA_DEFAULT
 };
+static triple_buffer_t s_control_data = TRIPLE_BUFFER_INIT(s_control_slots);
 
-/* Thread-safe data access functions */
+/* Wait-free data access functions: one reader task, one writer task */
 bool get_control_data_safe(shared_control_data_t *data)
 {
-    if (xSemaphoreTake(g_can_data_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        *data = g_control_data;
-        xSemaphoreGive(g_can_data_mutex);
-        return true;
-    }
-    return false;
+    bool fresh;
+
+    *data = *(const shared_control_data_t *)TripleBuffer_Read(&s_control_data, &fresh);
+    return fresh;
 }
 
 void set_control_data_safe(const shared_control_data_t *data)
 {
-    if (xSemaphoreTake(g_can_data_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        g_control_data = *data;
-        g_control_data.last_update_ms = xTaskGetTickCount();
-        xSemaphoreGive(g_can_data_mutex);
+    shared_control_data_t *slot = TripleBuffer_WriteSlot(&s_control_data);
+
+    *slot = *data;
+    slot->last_update_ms = xTaskGetTickCount();
+    TripleBuffer_Publish(&s_control_data);
+}
+
+/* Shell command: bus load, per COB-ID rates and driver counters */
+static int can_shell_command(int argc, char *argv[])
+{
+    uint32_t sent;
+    uint32_t queued;
+    uint32_t dropped;
+
+    (void)argc;
+    (void)argv;
+
+    BusLoad_Show();
+    CAN_HAL_GetTxStats(&sent, &queued, &dropped);
+    UART_PRINTF("CAN: rx overflows %lu, tx sent %lu, queued %lu, dropped %lu\r\n",
+                (unsigned long)CAN_HAL_GetRxOverflows(), (unsigned long)sent,
+                (unsigned long)queued, (unsigned long)dropped);
+    return SHELL_OK;
+}
+
+static const shell_command_t can_command = { "can", "- bus load and CAN driver statistics", can_shell_command };
+
+/* CAN task: sleeps until the FlexCAN ISR queues a frame, then publishes the decoded inputs */
+void can_monitor_task(void *pvParameters)
+{
+    shared_control_data_t data;
+
+    if (CAN_HAL_RxInit(xTaskGetCurrentTaskHandle()) != kStatus_Success) {
+        LOG_ERROR(CAN, "CAN RX FIFO init failed\r\n");
+        vTaskDelete(NULL);
+    }
+
+    (void)Shell_RegisterCommand(&can_command);
+    LOG_INFO(CAN, "CAN task started\r\n");
+
+#if JOYSTICK_BENCHMARK
+    Joystick_Benchmark();
+#endif
+
+    while (1)
+    {
+        /* One notification per frame; take them all and drain the queue in one go.
+         * Wake up at least once per window so the bus-load statistics of an idle bus decay. */
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BUSLOAD_WINDOW_NS / 1000000ULL));
+
+        if (CAN_HAL_ProcessRx() == 0) {
+            BusLoad_Update(enet_raw_time_ns());
+            continue;
+        }
+
+        Joystick_GetSetpoints(&data.x_axis, &data.y_axis);
+        data.enable = get_enable();
+        data.speed_mode = get_speed();
+        data.estop = get_E_Stop();
+        data.horn = get_Horn();
+        set_control_data_safe(&data);
     }
 }
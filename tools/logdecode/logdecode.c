@@ -0,0 +1,486 @@
+/*
+ * Host decoder for the binary UART log stream (UART_LOG_BINARY=1)
+ *
+ * Usage: logdecode -e Debug/EtherCATMaster.axf [-c] [-f core_hz] [input]
+ *
+ *   -e  firmware ELF the stream was produced by, format strings are read from it
+ *   -c  CSV output (time_s,type,message) instead of text
+ *   -f  core clock used to convert DWT cycle timestamps, default 120 MHz
+ *   input  capture file or serial device (set to 115200 8N1 raw), stdin if omitted
+ *
+ * Records are COBS framed (header/log_record.h). Malformed frames are counted
+ * and skipped, decoding resumes at the next 0x00 delimiter.
+ */
+
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "log_record.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define DEFAULT_CORE_HZ         120000000.0
+#define READ_CHUNK              65536
+#define FRAME_MAX               (LOG_COBS_MAX_SIZE(LOG_RECORD_MAX_SIZE + 4U * LOG_RECORD_MAX_ARGS) + 1U)
+#define TEXT_MAX                1024
+
+/* Loadable segment of the firmware image */
+typedef struct {
+    uint32_t vaddr;
+    uint32_t size;          /* Bytes present in the file */
+    const uint8_t *data;
+} segment_t;
+
+typedef struct {
+    uint8_t *image;
+    size_t image_size;
+    segment_t *segments;
+    size_t segment_count;
+} firmware_t;
+
+typedef struct {
+    bool csv;
+    double core_hz;
+    uint32_t last_cycles;
+    uint64_t wraps;
+    bool have_time;
+    uint64_t records;
+    uint64_t bad_frames;
+    uint64_t unknown_formats;
+} decoder_t;
+
+/*******************************************************************************
+ * ELF Loading
+ ******************************************************************************/
+
+/**
+ * @brief Load an ARM ELF32 image and index its PT_LOAD segments
+ * @return 0 on success, -1 on error (reported on stderr)
+ */
+static int firmware_load(firmware_t *fw, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    const Elf32_Ehdr *ehdr;
+    struct stat st;
+    size_t i;
+
+    if (!file || fstat(fileno(file), &st) != 0)
+    {
+        fprintf(stderr, "logdecode: cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    fw->image_size = (size_t)st.st_size;
+    fw->image = malloc(fw->image_size);
+    if (!fw->image || fread(fw->image, 1, fw->image_size, file) != fw->image_size)
+    {
+        fprintf(stderr, "logdecode: cannot read %s\n", path);
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+
+    ehdr = (const Elf32_Ehdr *)fw->image;
+    if (fw->image_size < sizeof(*ehdr) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+        ehdr->e_ident[EI_CLASS] != ELFCLASS32 || ehdr->e_ident[EI_DATA] != ELFDATA2LSB ||
+        (size_t)ehdr->e_phoff + (size_t)ehdr->e_phnum * sizeof(Elf32_Phdr) > fw->image_size)
+    {
+        fprintf(stderr, "logdecode: %s is not a little-endian ELF32 image\n", path);
+        return -1;
+    }
+
+    fw->segments = calloc(ehdr->e_phnum, sizeof(segment_t));
+    for (i = 0; i < ehdr->e_phnum; i++)
+    {
+        const Elf32_Phdr *phdr = (const Elf32_Phdr *)(fw->image + ehdr->e_phoff) + i;
+
+        if (phdr->p_type != PT_LOAD || phdr->p_filesz == 0 ||
+            (size_t)phdr->p_offset + phdr->p_filesz > fw->image_size)
+        {
+            continue;
+        }
+        fw->segments[fw->segment_count].vaddr = phdr->p_vaddr;
+        fw->segments[fw->segment_count].size = phdr->p_filesz;
+        fw->segments[fw->segment_count].data = fw->image + phdr->p_offset;
+        fw->segment_count++;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Find the NUL terminated string at a target address
+ * @return Pointer into the image, NULL if the address is not in a segment
+ */
+static const char *firmware_string(const firmware_t *fw, uint32_t address)
+{
+    size_t i;
+
+    for (i = 0; i < fw->segment_count; i++)
+    {
+        const segment_t *seg = &fw->segments[i];
+
+        if (address >= seg->vaddr && address - seg->vaddr < seg->size)
+        {
+            uint32_t offset = address - seg->vaddr;
+
+            if (memchr(seg->data + offset, 0, seg->size - offset) == NULL)
+            {
+                return NULL;
+            }
+            return (const char *)seg->data + offset;
+        }
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+ * Formatting
+ ******************************************************************************/
+
+/**
+ * @brief printf a target format string with 32-bit argument words
+ *
+ * Length modifiers are dropped since every target argument is one 32-bit
+ * word; %s arguments are target addresses and are looked up in the ELF.
+ */
+static void format_target(const firmware_t *fw, const char *format, const uint32_t *args,
+                          uint32_t argc, char *out, size_t out_size)
+{
+    size_t used = 0;
+    uint32_t arg = 0;
+    const char *p = format;
+
+    out[0] = '\0';
+    while (*p && used + 1 < out_size)
+    {
+        char spec[32];
+        size_t spec_len = 0;
+        uint32_t value;
+        int n;
+
+        if (*p != '%')
+        {
+            out[used++] = *p++;
+            out[used] = '\0';
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            out[used++] = '%';
+            out[used] = '\0';
+            p += 2;
+            continue;
+        }
+
+        /* Copy flags, width and precision, skip length modifiers */
+        spec[spec_len++] = *p++;
+        while (*p && strchr("-+ #0123456789.*", *p) && spec_len < sizeof(spec) - 3)
+        {
+            spec[spec_len++] = *p++;
+        }
+        while (*p && strchr("hlLqjzt", *p))
+        {
+            p++;
+        }
+        if (!*p)
+        {
+            break;
+        }
+
+        value = (arg < argc) ? args[arg] : 0;
+        arg++;
+
+        switch (*p)
+        {
+        case 'd':
+        case 'i':
+            spec[spec_len++] = *p;
+            spec[spec_len] = '\0';
+            n = snprintf(out + used, out_size - used, spec, (int32_t)value);
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'c':
+            spec[spec_len++] = *p;
+            spec[spec_len] = '\0';
+            n = snprintf(out + used, out_size - used, spec, value);
+            break;
+        case 'p':
+            n = snprintf(out + used, out_size - used, "0x%08" PRIx32, value);
+            break;
+        case 's':
+        {
+            const char *str = firmware_string(fw, value);
+            char missing[24];
+
+            if (!str)
+            {
+                snprintf(missing, sizeof(missing), "<0x%08" PRIx32 ">", value);
+                str = missing;
+            }
+            spec[spec_len++] = 's';
+            spec[spec_len] = '\0';
+            n = snprintf(out + used, out_size - used, spec, str);
+            break;
+        }
+        default:
+            /* Unsupported conversion (floats are not sent), print it verbatim */
+            n = snprintf(out + used, out_size - used, "%.*s%c", (int)spec_len, spec, *p);
+            break;
+        }
+        p++;
+
+        if (n < 0)
+        {
+            break;
+        }
+        used += ((size_t)n < out_size - used) ? (size_t)n : out_size - used - 1;
+    }
+}
+
+/*******************************************************************************
+ * Output
+ ******************************************************************************/
+
+/**
+ * @brief Extend the 32-bit cycle counter and convert it to seconds
+ *
+ * Records arrive in order, so a smaller counter than the previous one means
+ * one wrap. Gaps longer than one wrap period (~35 s at 120 MHz) are not seen.
+ */
+static double decoder_time(decoder_t *dec, uint32_t cycles)
+{
+    if (dec->have_time && cycles < dec->last_cycles)
+    {
+        dec->wraps++;
+    }
+    dec->last_cycles = cycles;
+    dec->have_time = true;
+
+    return (double)((dec->wraps << 32) | cycles) / dec->core_hz;
+}
+
+static void emit(decoder_t *dec, double time_s, const char *type, char *text)
+{
+    size_t len = strlen(text);
+    char *p;
+
+    /* Line endings come from the target format strings */
+    while (len > 0 && (text[len - 1] == '\n' || text[len - 1] == '\r'))
+    {
+        text[--len] = '\0';
+    }
+
+    if (!dec->csv)
+    {
+        printf("[%14.6f] %s\n", time_s, text);
+        return;
+    }
+
+    printf("%.6f,%s,\"", time_s, type);
+    for (p = text; *p; p++)
+    {
+        if (*p == '"')
+        {
+            putchar('"');
+        }
+        putchar((*p == '\r' || *p == '\n') ? ' ' : *p);
+    }
+    printf("\"\n");
+}
+
+/**
+ * @brief Decode one frame (delimiter removed) and print it
+ */
+static void decode_frame(decoder_t *dec, const firmware_t *fw, const uint8_t *frame, size_t len)
+{
+    uint8_t record[LOG_RECORD_MAX_SIZE + 4U * LOG_RECORD_MAX_ARGS];
+    char text[TEXT_MAX];
+    int32_t record_len;
+    uint32_t cycles;
+
+    if (len == 0)
+    {
+        return;
+    }
+
+    record_len = LogCobs_Decode(frame, len, record, sizeof(record));
+    if (record_len < (int32_t)LOG_RECORD_HEADER_SIZE)
+    {
+        dec->bad_frames++;
+        return;
+    }
+    memcpy(&cycles, &record[1], sizeof(cycles));
+
+    if (record[0] == LOG_RECORD_TEXT)
+    {
+        size_t text_len = (size_t)record_len - LOG_RECORD_HEADER_SIZE;
+
+        memcpy(text, &record[LOG_RECORD_HEADER_SIZE], text_len);
+        text[text_len] = '\0';
+        emit(dec, decoder_time(dec, cycles), "text", text);
+    }
+    else if (record[0] == LOG_RECORD_FORMAT &&
+             record_len >= (int32_t)(LOG_RECORD_HEADER_SIZE + 4U) &&
+             ((record_len - LOG_RECORD_HEADER_SIZE - 4U) % 4U) == 0)
+    {
+        uint32_t args[LOG_RECORD_MAX_ARGS];
+        uint32_t argc = (uint32_t)(record_len - LOG_RECORD_HEADER_SIZE - 4U) / 4U;
+        uint32_t address;
+        const char *format;
+
+        memcpy(&address, &record[LOG_RECORD_HEADER_SIZE], sizeof(address));
+        memcpy(args, &record[LOG_RECORD_HEADER_SIZE + 4U], argc * 4U);
+
+        format = firmware_string(fw, address);
+        if (!format)
+        {
+            dec->unknown_formats++;
+            snprintf(text, sizeof(text), "<unknown format 0x%08" PRIx32 ">", address);
+        }
+        else
+        {
+            format_target(fw, format, args, argc, text, sizeof(text));
+        }
+        emit(dec, decoder_time(dec, cycles), "format", text);
+    }
+    else
+    {
+        dec->bad_frames++;
+        return;
+    }
+
+    dec->records++;
+}
+
+/*******************************************************************************
+ * Main
+ ******************************************************************************/
+
+static void serial_setup(int fd)
+{
+    struct termios tio;
+
+    if (!isatty(fd) || tcgetattr(fd, &tio) != 0)
+    {
+        return;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B115200);
+    cfsetospeed(&tio, B115200);
+    tcsetattr(fd, TCSANOW, &tio);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: logdecode -e firmware.axf [-c] [-f core_hz] [input]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t chunk[READ_CHUNK];
+    uint8_t frame[FRAME_MAX];
+    size_t frame_len = 0;
+    bool overrun = false;
+    const char *elf_path = NULL;
+    firmware_t fw = {0};
+    decoder_t dec = {0};
+    int fd = STDIN_FILENO;
+    ssize_t n;
+    int opt;
+
+    dec.core_hz = DEFAULT_CORE_HZ;
+    while ((opt = getopt(argc, argv, "e:cf:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'e':
+            elf_path = optarg;
+            break;
+        case 'c':
+            dec.csv = true;
+            break;
+        case 'f':
+            dec.core_hz = strtod(optarg, NULL);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (!elf_path || dec.core_hz <= 0.0 || argc - optind > 1)
+    {
+        usage();
+    }
+    if (firmware_load(&fw, elf_path) != 0)
+    {
+        return 1;
+    }
+    if (optind < argc)
+    {
+        fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+        if (fd < 0)
+        {
+            fprintf(stderr, "logdecode: cannot open %s: %s\n", argv[optind], strerror(errno));
+            return 1;
+        }
+        serial_setup(fd);
+    }
+
+    if (dec.csv)
+    {
+        printf("time_s,type,message\n");
+    }
+
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0)
+    {
+        ssize_t i;
+
+        for (i = 0; i < n; i++)
+        {
+            if (chunk[i] == 0)
+            {
+                /* An overlong frame means a delimiter was lost, drop it whole */
+                if (overrun)
+                {
+                    dec.bad_frames++;
+                }
+                else
+                {
+                    decode_frame(&dec, &fw, frame, frame_len);
+                }
+                frame_len = 0;
+                overrun = false;
+            }
+            else if (frame_len < sizeof(frame))
+            {
+                frame[frame_len++] = chunk[i];
+            }
+            else
+            {
+                overrun = true;
+            }
+        }
+    }
+
+    fflush(stdout);
+    fprintf(stderr, "logdecode: %" PRIu64 " records, %" PRIu64 " bad frames, %" PRIu64
+            " unknown formats\n", dec.records, dec.bad_frames, dec.unknown_formats);
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""RAM budget report from a GNU ld map file.
+
+Usage: ram_report.py [-n N] [--min-free BYTES] Debug/EtherCATMaster.map
+
+Sums every input section placed in a RAM region (.data, .bss, .noinit, ...)
+per subsystem and per region, and prints the headroom left in SRAM_UPPER
+(192K) and SRAM_LOWER (64K). The C heap and main stack reserved by the linker
+script are listed separately. With all kernel objects static, this is the
+whole RAM use of the firmware: nothing is allocated at run time.
+
+-n N            also list the N largest symbols
+--min-free B    exit with status 1 if a RAM region has less than B bytes free,
+                for use as a post-build step
+"""
+
+import argparse
+import re
+import sys
+
+# Object path -> subsystem, first match wins
+SUBSYSTEMS = [
+    (r"source/(enet_raw|ecat_)", "EtherCAT / ENET"),
+    (r"source/(CAN|CANopen|Joystick)", "CAN / CANopen"),
+    (r"source/(Utilities|UART_HAL|Shell|Trace|Profiler|CyclicTask)", "Logging / shell / diagnostics"),
+    (r"source/", "Application tasks"),
+    (r"FreeRTOS/", "FreeRTOS kernel"),
+    (r"(drivers|device|board|component|utilities|mdio|phy|startup)/", "SDK / startup"),
+    (r"\.a\(|lib", "C library"),
+]
+
+# Regions reserved by the linker script rather than by objects
+RESERVED = {".heap": "C heap (linker)", ".stack": "Main stack (linker)"}
+
+RAM_REGIONS = ("SRAM_UPPER", "SRAM_LOWER", "FLEX_RAM")
+
+MEMORY_RE = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+ADDR_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+INPUT_RE = re.compile(r"^ (\.\S+|COMMON)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$")
+OUTPUT_RE = re.compile(r"^(\.\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+
+
+def parse_map(path):
+    """Return (regions {name: (origin, length)}, entries [(section, addr, size, obj)])."""
+    regions = {}
+    entries = []
+    with open(path, encoding="utf-8", errors="replace") as f:
+        lines = f.read().splitlines()
+
+    i = 0
+    while i < len(lines) and not lines[i].startswith("Memory Configuration"):
+        i += 1
+    i += 1
+    while i < len(lines) and not lines[i].startswith("Linker script and memory map"):
+        m = MEMORY_RE.match(lines[i])
+        if m and m.group(1) in RAM_REGIONS:
+            regions[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+        i += 1
+
+    while i < len(lines):
+        line = lines[i]
+        m = OUTPUT_RE.match(line)
+        if m and m.group(1) in RESERVED:
+            entries.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16), None))
+            i += 1
+            continue
+
+        m = INPUT_RE.match(line)
+        if m:
+            section = m.group(1)
+            if m.group(2) is None and i + 1 < len(lines):
+                # Long section names put the address on the next line
+                n = ADDR_RE.match(lines[i + 1])
+                if n:
+                    entries.append((section, int(n.group(1), 16), int(n.group(2), 16), n.group(3).strip()))
+                    i += 2
+                    continue
+            elif m.group(2) is not None:
+                entries.append((section, int(m.group(2), 16), int(m.group(3), 16), m.group(4).strip()))
+        elif line.startswith(" *fill*"):
+            n = ADDR_RE.match(line[len(" *fill*"):])
+            if n:
+                entries.append(("*fill*", int(n.group(1), 16), int(n.group(2), 16), "padding"))
+        i += 1
+
+    return regions, entries
+
+
+def region_of(regions, addr):
+    for name, (origin, length) in regions.items():
+        if origin <= addr < origin + length:
+            return name
+    return None
+
+
+def subsystem_of(section, obj):
+    if section in RESERVED:
+        return RESERVED[section]
+    if obj == "padding":
+        return "Alignment padding"
+    for pattern, label in SUBSYSTEMS:
+        if re.search(pattern, obj):
+            return label
+    return "Other"
+
+
+def symbol_name(section):
+    """".bss.name" -> "name", ".bss.$SRAM_LOWER.name" -> "name"."""
+    for prefix in (".bss.", ".data.", ".noinit.", ".ramfunc."):
+        if section.startswith(prefix):
+            name = section[len(prefix):]
+            if name.startswith("$"):
+                _, _, rest = name.partition(".")
+                name = rest or name
+            return name
+    return section
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RAM budget report from a GNU ld map file")
+    parser.add_argument("mapfile")
+    parser.add_argument("-n", type=int, default=0, help="list the N largest symbols")
+    parser.add_argument("--min-free", type=int, default=None, help="fail if a region has less free RAM")
+    args = parser.parse_args()
+
+    regions, entries = parse_map(args.mapfile)
+    if not regions:
+        sys.exit("ram_report: no RAM regions in the memory configuration of %s" % args.mapfile)
+
+    used = {name: 0 for name in regions}
+    by_subsystem = {}
+    symbols = []
+    for section, addr, size, obj in entries:
+        region = region_of(regions, addr)
+        if region is None or size == 0:
+            continue
+        label = subsystem_of(section, obj or "")
+        used[region] += size
+        key = (label, region)
+        by_subsystem[key] = by_subsystem.get(key, 0) + size
+        if obj not in (None, "padding"):
+            symbols.append((size, symbol_name(section), region, obj))
+
+    names = [r for r in RAM_REGIONS if r in regions]
+    print("%-32s" % "Subsystem" + "".join("%12s" % r for r in names) + "%12s" % "Total")
+    for label in sorted({k[0] for k in by_subsystem}, key=lambda l: -sum(
+            by_subsystem.get((l, r), 0) for r in names)):
+        row = [by_subsystem.get((label, r), 0) for r in names]
+        print("%-32s" % label + "".join("%12d" % v for v in row) + "%12d" % sum(row))
+
+    print()
+    status = 0
+    for r in names:
+        length = regions[r][1]
+        free = length - used[r]
+        print("%-10s %7d / %7d bytes used (%5.1f%%), %7d free" % (r, used[r], length, 100.0 * used[r] / length, free))
+        if args.min_free is not None and free < args.min_free:
+            status = 1
+
+    if args.n > 0:
+        print()
+        print("Largest symbols:")
+        for size, name, region, obj in sorted(symbols, reverse=True)[:args.n]:
+            print("  %7d  %-10s %-32s %s" % (size, region, name, obj))
+
+    if status:
+        print("ram_report: less than %d bytes free in a RAM region" % args.min_free, file=sys.stderr)
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
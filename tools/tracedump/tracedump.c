@@ -0,0 +1,325 @@
+/*
+ * Host renderer for the kernel trace recorder ("trace dump" shell command)
+ *
+ * Usage: tracedump [-f core_hz] [capture]
+ *
+ *   -f  core clock of the DWT timestamps, default: the one in the dump header
+ *   capture  console log holding a TRACE BEGIN ... TRACE END block, stdin if
+ *            omitted. Other console lines are ignored, the last block is used.
+ *
+ * Prints per task CPU load and switch-in rate, the context switch rate, and per
+ * ISR the handler duration and the latency from handler exit to the task it
+ * made ready (the next switch-in to another task). ISR time is charged to the
+ * task it interrupted, as in the FreeRTOS run-time stats.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Trace.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define LINE_MAX_LEN            512
+#define MAX_TASK_NUMBER         256
+#define TASK_NAME_LEN           32
+
+typedef struct {
+    uint64_t time;          /* Cycles, unwrapped */
+    uint8_t type;
+    uint8_t id;
+} event_t;
+
+typedef struct {
+    char name[TASK_NAME_LEN];
+    uint64_t run_cycles;
+    uint64_t switch_ins;
+} task_t;
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_cycles;
+    uint64_t max_cycles;
+    uint64_t enter_time;
+    bool active;
+    uint64_t wakeups;       /* Exits followed by a switch to another task */
+    uint64_t total_latency;
+    uint64_t max_latency;
+} isr_t;
+
+static const char *const isr_names[TRACE_ISR_COUNT] = { "uart", "can", "enet" };
+
+/*******************************************************************************
+ * Capture Parsing
+ ******************************************************************************/
+
+/**
+ * @brief Append the events of one "E" line, unwrapping the 32-bit timestamps
+ */
+static void parse_events(const char *line, event_t **events, size_t *count, size_t *capacity,
+                         uint32_t *last_raw, uint64_t *high)
+{
+    const char *p = line + 1;
+
+    while (*p == ' ')
+    {
+        char token[13];
+        uint32_t raw;
+        unsigned type;
+        unsigned id;
+
+        p++;
+        if (strlen(p) < 12)
+        {
+            break;
+        }
+        memcpy(token, p, 12);
+        token[12] = '\0';
+        if (sscanf(token, "%8" SCNx32 "%2x%2x", &raw, &type, &id) != 3)
+        {
+            break;
+        }
+        p += 12;
+
+        if (*count > 0 && raw < *last_raw)
+        {
+            *high += 1ULL << 32;
+        }
+        *last_raw = raw;
+
+        if (*count == *capacity)
+        {
+            *capacity = (*capacity != 0) ? (*capacity * 2) : 1024;
+            *events = realloc(*events, *capacity * sizeof(event_t));
+            if (!*events)
+            {
+                fprintf(stderr, "tracedump: out of memory\n");
+                exit(1);
+            }
+        }
+        (*events)[*count].time = *high | raw;
+        (*events)[*count].type = (uint8_t)type;
+        (*events)[*count].id = (uint8_t)id;
+        (*count)++;
+    }
+}
+
+/*******************************************************************************
+ * Main
+ ******************************************************************************/
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: tracedump [-f core_hz] [capture]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    static task_t tasks[MAX_TASK_NUMBER];
+    isr_t isrs[TRACE_ISR_COUNT] = {{0}};
+    char line[LINE_MAX_LEN];
+    event_t *events = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    uint32_t last_raw = 0;
+    uint64_t high = 0;
+    double core_hz = 0.0;
+    double dump_hz = 0.0;
+    bool in_block = false;
+    bool have_block = false;
+    int current = -1;
+    int pending_isr = -1;
+    uint64_t pending_exit = 0;
+    uint64_t last_switch = 0;
+    uint64_t switches = 0;
+    double duration_s;
+    FILE *in = stdin;
+    size_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            core_hz = strtod(optarg, NULL);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (argc - optind > 1)
+    {
+        usage();
+    }
+    if (optind < argc)
+    {
+        in = fopen(argv[optind], "r");
+        if (!in)
+        {
+            fprintf(stderr, "tracedump: cannot open %s\n", argv[optind]);
+            return 1;
+        }
+    }
+
+    while (fgets(line, sizeof(line), in))
+    {
+        char *text = strstr(line, "TRACE BEGIN");
+
+        if (text)
+        {
+            /* A new block replaces any previous one */
+            unsigned long hz = 0;
+
+            (void)sscanf(text, "TRACE BEGIN %lu", &hz);
+            dump_hz = (double)hz;
+            memset(tasks, 0, sizeof(tasks));
+            count = 0;
+            high = 0;
+            in_block = true;
+            have_block = true;
+        }
+        else if (!in_block)
+        {
+            continue;
+        }
+        else if (strstr(line, "TRACE END"))
+        {
+            in_block = false;
+        }
+        else if (line[0] == 'N' && line[1] == ' ')
+        {
+            unsigned number;
+            char name[TASK_NAME_LEN];
+
+            if (sscanf(line, "N %u %31s", &number, name) == 2 && number < MAX_TASK_NUMBER)
+            {
+                strcpy(tasks[number].name, name);
+            }
+        }
+        else if (line[0] == 'E' && line[1] == ' ')
+        {
+            parse_events(line, &events, &count, &capacity, &last_raw, &high);
+        }
+    }
+
+    if (!have_block || count < 2)
+    {
+        fprintf(stderr, "tracedump: no trace block with events found\n");
+        return 1;
+    }
+    if (core_hz <= 0.0)
+    {
+        core_hz = (dump_hz > 0.0) ? dump_hz : 120000000.0;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        const event_t *ev = &events[i];
+
+        switch (ev->type)
+        {
+        case TRACE_EVENT_SWITCH_IN:
+            if (current >= 0)
+            {
+                tasks[current].run_cycles += ev->time - last_switch;
+            }
+            if (pending_isr >= 0 && (int)ev->id != current)
+            {
+                uint64_t latency = ev->time - pending_exit;
+
+                isrs[pending_isr].wakeups++;
+                isrs[pending_isr].total_latency += latency;
+                if (latency > isrs[pending_isr].max_latency)
+                {
+                    isrs[pending_isr].max_latency = latency;
+                }
+            }
+            if (current >= 0 && (int)ev->id != current)
+            {
+                switches++;
+            }
+            pending_isr = -1;
+            current = ev->id;
+            tasks[current].switch_ins++;
+            last_switch = ev->time;
+            break;
+
+        case TRACE_EVENT_ISR_ENTER:
+            if (ev->id < TRACE_ISR_COUNT)
+            {
+                isrs[ev->id].enter_time = ev->time;
+                isrs[ev->id].active = true;
+            }
+            pending_isr = -1;
+            break;
+
+        case TRACE_EVENT_ISR_EXIT:
+            if (ev->id < TRACE_ISR_COUNT && isrs[ev->id].active)
+            {
+                uint64_t cycles = ev->time - isrs[ev->id].enter_time;
+
+                isrs[ev->id].count++;
+                isrs[ev->id].total_cycles += cycles;
+                if (cycles > isrs[ev->id].max_cycles)
+                {
+                    isrs[ev->id].max_cycles = cycles;
+                }
+                isrs[ev->id].active = false;
+                pending_isr = ev->id;
+                pending_exit = ev->time;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+    if (current >= 0)
+    {
+        tasks[current].run_cycles += events[count - 1].time - last_switch;
+    }
+
+    duration_s = (double)(events[count - 1].time - events[0].time) / core_hz;
+    printf("%zu events over %.3f ms, %.0f context switches/s\n\n",
+           count, duration_s * 1e3, (double)switches / duration_s);
+
+    printf("%-16s %7s %12s\n", "task", "CPU %", "switch-in/s");
+    for (i = 0; i < MAX_TASK_NUMBER; i++)
+    {
+        if (tasks[i].switch_ins == 0)
+        {
+            continue;
+        }
+        printf("%-16s %7.2f %12.1f\n", tasks[i].name[0] ? tasks[i].name : "?",
+               100.0 * (double)tasks[i].run_cycles / core_hz / duration_s,
+               (double)tasks[i].switch_ins / duration_s);
+    }
+
+    printf("\n%-6s %8s %10s %10s %8s %12s %12s\n", "isr", "count", "avg us", "max us",
+           "wakeups", "wake avg us", "wake max us");
+    for (i = 0; i < TRACE_ISR_COUNT; i++)
+    {
+        const isr_t *isr = &isrs[i];
+
+        if (isr->count == 0)
+        {
+            continue;
+        }
+        printf("%-6s %8" PRIu64 " %10.2f %10.2f %8" PRIu64 " %12.2f %12.2f\n", isr_names[i], isr->count,
+               (double)isr->total_cycles / (double)isr->count / core_hz * 1e6,
+               (double)isr->max_cycles / core_hz * 1e6, isr->wakeups,
+               isr->wakeups ? (double)isr->total_latency / (double)isr->wakeups / core_hz * 1e6 : 0.0,
+               (double)isr->max_latency / core_hz * 1e6);
+    }
+
+    free(events);
+    return 0;
+}